@@ -2,9 +2,9 @@
 AUDIO_LIBS = openal
 AUDIO_CFLAGS = -DAUDIO
 ifneq (, $(findstring audio_device.o, $(OBJ)))
-    AUDIO_OBJ = audio_call.o
+    AUDIO_OBJ = audio_call.o audio_mixer.o
 else
-    AUDIO_OBJ = audio_call.o audio_device.o
+    AUDIO_OBJ = audio_call.o audio_device.o audio_level.o audio_mixer.o audio_pseudo_device.o
 endif
 
 # Check if we can build audio support
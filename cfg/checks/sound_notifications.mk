@@ -4,7 +4,7 @@ SND_NOTIFY_CFLAGS = -DSOUND_NOTIFY
 ifneq (, $(findstring audio_device.o, $(OBJ)))
     SND_NOTIFY_OBJ =
 else
-    SND_NOTIFY_OBJ = audio_device.o
+    SND_NOTIFY_OBJ = audio_device.o audio_level.o audio_pseudo_device.o
 endif
 
 # Check if we can build sound notifications support
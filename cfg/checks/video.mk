@@ -4,7 +4,7 @@ VIDEO_CFLAGS = -DVIDEO
 ifneq (, $(findstring video_device.o, $(OBJ)))
     VIDEO_OBJ = video_call.o
 else
-    VIDEO_OBJ = video_call.o video_device.o
+    VIDEO_OBJ = video_call.o video_device.o video_pseudo_device.o
 endif
 
 # Check if we can build video support
@@ -0,0 +1,182 @@
+#!/usr/bin/env sh
+
+# Benchmarks an audio call between two Toxic instances on this machine, without
+# any sound hardware, using the audio pseudo devices.
+#
+# Both instances capture from the latency pulse input and play to the discard
+# output. Every pulse is emitted on a whole second of the shared CLOCK_MONOTONIC,
+# so the receiving side can time it, giving the end-to-end latency of the call.
+# The /audiostats output of both instances is printed at the end, including the
+# CPU time spent per frame.
+#
+# The instances find each other by LAN discovery, so no DHT bootstrap is needed.
+# Requires tmux and a toxic binary built with audio support.
+#
+# Run as:
+#
+#    script/av-loopback-bench.sh [path to toxic binary] [call duration in seconds]
+#
+# The profiles and full window captures are left in the directory printed on exit.
+
+set -eu
+
+TOXIC="${1:-./build/toxic}"
+DURATION="${2:-30}"
+WORKDIR="$(mktemp -d "${TMPDIR:-/tmp}/toxic-av-bench.XXXXXX")"
+SESSION="toxic-av-bench-$$"
+
+if [ ! -x "$TOXIC" ]
+then
+  echo "Error: $TOXIC is not an executable. Pass the path to a toxic binary."
+  exit 1
+fi
+
+if ! command -v tmux > /dev/null
+then
+  echo "Error: tmux is required."
+  exit 1
+fi
+
+cleanup()
+{
+  for peer in a b
+  do
+    tmux capture-pane -p -J -S -2000 -t "$SESSION-$peer" > "$WORKDIR/$peer.log" 2> /dev/null || true
+    tmux kill-session -t "$SESSION-$peer" 2> /dev/null || true
+  done
+
+  echo "Work files left in $WORKDIR"
+}
+
+trap cleanup EXIT
+
+# send <peer> <line>
+send()
+{
+  tmux send-keys -t "$SESSION-$1" -l "$2"
+  tmux send-keys -t "$SESSION-$1" Enter
+}
+
+# pane <peer>
+pane()
+{
+  tmux capture-pane -p -J -S -2000 -t "$SESSION-$1"
+}
+
+# wait_for <peer> <pattern> <timeout in seconds>
+wait_for()
+{
+  tries=0
+
+  while ! pane "$1" | grep -q -- "$2"
+  do
+    tries=$((tries + 1))
+
+    if [ "$tries" -ge $(($3 * 10)) ]
+    then
+      echo "Error: timed out waiting for '$2' on instance $1."
+      exit 1
+    fi
+
+    sleep 0.1
+  done
+}
+
+# start <peer>
+start()
+{
+  tmux new-session -d -s "$SESSION-$1" -x 160 -y 50 \
+    "$TOXIC" -f "$WORKDIR/$1.tox" -c "$WORKDIR/toxic.conf" -n "$WORKDIR/nodes.json"
+
+  wait_for "$1" "Would you like to encrypt it" 10
+  send "$1" n
+  wait_for "$1" "Welcome to Toxic" 10
+}
+
+# device_index <peer> <in|out> <device name>
+device_index()
+{
+  send "$1" "/lsdev $2"
+  sleep 0.5
+  pane "$1" | grep -o "[0-9]*: $3" | tail -n 1 | cut -d: -f1
+}
+
+# use_pseudo_devices <peer>
+use_pseudo_devices()
+{
+  input="$(device_index "$1" in "Latency pulse")"
+  output="$(device_index "$1" out "Discard")"
+
+  if [ -z "$input" ] || [ -z "$output" ]
+  then
+    echo "Error: pseudo devices not listed by instance $1. Is toxic built with audio support?"
+    exit 1
+  fi
+
+  send "$1" "/sdev in $input"
+  send "$1" "/sdev out $output"
+}
+
+now="$(date +%s)"
+printf '{"last_scan": %s, "last_refresh": %s, "nodes": []}\n' "$now" "$now" > "$WORKDIR/nodes.json"
+: > "$WORKDIR/toxic.conf"
+
+echo "Starting instances..."
+start a
+start b
+
+use_pseudo_devices a
+use_pseudo_devices b
+
+send a "/myid"
+sleep 0.5
+TOX_ID="$(pane a | grep -o '[0-9A-F]\{76\}' | tail -n 1)"
+
+if [ -z "$TOX_ID" ]
+then
+  echo "Error: failed to read the Tox ID of instance a."
+  exit 1
+fi
+
+echo "Connecting instances..."
+send b "/add $TOX_ID benchmark"
+wait_for a "/accept 0" 30
+send a "/accept 0"
+wait_for b "has come online" 60
+
+# Open the chat window on b (the contacts list is the next tab) and place the call
+tmux send-keys -t "$SESSION-b" C-p
+sleep 0.5
+tmux send-keys -t "$SESSION-b" Enter
+sleep 0.5
+send b "/call"
+
+# The invite opens a chat window on a after its contacts list
+sleep 1
+tmux send-keys -t "$SESSION-a" C-p
+sleep 0.2
+tmux send-keys -t "$SESSION-a" C-p
+wait_for a "Incoming audio call" 10
+send a "/answer"
+
+echo "Call running for $DURATION seconds..."
+sleep "$DURATION"
+
+for peer in a b
+do
+  send "$peer" "/audiostats"
+done
+
+sleep 1
+
+for peer in a b
+do
+  echo
+  echo "Instance $peer:"
+  pane "$peer" | sed -n '/Capture to send latency/,$p' | grep -v '^ *$' | tail -n 16
+done
+
+for peer in a b
+do
+  send "$peer" "/hangup"
+done
@@ -106,8 +106,7 @@ void api_send(const char *msg)
         return;
     }
 
-    snprintf((char *) self_window->chatwin->line, sizeof(self_window->chatwin->line), "%s", msg);
-    add_line_to_hist(self_window->chatwin);
+    add_line_to_hist(self_window->chatwin, &user_toxic->client_data.input_history, msg);
     const int id = line_info_add(self_window, user_toxic->c_config, true, name, NULL, OUT_MSG, 0, 0, "%s", msg);
     cqueue_add(self_window->chatwin->cqueue, msg, strlen(msg), OUT_MSG, id);
     free(name);
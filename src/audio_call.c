@@ -830,13 +830,13 @@ void cmd_change_device(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc,
 
     const Client_Config *c_config = toxic->c_config;
 
-    if (argc != 2) {
+    if (argc != 2 && argc != 3) {
         if (argc < 1) {
             print_err(self, c_config, "Type must be specified!");
         } else if (argc < 2) {
             print_err(self, c_config, "Must have id!");
         } else {
-            print_err(self, c_config, "Only two arguments allowed!");
+            print_err(self, c_config, "Only three arguments allowed!");
         }
 
         return;
@@ -866,10 +866,22 @@ void cmd_change_device(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc,
         return;
     }
 
-    if (set_al_device(type, selection) == de_InvalidSelection) {
+    if (argc == 3 && set_device_file(type, argv[3]) != de_None) {
+        print_err(self, c_config, "Failed to set device file");
+        return;
+    }
+
+    const DeviceError err = set_al_device(type, selection);
+
+    if (err == de_InvalidSelection) {
         print_err(self, c_config, "Invalid selection!");
         return;
     }
+
+    if (err == de_FileError) {
+        print_err(self, c_config, "Device file missing or unusable. Usage: /sdev <type> <id> [file]");
+        return;
+    }
 }
 
 void cmd_mute(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
@@ -1032,6 +1044,98 @@ void cmd_bitrate(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (
     return;
 }
 
+void cmd_audiostats(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
+{
+    UNUSED_VAR(window);
+    UNUSED_VAR(argc);
+    UNUSED_VAR(argv);
+
+    if (toxic == NULL || self == NULL) {
+        return;
+    }
+
+    const Client_Config *c_config = toxic->c_config;
+
+    if (self->num >= toxic->call_control->max_calls) {
+        print_err(self, c_config, "Invalid call index.");
+        return;
+    }
+
+    const Call *call = toxic->call_control->calls[self->num];
+
+    if (call->status != cs_Active || call->in_idx == -1) {
+        print_err(self, c_config, "Must be in a call");
+        return;
+    }
+
+    AudioLatencyStats stats;
+
+    if (device_get_latency_stats(call->in_idx, &stats) != de_None) {
+        print_err(self, c_config, "Audio input device is not active");
+        return;
+    }
+
+    const uint64_t avg_usec = stats.frames > 0 ? stats.total_usec / stats.frames : 0;
+
+    line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0,
+                  "Capture to send latency: %llu frames, %llu dropped, avg %.2f ms, max %.2f ms",
+                  (unsigned long long) stats.frames, (unsigned long long) stats.dropped_frames,
+                  avg_usec / 1000.0, stats.max_usec / 1000.0);
+
+    if (stats.frames > 0) {
+        line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "Encode and send CPU time: %.1f us/frame",
+                      (double) stats.cpu_usec / stats.frames);
+    }
+
+    const uint32_t bounds[AUDIO_LATENCY_NUM_BUCKETS - 1] = AUDIO_LATENCY_BUCKET_BOUNDS;
+
+    for (size_t i = 0; i < AUDIO_LATENCY_NUM_BUCKETS; ++i) {
+        char range[32];
+
+        if (i == AUDIO_LATENCY_NUM_BUCKETS - 1) {
+            snprintf(range, sizeof(range), ">= %u ms", bounds[i - 1]);
+        } else {
+            snprintf(range, sizeof(range), "< %u ms", bounds[i]);
+        }
+
+        const double percent = stats.frames > 0 ? 100.0 * stats.buckets[i] / stats.frames : 0.0;
+
+        line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "  %-9s: %llu (%.1f%%)",
+                      range, (unsigned long long) stats.buckets[i], percent);
+    }
+
+    AudioPlayoutStats playout;
+
+    if (call->out_idx == -1 || device_get_playout_stats(call->out_idx, &playout) != de_None) {
+        return;
+    }
+
+    line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0,
+                  "Playout buffer: %u/%u frames queued (+%u ms), jitter %.2f ms",
+                  playout.depth, playout.target_depth, playout.added_latency_ms, playout.jitter_ms);
+    line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0,
+                  "  underruns %llu, concealed %llu, stretched %llu, dropped %llu",
+                  (unsigned long long) playout.underruns, (unsigned long long) playout.concealed_frames,
+                  (unsigned long long) playout.stretched_frames, (unsigned long long) playout.dropped_frames);
+
+    PseudoAudioStats pseudo;
+
+    if (device_get_pseudo_stats(output, &pseudo) != de_None || pseudo.frames == 0) {
+        return;
+    }
+
+    line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0,
+                  "Pseudo output: %llu frames received, process CPU time %.1f us/frame",
+                  (unsigned long long) pseudo.frames, (double) pseudo.cpu_usec / pseudo.frames);
+
+    if (pseudo.pulses > 0) {
+        line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0,
+                      "  pulse latency: %llu pulses, avg %.2f ms, min %.2f ms, max %.2f ms",
+                      (unsigned long long) pseudo.pulses, pseudo.pulse_total_usec / 1000.0 / pseudo.pulses,
+                      pseudo.pulse_min_usec / 1000.0, pseudo.pulse_max_usec / 1000.0);
+    }
+}
+
 void place_call(ToxWindow *self, Toxic *toxic)
 {
     const Client_Config *c_config = toxic->c_config;
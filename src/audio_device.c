@@ -22,6 +22,7 @@
 
 #include "audio_device.h"
 
+#include "audio_level.h"
 #include "line_info.h"
 #include "misc_tools.h"
 #include "settings.h"
@@ -33,8 +34,10 @@
 #include <AL/alext.h>
 #endif /* ALC_ALL_DEVICES_SPECIFIER */
 
+#include <errno.h>
 #include <math.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -48,6 +51,64 @@ typedef struct FrameInfo {
     bool stereo;
 } FrameInfo;
 
+/* Number of captured frames an input device can hold before the send side must catch up.
+ * Must be a power of two.
+ */
+#define AUDIO_RING_SLOTS 8
+
+/* Single-producer single-consumer queue of captured frames. The capture thread is the
+ * only producer and the AV thread the only consumer, so neither side takes a lock to
+ * move frames through it.
+ */
+typedef struct AudioRing {
+    int16_t *frames;  /* AUDIO_RING_SLOTS slots of `slot_samples` samples each */
+    uint64_t timestamps[AUDIO_RING_SLOTS];
+    uint32_t slot_samples;
+
+    _Atomic uint32_t head;  /* Written only by the producer */
+    _Atomic uint32_t tail;  /* Written only by the consumer */
+    _Atomic uint64_t dropped;
+} AudioRing;
+
+// Bounds for the number of frames the playout buffer keeps queued on a source
+#define PLAYOUT_MIN_DEPTH 2
+#define PLAYOUT_MAX_DEPTH (OPENAL_BUFS / 2)
+
+// Number of consecutive frames we conceal before letting the source run dry
+#define PLAYOUT_MAX_CONCEAL 5
+
+// Frames are stretched or compressed by 1/PLAYOUT_STRETCH_DIVISOR of their length
+#define PLAYOUT_STRETCH_DIVISOR 8
+
+// Volume below which a frame may be dropped outright when the buffer is too deep
+#define PLAYOUT_SILENCE_VOLUME 1.0f
+
+/* Adaptive playout buffer for an output device. The AL buffers are allocated once
+ * when the source is opened and recycled between the source queue and `free_buffers`.
+ */
+typedef struct PlayoutBuffer {
+    uint32_t buffers[OPENAL_BUFS];
+    uint32_t free_buffers[OPENAL_BUFS];
+    uint32_t num_free;
+
+    // last frame received, used for loss concealment
+    int16_t *last_frame;
+    uint32_t last_frame_samples;  /* Samples per channel */
+    uint8_t last_frame_channels;
+    uint32_t last_frame_rate;
+
+    int16_t *scratch;
+    size_t frame_capacity;  /* Capacity of `last_frame` and `scratch` in samples */
+
+    uint64_t last_arrival_usec;
+    float jitter_usec;
+    uint32_t target_depth;
+    uint32_t conceal_run;
+    bool prebuffering;
+
+    AudioPlayoutStats stats;
+} PlayoutBuffer;
+
 /* A virtual input/output device, abstracting the currently selected openal
  * device (which may change during the lifetime of the virtual device).
  * We refer to a virtual device as a "device", and refer to an underlying
@@ -65,12 +126,13 @@ typedef struct Device {
     // used only by input devices:
     DataHandleCallback cb;
     void *cb_data;
-    float VAD_threshold;
-    uint32_t VAD_samples_remaining;
+    VoiceDetector vad;
+    AudioRing ring;
+    AudioLatencyStats latency;
 
     // used only by output devices:
     uint32_t source;
-    uint32_t buffers[OPENAL_BUFS];
+    PlayoutBuffer playout;
     bool source_open;
 } Device;
 
@@ -88,16 +150,48 @@ typedef struct AudioState {
     // mutex[input] also used to lock input_volume which poll_input writes to.
     pthread_mutex_t mutex[2];
 
+    // signalled by poll_input whenever it queues a frame for the send side
+    pthread_mutex_t queue_mutex;
+    pthread_cond_t queue_cond;
+    bool frames_queued;
+
     // TODO: unused
     const char *default_al_device_name[2];              /* Default devices */
 
     const char *al_device_names[2][MAX_OPENAL_DEVICES]; /* Available devices */
     uint32_t num_al_devices[2];
     char *current_al_device_name[2];
+
+    // pseudo device selected in place of an openal device, and its instance while open
+    bool pseudo_selected[2];
+    PseudoAudioKind pseudo_kind[2];
+    char *pseudo_file[2];
+    PseudoAudioDevice *pseudo[2];
 } AudioState;
 
 static AudioState *audio_state;
 
+/* Pseudo devices, listed after the openal devices of each type */
+static const PseudoAudioKind pseudo_input_kinds[] = {pa_Silence, pa_Tone, pa_Pulse, pa_FileIn};
+static const PseudoAudioKind pseudo_output_kinds[] = {pa_Discard, pa_FileOut};
+
+static uint32_t num_pseudo_devices(DeviceType type)
+{
+    return type == input ? sizeof(pseudo_input_kinds) / sizeof(pseudo_input_kinds[0])
+           : sizeof(pseudo_output_kinds) / sizeof(pseudo_output_kinds[0]);
+}
+
+static PseudoAudioKind pseudo_device_kind(DeviceType type, uint32_t idx)
+{
+    return type == input ? pseudo_input_kinds[idx] : pseudo_output_kinds[idx];
+}
+
+/* Returns true if an openal or pseudo al_device of `type` is open. */
+static bool al_device_open(DeviceType type)
+{
+    return audio_state->al_device[type] != NULL || audio_state->pseudo[type] != NULL;
+}
+
 static void lock(DeviceType type)
 {
     pthread_mutex_lock(&audio_state->mutex[type]);
@@ -113,6 +207,8 @@ static bool thread_running = true,
             thread_paused = true;               /* Thread control */
 
 #ifdef AUDIO
+static pthread_t capture_thread;
+
 static void *poll_input(void *);
 #endif
 
@@ -144,12 +240,15 @@ DeviceError init_devices(void)
         }
     }
 
+    if (pthread_mutex_init(&audio_state->queue_mutex, NULL) != 0
+            || pthread_cond_init(&audio_state->queue_cond, NULL) != 0) {
+        return de_InternalError;
+    }
+
 #ifdef AUDIO
-    // Start poll thread
-    pthread_t thread_id;
 
-    if (pthread_create(&thread_id, NULL, poll_input, NULL) != 0
-            || pthread_detach(thread_id) != 0) {
+    // Start capture thread
+    if (pthread_create(&capture_thread, NULL, poll_input, NULL) != 0) {
         return de_InternalError;
     }
 
@@ -164,7 +263,9 @@ DeviceError terminate_devices(void)
     thread_running = false;
     unlock(input);
 
-    sleep_thread(20000L);
+#ifdef AUDIO
+    pthread_join(capture_thread, NULL);
+#endif
 
     for (DeviceType type = input; type <= output; ++type) {
         if (pthread_mutex_destroy(&audio_state->mutex[type]) != 0) {
@@ -172,8 +273,19 @@ DeviceError terminate_devices(void)
         }
 
         free(audio_state->current_al_device_name[type]);
+        free(audio_state->pseudo_file[type]);
+        pseudo_audio_close(audio_state->pseudo[type]);
+    }
+
+    for (uint32_t i = 0; i < MAX_DEVICES; ++i) {
+        free(audio_state->devices[input][i].ring.frames);
+        free(audio_state->devices[output][i].playout.last_frame);
+        free(audio_state->devices[output][i].playout.scratch);
     }
 
+    pthread_cond_destroy(&audio_state->queue_cond);
+    pthread_mutex_destroy(&audio_state->queue_mutex);
+
     free(audio_state);
 
     return de_None;
@@ -262,7 +374,7 @@ DeviceError device_set_VAD_threshold(uint32_t device_idx, float value)
 
     lock(input);
 
-    device->VAD_threshold = value;
+    device->vad.threshold = value;
 
     unlock(input);
     return de_None;
@@ -280,7 +392,7 @@ float device_get_VAD_threshold(uint32_t device_idx)
         return 0.0;
     }
 
-    return device->VAD_threshold;
+    return device->vad.threshold;
 }
 
 DeviceError set_source_position(uint32_t device_idx, float x, float y, float z)
@@ -297,6 +409,11 @@ DeviceError set_source_position(uint32_t device_idx, float x, float y, float z)
 
     lock(output);
 
+    if (audio_state->pseudo[output] != NULL) {
+        unlock(output);
+        return de_None;
+    }
+
     alSource3f(device->source, AL_POSITION, x, y, z);
 
     unlock(output);
@@ -310,6 +427,17 @@ DeviceError set_source_position(uint32_t device_idx, float x, float y, float z)
 
 static DeviceError close_al_device(DeviceType type)
 {
+    if (audio_state->pseudo[type] != NULL) {
+        pseudo_audio_close(audio_state->pseudo[type]);
+        audio_state->pseudo[type] = NULL;
+
+        if (type == input) {
+            thread_paused = true;
+        }
+
+        return de_None;
+    }
+
     if (audio_state->al_device[type] == NULL) {
         return de_None;
     }
@@ -335,8 +463,31 @@ static DeviceError close_al_device(DeviceType type)
     return de_None;
 }
 
+static DeviceError open_pseudo_device(DeviceType type, FrameInfo frame_info)
+{
+    const PseudoAudioKind kind = audio_state->pseudo_kind[type];
+
+    audio_state->pseudo[type] = pseudo_audio_open(kind, audio_state->pseudo_file[type], frame_info.sample_rate,
+                                frame_info.stereo ? 2 : 1);
+
+    if (audio_state->pseudo[type] == NULL) {
+        return pseudo_audio_needs_file(kind) ? de_FileError : de_FailedStart;
+    }
+
+    if (type == input) {
+        thread_paused = false;
+        audio_state->capture_frame_info = frame_info;
+    }
+
+    return de_None;
+}
+
 static DeviceError open_al_device(DeviceType type, FrameInfo frame_info)
 {
+    if (audio_state->pseudo_selected[type]) {
+        return open_pseudo_device(type, frame_info);
+    }
+
     audio_state->al_device[type] = type == input
                                    ? alcCaptureOpenDevice(audio_state->current_al_device_name[type],
                                        frame_info.sample_rate, sound_mode(frame_info.stereo), frame_info.samples_per_frame * 2)
@@ -366,8 +517,9 @@ static DeviceError open_al_device(DeviceType type, FrameInfo frame_info)
 static void close_source(Device *device)
 {
     if (device->source_open) {
+        alSourceStop(device->source);
         alDeleteSources(1, &device->source);
-        alDeleteBuffers(OPENAL_BUFS, device->buffers);
+        alDeleteBuffers(OPENAL_BUFS, device->playout.buffers);
 
         device->source_open = false;
     }
@@ -375,7 +527,14 @@ static void close_source(Device *device)
 
 static DeviceError open_source(Device *device)
 {
-    alGenBuffers(OPENAL_BUFS, device->buffers);
+    // pseudo outputs take frames directly, without a source
+    if (audio_state->pseudo[output] != NULL) {
+        return de_None;
+    }
+
+    PlayoutBuffer *playout = &device->playout;
+
+    alGenBuffers(OPENAL_BUFS, playout->buffers);
 
     if (alcGetError(audio_state->al_device[output]) != AL_NO_ERROR) {
         return de_FailedStart;
@@ -384,7 +543,7 @@ static DeviceError open_source(Device *device)
     alGenSources((uint32_t)1, &device->source);
 
     if (alcGetError(audio_state->al_device[output]) != AL_NO_ERROR) {
-        alDeleteBuffers(OPENAL_BUFS, device->buffers);
+        alDeleteBuffers(OPENAL_BUFS, playout->buffers);
         return de_FailedStart;
     }
 
@@ -392,52 +551,58 @@ static DeviceError open_source(Device *device)
 
     alSourcei(device->source, AL_LOOPING, AL_FALSE);
 
-    const uint32_t frame_size = device->frame_info.samples_per_frame * sample_size(device->frame_info.stereo);
-    size_t zeros_size = frame_size * sizeof(uint16_t);
-    uint16_t *zeros = calloc(1, zeros_size);
-
-    if (zeros == NULL) {
-        close_source(device);
-        return de_FailedStart;
-    }
-
-    for (int i = 0; i < OPENAL_BUFS; ++i) {
-        alBufferData(device->buffers[i], sound_mode(device->frame_info.stereo), zeros,
-                     zeros_size, device->frame_info.sample_rate);
-    }
-
-    free(zeros);
-
-    alSourceQueueBuffers(device->source, OPENAL_BUFS, device->buffers);
-    alSourcePlay(device->source);
-
     if (alcGetError(audio_state->al_device[output]) != AL_NO_ERROR) {
         close_source(device);
         return de_FailedStart;
     }
 
+    memcpy(playout->free_buffers, playout->buffers, sizeof(playout->free_buffers));
+    playout->num_free = OPENAL_BUFS;
+    playout->last_frame_samples = 0;
+    playout->last_arrival_usec = 0;
+    playout->jitter_usec = 0.0f;
+    playout->target_depth = PLAYOUT_MIN_DEPTH;
+    playout->conceal_run = 0;
+    playout->prebuffering = true;
+    playout->stats = (AudioPlayoutStats) {
+        0
+    };
+
     return de_None;
 }
 
 DeviceError set_al_device(DeviceType type, int32_t selection)
 {
-    if (audio_state->num_al_devices[type] <= selection || selection < 0) {
+    if (selection_valid(type, selection) != de_None) {
         return de_InvalidSelection;
     }
 
-    const char *name = audio_state->al_device_names[type][selection];
+    if ((uint32_t) selection >= audio_state->num_al_devices[type]) {
+        const PseudoAudioKind kind = pseudo_device_kind(type, selection - audio_state->num_al_devices[type]);
 
-    char **cur_name = &audio_state->current_al_device_name[type];
+        if (pseudo_audio_needs_file(kind) && audio_state->pseudo_file[type] == NULL) {
+            return de_FileError;
+        }
 
-    free(*cur_name);
+        audio_state->pseudo_selected[type] = true;
+        audio_state->pseudo_kind[type] = kind;
+    } else {
+        const char *name = audio_state->al_device_names[type][selection];
 
-    *cur_name = malloc(strlen(name) + 1);
+        char **cur_name = &audio_state->current_al_device_name[type];
 
-    if (*cur_name == NULL) {
-        return de_InternalError;
-    }
+        free(*cur_name);
 
-    strcpy(*cur_name, name);
+        *cur_name = malloc(strlen(name) + 1);
+
+        if (*cur_name == NULL) {
+            return de_InternalError;
+        }
+
+        strcpy(*cur_name, name);
+
+        audio_state->pseudo_selected[type] = false;
+    }
 
     if (audio_state->num_devices[type] > 0) {
         // close any existing al_device and try to open new one, reopening existing sources
@@ -478,6 +643,20 @@ DeviceError set_al_device(DeviceType type, int32_t selection)
     return de_None;
 }
 
+DeviceError set_device_file(DeviceType type, const char *path)
+{
+    char *file = strdup(path);
+
+    if (file == NULL) {
+        return de_InternalError;
+    }
+
+    free(audio_state->pseudo_file[type]);
+    audio_state->pseudo_file[type] = file;
+
+    return de_None;
+}
+
 static DeviceError open_device(DeviceType type, uint32_t *device_idx, DataHandleCallback cb, void *cb_data,
                                uint32_t sample_rate, uint32_t frame_duration, uint8_t channels, double VAD_threshold)
 {
@@ -500,7 +679,7 @@ static DeviceError open_device(DeviceType type, uint32_t *device_idx, DataHandle
 
     lock(type);
 
-    if (audio_state->al_device[type] == NULL) {
+    if (!al_device_open(type)) {
         DeviceError err = open_al_device(type, frame_info);
 
         if (err != de_None) {
@@ -520,16 +699,37 @@ static DeviceError open_device(DeviceType type, uint32_t *device_idx, DataHandle
     device->frame_info = frame_info;
 
     if (type == input) {
-        device->cb = cb;
-        device->cb_data = cb_data;
-#ifdef AUDIO
+        const uint32_t slot_samples = frame_info.samples_per_frame * (frame_info.stereo ? 2 : 1);
+        int16_t *frames = calloc(AUDIO_RING_SLOTS, slot_samples * sizeof(int16_t));
+
+        if (frames == NULL) {
+            device->active = false;
+            --audio_state->num_devices[type];
 
-        if (VAD_threshold >= 0.0) {
-            device->VAD_threshold = VAD_threshold;
+            if (audio_state->num_devices[type] == 0) {
+                close_al_device(type);
+            }
+
+            unlock(type);
+            return de_InternalError;
         }
 
+        free(device->ring.frames);
+        device->ring.frames = frames;
+        device->ring.slot_samples = slot_samples;
+        atomic_store(&device->ring.head, 0);
+        atomic_store(&device->ring.tail, 0);
+        atomic_store(&device->ring.dropped, 0);
+        device->latency = (AudioLatencyStats) {
+            0
+        };
+
+        device->cb = cb;
+        device->cb_data = cb_data;
+#ifdef AUDIO
+        vad_init(&device->vad, VAD_threshold >= 0.0 ? VAD_threshold : 0.0f, frame_duration);
 #else
-        device->VAD_threshold = 0.0f;
+        vad_init(&device->vad, 0.0f, frame_duration);
 #endif
     } else {
         if (open_source(device) != de_None) {
@@ -588,6 +788,166 @@ DeviceError close_device(DeviceType type, uint32_t device_idx)
     return err;
 }
 
+/* Moves every buffer the source has finished playing back to the free list. */
+static void reclaim_buffers(Device *device)
+{
+    PlayoutBuffer *playout = &device->playout;
+
+    ALint processed = 0;
+    alGetSourcei(device->source, AL_BUFFERS_PROCESSED, &processed);
+
+    processed = MIN(processed, (ALint)(OPENAL_BUFS - playout->num_free));
+
+    if (processed > 0) {
+        alSourceUnqueueBuffers(device->source, processed, &playout->free_buffers[playout->num_free]);
+        playout->num_free += processed;
+    }
+}
+
+static uint32_t playout_depth(const PlayoutBuffer *playout)
+{
+    return OPENAL_BUFS - playout->num_free;
+}
+
+static bool queue_playout_frame(Device *device, const int16_t *data, uint32_t sample_count, uint8_t channels,
+                                uint32_t sample_rate)
+{
+    PlayoutBuffer *playout = &device->playout;
+
+    if (playout->num_free == 0) {
+        ++playout->stats.dropped_frames;
+        return false;
+    }
+
+    const ALuint bufid = playout->free_buffers[--playout->num_free];
+    const bool stereo = channels == 2;
+
+    alGetError();  // the error state is sticky, so clear anything left over from an earlier call
+
+    alBufferData(bufid, sound_mode(stereo), data, sample_count * sample_size(stereo), sample_rate);
+
+    if (alGetError() == AL_NO_ERROR) {
+        alSourceQueueBuffers(device->source, 1, &bufid);
+
+        if (alGetError() == AL_NO_ERROR) {
+            return true;
+        }
+    }
+
+    // The buffer was never queued, so it would otherwise be lost to the pool for good
+    playout->free_buffers[playout->num_free++] = bufid;
+    ++playout->stats.dropped_frames;
+
+    return false;
+}
+
+/* Makes sure `last_frame` and `scratch` can each hold `samples` samples.
+ * Only reallocates when a larger frame than any before it arrives.
+ */
+static bool reserve_playout_frames(PlayoutBuffer *playout, size_t samples)
+{
+    if (samples <= playout->frame_capacity) {
+        return true;
+    }
+
+    int16_t *last_frame = realloc(playout->last_frame, samples * sizeof(int16_t));
+
+    if (last_frame == NULL) {
+        return false;
+    }
+
+    playout->last_frame = last_frame;
+
+    int16_t *scratch = realloc(playout->scratch, samples * sizeof(int16_t));
+
+    if (scratch == NULL) {
+        return false;
+    }
+
+    playout->scratch = scratch;
+    playout->frame_capacity = samples;
+
+    return true;
+}
+
+/* Resamples `in_samples` interleaved samples per channel of `in` to `out_samples` per
+ * channel in `out` by linear interpolation. Used to shrink or grow the playout buffer
+ * without audible gaps.
+ */
+static void stretch_frame(const int16_t *in, uint32_t in_samples, int16_t *out, uint32_t out_samples,
+                          uint8_t channels)
+{
+    if (in_samples == 0 || out_samples == 0) {
+        return;
+    }
+
+    const uint64_t span = MAX(out_samples - 1, 1);
+
+    for (uint32_t i = 0; i < out_samples; ++i) {
+        const uint64_t pos = ((uint64_t) i * (in_samples - 1) << 16) / span;
+        const uint32_t idx = (uint32_t)(pos >> 16);
+        const int32_t frac = (int32_t)(pos & 0xFFFF);
+        const uint32_t next = MIN(idx + 1, in_samples - 1);
+
+        for (uint8_t c = 0; c < channels; ++c) {
+            const int32_t a = in[idx * channels + c];
+            const int32_t b = in[next * channels + c];
+            out[i * channels + c] = (int16_t)(a + (((b - a) * frac) >> 16));
+        }
+    }
+}
+
+/* Updates the inter-arrival jitter estimate (as in RFC 3550) and the depth the buffer
+ * should hold to absorb it.
+ */
+static void update_playout_target(PlayoutBuffer *playout, uint64_t frame_usec)
+{
+    const uint64_t now = get_monotonic_time_usec();
+
+    if (playout->last_arrival_usec != 0 && frame_usec > 0) {
+        const uint64_t delta = now - playout->last_arrival_usec;
+        const float deviation = delta > frame_usec ? (float)(delta - frame_usec) : (float)(frame_usec - delta);
+
+        playout->jitter_usec += (deviation - playout->jitter_usec) / 16.0f;
+
+        const uint32_t target = 1 + (uint32_t) ceilf((frame_usec + 2.0f * playout->jitter_usec) / frame_usec);
+        playout->target_depth = MIN(MAX(target, PLAYOUT_MIN_DEPTH), PLAYOUT_MAX_DEPTH);
+    }
+
+    playout->last_arrival_usec = now;
+}
+
+static void start_playout(Device *device)
+{
+    ALint state;
+    alGetSourcei(device->source, AL_SOURCE_STATE, &state);
+
+    if (state != AL_PLAYING) {
+        alSourcePlay(device->source);
+    }
+}
+
+static void update_playout_stats(PlayoutBuffer *playout, uint32_t sample_rate, uint32_t sample_count)
+{
+    const uint32_t depth = playout_depth(playout);
+
+    playout->stats.depth = depth;
+    playout->stats.target_depth = playout->target_depth;
+    playout->stats.jitter_ms = playout->jitter_usec / 1000.0f;
+
+    if (sample_rate > 0) {
+        playout->stats.added_latency_ms = (uint32_t)((uint64_t) depth * sample_count * 1000 / sample_rate);
+    }
+}
+
+static float frame_volume(const int16_t *frame, uint32_t samples, uint8_t channels)
+{
+    AudioLevel level;
+    audio_level_measure(frame, samples, channels, &level);
+
+    return level.volume;
+}
+
 DeviceError write_out(uint32_t device_idx, const int16_t *data, uint32_t sample_count, uint8_t channels,
                       uint32_t sample_rate)
 {
@@ -604,82 +964,442 @@ DeviceError write_out(uint32_t device_idx, const int16_t *data, uint32_t sample_
         return de_DeviceNotActive;
     }
 
-    ALuint bufid;
-    ALint processed, queued;
-    alGetSourcei(device->source, AL_BUFFERS_PROCESSED, &processed);
-    alGetSourcei(device->source, AL_BUFFERS_QUEUED, &queued);
+    if (audio_state->pseudo[output] != NULL) {
+        const bool written = pseudo_audio_write(audio_state->pseudo[output], data, sample_count, channels, sample_rate,
+                                                get_monotonic_time_usec());
+        unlock(output);
+        return written ? de_None : de_FileError;
+    }
 
-    if (audio_state->al_device[output] == NULL || alcGetError(audio_state->al_device[output]) != AL_NO_ERROR) {
+    if (audio_state->al_device[output] == NULL || !device->source_open) {
         unlock(output);
         return de_AlError;
     }
 
-    if (processed) {
-        ALuint *bufids = malloc(processed * sizeof(ALuint));
+    PlayoutBuffer *playout = &device->playout;
 
-        if (bufids == NULL) {
-            unlock(output);
-            return de_InternalError;
-        }
+    reclaim_buffers(device);
 
-        alSourceUnqueueBuffers(device->source, processed, bufids);
-        alDeleteBuffers(processed - 1, bufids + 1);
-        bufid = bufids[0];
-        free(bufids);
-    } else if (queued < 16) {
-        alGenBuffers(1, &bufid);
-    } else {
+    if (alcGetError(audio_state->al_device[output]) != AL_NO_ERROR) {
         unlock(output);
-        return de_Busy;
+        return de_AlError;
     }
 
+    const size_t num_samples = (size_t) sample_count * channels;
+    const uint32_t max_stretch = sample_count + sample_count / PLAYOUT_STRETCH_DIVISOR;
 
-    const bool stereo = channels == 2;
-    alBufferData(bufid, sound_mode(stereo), data,
-                 sample_count * sample_size(stereo),
-                 sample_rate);
-    alSourceQueueBuffers(device->source, 1, &bufid);
+    if (!reserve_playout_frames(playout, (size_t) max_stretch * channels)) {
+        unlock(output);
+        return de_InternalError;
+    }
+
+    const uint64_t frame_usec = sample_rate > 0 ? (uint64_t) sample_count * 1000000 / sample_rate : 0;
+    update_playout_target(playout, frame_usec);
+
+    memcpy(playout->last_frame, data, num_samples * sizeof(int16_t));
+    playout->last_frame_samples = sample_count;
+    playout->last_frame_channels = channels;
+    playout->last_frame_rate = sample_rate;
+    playout->conceal_run = 0;
 
     ALint state;
     alGetSourcei(device->source, AL_SOURCE_STATE, &state);
 
-    if (state != AL_PLAYING) {
-        alSourcePlay(device->source);
+    if (state != AL_PLAYING && !playout->prebuffering) {
+        // The source ran dry; build the buffer back up before resuming playback
+        ++playout->stats.underruns;
+        playout->prebuffering = true;
+    }
+
+    // depth once this frame is queued
+    const uint32_t depth = playout_depth(playout) + 1;
+    const uint32_t target = playout->target_depth;
+    const bool too_deep = depth > target + 1;
+    const bool too_shallow = depth < target && depth > 1;
+
+    DeviceError err = de_None;
+
+    if (!playout->prebuffering && depth > target + 2
+            && frame_volume(data, (uint32_t) num_samples, channels) < PLAYOUT_SILENCE_VOLUME) {
+        // Too much audio queued and this frame is silent; dropping it costs nothing
+        ++playout->stats.dropped_frames;
+    } else if (!playout->prebuffering && (too_deep || too_shallow)) {
+        const uint32_t delta = sample_count / PLAYOUT_STRETCH_DIVISOR;
+        const uint32_t out_samples = too_deep ? sample_count - delta : sample_count + delta;
+
+        stretch_frame(data, sample_count, playout->scratch, out_samples, channels);
+        ++playout->stats.stretched_frames;
+
+        if (!queue_playout_frame(device, playout->scratch, out_samples, channels, sample_rate)) {
+            err = de_Busy;
+        }
+    } else if (!queue_playout_frame(device, data, sample_count, channels, sample_rate)) {
+        err = de_Busy;
+    }
+
+    if (playout->prebuffering && playout_depth(playout) >= playout->target_depth) {
+        playout->prebuffering = false;
+    }
+
+    if (!playout->prebuffering) {
+        start_playout(device);
+    }
+
+    update_playout_stats(playout, sample_rate, sample_count);
+
+    unlock(output);
+    return err;
+}
+
+/*
+ * Conceals a missing frame by replaying the last one received at a decaying volume.
+ */
+static void conceal_frame(Device *device)
+{
+    PlayoutBuffer *playout = &device->playout;
+
+    const uint32_t sample_count = playout->last_frame_samples;
+    const uint8_t channels = playout->last_frame_channels;
+    const size_t num_samples = (size_t) sample_count * channels;
+
+    // halve the volume with each consecutive concealed frame
+    const int shift = (int) playout->conceal_run + 1;
+
+    for (size_t i = 0; i < num_samples; ++i) {
+        playout->scratch[i] = (int16_t)(playout->last_frame[i] >> shift);
+    }
+
+    if (queue_playout_frame(device, playout->scratch, sample_count, channels, playout->last_frame_rate)) {
+        ++playout->stats.concealed_frames;
+        ++playout->conceal_run;
+    }
+}
+
+long int service_output_devices(void)
+{
+    long int next_service = -1;
+
+    if (audio_state == NULL) {
+        return next_service;
+    }
+
+    lock(output);
+
+    if (audio_state->al_device[output] == NULL) {
+        unlock(output);
+        return next_service;
+    }
+
+    for (uint32_t i = 0; i < MAX_DEVICES; ++i) {
+        Device *device = &audio_state->devices[output][i];
+        PlayoutBuffer *playout = &device->playout;
+
+        if (!device->active || !device->source_open || playout->prebuffering
+                || playout->last_frame_samples == 0 || playout->last_frame_rate == 0) {
+            continue;
+        }
+
+        reclaim_buffers(device);
+
+        // Only the frame currently playing is left: conceal the gap before the source runs dry
+        if (playout_depth(playout) <= 1 && playout->conceal_run < PLAYOUT_MAX_CONCEAL && !device->muted) {
+            conceal_frame(device);
+            start_playout(device);
+        }
+
+        update_playout_stats(playout, playout->last_frame_rate, playout->last_frame_samples);
+
+        // Check back twice per frame
+        const long int half_frame = (long int)((uint64_t) playout->last_frame_samples * 500000
+                                               / playout->last_frame_rate);
+
+        if (next_service < 0 || half_frame < next_service) {
+            next_service = half_frame;
+        }
+    }
+
+    unlock(output);
+
+    return next_service;
+}
+
+DeviceError device_get_playout_stats(uint32_t device_idx, AudioPlayoutStats *stats)
+{
+    if (device_idx >= MAX_DEVICES) {
+        return de_InvalidSelection;
+    }
+
+    lock(output);
+
+    const Device *device = &audio_state->devices[output][device_idx];
+
+    if (!device->active) {
+        unlock(output);
+        return de_DeviceNotActive;
     }
 
+    *stats = device->playout.stats;
+
     unlock(output);
     return de_None;
 }
 
+DeviceError device_get_pseudo_stats(DeviceType type, PseudoAudioStats *stats)
+{
+    lock(type);
+
+    if (audio_state->pseudo[type] == NULL) {
+        unlock(type);
+        return de_DeviceNotActive;
+    }
+
+    pseudo_audio_get_stats(audio_state->pseudo[type], stats);
+
+    unlock(type);
+    return de_None;
+}
+
 #ifdef AUDIO
-/* Adapted from qtox,
- * Copyright © 2014-2019 by The qTox Project Contributors
- *
- * return normalized volume of buffer in range 0.0-100.0
- */
-static float volume(int16_t *frame, uint32_t samples)
+static bool audio_ring_push(AudioRing *ring, const int16_t *frame, uint64_t timestamp)
+{
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= AUDIO_RING_SLOTS) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+
+    const uint32_t slot = head % AUDIO_RING_SLOTS;
+
+    memcpy(&ring->frames[slot * ring->slot_samples], frame, ring->slot_samples * sizeof(int16_t));
+    ring->timestamps[slot] = timestamp;
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+/* Returns the oldest queued frame without removing it, or NULL if the ring is empty. */
+static const int16_t *audio_ring_peek(AudioRing *ring, uint64_t *timestamp)
+{
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) {
+        return NULL;
+    }
+
+    const uint32_t slot = tail % AUDIO_RING_SLOTS;
+    *timestamp = ring->timestamps[slot];
+
+    return &ring->frames[slot * ring->slot_samples];
+}
+
+static void audio_ring_pop(AudioRing *ring)
+{
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+static void record_latency(AudioLatencyStats *stats, uint64_t latency_usec)
+{
+    static const uint64_t bounds[AUDIO_LATENCY_NUM_BUCKETS - 1] = AUDIO_LATENCY_BUCKET_BOUNDS;
+
+    size_t bucket = 0;
+
+    while (bucket < AUDIO_LATENCY_NUM_BUCKETS - 1 && latency_usec >= bounds[bucket] * 1000) {
+        ++bucket;
+    }
+
+    ++stats->buckets[bucket];
+    ++stats->frames;
+    stats->total_usec += latency_usec;
+    stats->max_usec = MAX(stats->max_usec, latency_usec);
+}
+
+static uint64_t thread_cpu_usec(void)
+{
+    struct timespec t;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) != 0) {
+        return 0;
+    }
+
+    return (uint64_t) t.tv_sec * 1000000ULL + (uint64_t) t.tv_nsec / 1000ULL;
+}
+
+void send_captured_audio(void)
+{
+    if (audio_state == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < MAX_DEVICES; ++i) {
+        Device *device = &audio_state->devices[input][i];
+
+        if (!device->active) {
+            continue;
+        }
+
+        const int16_t *frame;
+        uint64_t timestamp;
+
+        while ((frame = audio_ring_peek(&device->ring, &timestamp)) != NULL) {
+            if (device->cb) {
+                const uint64_t cpu_start = thread_cpu_usec();
+                device->cb(frame, device->frame_info.samples_per_frame, device->cb_data);
+                device->latency.cpu_usec += thread_cpu_usec() - cpu_start;
+            }
+
+            record_latency(&device->latency, get_monotonic_time_usec() - timestamp);
+            audio_ring_pop(&device->ring);
+        }
+    }
+}
+
+void wait_captured_audio(long int usec)
 {
-    float sum_of_squares = 0;
+    if (audio_state == NULL) {
+        sleep_thread(usec);
+        return;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+
+    deadline.tv_sec += usec / 1000000L;
+    deadline.tv_nsec += (usec % 1000000L) * 1000L;
 
-    for (uint32_t i = 0; i < samples; i++) {
-        const float sample = (float)(frame[i]) / INT16_MAX;
-        sum_of_squares += powf(sample, 2);
+    if (deadline.tv_nsec >= 1000000000L) {
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= 1000000000L;
     }
 
-    const float root_mean_square = sqrtf(sum_of_squares / samples);
-    const float root_two = 1.414213562;
+    pthread_mutex_lock(&audio_state->queue_mutex);
 
-    // normalizedVolume == 1.0 corresponds to a sine wave of maximal amplitude
-    const float normalized_volume = root_mean_square * root_two;
+    while (!audio_state->frames_queued) {
+        if (pthread_cond_timedwait(&audio_state->queue_cond, &audio_state->queue_mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
 
-    return 100.0f * fminf(1.0f, normalized_volume);
+    audio_state->frames_queued = false;
+
+    pthread_mutex_unlock(&audio_state->queue_mutex);
 }
 
-// Time in ms for which we continue to capture audio after VAD is triggered:
-#define VAD_TIME 250
+DeviceError device_get_latency_stats(uint32_t device_idx, AudioLatencyStats *stats)
+{
+    if (device_idx >= MAX_DEVICES) {
+        return de_InvalidSelection;
+    }
+
+    const Device *device = &audio_state->devices[input][device_idx];
+
+    if (!device->active) {
+        return de_DeviceNotActive;
+    }
+
+    *stats = device->latency;
+    stats->dropped_frames = atomic_load_explicit(&device->ring.dropped, memory_order_relaxed);
+
+    return de_None;
+}
 
 #define FRAME_BUF_SIZE 16000
 
+// Shortest time the capture thread sleeps between polls, in microseconds
+#define MIN_CAPTURE_SLEEP 1000L
+
+/*
+ * Hands a captured frame to every input device that wants it.
+ *
+ * Returns true if the frame was queued for at least one device.
+ */
+static bool queue_captured_frame(const int16_t *frame, uint32_t f_size, uint64_t timestamp)
+{
+    const FrameInfo *frame_info = &audio_state->capture_frame_info;
+    const uint8_t channels = frame_info->stereo ? 2 : 1;
+
+    AudioLevel level;
+    audio_level_measure(frame, f_size * channels, channels, &level);
+
+    audio_state->input_volume = level.volume;
+
+    bool queued = false;
+
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        Device *device = &audio_state->devices[input][i];
+
+        if (!device->active || device->muted || device->cb == NULL) {
+            continue;
+        }
+
+        if (!vad_process(&device->vad, &level)) {
+            continue;
+        }
+
+        queued |= audio_ring_push(&device->ring, frame, timestamp);
+    }
+
+    return queued;
+}
+
+static void signal_frames_queued(void)
+{
+    pthread_mutex_lock(&audio_state->queue_mutex);
+    audio_state->frames_queued = true;
+    pthread_cond_signal(&audio_state->queue_cond);
+    pthread_mutex_unlock(&audio_state->queue_mutex);
+}
+
+/*
+ * Generates every frame a pseudo input has due, pacing it as a real capture device would.
+ *
+ * Returns the number of microseconds until the next frame is due.
+ */
+static long int poll_pseudo_input(PseudoAudioDevice *pseudo, int16_t *frame_buf)
+{
+    const FrameInfo *frame_info = &audio_state->capture_frame_info;
+    const uint32_t f_size = frame_info->samples_per_frame;
+    const uint32_t f_samples = f_size * (frame_info->stereo ? 2 : 1);
+    const uint64_t now = get_monotonic_time_usec();
+
+    if (f_samples > FRAME_BUF_SIZE) {
+        return MIN_CAPTURE_SLEEP;
+    }
+
+    // Don't try to catch up on more frames than the rings can hold, e.g. after a stall
+    if (now >= pseudo_audio_next_frame_time(pseudo, f_size * AUDIO_RING_SLOTS)) {
+        pseudo_audio_resync(pseudo, now);
+    }
+
+    bool queued = false;
+
+    while (now >= pseudo_audio_next_frame_time(pseudo, f_size)) {
+        if (!pseudo_audio_read(pseudo, frame_buf, f_size)) {
+            pseudo_audio_resync(pseudo, now);
+            break;
+        }
+
+        queued |= queue_captured_frame(frame_buf, f_size, now);
+    }
+
+    if (queued) {
+        signal_frames_queued();
+    }
+
+    const uint64_t next_frame = pseudo_audio_next_frame_time(pseudo, f_size);
+
+    return next_frame > now ? (long int)(next_frame - now) : 0;
+}
+
+/*
+ * Capture thread. Pulls frames off the capture device as soon as they are complete and
+ * queues them for the AV thread, which sends them. This thread never takes the Winthread
+ * lock, so a busy UI can't delay capture.
+ */
 static void *poll_input(void *arg)
 {
     UNUSED_VAR(arg);
@@ -705,50 +1425,43 @@ static void *poll_input(void *arg)
             continue;
         }
 
+        long int sleep_duration = MIN_CAPTURE_SLEEP;
+
         if (audio_state->al_device[input] != NULL) {
+            const FrameInfo *frame_info = &audio_state->capture_frame_info;
+            const uint32_t f_size = frame_info->samples_per_frame;
+            const uint32_t f_samples = f_size * (frame_info->stereo ? 2 : 1);
+
             int32_t available_samples;
             alcGetIntegerv(audio_state->al_device[input], ALC_CAPTURE_SAMPLES, sizeof(int32_t), &available_samples);
 
-            const uint32_t f_size = audio_state->capture_frame_info.samples_per_frame;
+            bool queued = false;
 
-            if (available_samples >= f_size && f_size <= FRAME_BUF_SIZE) {
+            while (available_samples >= f_size && f_samples <= FRAME_BUF_SIZE) {
                 alcCaptureSamples(audio_state->al_device[input], frame_buf, f_size);
+                available_samples -= f_size;
 
-                unlock(input);
-                pthread_mutex_lock(&Winthread.lock);
-                lock(input);
-
-                float frame_volume = volume(frame_buf, f_size);
-
-                audio_state->input_volume = frame_volume;
-
-                for (int i = 0; i < MAX_DEVICES; i++) {
-                    Device *device = &audio_state->devices[input][i];
-
-                    if (device->VAD_threshold != 0.0f) {
-                        if (frame_volume >= device->VAD_threshold) {
-                            device->VAD_samples_remaining = VAD_TIME * (audio_state->capture_frame_info.sample_rate / 1000);
-                        } else if (device->VAD_samples_remaining < f_size) {
-                            continue;
-                        } else {
-                            device->VAD_samples_remaining -= f_size;
-                        }
-                    }
+                queued |= queue_captured_frame(frame_buf, f_size, get_monotonic_time_usec());
+            }
 
-                    if (device->active && !device->muted && device->cb) {
-                        device->cb(frame_buf, f_size, device->cb_data);
-                    }
-                }
+            if (queued) {
+                signal_frames_queued();
+            }
 
-                pthread_mutex_unlock(&Winthread.lock);
+            // Sleep until the next frame should be complete
+            if (available_samples < f_size && frame_info->sample_rate > 0) {
+                const uint64_t missing_samples = f_size - MAX(available_samples, 0);
+                sleep_duration = (long int)(missing_samples * 1000000 / frame_info->sample_rate);
             }
+        } else if (audio_state->pseudo[input] != NULL) {
+            sleep_duration = poll_pseudo_input(audio_state->pseudo[input], frame_buf);
         }
 
         unlock(input);
-        sleep_thread(5000L);
+        sleep_thread(MAX(sleep_duration, MIN_CAPTURE_SLEEP));
     }
 
-    pthread_exit(NULL);
+    return NULL;
 }
 
 #endif
@@ -757,7 +1470,7 @@ float get_input_volume(void)
 {
     float ret = 0.0f;
 
-    if (audio_state->al_device[input] != NULL) {
+    if (al_device_open(input)) {
         lock(input);
         ret = audio_state->input_volume;
         unlock(input);
@@ -768,17 +1481,31 @@ float get_input_volume(void)
 
 void print_al_devices(ToxWindow *self, const Client_Config *c_config, DeviceType type)
 {
+    const bool pseudo_selected = audio_state->pseudo_selected[type];
+
     for (int i = 0; i < audio_state->num_al_devices[type]; ++i) {
         line_info_add(self, c_config, false, NULL, NULL, SYS_MSG,
-                      audio_state->current_al_device_name[type]
+                      !pseudo_selected && audio_state->current_al_device_name[type]
                       && strcmp(audio_state->current_al_device_name[type], audio_state->al_device_names[type][i]) == 0 ? 1 : 0,
                       0, "%d: %s", i, audio_state->al_device_names[type][i]);
     }
 
+    for (uint32_t i = 0; i < num_pseudo_devices(type); ++i) {
+        const PseudoAudioKind kind = pseudo_device_kind(type, i);
+        const char *file = pseudo_audio_needs_file(kind) && audio_state->pseudo_file[type] != NULL
+                           ? audio_state->pseudo_file[type] : "";
+
+        line_info_add(self, c_config, false, NULL, NULL, SYS_MSG,
+                      pseudo_selected && audio_state->pseudo_kind[type] == kind ? 1 : 0,
+                      0, "%u: %s %s", audio_state->num_al_devices[type] + i, pseudo_audio_name(kind), file);
+    }
+
     return;
 }
 
 DeviceError selection_valid(DeviceType type, int32_t selection)
 {
-    return (audio_state->num_al_devices[type] <= selection || selection < 0) ? de_InvalidSelection : de_None;
+    const int64_t num_selections = (int64_t) audio_state->num_al_devices[type] + num_pseudo_devices(type);
+
+    return (num_selections <= selection || selection < 0) ? de_InvalidSelection : de_None;
 }
@@ -29,10 +29,12 @@
 #ifndef AUDIO_DEVICE_H
 #define AUDIO_DEVICE_H
 
-#define OPENAL_BUFS 5
+/* Number of AL buffers each output device recycles for playback */
+#define OPENAL_BUFS 16
 #define MAX_OPENAL_DEVICES 32
 #define MAX_DEVICES 32
 
+#include "audio_pseudo_device.h"
 #include "settings.h"
 #include "windows.h"
 
@@ -52,10 +54,41 @@ typedef enum DeviceError {
     de_BufferError = -7,
     de_UnsupportedMode = -8,
     de_AlError = -9,
+    de_FileError = -10,
 } DeviceError;
 
 typedef void (*DataHandleCallback)(const int16_t *, uint32_t size, void *data);
 
+/* Upper bounds in milliseconds of each capture latency histogram bucket. The last
+ * bucket holds every frame that took longer than the largest bound.
+ */
+#define AUDIO_LATENCY_BUCKET_BOUNDS {1, 2, 5, 10, 20, 50, 100, 200}
+#define AUDIO_LATENCY_NUM_BUCKETS 9
+
+/* Time from a frame being pulled off the capture device to it being handed to the
+ * input device's callback.
+ */
+typedef struct AudioLatencyStats {
+    uint64_t buckets[AUDIO_LATENCY_NUM_BUCKETS];
+    uint64_t frames;
+    uint64_t dropped_frames;  /* Frames discarded because the send side fell behind */
+    uint64_t total_usec;
+    uint64_t max_usec;
+    uint64_t cpu_usec;        /* CPU time spent in the callback encoding and sending frames */
+} AudioLatencyStats;
+
+/* State of an output device's adaptive playout buffer. */
+typedef struct AudioPlayoutStats {
+    uint32_t depth;             /* Frames currently queued for playback */
+    uint32_t target_depth;      /* Depth the buffer is adapting towards */
+    uint32_t added_latency_ms;  /* Playback delay introduced by the queued frames */
+    float jitter_ms;            /* Smoothed inter-arrival jitter */
+    uint64_t underruns;
+    uint64_t concealed_frames;
+    uint64_t stretched_frames;
+    uint64_t dropped_frames;
+} AudioPlayoutStats;
+
 
 DeviceError init_devices(void);
 
@@ -73,8 +106,21 @@ float device_get_VAD_threshold(uint32_t device_idx);
 
 DeviceError set_source_position(uint32_t device_idx, float x, float y, float z);
 
+/*
+ * Selects the al_device used by every virtual device of `type`. Selections past the last
+ * OpenAL device pick a pseudo device instead (see audio_pseudo_device.h).
+ *
+ * Returns de_FileError if a file pseudo device is selected before its file is set.
+ */
 DeviceError set_al_device(DeviceType type, int32_t selection);
 
+/*
+ * Sets the WAV file read by the file input pseudo device (`type` input) or written by
+ * the file output pseudo device (`type` output). Takes effect the next time the device
+ * is selected.
+ */
+DeviceError set_device_file(DeviceType type, const char *path);
+
 /* Start device */
 DeviceError open_input_device(uint32_t *device_idx, DataHandleCallback cb, void *cb_data,
                               uint32_t sample_rate, uint32_t frame_duration, uint8_t channels, double VAD_threshold);
@@ -84,13 +130,55 @@ DeviceError open_output_device(uint32_t *device_idx, uint32_t sample_rate, uint3
 /* Stop device */
 DeviceError close_device(DeviceType type, uint32_t device_idx);
 
-/* Write data to output device */
+/* Write data to output device. Frames pass through the device's adaptive playout buffer,
+ * which may stretch, compress or drop them to absorb network jitter.
+ */
 DeviceError write_out(uint32_t device_idx, const int16_t *data, uint32_t length, uint8_t channels,
                       uint32_t sample_rate);
 
 /* return current input volume as float in range 0.0-100.0 */
 float get_input_volume(void);
 
+/*
+ * Passes every frame queued by the capture thread to its input device's callback.
+ *
+ * Must be called with the Winthread lock held, as the callbacks use the tox and
+ * toxav instances. Input devices are only opened and closed under the same lock.
+ */
+void send_captured_audio(void);
+
+/*
+ * Blocks the caller until the capture thread queues a frame or `usec` microseconds
+ * have elapsed, whichever comes first.
+ */
+void wait_captured_audio(long int usec);
+
+/*
+ * Conceals missing frames on output devices whose playout buffer is about to run dry.
+ *
+ * Returns the number of microseconds after which it should be called again, or -1 if
+ * no output device is playing.
+ */
+long int service_output_devices(void);
+
+/*
+ * Copies the playout buffer statistics of output device `device_idx` to `stats`.
+ */
+DeviceError device_get_playout_stats(uint32_t device_idx, AudioPlayoutStats *stats);
+
+/*
+ * Copies the capture latency statistics of input device `device_idx` to `stats`.
+ *
+ * Must be called with the Winthread lock held.
+ */
+DeviceError device_get_latency_stats(uint32_t device_idx, AudioLatencyStats *stats);
+
+/*
+ * Copies the statistics of the pseudo device in use as the input or output al_device to
+ * `stats`. Returns de_DeviceNotActive if no pseudo device of `type` is open.
+ */
+DeviceError device_get_pseudo_stats(DeviceType type, PseudoAudioStats *stats);
+
 void print_al_devices(ToxWindow *self, const Client_Config *c_config, DeviceType type);
 
 DeviceError selection_valid(DeviceType type, int32_t selection);
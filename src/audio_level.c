@@ -0,0 +1,173 @@
+/*  audio_level.c
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+#include "audio_level.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* __SSE2__ */
+
+/* Zero crossing rate above which a quiet frame is treated as noise rather than voiced speech */
+#define VAD_VOICED_MAX_ZCR 0.25f
+
+/* Largest number of vector iterations before the 16-bit zero crossing counters must be flushed */
+#define ZC_FLUSH_INTERVAL 16384
+
+void audio_level_measure(const int16_t *frame, uint32_t samples, uint8_t channels, AudioLevel *level)
+{
+    *level = (AudioLevel) {
+        0
+    };
+
+    if (frame == NULL || samples == 0 || channels == 0) {
+        return;
+    }
+
+    uint64_t sum_of_squares = 0;
+    int32_t max_sample = 0;
+    int32_t min_sample = 0;
+    uint64_t crossings = 0;
+    uint32_t i = 0;
+
+#ifdef __SSE2__
+    // Each iteration reads 8 samples plus the 8 samples `channels` further on for zero crossings
+    if (samples >= 8 + (uint32_t) channels) {
+        const uint32_t vec_end = samples - 8 - channels;
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sq_acc = zero;
+        __m128i max_acc = zero;
+        __m128i min_acc = zero;
+        __m128i zc_acc = zero;
+        uint32_t zc_iterations = 0;
+
+        for (; i <= vec_end; i += 8) {
+            const __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(frame + i));
+            const __m128i next = _mm_loadu_si128((const __m128i *)(const void *)(frame + i + channels));
+
+            // Pairwise sums of squares fit in an unsigned 32-bit lane; widen before accumulating
+            const __m128i sq = _mm_madd_epi16(v, v);
+            sq_acc = _mm_add_epi64(sq_acc, _mm_unpacklo_epi32(sq, zero));
+            sq_acc = _mm_add_epi64(sq_acc, _mm_unpackhi_epi32(sq, zero));
+
+            max_acc = _mm_max_epi16(max_acc, v);
+            min_acc = _mm_min_epi16(min_acc, v);
+
+            // Sign bits differ between a sample and the next one in its channel: the mask is -1
+            const __m128i crossed = _mm_srai_epi16(_mm_xor_si128(v, next), 15);
+            zc_acc = _mm_sub_epi16(zc_acc, crossed);
+
+            if (++zc_iterations == ZC_FLUSH_INTERVAL) {
+                int16_t lanes[8];
+                _mm_storeu_si128((__m128i *)(void *) lanes, zc_acc);
+
+                for (int j = 0; j < 8; ++j) {
+                    crossings += (uint16_t) lanes[j];
+                }
+
+                zc_acc = zero;
+                zc_iterations = 0;
+            }
+        }
+
+        uint64_t sq_lanes[2];
+        int16_t max_lanes[8];
+        int16_t min_lanes[8];
+        int16_t zc_lanes[8];
+
+        _mm_storeu_si128((__m128i *)(void *) sq_lanes, sq_acc);
+        _mm_storeu_si128((__m128i *)(void *) max_lanes, max_acc);
+        _mm_storeu_si128((__m128i *)(void *) min_lanes, min_acc);
+        _mm_storeu_si128((__m128i *)(void *) zc_lanes, zc_acc);
+
+        sum_of_squares = sq_lanes[0] + sq_lanes[1];
+
+        for (int j = 0; j < 8; ++j) {
+            max_sample = max_lanes[j] > max_sample ? max_lanes[j] : max_sample;
+            min_sample = min_lanes[j] < min_sample ? min_lanes[j] : min_sample;
+            crossings += (uint16_t) zc_lanes[j];
+        }
+    }
+
+#endif /* __SSE2__ */
+
+    // Branchless so the compiler can vectorize it where SSE2 isn't available
+    const uint32_t pair_end = samples > channels ? samples - channels : 0;
+
+    for (; i < pair_end; ++i) {
+        const int32_t sample = frame[i];
+
+        sum_of_squares += (uint32_t)(sample * sample);
+        max_sample = sample > max_sample ? sample : max_sample;
+        min_sample = sample < min_sample ? sample : min_sample;
+        crossings += (uint32_t)(((sample ^ frame[i + channels]) >> 31) & 1);
+    }
+
+    for (; i < samples; ++i) {
+        const int32_t sample = frame[i];
+
+        sum_of_squares += (uint32_t)(sample * sample);
+        max_sample = sample > max_sample ? sample : max_sample;
+        min_sample = sample < min_sample ? sample : min_sample;
+    }
+
+    /* Normalization adapted from qtox,
+     * Copyright © 2014-2019 by The qTox Project Contributors
+     */
+    const float root_mean_square = sqrtf((float) sum_of_squares / samples) / INT16_MAX;
+    const float root_two = 1.414213562;
+
+    // normalized volume == 1.0 corresponds to a sine wave of maximal amplitude
+    const float normalized_volume = root_mean_square * root_two;
+
+    const int32_t peak = -min_sample > max_sample ? -min_sample : max_sample;
+
+    level->volume = 100.0f * fminf(1.0f, normalized_volume);
+    level->peak = 100.0f * fminf(1.0f, (float) peak / INT16_MAX);
+
+    const uint32_t pairs = samples > channels ? samples - channels : 0;
+
+    if (pairs > 0) {
+        level->zcr = (float) crossings / pairs;
+    }
+}
+
+void vad_init(VoiceDetector *vad, float threshold, uint32_t frame_duration)
+{
+    *vad = (VoiceDetector) {
+        0
+    };
+
+    vad->threshold = threshold > 0.0f ? threshold : 0.0f;
+    vad->hangover_frames = frame_duration > 0 ? (VAD_HANGOVER_TIME + frame_duration - 1) / frame_duration : 0;
+}
+
+bool vad_process(VoiceDetector *vad, const AudioLevel *level)
+{
+    if (vad->threshold == 0.0f) {
+        vad->active = true;
+        return true;
+    }
+
+    const bool loud = level->volume >= vad->threshold;
+    const bool voiced = level->volume >= vad->threshold / 2.0f && level->zcr <= VAD_VOICED_MAX_ZCR;
+
+    if (loud || voiced) {
+        vad->hangover_remaining = vad->hangover_frames;
+        vad->active = true;
+    } else if (vad->hangover_remaining > 0) {
+        --vad->hangover_remaining;
+        vad->active = true;
+    } else {
+        vad->active = false;
+    }
+
+    return vad->active;
+}
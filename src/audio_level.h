@@ -0,0 +1,61 @@
+/*  audio_level.h
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+#ifndef AUDIO_LEVEL_H
+#define AUDIO_LEVEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Time in ms for which voice activity is held after the last frame containing speech */
+#define VAD_HANGOVER_TIME 250
+
+typedef struct AudioLevel {
+    float volume;  /* RMS level normalized to 0.0-100.0, where 100.0 is a full scale sine wave */
+    float peak;    /* Largest absolute sample as a percentage of full scale */
+    float zcr;     /* Zero crossings per sample pair, per channel, in range 0.0-1.0 */
+} AudioLevel;
+
+typedef struct VoiceDetector {
+    float threshold;            /* Volume at or above which a frame counts as speech. 0.0 disables detection */
+    uint32_t hangover_frames;   /* Number of frames VAD_HANGOVER_TIME spans */
+    uint32_t hangover_remaining;
+    bool active;
+} VoiceDetector;
+
+/*
+ * Measures the level of `samples` interleaved samples in `frame` in a single pass.
+ */
+void audio_level_measure(const int16_t *frame, uint32_t samples, uint8_t channels, AudioLevel *level);
+
+/*
+ * Initializes `vad` for frames of `frame_duration` ms. A threshold of 0.0 passes every frame.
+ */
+void vad_init(VoiceDetector *vad, float threshold, uint32_t frame_duration);
+
+/*
+ * Feeds the level of the next frame to `vad`.
+ *
+ * A frame counts as speech if its volume reaches the threshold, or if it reaches half the
+ * threshold with a zero crossing rate low enough to be voiced; broadband noise crosses zero
+ * far more often than speech does. Voice activity is held for VAD_HANGOVER_TIME after the
+ * last speech frame so trailing syllables aren't clipped.
+ *
+ * Returns true if the frame should be transmitted.
+ */
+bool vad_process(VoiceDetector *vad, const AudioLevel *level);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif /* __cplusplus */
+
+#endif /* AUDIO_LEVEL_H */
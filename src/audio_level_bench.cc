@@ -0,0 +1,90 @@
+/* Microbenchmark for the per-frame capture level and VAD cost.
+ *
+ * Compares the previous float volume() loop with audio_level_measure() on typical
+ * 20ms call frames. Run with an optional iteration count.
+ */
+
+#include "audio_level.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+// The volume() implementation audio_level_measure() replaced
+float legacy_volume(const int16_t *frame, uint32_t samples)
+{
+    float sum_of_squares = 0;
+
+    for (uint32_t i = 0; i < samples; i++) {
+        const float sample = (float)(frame[i]) / INT16_MAX;
+        sum_of_squares += powf(sample, 2);
+    }
+
+    const float root_mean_square = sqrtf(sum_of_squares / samples);
+    const float root_two = 1.414213562;
+
+    return 100.0f * fminf(1.0f, root_mean_square * root_two);
+}
+
+template <typename Fn>
+double ns_per_frame(uint32_t iterations, Fn &&fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+volatile float sink;
+
+void run(const char *label, uint32_t samples_per_frame, uint8_t channels, uint32_t iterations)
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> dist(INT16_MIN, INT16_MAX);
+    std::vector<int16_t> frame(samples_per_frame * channels);
+
+    for (int16_t &sample : frame) {
+        sample = static_cast<int16_t>(dist(rng));
+    }
+
+    const uint32_t samples = frame.size();
+
+    const double legacy = ns_per_frame(iterations, [&] {
+        sink = legacy_volume(frame.data(), samples);
+    });
+
+    VoiceDetector vad;
+    vad_init(&vad, 5.0f, 20);
+
+    const double fused = ns_per_frame(iterations, [&] {
+        AudioLevel level;
+        audio_level_measure(frame.data(), samples, channels, &level);
+        sink = vad_process(&vad, &level) ? level.volume : 0.0f;
+    });
+
+    printf("%-22s legacy %9.1f ns/frame   fused+VAD %9.1f ns/frame   speedup %5.1fx\n",
+           label, legacy, fused, legacy / fused);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const uint32_t iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+
+    run("48kHz mono 20ms", 960, 1, iterations);
+    run("48kHz stereo 20ms", 960, 2, iterations);
+    run("48kHz mono 60ms", 2880, 1, iterations);
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "audio_level.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr uint32_t kFrameSamples = 960;  // 20ms at 48kHz
+
+std::vector<int16_t> sine(double frequency, double amplitude, uint32_t samples, uint8_t channels = 1)
+{
+    std::vector<int16_t> frame(samples * channels);
+
+    for (uint32_t i = 0; i < samples; ++i) {
+        const double value = amplitude * INT16_MAX * std::sin(2.0 * M_PI * frequency * i / kSampleRate);
+
+        for (uint8_t c = 0; c < channels; ++c) {
+            frame[i * channels + c] = static_cast<int16_t>(value);
+        }
+    }
+
+    return frame;
+}
+
+float reference_volume(const std::vector<int16_t> &frame)
+{
+    float sum_of_squares = 0;
+
+    for (int16_t sample : frame) {
+        const float normalized = static_cast<float>(sample) / INT16_MAX;
+        sum_of_squares += normalized * normalized;
+    }
+
+    return 100.0f * std::fmin(1.0f, std::sqrt(sum_of_squares / frame.size()) * 1.414213562f);
+}
+
+TEST(AudioLevel, SilenceIsZero)
+{
+    std::vector<int16_t> frame(kFrameSamples, 0);
+    AudioLevel level;
+    audio_level_measure(frame.data(), frame.size(), 1, &level);
+
+    EXPECT_EQ(level.volume, 0.0f);
+    EXPECT_EQ(level.peak, 0.0f);
+    EXPECT_EQ(level.zcr, 0.0f);
+}
+
+TEST(AudioLevel, MatchesFloatReference)
+{
+    for (double amplitude : {0.01, 0.1, 0.5, 1.0}) {
+        const std::vector<int16_t> frame = sine(440.0, amplitude, kFrameSamples);
+        AudioLevel level;
+        audio_level_measure(frame.data(), frame.size(), 1, &level);
+
+        EXPECT_NEAR(level.volume, reference_volume(frame), 0.01f) << "amplitude " << amplitude;
+        EXPECT_NEAR(level.peak, 100.0 * amplitude, 0.1) << "amplitude " << amplitude;
+    }
+}
+
+TEST(AudioLevel, FullScaleNegativePeak)
+{
+    std::vector<int16_t> frame(kFrameSamples, 0);
+    frame[17] = INT16_MIN;
+    AudioLevel level;
+    audio_level_measure(frame.data(), frame.size(), 1, &level);
+
+    EXPECT_EQ(level.peak, 100.0f);
+}
+
+TEST(AudioLevel, OddLengthsMatchReference)
+{
+    for (uint32_t samples : {1u, 7u, 9u, 15u, 17u, 961u}) {
+        const std::vector<int16_t> frame = sine(1000.0, 0.3, samples);
+        AudioLevel level;
+        audio_level_measure(frame.data(), frame.size(), 1, &level);
+
+        EXPECT_NEAR(level.volume, reference_volume(frame), 0.01f) << samples << " samples";
+    }
+}
+
+TEST(AudioLevel, ZeroCrossingRateTracksFrequency)
+{
+    // A sine wave crosses zero twice per period
+    const std::vector<int16_t> frame = sine(1200.0, 0.5, kFrameSamples);
+    AudioLevel level;
+    audio_level_measure(frame.data(), frame.size(), 1, &level);
+
+    EXPECT_NEAR(level.zcr, 2.0 * 1200.0 / kSampleRate, 0.005);
+}
+
+TEST(AudioLevel, StereoCrossingsArePerChannel)
+{
+    const std::vector<int16_t> frame = sine(1200.0, 0.5, kFrameSamples, 2);
+    AudioLevel level;
+    audio_level_measure(frame.data(), frame.size(), 2, &level);
+
+    EXPECT_NEAR(level.zcr, 2.0 * 1200.0 / kSampleRate, 0.005);
+}
+
+TEST(VoiceDetector, ZeroThresholdPassesEverything)
+{
+    VoiceDetector vad;
+    vad_init(&vad, 0.0f, 20);
+
+    const AudioLevel silence = {0.0f, 0.0f, 0.0f};
+    EXPECT_TRUE(vad_process(&vad, &silence));
+}
+
+TEST(VoiceDetector, HoldsActivityForHangover)
+{
+    VoiceDetector vad;
+    vad_init(&vad, 10.0f, 20);
+
+    const AudioLevel speech = {30.0f, 50.0f, 0.05f};
+    const AudioLevel silence = {0.0f, 0.0f, 0.0f};
+
+    EXPECT_FALSE(vad_process(&vad, &silence));
+    EXPECT_TRUE(vad_process(&vad, &speech));
+
+    const uint32_t hangover_frames = (VAD_HANGOVER_TIME + 19) / 20;
+
+    for (uint32_t i = 0; i < hangover_frames; ++i) {
+        EXPECT_TRUE(vad_process(&vad, &silence)) << "frame " << i;
+    }
+
+    EXPECT_FALSE(vad_process(&vad, &silence));
+}
+
+TEST(VoiceDetector, QuietVoicedFramesPassButNoiseDoesNot)
+{
+    VoiceDetector vad;
+    vad_init(&vad, 10.0f, 20);
+
+    const AudioLevel hiss = {6.0f, 20.0f, 0.6f};
+    const AudioLevel voiced = {6.0f, 20.0f, 0.05f};
+
+    EXPECT_FALSE(vad_process(&vad, &hiss));
+    EXPECT_TRUE(vad_process(&vad, &voiced));
+}
+
+}  // namespace
@@ -0,0 +1,521 @@
+/*  audio_mixer.c
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+#include "audio_mixer.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_level.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* __SSE2__ */
+
+/* Number of output frames of audio queued per input before the oldest samples are dropped.
+ * Holds the largest 120ms Opus frame a peer may send with room to spare.
+ */
+#define MIXER_QUEUE_FRAMES 8
+
+/* Number of consecutive mixes an input may miss before the mixer stops waiting for it */
+#define MIXER_MAX_MISSED 2
+
+/* Volume below which a frame is skipped as silence. Kept low so quiet speakers aren't cut */
+#define MIXER_SPEECH_THRESHOLD 1.0f
+
+/* Gains are applied as Q13 fixed point, so the largest gain of 2.0 still fits an int16_t */
+#define GAIN_SHIFT 13
+#define GAIN_UNITY (1 << GAIN_SHIFT)
+
+#define QUARTER_PI 0.78539816f
+
+typedef struct MixerInput {
+    bool used;
+    bool muted;
+    bool speaking;
+    uint32_t missed;
+
+    float gain;
+    float pan;
+
+    /* Gains applied to the mono and the left/right output */
+    int16_t mono_gain;
+    int16_t left_gain;
+    int16_t right_gain;
+
+    VoiceDetector vad;
+
+    /* Ring of mono samples. Peers may send any frame size; the mixer takes whole output frames */
+    int16_t *queue;
+    uint32_t head;
+    uint32_t count;
+} MixerInput;
+
+struct AudioMixer {
+    uint32_t sample_rate;
+    uint32_t frame_samples;
+    bool panning;
+
+    MixerInput *inputs;
+    uint32_t max_inputs;
+
+    int32_t *accumulator;   /* frame_samples * 2 */
+    int16_t *output;        /* frame_samples * 2 */
+    int16_t *frame;         /* frame_samples */
+
+    AudioMixerStats stats;
+};
+
+static int16_t to_fixed_gain(float gain)
+{
+    return (int16_t) lrintf(gain * GAIN_UNITY);
+}
+
+/* Constant power pan law: the left and right gains trace a quarter circle, so a peer
+ * sounds equally loud wherever it's placed.
+ */
+static void update_gains(MixerInput *in)
+{
+    const float angle = (in->pan + 1.0f) * QUARTER_PI;
+
+    in->mono_gain = to_fixed_gain(in->gain);
+    in->left_gain = to_fixed_gain(in->gain * cosf(angle));
+    in->right_gain = to_fixed_gain(in->gain * sinf(angle));
+}
+
+static MixerInput *get_input(const AudioMixer *mixer, int32_t input)
+{
+    if (mixer == NULL || input < 0 || (uint32_t) input >= mixer->max_inputs || !mixer->inputs[input].used) {
+        return NULL;
+    }
+
+    return &mixer->inputs[input];
+}
+
+AudioMixer *audio_mixer_new(uint32_t sample_rate, uint32_t frame_samples)
+{
+    if (sample_rate == 0 || frame_samples == 0) {
+        return NULL;
+    }
+
+    AudioMixer *mixer = calloc(1, sizeof(AudioMixer));
+
+    if (mixer == NULL) {
+        return NULL;
+    }
+
+    mixer->sample_rate = sample_rate;
+    mixer->frame_samples = frame_samples;
+    mixer->accumulator = malloc(frame_samples * 2 * sizeof(int32_t));
+    mixer->output = malloc(frame_samples * 2 * sizeof(int16_t));
+    mixer->frame = malloc(frame_samples * sizeof(int16_t));
+
+    if (mixer->accumulator == NULL || mixer->output == NULL || mixer->frame == NULL) {
+        audio_mixer_free(mixer);
+        return NULL;
+    }
+
+    return mixer;
+}
+
+void audio_mixer_free(AudioMixer *mixer)
+{
+    if (mixer == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < mixer->max_inputs; ++i) {
+        free(mixer->inputs[i].queue);
+    }
+
+    free(mixer->inputs);
+    free(mixer->accumulator);
+    free(mixer->output);
+    free(mixer->frame);
+    free(mixer);
+}
+
+int32_t audio_mixer_add_input(AudioMixer *mixer)
+{
+    if (mixer == NULL) {
+        return -1;
+    }
+
+    uint32_t i = 0;
+
+    while (i < mixer->max_inputs && mixer->inputs[i].used) {
+        ++i;
+    }
+
+    if (i == mixer->max_inputs) {
+        if (mixer->max_inputs >= INT32_MAX / 2) {
+            return -1;
+        }
+
+        const uint32_t new_max = mixer->max_inputs == 0 ? 8 : mixer->max_inputs * 2;
+        MixerInput *tmp = realloc(mixer->inputs, new_max * sizeof(MixerInput));
+
+        if (tmp == NULL) {
+            return -1;
+        }
+
+        memset(&tmp[mixer->max_inputs], 0, (new_max - mixer->max_inputs) * sizeof(MixerInput));
+        mixer->inputs = tmp;
+        mixer->max_inputs = new_max;
+    }
+
+    int16_t *queue = malloc((size_t) MIXER_QUEUE_FRAMES * mixer->frame_samples * sizeof(int16_t));
+
+    if (queue == NULL) {
+        return -1;
+    }
+
+    MixerInput *in = &mixer->inputs[i];
+
+    *in = (MixerInput) {
+        .used = true,
+        .gain = 1.0f,
+        .queue = queue,
+    };
+
+    vad_init(&in->vad, MIXER_SPEECH_THRESHOLD, mixer->frame_samples * 1000 / mixer->sample_rate);
+    update_gains(in);
+
+    return (int32_t) i;
+}
+
+void audio_mixer_remove_input(AudioMixer *mixer, int32_t input)
+{
+    MixerInput *in = get_input(mixer, input);
+
+    if (in == NULL) {
+        return;
+    }
+
+    free(in->queue);
+
+    *in = (MixerInput) {
+        .used = false
+    };
+}
+
+void audio_mixer_set_gain(AudioMixer *mixer, int32_t input, float gain)
+{
+    MixerInput *in = get_input(mixer, input);
+
+    if (in == NULL) {
+        return;
+    }
+
+    in->gain = fminf(fmaxf(gain, 0.0f), AUDIO_MIXER_MAX_GAIN);
+    update_gains(in);
+}
+
+float audio_mixer_get_gain(const AudioMixer *mixer, int32_t input)
+{
+    const MixerInput *in = get_input(mixer, input);
+
+    return in != NULL ? in->gain : 0.0f;
+}
+
+void audio_mixer_set_muted(AudioMixer *mixer, int32_t input, bool muted)
+{
+    MixerInput *in = get_input(mixer, input);
+
+    if (in != NULL) {
+        in->muted = muted;
+    }
+}
+
+bool audio_mixer_is_muted(const AudioMixer *mixer, int32_t input)
+{
+    const MixerInput *in = get_input(mixer, input);
+
+    return in != NULL && in->muted;
+}
+
+void audio_mixer_set_pan(AudioMixer *mixer, int32_t input, float pan)
+{
+    MixerInput *in = get_input(mixer, input);
+
+    if (in == NULL) {
+        return;
+    }
+
+    in->pan = fminf(fmaxf(pan, -1.0f), 1.0f);
+    update_gains(in);
+}
+
+void audio_mixer_set_panning(AudioMixer *mixer, bool enabled)
+{
+    if (mixer != NULL) {
+        mixer->panning = enabled;
+    }
+}
+
+bool audio_mixer_get_panning(const AudioMixer *mixer)
+{
+    return mixer != NULL && mixer->panning;
+}
+
+bool audio_mixer_is_speaking(const AudioMixer *mixer, int32_t input)
+{
+    const MixerInput *in = get_input(mixer, input);
+
+    return in != NULL && in->speaking;
+}
+
+static uint32_t queue_capacity(const AudioMixer *mixer)
+{
+    return MIXER_QUEUE_FRAMES * mixer->frame_samples;
+}
+
+bool audio_mixer_push(AudioMixer *mixer, int32_t input, const int16_t *pcm, uint32_t samples, uint8_t channels)
+{
+    MixerInput *in = get_input(mixer, input);
+
+    if (in == NULL || pcm == NULL) {
+        return false;
+    }
+
+    const uint32_t capacity = queue_capacity(mixer);
+
+    if (samples == 0 || samples > capacity || (channels != 1 && channels != 2)) {
+        ++mixer->stats.dropped_frames;
+        return false;
+    }
+
+    if (in->count + samples > capacity) {
+        const uint32_t excess = in->count + samples - capacity;
+        in->head = (in->head + excess) % capacity;
+        in->count -= excess;
+        ++mixer->stats.dropped_frames;
+    }
+
+    const uint32_t tail = (in->head + in->count) % capacity;
+    const uint32_t first = capacity - tail < samples ? capacity - tail : samples;
+
+    if (channels == 1) {
+        memcpy(&in->queue[tail], pcm, first * sizeof(int16_t));
+        memcpy(in->queue, pcm + first, (samples - first) * sizeof(int16_t));
+    } else {
+        for (uint32_t i = 0; i < samples; ++i) {
+            in->queue[(tail + i) % capacity] = (int16_t)(((int32_t) pcm[2 * i] + pcm[2 * i + 1]) / 2);
+        }
+    }
+
+    in->count += samples;
+    in->missed = 0;
+
+    return true;
+}
+
+bool audio_mixer_ready(const AudioMixer *mixer)
+{
+    if (mixer == NULL) {
+        return false;
+    }
+
+    bool any_queued = false;
+
+    for (uint32_t i = 0; i < mixer->max_inputs; ++i) {
+        const MixerInput *in = &mixer->inputs[i];
+
+        if (!in->used) {
+            continue;
+        }
+
+        const uint32_t frames = in->count / mixer->frame_samples;
+
+        // An input running ahead shouldn't have to wait on the others
+        if (frames > 1) {
+            return true;
+        }
+
+        if (frames == 1) {
+            any_queued = true;
+        } else if (in->missed < MIXER_MAX_MISSED) {
+            return false;
+        }
+    }
+
+    return any_queued;
+}
+
+/* Moves the oldest frame queued for `in` to the mixer's frame buffer. */
+static const int16_t *pop_frame(AudioMixer *mixer, MixerInput *in)
+{
+    const uint32_t samples = mixer->frame_samples;
+    const uint32_t capacity = queue_capacity(mixer);
+    const uint32_t first = capacity - in->head < samples ? capacity - in->head : samples;
+
+    memcpy(mixer->frame, &in->queue[in->head], first * sizeof(int16_t));
+    memcpy(mixer->frame + first, in->queue, (samples - first) * sizeof(int16_t));
+
+    in->head = (in->head + samples) % capacity;
+    in->count -= samples;
+
+    return mixer->frame;
+}
+
+#ifdef __SSE2__
+/* Adds the 8 samples in `v`, scaled by the matching lanes of `gain`, to `acc`. */
+static inline void mul_add8(int32_t *acc, __m128i v, __m128i gain)
+{
+    // Full 32-bit products, reassembled from their low and high halves
+    const __m128i lo = _mm_mullo_epi16(v, gain);
+    const __m128i hi = _mm_mulhi_epi16(v, gain);
+    const __m128i prod0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), GAIN_SHIFT);
+    const __m128i prod1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), GAIN_SHIFT);
+
+    __m128i *dst = (__m128i *)(void *) acc;
+    _mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), prod0));
+    _mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1), prod1));
+}
+#endif /* __SSE2__ */
+
+/* Adds the mono frame `src`, scaled by `gain`, to the mono accumulator `acc`. */
+static void accumulate_mono(int32_t *acc, const int16_t *src, uint32_t samples, int16_t gain)
+{
+    uint32_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i gain_v = _mm_set1_epi16(gain);
+
+    for (; i + 8 <= samples; i += 8) {
+        mul_add8(acc + i, _mm_loadu_si128((const __m128i *)(const void *)(src + i)), gain_v);
+    }
+
+#endif /* __SSE2__ */
+
+    for (; i < samples; ++i) {
+        acc[i] += (src[i] * gain) >> GAIN_SHIFT;
+    }
+}
+
+/* Adds the mono frame `src` to the interleaved stereo accumulator `acc`, scaled by `left`
+ * and `right`. Each sample is duplicated in register rather than upmixed in memory.
+ */
+static void accumulate_stereo(int32_t *acc, const int16_t *src, uint32_t samples, int16_t left, int16_t right)
+{
+    uint32_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i gain_v = _mm_set_epi16(right, left, right, left, right, left, right, left);
+
+    for (; i + 8 <= samples; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(src + i));
+
+        mul_add8(acc + 2 * i, _mm_unpacklo_epi16(v, v), gain_v);
+        mul_add8(acc + 2 * i + 8, _mm_unpackhi_epi16(v, v), gain_v);
+    }
+
+#endif /* __SSE2__ */
+
+    for (; i < samples; ++i) {
+        acc[2 * i] += (src[i] * left) >> GAIN_SHIFT;
+        acc[2 * i + 1] += (src[i] * right) >> GAIN_SHIFT;
+    }
+}
+
+/* Converts the accumulated sums to samples, saturating on overflow. */
+static void saturate(int16_t *dst, const int32_t *acc, uint32_t count)
+{
+    uint32_t i = 0;
+
+#ifdef __SSE2__
+
+    for (; i + 8 <= count; i += 8) {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(const void *)(acc + i));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(const void *)(acc + i + 4));
+        _mm_storeu_si128((__m128i *)(void *)(dst + i), _mm_packs_epi32(a, b));
+    }
+
+#endif /* __SSE2__ */
+
+    for (; i < count; ++i) {
+        dst[i] = (int16_t)(acc[i] > INT16_MAX ? INT16_MAX : acc[i] < INT16_MIN ? INT16_MIN : acc[i]);
+    }
+}
+
+const int16_t *audio_mixer_mix(AudioMixer *mixer, uint8_t *channels)
+{
+    if (mixer == NULL) {
+        return NULL;
+    }
+
+    const uint32_t samples = mixer->frame_samples;
+    const uint8_t out_channels = mixer->panning ? 2 : 1;
+    const uint32_t out_size = samples * out_channels;
+
+    memset(mixer->accumulator, 0, out_size * sizeof(int32_t));
+
+    for (uint32_t i = 0; i < mixer->max_inputs; ++i) {
+        MixerInput *in = &mixer->inputs[i];
+
+        if (!in->used) {
+            continue;
+        }
+
+        if (in->count < samples) {
+            ++in->missed;
+            continue;
+        }
+
+        const int16_t *frame = pop_frame(mixer, in);
+
+        AudioLevel level;
+        audio_level_measure(frame, samples, 1, &level);
+        in->speaking = vad_process(&in->vad, &level);
+
+        if (in->muted || !in->speaking || in->mono_gain == 0) {
+            ++mixer->stats.skipped_inputs;
+            continue;
+        }
+
+        if (out_channels == 1) {
+            accumulate_mono(mixer->accumulator, frame, samples, in->mono_gain);
+        } else {
+            accumulate_stereo(mixer->accumulator, frame, samples, in->left_gain, in->right_gain);
+        }
+
+        ++mixer->stats.mixed_inputs;
+    }
+
+    saturate(mixer->output, mixer->accumulator, out_size);
+    ++mixer->stats.frames;
+
+    if (channels != NULL) {
+        *channels = out_channels;
+    }
+
+    return mixer->output;
+}
+
+uint32_t audio_mixer_sample_rate(const AudioMixer *mixer)
+{
+    return mixer != NULL ? mixer->sample_rate : 0;
+}
+
+uint32_t audio_mixer_frame_samples(const AudioMixer *mixer)
+{
+    return mixer != NULL ? mixer->frame_samples : 0;
+}
+
+void audio_mixer_get_stats(const AudioMixer *mixer, AudioMixerStats *stats)
+{
+    if (mixer == NULL) {
+        *stats = (AudioMixerStats) {
+            0
+        };
+        return;
+    }
+
+    *stats = mixer->stats;
+}
@@ -0,0 +1,117 @@
+/*  audio_mixer.h
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+/*
+ * Mixes the audio of many conference peers into a single output stream, so a conference
+ * needs one output device however many peers are talking.
+ *
+ * Each peer is an input with its own gain, mute and stereo position. Audio is queued per
+ * input as it arrives, in frames of any size, and mixed in fixed size frames once every
+ * live input has one queued, or as soon as any input gets a frame ahead; inputs that stop
+ * sending are no longer waited for. Frames without speech are skipped instead of summed.
+ */
+
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Largest per-input gain */
+#define AUDIO_MIXER_MAX_GAIN 2.0f
+
+typedef struct AudioMixerStats {
+    uint64_t frames;            /* Output frames mixed */
+    uint64_t mixed_inputs;      /* Input frames summed into an output frame */
+    uint64_t skipped_inputs;    /* Input frames skipped because they were silent or muted */
+    uint64_t dropped_frames;    /* Input frames rejected, or that overflowed their queue and displaced older audio */
+} AudioMixerStats;
+
+typedef struct AudioMixer AudioMixer;
+
+/*
+ * Creates a mixer for frames of `frame_samples` samples per channel at `sample_rate`.
+ *
+ * Returns NULL on failure.
+ */
+AudioMixer *audio_mixer_new(uint32_t sample_rate, uint32_t frame_samples);
+
+void audio_mixer_free(AudioMixer *mixer);
+
+/*
+ * Adds an input with unity gain, centered and unmuted.
+ *
+ * Returns the input's id, or -1 on failure.
+ */
+int32_t audio_mixer_add_input(AudioMixer *mixer);
+
+void audio_mixer_remove_input(AudioMixer *mixer, int32_t input);
+
+/*
+ * Sets the gain of `input`, clamped to the range 0.0-AUDIO_MIXER_MAX_GAIN.
+ */
+void audio_mixer_set_gain(AudioMixer *mixer, int32_t input, float gain);
+float audio_mixer_get_gain(const AudioMixer *mixer, int32_t input);
+
+void audio_mixer_set_muted(AudioMixer *mixer, int32_t input, bool muted);
+bool audio_mixer_is_muted(const AudioMixer *mixer, int32_t input);
+
+/*
+ * Sets the stereo position of `input` from -1.0 (left) to 1.0 (right). Only used while
+ * panning is enabled.
+ */
+void audio_mixer_set_pan(AudioMixer *mixer, int32_t input, float pan);
+
+/*
+ * Enables or disables panning. The output is stereo while panning is enabled, and mono
+ * otherwise, which halves the mixing cost.
+ */
+void audio_mixer_set_panning(AudioMixer *mixer, bool enabled);
+bool audio_mixer_get_panning(const AudioMixer *mixer);
+
+/*
+ * Returns true if the last frame mixed from `input` contained speech.
+ */
+bool audio_mixer_is_speaking(const AudioMixer *mixer, int32_t input);
+
+/*
+ * Queues a frame of `samples` samples per channel received from `input`. Mono and stereo
+ * frames of any size up to 8 mixer frames are accepted. If the input's queue overflows
+ * its oldest samples are dropped.
+ *
+ * Returns false if the frame was rejected.
+ */
+bool audio_mixer_push(AudioMixer *mixer, int32_t input, const int16_t *pcm, uint32_t samples, uint8_t channels);
+
+/*
+ * Returns true if a frame is ready to be mixed.
+ */
+bool audio_mixer_ready(const AudioMixer *mixer);
+
+/*
+ * Mixes the next queued frame of every input. The frame holds the number of samples per
+ * channel given to audio_mixer_new(), and its channel count is written to `channels`.
+ *
+ * The returned frame is owned by the mixer and valid until the next call.
+ */
+const int16_t *audio_mixer_mix(AudioMixer *mixer, uint8_t *channels);
+
+uint32_t audio_mixer_sample_rate(const AudioMixer *mixer);
+uint32_t audio_mixer_frame_samples(const AudioMixer *mixer);
+
+void audio_mixer_get_stats(const AudioMixer *mixer, AudioMixerStats *stats);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif /* __cplusplus */
+
+#endif /* AUDIO_MIXER_H */
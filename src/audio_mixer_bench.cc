@@ -0,0 +1,91 @@
+/* Microbenchmark for the conference audio mixer.
+ *
+ * Pushes one 20ms frame per simulated peer and mixes it, for conferences of 10, 50 and
+ * 100 peers with everyone talking or only a tenth of them, in mono and with panning.
+ * Run with an optional iteration count.
+ */
+
+#include "audio_mixer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr uint32_t kFrameSamples = 960;
+
+volatile int16_t sink;
+
+void run(uint32_t peers, uint32_t talking, bool panning, uint32_t iterations)
+{
+    AudioMixer *mixer = audio_mixer_new(kSampleRate, kFrameSamples);
+
+    if (mixer == nullptr) {
+        fprintf(stderr, "Failed to create mixer\n");
+        exit(1);
+    }
+
+    audio_mixer_set_panning(mixer, panning);
+
+    std::vector<int32_t> inputs(peers);
+    std::vector<std::vector<int16_t>> frames(peers, std::vector<int16_t>(kFrameSamples, 0));
+
+    for (uint32_t p = 0; p < peers; ++p) {
+        inputs[p] = audio_mixer_add_input(mixer);
+        audio_mixer_set_pan(mixer, inputs[p], peers > 1 ? 2.0f * p / (peers - 1) - 1.0f : 0.0f);
+
+        if (p % (peers / talking) != 0) {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < kFrameSamples; ++i) {
+            frames[p][i] = static_cast<int16_t>(4000 * std::sin(i * (p + 1) * 0.01));
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        for (uint32_t p = 0; p < peers; ++p) {
+            audio_mixer_push(mixer, inputs[p], frames[p].data(), kFrameSamples, 1);
+        }
+
+        while (audio_mixer_ready(mixer)) {
+            sink = audio_mixer_mix(mixer, nullptr)[0];
+        }
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const double us = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+
+    AudioMixerStats stats;
+    audio_mixer_get_stats(mixer, &stats);
+
+    printf("%3u peers %3u talking %-6s %8.1f us/frame  (%5.2f%% of a 20ms frame)  mixed %llu skipped %llu\n",
+           peers, talking, panning ? "stereo" : "mono", us, us / 200.0,
+           (unsigned long long) stats.mixed_inputs, (unsigned long long) stats.skipped_inputs);
+
+    audio_mixer_free(mixer);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const uint32_t iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+
+    const uint32_t peer_counts[] = {10, 50, 100};
+
+    for (const uint32_t peers : peer_counts) {
+        for (int panning = 0; panning < 2; ++panning) {
+            run(peers, peers, panning, iterations);
+            run(peers, peers / 10, panning, iterations);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include "audio_mixer.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr uint32_t kFrameSamples = 960;  // 20ms at 48kHz
+
+std::vector<int16_t> tone(int16_t amplitude, uint8_t channels = 1)
+{
+    std::vector<int16_t> frame(kFrameSamples * channels);
+
+    for (uint32_t i = 0; i < kFrameSamples; ++i) {
+        const int16_t sample = static_cast<int16_t>(amplitude * std::sin(i * 2 * 3.14159265 * 440 / kSampleRate));
+
+        for (uint8_t c = 0; c < channels; ++c) {
+            frame[i * channels + c] = sample;
+        }
+    }
+
+    return frame;
+}
+
+class AudioMixerTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        mixer_ = audio_mixer_new(kSampleRate, kFrameSamples);
+        ASSERT_NE(mixer_, nullptr);
+    }
+
+    void TearDown() override
+    {
+        audio_mixer_free(mixer_);
+    }
+
+    AudioMixer *mixer_ = nullptr;
+};
+
+TEST_F(AudioMixerTest, SumsInputsWithGain)
+{
+    const int32_t a = audio_mixer_add_input(mixer_);
+    const int32_t b = audio_mixer_add_input(mixer_);
+    ASSERT_GE(a, 0);
+    ASSERT_GE(b, 0);
+
+    audio_mixer_set_gain(mixer_, b, 0.5f);
+
+    const std::vector<int16_t> frame = tone(8000);
+    ASSERT_TRUE(audio_mixer_push(mixer_, a, frame.data(), kFrameSamples, 1));
+    EXPECT_FALSE(audio_mixer_ready(mixer_));  // still waiting on b
+    ASSERT_TRUE(audio_mixer_push(mixer_, b, frame.data(), kFrameSamples, 1));
+    ASSERT_TRUE(audio_mixer_ready(mixer_));
+
+    uint8_t channels = 0;
+    const int16_t *out = audio_mixer_mix(mixer_, &channels);
+    ASSERT_NE(out, nullptr);
+    EXPECT_EQ(channels, 1);
+
+    for (uint32_t i = 0; i < kFrameSamples; ++i) {
+        ASSERT_NEAR(out[i], frame[i] * 1.5, 2) << "sample " << i;
+    }
+}
+
+TEST_F(AudioMixerTest, SaturatesInsteadOfWrapping)
+{
+    const std::vector<int16_t> loud(kFrameSamples, 30000);
+
+    for (int i = 0; i < 3; ++i) {
+        const int32_t input = audio_mixer_add_input(mixer_);
+        ASSERT_TRUE(audio_mixer_push(mixer_, input, loud.data(), kFrameSamples, 1));
+    }
+
+    const int16_t *out = audio_mixer_mix(mixer_, nullptr);
+
+    for (uint32_t i = 0; i < kFrameSamples; ++i) {
+        ASSERT_EQ(out[i], INT16_MAX) << "sample " << i;
+    }
+}
+
+TEST_F(AudioMixerTest, SkipsMutedAndSilentInputs)
+{
+    const int32_t talking = audio_mixer_add_input(mixer_);
+    const int32_t muted = audio_mixer_add_input(mixer_);
+    const int32_t silent = audio_mixer_add_input(mixer_);
+
+    audio_mixer_set_muted(mixer_, muted, true);
+    EXPECT_TRUE(audio_mixer_is_muted(mixer_, muted));
+
+    const std::vector<int16_t> frame = tone(8000);
+    const std::vector<int16_t> quiet(kFrameSamples, 0);
+
+    audio_mixer_push(mixer_, talking, frame.data(), kFrameSamples, 1);
+    audio_mixer_push(mixer_, muted, frame.data(), kFrameSamples, 1);
+    audio_mixer_push(mixer_, silent, quiet.data(), kFrameSamples, 1);
+
+    const int16_t *out = audio_mixer_mix(mixer_, nullptr);
+
+    EXPECT_TRUE(audio_mixer_is_speaking(mixer_, talking));
+    EXPECT_FALSE(audio_mixer_is_speaking(mixer_, silent));
+
+    for (uint32_t i = 0; i < kFrameSamples; ++i) {
+        ASSERT_NEAR(out[i], frame[i], 1) << "sample " << i;
+    }
+
+    AudioMixerStats stats;
+    audio_mixer_get_stats(mixer_, &stats);
+    EXPECT_EQ(stats.frames, 1u);
+    EXPECT_EQ(stats.mixed_inputs, 1u);
+    EXPECT_EQ(stats.skipped_inputs, 2u);
+}
+
+TEST_F(AudioMixerTest, PansToStereo)
+{
+    const int32_t left = audio_mixer_add_input(mixer_);
+    audio_mixer_set_pan(mixer_, left, -1.0f);
+    audio_mixer_set_panning(mixer_, true);
+
+    // stereo input is downmixed before panning
+    const std::vector<int16_t> frame = tone(8000, 2);
+    ASSERT_TRUE(audio_mixer_push(mixer_, left, frame.data(), kFrameSamples, 2));
+
+    uint8_t channels = 0;
+    const int16_t *out = audio_mixer_mix(mixer_, &channels);
+    ASSERT_EQ(channels, 2);
+
+    for (uint32_t i = 0; i < kFrameSamples; ++i) {
+        ASSERT_NEAR(out[2 * i], frame[2 * i], 1) << "sample " << i;
+        ASSERT_EQ(out[2 * i + 1], 0) << "sample " << i;
+    }
+}
+
+TEST_F(AudioMixerTest, StopsWaitingForSilentPeers)
+{
+    const int32_t active = audio_mixer_add_input(mixer_);
+    const int32_t gone = audio_mixer_add_input(mixer_);
+    ASSERT_GE(gone, 0);
+
+    const std::vector<int16_t> frame = tone(8000);
+
+    // Once `active` runs a frame ahead the mix proceeds without `gone`, until it's dropped as not live
+    for (int i = 0; i < 4; ++i) {
+        audio_mixer_push(mixer_, active, frame.data(), kFrameSamples, 1);
+
+        if (i == 0) {
+            EXPECT_FALSE(audio_mixer_ready(mixer_));
+            continue;
+        }
+
+        ASSERT_TRUE(audio_mixer_ready(mixer_));
+        audio_mixer_mix(mixer_, nullptr);
+    }
+
+    while (audio_mixer_ready(mixer_)) {
+        audio_mixer_mix(mixer_, nullptr);
+    }
+
+    audio_mixer_push(mixer_, active, frame.data(), kFrameSamples, 1);
+    EXPECT_TRUE(audio_mixer_ready(mixer_));
+}
+
+TEST_F(AudioMixerTest, RechunksOtherFrameSizes)
+{
+    const int32_t input = audio_mixer_add_input(mixer_);
+    const std::vector<int16_t> frame = tone(8000);
+
+    // A 10ms frame is not enough for a 20ms mix, two of them are
+    ASSERT_TRUE(audio_mixer_push(mixer_, input, frame.data(), kFrameSamples / 2, 1));
+    EXPECT_FALSE(audio_mixer_ready(mixer_));
+    ASSERT_TRUE(audio_mixer_push(mixer_, input, frame.data() + kFrameSamples / 2, kFrameSamples / 2, 1));
+    ASSERT_TRUE(audio_mixer_ready(mixer_));
+
+    const int16_t *out = audio_mixer_mix(mixer_, nullptr);
+
+    for (uint32_t i = 0; i < kFrameSamples; ++i) {
+        ASSERT_NEAR(out[i], frame[i], 1) << "sample " << i;
+    }
+
+    const std::vector<int16_t> huge(kFrameSamples * 9);
+    EXPECT_FALSE(audio_mixer_push(mixer_, input, huge.data(), huge.size(), 1));
+}
+
+TEST_F(AudioMixerTest, ReusesRemovedInputs)
+{
+    const int32_t input = audio_mixer_add_input(mixer_);
+    const std::vector<int16_t> frame = tone(8000);
+
+    audio_mixer_remove_input(mixer_, input);
+    EXPECT_FALSE(audio_mixer_push(mixer_, input, frame.data(), kFrameSamples, 1));
+    EXPECT_EQ(audio_mixer_add_input(mixer_), input);
+}
+
+}  // namespace
@@ -0,0 +1,493 @@
+/*  audio_pseudo_device.c
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+#include "audio_pseudo_device.h"
+
+#include "audio_level.h"
+#include "misc_tools.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WAV_HEADER_SIZE 44
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+#define TONE_FREQUENCY 440
+#define TONE_AMPLITUDE (INT16_MAX / 4)
+#define TWO_PI 6.28318530718f
+
+#define PULSE_FREQUENCY 1000
+#define PULSE_AMPLITUDE (INT16_MAX / 2)
+
+/* Peak, as a percentage of full scale, at which an output treats a frame as a pulse */
+#define PULSE_DETECT_PEAK 25.0f
+
+/* Shortest gap in microseconds between two pulses an output will count separately */
+#define PULSE_DETECT_GAP 500000
+
+struct PseudoAudioDevice {
+    PseudoAudioKind kind;
+    FILE *fp;
+
+    uint32_t sample_rate;
+    uint8_t channels;
+    uint64_t next_sample;   /* Index of the next input sample, counted from the epoch of CLOCK_MONOTONIC */
+
+    // used only by WAV inputs:
+    uint8_t file_channels;
+    long data_start;
+    uint32_t data_len;      /* Length of the data chunk in bytes */
+    uint32_t data_pos;
+
+    // used only by WAV outputs:
+    bool header_written;
+    uint32_t data_written;
+
+    uint8_t *io_buf;
+    size_t io_buf_size;
+
+    uint64_t last_pulse_usec;
+    uint64_t cpu_start_usec;
+
+    PseudoAudioStats stats;
+};
+
+const char *pseudo_audio_name(PseudoAudioKind kind)
+{
+    switch (kind) {
+        case pa_Silence:
+            return "Silence (pseudo device)";
+
+        case pa_Tone:
+            return "440 Hz test tone (pseudo device)";
+
+        case pa_Pulse:
+            return "Latency pulse (pseudo device)";
+
+        case pa_FileIn:
+            return "WAV file input (pseudo device)";
+
+        case pa_Discard:
+            return "Discard (pseudo device)";
+
+        case pa_FileOut:
+            return "WAV file output (pseudo device)";
+    }
+
+    return "Unknown (pseudo device)";
+}
+
+bool pseudo_audio_needs_file(PseudoAudioKind kind)
+{
+    return kind == pa_FileIn || kind == pa_FileOut;
+}
+
+static uint64_t process_cpu_usec(void)
+{
+    struct timespec t;
+
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t) != 0) {
+        return 0;
+    }
+
+    return (uint64_t) t.tv_sec * 1000000ULL + (uint64_t) t.tv_nsec / 1000ULL;
+}
+
+static uint16_t read_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_le32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void write_le16(uint8_t *p, uint16_t value)
+{
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+}
+
+static void write_le32(uint8_t *p, uint32_t value)
+{
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = (value >> 24) & 0xFF;
+}
+
+static bool reserve_io_buf(PseudoAudioDevice *dev, size_t size)
+{
+    if (size <= dev->io_buf_size) {
+        return true;
+    }
+
+    uint8_t *io_buf = realloc(dev->io_buf, size);
+
+    if (io_buf == NULL) {
+        return false;
+    }
+
+    dev->io_buf = io_buf;
+    dev->io_buf_size = size;
+
+    return true;
+}
+
+/* Finds the format and data chunks of a WAV file. Only 16-bit PCM with one or two
+ * channels is accepted.
+ */
+static bool wav_read_header(PseudoAudioDevice *dev)
+{
+    uint8_t riff[12];
+
+    if (fread(riff, sizeof(riff), 1, dev->fp) != 1
+            || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool have_format = false;
+    uint8_t chunk[8];
+
+    while (fread(chunk, sizeof(chunk), 1, dev->fp) == 1) {
+        const uint32_t size = read_le32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+
+            if (size < sizeof(fmt) || fread(fmt, sizeof(fmt), 1, dev->fp) != 1) {
+                return false;
+            }
+
+            const uint16_t format = read_le16(fmt);
+            const uint16_t channels = read_le16(fmt + 2);
+            const uint16_t bits = read_le16(fmt + 14);
+
+            if ((format != WAV_FORMAT_PCM && format != WAV_FORMAT_EXTENSIBLE) || bits != 16
+                    || (channels != 1 && channels != 2)) {
+                return false;
+            }
+
+            dev->file_channels = (uint8_t) channels;
+            have_format = true;
+
+            if (fseek(dev->fp, (long)(size - sizeof(fmt) + (size & 1)), SEEK_CUR) != 0) {
+                return false;
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!have_format) {
+                return false;
+            }
+
+            dev->data_start = ftell(dev->fp);
+            dev->data_len = size - size % (2 * dev->file_channels);
+            dev->data_pos = 0;
+
+            return dev->data_start >= 0;
+        } else if (fseek(dev->fp, (long)(size + (size & 1)), SEEK_CUR) != 0) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+static bool wav_write_header(PseudoAudioDevice *dev, uint8_t channels, uint32_t sample_rate)
+{
+    uint8_t header[WAV_HEADER_SIZE];
+
+    memcpy(header, "RIFF", 4);
+    write_le32(header + 4, 36);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    write_le32(header + 16, 16);
+    write_le16(header + 20, WAV_FORMAT_PCM);
+    write_le16(header + 22, channels);
+    write_le32(header + 24, sample_rate);
+    write_le32(header + 28, sample_rate * channels * 2);
+    write_le16(header + 32, (uint16_t)(channels * 2));
+    write_le16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    write_le32(header + 40, 0);
+
+    return fwrite(header, sizeof(header), 1, dev->fp) == 1;
+}
+
+/* Patches the chunk sizes left empty by wav_write_header. */
+static void wav_finalize(PseudoAudioDevice *dev)
+{
+    uint8_t size[4];
+
+    write_le32(size, 36 + dev->data_written);
+
+    if (fseek(dev->fp, 4, SEEK_SET) == 0) {
+        fwrite(size, sizeof(size), 1, dev->fp);
+    }
+
+    write_le32(size, dev->data_written);
+
+    if (fseek(dev->fp, 40, SEEK_SET) == 0) {
+        fwrite(size, sizeof(size), 1, dev->fp);
+    }
+}
+
+PseudoAudioDevice *pseudo_audio_open(PseudoAudioKind kind, const char *path, uint32_t sample_rate, uint8_t channels)
+{
+    if (pseudo_audio_needs_file(kind) && (path == NULL || path[0] == '\0')) {
+        return NULL;
+    }
+
+    PseudoAudioDevice *dev = calloc(1, sizeof(PseudoAudioDevice));
+
+    if (dev == NULL) {
+        return NULL;
+    }
+
+    dev->kind = kind;
+    dev->sample_rate = sample_rate;
+    dev->channels = channels;
+    dev->stats.pulse_min_usec = UINT64_MAX;
+
+    if (kind == pa_FileIn) {
+        dev->fp = fopen(path, "rb");
+
+        if (dev->fp == NULL || !wav_read_header(dev)) {
+            pseudo_audio_close(dev);
+            return NULL;
+        }
+    } else if (kind == pa_FileOut) {
+        dev->fp = fopen(path, "wb");
+
+        if (dev->fp == NULL) {
+            pseudo_audio_close(dev);
+            return NULL;
+        }
+    }
+
+    pseudo_audio_resync(dev, get_monotonic_time_usec());
+
+    return dev;
+}
+
+void pseudo_audio_close(PseudoAudioDevice *dev)
+{
+    if (dev == NULL) {
+        return;
+    }
+
+    if (dev->fp != NULL) {
+        if (dev->kind == pa_FileOut && dev->header_written) {
+            wav_finalize(dev);
+        }
+
+        fclose(dev->fp);
+    }
+
+    free(dev->io_buf);
+    free(dev);
+}
+
+uint64_t pseudo_audio_next_frame_time(const PseudoAudioDevice *dev, uint32_t samples)
+{
+    if (dev->sample_rate == 0) {
+        return 0;
+    }
+
+    return (dev->next_sample + samples) * 1000000ULL / dev->sample_rate;
+}
+
+void pseudo_audio_resync(PseudoAudioDevice *dev, uint64_t now_usec)
+{
+    dev->next_sample = now_usec * dev->sample_rate / 1000000ULL;
+}
+
+static bool read_wav_samples(PseudoAudioDevice *dev, int16_t *frame, uint32_t samples)
+{
+    const uint8_t file_channels = dev->file_channels;
+    const size_t frame_bytes = (size_t) samples * file_channels * 2;
+
+    if (!reserve_io_buf(dev, frame_bytes)) {
+        return false;
+    }
+
+    size_t filled = 0;
+
+    while (filled < frame_bytes && dev->data_len > 0) {
+        if (dev->data_pos >= dev->data_len) {
+            // loop back to the start of the data chunk
+            if (fseek(dev->fp, dev->data_start, SEEK_SET) != 0) {
+                return false;
+            }
+
+            dev->data_pos = 0;
+        }
+
+        const size_t want = MIN(frame_bytes - filled, (size_t)(dev->data_len - dev->data_pos));
+        const size_t got = fread(dev->io_buf + filled, 1, want, dev->fp);
+
+        if (got == 0) {
+            return false;
+        }
+
+        filled += got;
+        dev->data_pos += (uint32_t) got;
+    }
+
+    memset(dev->io_buf + filled, 0, frame_bytes - filled);
+
+    for (uint32_t i = 0; i < samples; ++i) {
+        const uint8_t *in = dev->io_buf + (size_t) i * file_channels * 2;
+        const int16_t left = (int16_t) read_le16(in);
+        const int16_t right = file_channels == 2 ? (int16_t) read_le16(in + 2) : left;
+
+        if (dev->channels == 1) {
+            frame[i] = (int16_t)(((int32_t) left + right) / 2);
+        } else {
+            frame[i * 2] = left;
+            frame[i * 2 + 1] = right;
+        }
+    }
+
+    return true;
+}
+
+static int16_t generate_sample(const PseudoAudioDevice *dev, uint64_t n)
+{
+    const uint32_t rate = dev->sample_rate;
+
+    switch (dev->kind) {
+        case pa_Tone: {
+            const float phase = (float)((n * TONE_FREQUENCY) % rate) / rate;
+            return (int16_t)(TONE_AMPLITUDE * sinf(TWO_PI * phase));
+        }
+
+        case pa_Pulse: {
+            // a short burst of square wave starting on every whole second
+            const uint64_t offset = n % rate;
+
+            if (offset >= (uint64_t) rate * PSEUDO_PULSE_LENGTH / 1000) {
+                return 0;
+            }
+
+            const uint64_t half_period = MAX(rate / (2 * PULSE_FREQUENCY), 1);
+            return (offset / half_period) & 1 ? -PULSE_AMPLITUDE : PULSE_AMPLITUDE;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+bool pseudo_audio_read(PseudoAudioDevice *dev, int16_t *frame, uint32_t samples)
+{
+    if (dev->kind == pa_FileIn) {
+        if (!read_wav_samples(dev, frame, samples)) {
+            return false;
+        }
+    } else if (dev->kind == pa_Silence || dev->sample_rate == 0) {
+        memset(frame, 0, (size_t) samples * dev->channels * sizeof(int16_t));
+    } else {
+        for (uint32_t i = 0; i < samples; ++i) {
+            const int16_t sample = generate_sample(dev, dev->next_sample + i);
+
+            for (uint8_t c = 0; c < dev->channels; ++c) {
+                frame[i * dev->channels + c] = sample;
+            }
+        }
+    }
+
+    dev->next_sample += samples;
+    ++dev->stats.frames;
+
+    return true;
+}
+
+/* Times the arrival of each pulse against the whole second it was emitted on. */
+static void detect_pulse(PseudoAudioDevice *dev, const int16_t *frame, uint32_t samples, uint8_t channels,
+                         uint64_t now_usec)
+{
+    AudioLevel level;
+    audio_level_measure(frame, samples * channels, channels, &level);
+
+    if (level.peak < PULSE_DETECT_PEAK) {
+        return;
+    }
+
+    if (dev->last_pulse_usec != 0 && now_usec - dev->last_pulse_usec < PULSE_DETECT_GAP) {
+        return;
+    }
+
+    dev->last_pulse_usec = now_usec;
+
+    const uint64_t latency = now_usec % 1000000ULL;
+
+    PseudoAudioStats *stats = &dev->stats;
+    ++stats->pulses;
+    stats->pulse_total_usec += latency;
+    stats->pulse_min_usec = MIN(stats->pulse_min_usec, latency);
+    stats->pulse_max_usec = MAX(stats->pulse_max_usec, latency);
+}
+
+bool pseudo_audio_write(PseudoAudioDevice *dev, const int16_t *frame, uint32_t samples, uint8_t channels,
+                        uint32_t sample_rate, uint64_t now_usec)
+{
+    if (dev->stats.frames == 0) {
+        dev->cpu_start_usec = process_cpu_usec();
+    }
+
+    ++dev->stats.frames;
+
+    detect_pulse(dev, frame, samples, channels, now_usec);
+
+    if (dev->kind != pa_FileOut) {
+        return true;
+    }
+
+    if (!dev->header_written) {
+        if (!wav_write_header(dev, channels, sample_rate)) {
+            return false;
+        }
+
+        dev->header_written = true;
+    }
+
+    const size_t num_samples = (size_t) samples * channels;
+
+    if (!reserve_io_buf(dev, num_samples * 2)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < num_samples; ++i) {
+        write_le16(dev->io_buf + i * 2, (uint16_t) frame[i]);
+    }
+
+    if (fwrite(dev->io_buf, num_samples * 2, 1, dev->fp) != 1) {
+        return false;
+    }
+
+    dev->data_written += (uint32_t)(num_samples * 2);
+
+    return true;
+}
+
+void pseudo_audio_get_stats(const PseudoAudioDevice *dev, PseudoAudioStats *stats)
+{
+    *stats = dev->stats;
+
+    if (stats->pulses == 0) {
+        stats->pulse_min_usec = 0;
+    }
+
+    if (stats->frames > 0 && (dev->kind == pa_Discard || dev->kind == pa_FileOut)) {
+        stats->cpu_usec = process_cpu_usec() - dev->cpu_start_usec;
+    }
+}
@@ -0,0 +1,112 @@
+/*  audio_pseudo_device.h
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+/*
+ * Pseudo audio devices stand in for OpenAL devices so calls can run on machines without
+ * sound hardware. Inputs generate silence, a test tone or latency pulses, or loop a WAV
+ * file; outputs discard what they receive or record it to a WAV file.
+ *
+ * The latency pulse input emits a short click at every whole second of CLOCK_MONOTONIC.
+ * Outputs time the arrival of each click against the same clock, which gives the
+ * capture-to-playback latency of a call between two clients on the same machine.
+ */
+
+#ifndef AUDIO_PSEUDO_DEVICE_H
+#define AUDIO_PSEUDO_DEVICE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Length in ms of each click emitted by the latency pulse input */
+#define PSEUDO_PULSE_LENGTH 10
+
+typedef enum PseudoAudioKind {
+    pa_Silence,     /* Input: all zero samples */
+    pa_Tone,        /* Input: 440 Hz sine wave */
+    pa_Pulse,       /* Input: a click at every whole second */
+    pa_FileIn,      /* Input: 16-bit PCM WAV file, looped */
+    pa_Discard,     /* Output: drops every frame */
+    pa_FileOut,     /* Output: records to a 16-bit PCM WAV file */
+} PseudoAudioKind;
+
+typedef struct PseudoAudioStats {
+    uint64_t frames;            /* Frames read from an input or written to an output */
+    uint64_t pulses;            /* Latency pulses detected by an output */
+    uint64_t pulse_total_usec;
+    uint64_t pulse_min_usec;
+    uint64_t pulse_max_usec;
+    uint64_t cpu_usec;          /* Process CPU time used since an output received its first frame */
+} PseudoAudioStats;
+
+typedef struct PseudoAudioDevice PseudoAudioDevice;
+
+/*
+ * Returns a human readable name for `kind`.
+ */
+const char *pseudo_audio_name(PseudoAudioKind kind);
+
+/*
+ * Returns true if `kind` reads from or writes to a file and needs a path to open.
+ */
+bool pseudo_audio_needs_file(PseudoAudioKind kind);
+
+/*
+ * Opens a pseudo device of `kind`. Inputs produce `channels` channels at `sample_rate`,
+ * starting from the current time; both are ignored for outputs, which take them from
+ * each frame written.
+ *
+ * A WAV input must hold 16-bit PCM; mono and stereo files are converted to `channels`,
+ * but no resampling is done.
+ *
+ * Returns NULL on failure.
+ */
+PseudoAudioDevice *pseudo_audio_open(PseudoAudioKind kind, const char *path, uint32_t sample_rate, uint8_t channels);
+
+/*
+ * Closes `dev`, finalizing the WAV header of a file output.
+ */
+void pseudo_audio_close(PseudoAudioDevice *dev);
+
+/*
+ * Returns the CLOCK_MONOTONIC time in microseconds at which the next `samples` samples
+ * per channel of an input are complete.
+ */
+uint64_t pseudo_audio_next_frame_time(const PseudoAudioDevice *dev, uint32_t samples);
+
+/*
+ * Skips an input ahead so its next frame starts at `now_usec`, discarding any frames
+ * that fell due while nothing was reading them.
+ */
+void pseudo_audio_resync(PseudoAudioDevice *dev, uint64_t now_usec);
+
+/*
+ * Fills `frame` with the next `samples` interleaved samples per channel of an input.
+ *
+ * Returns false on a read error.
+ */
+bool pseudo_audio_read(PseudoAudioDevice *dev, int16_t *frame, uint32_t samples);
+
+/*
+ * Passes a frame received at `now_usec` to an output.
+ *
+ * Returns false on a write error.
+ */
+bool pseudo_audio_write(PseudoAudioDevice *dev, const int16_t *frame, uint32_t samples, uint8_t channels,
+                        uint32_t sample_rate, uint64_t now_usec);
+
+void pseudo_audio_get_stats(const PseudoAudioDevice *dev, PseudoAudioStats *stats);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif /* __cplusplus */
+
+#endif /* AUDIO_PSEUDO_DEVICE_H */
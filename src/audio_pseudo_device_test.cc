@@ -0,0 +1,165 @@
+#include "audio_pseudo_device.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr uint32_t kFrameSamples = 960;  // 20ms at 48kHz
+
+class TempFile {
+public:
+    TempFile()
+    {
+        char path[] = "/tmp/toxic_pseudo_XXXXXX";
+        const int fd = mkstemp(path);
+        EXPECT_NE(fd, -1);
+
+        if (fd != -1) {
+            close(fd);
+        }
+
+        path_ = path;
+    }
+
+    ~TempFile()
+    {
+        std::remove(path_.c_str());
+    }
+
+    const char *path() const
+    {
+        return path_.c_str();
+    }
+
+private:
+    std::string path_;
+};
+
+TEST(AudioPseudoDevice, FileDevicesNeedAPath)
+{
+    EXPECT_EQ(pseudo_audio_open(pa_FileIn, nullptr, kSampleRate, 1), nullptr);
+    EXPECT_EQ(pseudo_audio_open(pa_FileOut, "", kSampleRate, 1), nullptr);
+}
+
+TEST(AudioPseudoDevice, SilenceIsSilent)
+{
+    PseudoAudioDevice *dev = pseudo_audio_open(pa_Silence, nullptr, kSampleRate, 2);
+    ASSERT_NE(dev, nullptr);
+
+    std::vector<int16_t> frame(kFrameSamples * 2, 1);
+    ASSERT_TRUE(pseudo_audio_read(dev, frame.data(), kFrameSamples));
+
+    for (int16_t sample : frame) {
+        EXPECT_EQ(sample, 0);
+    }
+
+    pseudo_audio_close(dev);
+}
+
+TEST(AudioPseudoDevice, PulseStartsOnTheSecond)
+{
+    PseudoAudioDevice *dev = pseudo_audio_open(pa_Pulse, nullptr, kSampleRate, 1);
+    ASSERT_NE(dev, nullptr);
+
+    // Start 10ms before a whole second, so the pulse begins halfway through the first frame
+    pseudo_audio_resync(dev, 4990000);
+    EXPECT_EQ(pseudo_audio_next_frame_time(dev, kFrameSamples), 5010000u);
+
+    std::vector<int16_t> frame(kFrameSamples);
+    ASSERT_TRUE(pseudo_audio_read(dev, frame.data(), kFrameSamples));
+
+    const uint32_t onset = kSampleRate / 100;
+    const uint32_t pulse_samples = kSampleRate * PSEUDO_PULSE_LENGTH / 1000;
+
+    for (uint32_t i = 0; i < onset; ++i) {
+        ASSERT_EQ(frame[i], 0) << "sample " << i;
+    }
+
+    for (uint32_t i = onset; i < onset + pulse_samples && i < kFrameSamples; ++i) {
+        ASSERT_NE(frame[i], 0) << "sample " << i;
+    }
+
+    pseudo_audio_close(dev);
+}
+
+TEST(AudioPseudoDevice, OutputTimesPulses)
+{
+    PseudoAudioDevice *dev = pseudo_audio_open(pa_Discard, nullptr, 0, 0);
+    ASSERT_NE(dev, nullptr);
+
+    std::vector<int16_t> quiet(kFrameSamples, 0);
+    std::vector<int16_t> loud(kFrameSamples, 20000);
+
+    ASSERT_TRUE(pseudo_audio_write(dev, quiet.data(), kFrameSamples, 1, kSampleRate, 3000000));
+    ASSERT_TRUE(pseudo_audio_write(dev, loud.data(), kFrameSamples, 1, kSampleRate, 3045000));
+    // still the same pulse
+    ASSERT_TRUE(pseudo_audio_write(dev, loud.data(), kFrameSamples, 1, kSampleRate, 3065000));
+    ASSERT_TRUE(pseudo_audio_write(dev, loud.data(), kFrameSamples, 1, kSampleRate, 4055000));
+
+    PseudoAudioStats stats;
+    pseudo_audio_get_stats(dev, &stats);
+
+    EXPECT_EQ(stats.frames, 4u);
+    EXPECT_EQ(stats.pulses, 2u);
+    EXPECT_EQ(stats.pulse_min_usec, 45000u);
+    EXPECT_EQ(stats.pulse_max_usec, 55000u);
+    EXPECT_EQ(stats.pulse_total_usec, 100000u);
+
+    pseudo_audio_close(dev);
+}
+
+TEST(AudioPseudoDevice, WavRoundTripLoopsAndUpmixes)
+{
+    TempFile file;
+
+    PseudoAudioDevice *out = pseudo_audio_open(pa_FileOut, file.path(), 0, 0);
+    ASSERT_NE(out, nullptr);
+
+    std::vector<int16_t> written(kFrameSamples);
+
+    for (uint32_t i = 0; i < kFrameSamples; ++i) {
+        written[i] = static_cast<int16_t>(i * 31 - 15000);
+    }
+
+    ASSERT_TRUE(pseudo_audio_write(out, written.data(), kFrameSamples, 1, kSampleRate, 1));
+    pseudo_audio_close(out);
+
+    PseudoAudioDevice *in = pseudo_audio_open(pa_FileIn, file.path(), kSampleRate, 2);
+    ASSERT_NE(in, nullptr);
+
+    std::vector<int16_t> frame(kFrameSamples * 2);
+
+    // The file holds a single frame; the second read must loop back to its start
+    for (int pass = 0; pass < 2; ++pass) {
+        ASSERT_TRUE(pseudo_audio_read(in, frame.data(), kFrameSamples));
+
+        for (uint32_t i = 0; i < kFrameSamples; ++i) {
+            ASSERT_EQ(frame[i * 2], written[i]) << "pass " << pass << " sample " << i;
+            ASSERT_EQ(frame[i * 2 + 1], written[i]) << "pass " << pass << " sample " << i;
+        }
+    }
+
+    pseudo_audio_close(in);
+}
+
+TEST(AudioPseudoDevice, RejectsNonWavFiles)
+{
+    TempFile file;
+
+    FILE *fp = std::fopen(file.path(), "wb");
+    ASSERT_NE(fp, nullptr);
+    std::fputs("definitely not a wav file", fp);
+    std::fclose(fp);
+
+    EXPECT_EQ(pseudo_audio_open(pa_FileIn, file.path(), kSampleRate, 1), nullptr);
+}
+
+}  // namespace
@@ -11,6 +11,7 @@
 #include <limits.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 #ifdef __APPLE__
 #include <sys/types.h>
@@ -24,9 +25,11 @@
 #include "line_info.h"
 #include "misc_tools.h"
 #include "toxic.h"
+#include "toxic_strings.h"
 #include "windows.h"
 
-static void print_ac_matches(ToxWindow *self, Toxic *toxic, char **list, size_t n_matches, bool have_matches)
+static void print_ac_matches(ToxWindow *self, Toxic *toxic, const char *const *list, size_t n_matches,
+                             bool have_matches)
 {
     if (have_matches) {
         execute(self->chatwin->history, self, toxic, "/clear", GLOBAL_COMMAND_MODE);
@@ -70,6 +73,28 @@ static size_t get_str_match(ToxWindow *self, char *match, size_t match_sz, const
     return snprintf(match, match_sz, "%s", matches[0]);
 }
 
+/* Returns the index of the first string in `list`, which is sorted with strcasecmp(), whose first
+ * `prefix_len` bytes compare greater than or equal to `prefix` ignoring case.
+ */
+static size_t sorted_prefix_lower_bound(const char *const *list, size_t n_items, const char *prefix,
+                                        size_t prefix_len)
+{
+    size_t lo = 0;
+    size_t hi = n_items;
+
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+
+        if (strncasecmp(list[mid], prefix, prefix_len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
 /*
  * Looks for all instances in list that begin with the last entered word in line according to pos,
  * then fills line with the complete word. e.g. "Hello jo" would complete the line
@@ -77,6 +102,9 @@ static size_t get_str_match(ToxWindow *self, char *match, size_t match_sz, const
  *
  * `list` is a pointer to `n_items` strings. Each string in the list must be <= MAX_STR_SIZE.
  *
+ * If `sorted` is true the list must be sorted with strcasecmp(), and only the entries that share
+ * the word's prefix, found by binary search, are examined.
+ *
  * dir_search should be true if the line being completed is a file path.
  *
  * If `out` is non-null the input string will be copied to it. `out` must have room for at least
@@ -88,7 +116,7 @@ static size_t get_str_match(ToxWindow *self, char *match, size_t match_sz, const
  * Note: This function should not be called directly. Use complete_line() and complete_path() instead.
  */
 static int complete_line_helper(ToxWindow *self, Toxic *toxic, const char *const *list, const size_t n_items,
-                                bool dir_search, char *out)
+                                bool sorted, bool dir_search, char *out)
 {
     ChatContext *ctx = self->chatwin;
 
@@ -104,7 +132,7 @@ static int complete_line_helper(ToxWindow *self, Toxic *toxic, const char *const
     char ubuf[MAX_STR_SIZE];
 
     /* work with multibyte string copy of buf for simplicity */
-    if (wcs_to_mbs_buf(ubuf, ctx->line, sizeof(ubuf)) == -1) {
+    if (wcs_to_mbs_buf(ubuf, get_line_buf(ctx), sizeof(ubuf)) == -1) {
         return -1;
     }
 
@@ -153,9 +181,33 @@ static int complete_line_helper(ToxWindow *self, Toxic *toxic, const char *const
     }
 
     const int s_len = strlen(sub);
+
+    size_t first = 0;
+    size_t last = n_items;
+
+    if (sorted) {
+        first = sorted_prefix_lower_bound(list, n_items, sub, s_len);
+        last = first;
+
+        while (last < n_items && strncasecmp(list[last], sub, s_len) == 0) {
+            ++last;
+        }
+    }
+
     size_t n_matches = 0;
 
-    char **matches = (char **) malloc_ptr_array(n_items, MAX_STR_SIZE);
+    for (size_t i = first; i < last; ++i) {
+        if (strncmp(list[i], sub, s_len) == 0) {
+            ++n_matches;
+        }
+    }
+
+    if (!n_matches) {
+        free(sub);
+        return -1;
+    }
+
+    const char **matches = malloc(n_matches * sizeof(char *));
 
     if (matches == NULL) {
         free(sub);
@@ -163,28 +215,24 @@ static int complete_line_helper(ToxWindow *self, Toxic *toxic, const char *const
     }
 
     /* put all list matches in matches array */
-    for (size_t i = 0; i < n_items; ++i) {
+    n_matches = 0;
+
+    for (size_t i = first; i < last; ++i) {
         if (strncmp(list[i], sub, s_len) == 0) {
-            snprintf(matches[n_matches++], MAX_STR_SIZE, "%s", list[i]);
+            matches[n_matches++] = list[i];
         }
     }
 
     free(sub);
 
-    if (!n_matches) {
-        free_ptr_array((void **) matches);
-        return -1;
-    }
-
     if (!dir_search && n_matches > 1) {
         print_ac_matches(self, toxic, matches, n_matches, false);
     }
 
     char match[MAX_STR_SIZE];
-    const size_t match_len = get_str_match(self, match, sizeof(match), (const char *const *) matches,
-                                           n_matches, MAX_STR_SIZE);
+    const size_t match_len = get_str_match(self, match, sizeof(match), matches, n_matches, MAX_STR_SIZE);
 
-    free_ptr_array((void **) matches);
+    free(matches);
 
     if (match_len == 0) {
         return 0;
@@ -252,10 +300,9 @@ static int complete_line_helper(ToxWindow *self, Toxic *toxic, const char *const
         return -1;
     }
 
-    wcscpy(ctx->line, newbuf);
-
-    ctx->len += diff;
-    ctx->pos += diff;
+    if (set_line_buf(ctx, newbuf, wcslen(newbuf), ctx->pos + diff) == -1) {
+        return -1;
+    }
 
     return diff;
 }
@@ -298,25 +345,25 @@ static const char *const status_list[] = {
 static int complete_line_command_arg(ToxWindow *self, Toxic *toxic, const char *input)
 {
     if (strncmp(input, "/status", strlen("/status")) == 0) {
-        return complete_line_helper(self, toxic, status_list, sizeof(status_list) / sizeof(char *), false, NULL);
+        return complete_line_helper(self, toxic, status_list, sizeof(status_list) / sizeof(char *), false, false, NULL);
     }
 
     if (strncmp(input, "/game", strlen("/game")) == 0) {
-        return complete_line_helper(self, toxic, game_list, sizeof(game_list) / sizeof(char *), false, NULL);
+        return complete_line_helper(self, toxic, game_list, sizeof(game_list) / sizeof(char *), false, false, NULL);
     }
 
     if (strncmp(input, "/color", strlen("/color")) == 0) {
-        return complete_line_helper(self, toxic, color_list, sizeof(color_list) / sizeof(char *), false, NULL);
+        return complete_line_helper(self, toxic, color_list, sizeof(color_list) / sizeof(char *), false, false, NULL);
     }
 
     return -1;
 }
 
-int complete_line(ToxWindow *self, Toxic *toxic, const char *const *list, size_t n_items)
+static int complete_line_list(ToxWindow *self, Toxic *toxic, const char *const *list, size_t n_items, bool sorted)
 {
     char cmd[MAX_STR_SIZE] = {0};
 
-    const int ret = complete_line_helper(self, toxic, list, n_items, false, cmd);
+    const int ret = complete_line_helper(self, toxic, list, n_items, sorted, false, cmd);
 
     if (ret >= 0) {
         return ret;
@@ -325,9 +372,19 @@ int complete_line(ToxWindow *self, Toxic *toxic, const char *const *list, size_t
     return complete_line_command_arg(self, toxic, cmd);
 }
 
+int complete_line(ToxWindow *self, Toxic *toxic, const char *const *list, size_t n_items)
+{
+    return complete_line_list(self, toxic, list, n_items, false);
+}
+
+int complete_sorted_line(ToxWindow *self, Toxic *toxic, const char *const *list, size_t n_items)
+{
+    return complete_line_list(self, toxic, list, n_items, true);
+}
+
 static int complete_path(ToxWindow *self, Toxic *toxic, const char *const *list, const size_t n_items)
 {
-    return complete_line_helper(self, toxic, list, n_items, true, NULL);
+    return complete_line_helper(self, toxic, list, n_items, false, true, NULL);
 }
 
 /* Transforms a tab complete starting with the shorthand "~" into the full home directory. */
@@ -355,9 +412,7 @@ static void complete_home_dir(ToxWindow *self, const Paths *paths, char *path, i
         return;
     }
 
-    wmemcpy(ctx->line, wline, newlen + 1);
-    ctx->pos = newlen;
-    ctx->len = ctx->pos;
+    set_line_buf(ctx, wline, newlen, newlen);
 }
 
 /*
@@ -375,7 +430,7 @@ static bool is_partial_match(const char *s, const char *p, size_t p_len)
 /* Attempts to match /command "<incomplete-dir>" line to matching directories.
  * If there is only one match the line is auto-completed.
  *
- * Returns the diff between old len and new len of ctx->line on success.
+ * Returns the diff between old len and new len of the input line on success.
  * Returns -1 if no matches or more than one match.
  */
 #define MAX_DIRS 75
@@ -444,7 +499,7 @@ int dir_match(ToxWindow *self, Toxic *toxic, const wchar_t *line, const wchar_t
 
     if (dircount > 1) {
         qsort(dirnames, dircount, sizeof(char *), qsort_ptr_char_array_helper);
-        print_ac_matches(self, toxic, dirnames, dircount, true);
+        print_ac_matches(self, toxic, (const char *const *) dirnames, dircount, true);
     }
 
     const int ret = complete_path(self, toxic, (const char *const *) dirnames, dircount);
@@ -28,10 +28,16 @@
  */
 int complete_line(ToxWindow *self, Toxic *toxic, const char *const *list, size_t n_items);
 
+/*
+ * Same as complete_line() for a list sorted with strcasecmp(), such as a room's nick list. Matches
+ * are found by binary search instead of a scan of the whole list.
+ */
+int complete_sorted_line(ToxWindow *self, Toxic *toxic, const char *const *list, size_t n_items);
+
 /* Attempts to match /command "<incomplete-dir>" line to matching directories.
  * If there is only one match the line is auto-completed.
  *
- * Returns the diff between old len and new len of ctx->line on success.
+ * Returns the diff between old len and new len of the input line on success.
  * Returns -1 if no matches or more than one match.
  */
 int dir_match(ToxWindow *self, Toxic *toxic, const wchar_t *line, const wchar_t *cmd);
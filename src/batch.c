@@ -0,0 +1,214 @@
+/*  batch.c
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+#include "batch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "execute.h"
+#include "friendlist.h"
+#include "line_info.h"
+#include "misc_tools.h"
+#include "windows.h"
+
+/* The number of slowest commands reported in the home window */
+#define BATCH_NUM_SLOWEST 3
+
+static bool batch_running;
+
+bool batch_is_running(void)
+{
+    return batch_running;
+}
+
+/* Adds `line` to `script`, taking ownership of it. Returns false on allocation failure. */
+static bool batch_script_add(Batch_Script *script, char *line, size_t line_number)
+{
+    Batch_Command *commands = realloc(script->commands, (script->num_commands + 1) * sizeof(Batch_Command));
+
+    if (commands == NULL) {
+        return false;
+    }
+
+    script->commands = commands;
+    script->commands[script->num_commands++] = (Batch_Command) {
+        line, line_number
+    };
+
+    return true;
+}
+
+Batch_Script *batch_script_read(FILE *fp)
+{
+    Batch_Script *script = calloc(1, sizeof(Batch_Script));
+
+    if (script == NULL) {
+        return NULL;
+    }
+
+    char *buf = NULL;
+    size_t buf_size = 0;
+    size_t line_number = 0;
+    ssize_t length;
+
+    while ((length = getline(&buf, &buf_size, fp)) != -1) {
+        ++line_number;
+
+        while (length > 0 && (buf[length - 1] == '\n' || buf[length - 1] == '\r')) {
+            buf[--length] = '\0';
+        }
+
+        const char *line = buf;
+
+        while (*line == ' ' || *line == '\t') {
+            ++line;
+        }
+
+        if (*line == '\0' || *line == '#') {
+            continue;
+        }
+
+        if (*line != '/' || strlen(line) >= MAX_STR_SIZE) {
+            fprintf(stderr, "batch: line %zu is not a valid command\n", line_number);
+            ++script->num_rejected;
+            continue;
+        }
+
+        char *command = strdup(line);
+
+        if (command == NULL || !batch_script_add(script, command, line_number)) {
+            free(command);
+            free(buf);
+            batch_script_free(script);
+            return NULL;
+        }
+    }
+
+    free(buf);
+
+    if (ferror(fp)) {
+        batch_script_free(script);
+        return NULL;
+    }
+
+    return script;
+}
+
+void batch_script_free(Batch_Script *script)
+{
+    if (script == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < script->num_commands; ++i) {
+        free(script->commands[i].line);
+    }
+
+    free(script->commands);
+    free(script);
+}
+
+/* Writes the command name at the start of `line` to `buf`, leaving out its arguments. */
+static void batch_command_name(const char *line, char *buf, size_t buf_size)
+{
+    const int name_length = char_find(0, line, ' ');
+    snprintf(buf, buf_size, "%.*s", name_length, line);
+}
+
+static void batch_report(const Batch_Script *script, const uint64_t *usec, uint64_t total_usec, Toxic *toxic)
+{
+    ToxWindow *home_window = toxic->home_window;
+    const Client_Config *c_config = toxic->c_config;
+
+    line_info_add(home_window, c_config, false, NULL, NULL, SYS_MSG, 0, 0,
+                  "Batch: ran %zu commands in %.1f ms (%zu lines rejected)", script->num_commands,
+                  total_usec / 1000.0, script->num_rejected);
+
+    if (usec == NULL) {
+        return;
+    }
+
+    char name[MAX_CMDNAME_SIZE];
+
+    for (size_t i = 0; i < script->num_commands; ++i) {
+        batch_command_name(script->commands[i].line, name, sizeof(name));
+        fprintf(stderr, "batch: line %zu %s %.3f ms\n", script->commands[i].line_number, name, usec[i] / 1000.0);
+    }
+
+    size_t slowest[BATCH_NUM_SLOWEST];
+    size_t num_slowest = 0;
+
+    // Insertion into a short sorted list is cheaper than sorting every timing
+    for (size_t i = 0; i < script->num_commands; ++i) {
+        size_t pos = num_slowest;
+
+        while (pos > 0 && usec[slowest[pos - 1]] < usec[i]) {
+            --pos;
+        }
+
+        if (pos >= BATCH_NUM_SLOWEST) {
+            continue;
+        }
+
+        const size_t last = MIN(num_slowest, BATCH_NUM_SLOWEST - 1);
+        memmove(&slowest[pos + 1], &slowest[pos], (last - pos) * sizeof(size_t));
+        slowest[pos] = i;
+        num_slowest = MIN(num_slowest + 1, BATCH_NUM_SLOWEST);
+    }
+
+    for (size_t i = 0; i < num_slowest; ++i) {
+        const Batch_Command *command = &script->commands[slowest[i]];
+        batch_command_name(command->line, name, sizeof(name));
+
+        line_info_add(home_window, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "Batch: %s on line %zu took %.1f ms",
+                      name, command->line_number, usec[slowest[i]] / 1000.0);
+    }
+}
+
+void batch_script_run(const Batch_Script *script, Toxic *toxic)
+{
+    ToxWindow *home_window = toxic->home_window;
+
+    // Without timings the commands still run, only the report is shorter
+    uint64_t *usec = script->num_commands > 0 ? calloc(script->num_commands, sizeof(uint64_t)) : NULL;
+
+    pthread_mutex_lock(&Winthread.lock);
+
+    batch_running = true;
+
+    const uint64_t start = get_monotonic_time_usec();
+
+    for (size_t i = 0; i < script->num_commands; ++i) {
+        const uint64_t command_start = get_monotonic_time_usec();
+
+        execute(home_window->chatwin->history, home_window, toxic, script->commands[i].line, GLOBAL_COMMAND_MODE);
+
+        if (usec != NULL) {
+            usec[i] = get_monotonic_time_usec() - command_start;
+        }
+    }
+
+    batch_running = false;
+
+    // Friends added by the batch were appended to the index unsorted
+    sort_friendlist_index(toxic->friends);
+
+    if (script->num_commands > 0 && store_data(toxic) != 0) {
+        line_info_add(home_window, toxic->c_config, false, NULL, NULL, SYS_MSG, 0, RED,
+                      "WARNING: Failed to save to data file");
+    }
+
+    batch_report(script, usec, get_monotonic_time_usec() - start, toxic);
+
+    flag_interface_refresh();
+
+    pthread_mutex_unlock(&Winthread.lock);
+
+    free(usec);
+}
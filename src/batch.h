@@ -0,0 +1,69 @@
+/*  batch.h
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+/*
+ * Runs a script of commands given with --exec-file at startup. The commands go through execute()
+ * like typed ones, but the whole batch runs under Winthread.lock so that the UI is drawn once when
+ * it ends, and the friend list sort and the profile save are deferred until then.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "toxic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct Batch_Command {
+    char   *line;
+    size_t line_number;
+} Batch_Command;
+
+typedef struct Batch_Script {
+    Batch_Command *commands;
+    size_t num_commands;
+    size_t num_rejected;    /* Lines that were neither commands, comments nor blank, or that were too long */
+} Batch_Script;
+
+/*
+ * Reads one command per line from `fp`. Blank lines and lines starting with '#' are skipped.
+ *
+ * Returns NULL on allocation or read failure.
+ *
+ * The returned script must be freed with batch_script_free().
+ */
+Batch_Script *batch_script_read(FILE *fp);
+
+/*
+ * Runs every command in `script` in the home window, then reports the total and the slowest
+ * commands there. Per-command timings are written to stderr.
+ *
+ * The caller must not hold Winthread.lock.
+ */
+void batch_script_run(const Batch_Script *script, Toxic *toxic);
+
+void batch_script_free(Batch_Script *script);
+
+/*
+ * Returns true while a batch is being run, for work that can wait until the end of it.
+ *
+ * The caller must hold Winthread.lock.
+ */
+bool batch_is_running(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* BATCH_H */
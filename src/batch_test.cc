@@ -0,0 +1,60 @@
+#include "batch.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+Batch_Script *read_script(std::string text)
+{
+    FILE *fp = fmemopen(&text[0], text.size(), "r");
+
+    if (fp == nullptr) {
+        return nullptr;
+    }
+
+    Batch_Script *script = batch_script_read(fp);
+    fclose(fp);
+
+    return script;
+}
+
+TEST(BatchScript, SkipsBlankLinesAndComments)
+{
+    Batch_Script *script = read_script("# provisioning\n\n/nick bot\r\n   \n  /status busy\n/note  two  spaces ");
+    ASSERT_NE(script, nullptr);
+
+    ASSERT_EQ(script->num_commands, 3);
+    EXPECT_STREQ(script->commands[0].line, "/nick bot");
+    EXPECT_EQ(script->commands[0].line_number, 3);
+    EXPECT_STREQ(script->commands[1].line, "/status busy");
+    EXPECT_EQ(script->commands[1].line_number, 5);
+    EXPECT_STREQ(script->commands[2].line, "/note  two  spaces ");
+    EXPECT_EQ(script->num_rejected, 0);
+
+    batch_script_free(script);
+}
+
+TEST(BatchScript, RejectsMessagesAndOverlongLines)
+{
+    Batch_Script *script = read_script("hello\n/" + std::string(MAX_STR_SIZE, 'x') + "\n/clear\n");
+    ASSERT_NE(script, nullptr);
+
+    ASSERT_EQ(script->num_commands, 1);
+    EXPECT_STREQ(script->commands[0].line, "/clear");
+    EXPECT_EQ(script->commands[0].line_number, 3);
+    EXPECT_EQ(script->num_rejected, 2);
+
+    batch_script_free(script);
+}
+
+TEST(BatchScript, EmptyInputHasNoCommands)
+{
+    Batch_Script *script = read_script("");
+    ASSERT_NE(script, nullptr);
+    EXPECT_EQ(script->num_commands, 0);
+    batch_script_free(script);
+}
+
+}  // namespace
@@ -84,6 +84,7 @@ static const char *const chat_cmd_list[] = {
     "/nospam",
     "/quit",
     "/savefile",
+    "/savestats",
     "/sendfile",
     "/status",
 
@@ -97,6 +98,7 @@ static const char *const chat_cmd_list[] = {
     "/mute",
     "/sense",
     "/bitrate",
+    "/audiostats",
 
 #endif /* AUDIO */
 
@@ -148,6 +150,7 @@ void kill_chat_window(ToxWindow *self, Toxic *toxic)
     if (ctx != NULL) {
         log_disable(ctx->log);
         line_info_cleanup(ctx->hst);
+        free_line_hist(ctx);
         cqueue_cleanup(ctx->cqueue);
 
         delwin(ctx->linewin);
@@ -399,19 +402,14 @@ static void chat_onReadReceipt(ToxWindow *self, Toxic *toxic, uint32_t num, uint
 /* Stops active file transfers for this friend. Called when a friend goes offline */
 static void chat_pause_file_transfers(FriendsList *friends, uint32_t friendnum)
 {
-    ToxicFriend *friend = &friends->list[friendnum];
+    for (int direction = FILE_TRANSFER_SEND; direction <= FILE_TRANSFER_RECV; ++direction) {
+        size_t cursor = 0;
+        struct FileTransfer *ft;
 
-    for (size_t i = 0; i < MAX_FILES; ++i) {
-        struct FileTransfer *fts = &friend->file_sender[i];
-
-        if (fts->file_type == TOX_FILE_KIND_DATA && fts->state >= FILE_TRANSFER_STARTED) {
-            fts->state = FILE_TRANSFER_PAUSED;
-        }
-
-        struct FileTransfer *ftr = &friend->file_receiver[i];
-
-        if (ftr->file_type == TOX_FILE_KIND_DATA && ftr->state >= FILE_TRANSFER_STARTED) {
-            ftr->state = FILE_TRANSFER_PAUSED;
+        while ((ft = file_transfer_iterate(friends, friendnum, direction, &cursor)) != NULL) {
+            if (ft->file_type == TOX_FILE_KIND_DATA && ft->state >= FILE_TRANSFER_STARTED) {
+                ft->state = FILE_TRANSFER_PAUSED;
+            }
         }
     }
 }
@@ -419,16 +417,17 @@ static void chat_pause_file_transfers(FriendsList *friends, uint32_t friendnum)
 /* Tries to resume broken file senders. Called when a friend comes online */
 static void chat_resume_file_senders(ToxWindow *self, const Toxic *toxic, uint32_t friendnum)
 {
-    for (size_t i = 0; i < MAX_FILES; ++i) {
-        struct FileTransfer *ft = &toxic->friends->list[friendnum].file_sender[i];
+    size_t cursor = 0;
+    struct FileTransfer *ft;
 
+    while ((ft = file_transfer_iterate(toxic->friends, friendnum, FILE_TRANSFER_SEND, &cursor)) != NULL) {
         if (ft->state != FILE_TRANSFER_PAUSED || ft->file_type != TOX_FILE_KIND_DATA) {
             continue;
         }
 
         Tox_Err_File_Send err;
-        ft->filenumber = tox_file_send(toxic->tox, friendnum, TOX_FILE_KIND_DATA, ft->file_size, ft->file_id,
-                                       (uint8_t *) ft->file_name, strlen(ft->file_name), &err);
+        const uint32_t filenumber = tox_file_send(toxic->tox, friendnum, TOX_FILE_KIND_DATA, ft->file_size, ft->file_id,
+                                    (uint8_t *) ft->file_name, strlen(ft->file_name), &err);
 
         if (err != TOX_ERR_FILE_SEND_OK) {
             char msg[MAX_STR_SIZE];
@@ -436,6 +435,8 @@ static void chat_resume_file_senders(ToxWindow *self, const Toxic *toxic, uint32
             close_file_transfer(self, toxic, ft, TOX_FILE_CONTROL_CANCEL, msg, notif_error);
             continue;
         }
+
+        set_file_transfer_filenumber(toxic->friends, ft, filenumber);
     }
 }
 
@@ -638,18 +639,12 @@ static bool chat_resume_broken_ft(ToxWindow *self, Toxic *toxic, uint32_t friend
     }
 
     bool resuming = false;
-    struct FileTransfer *ft = NULL;
-    size_t i;
-
-    for (i = 0; i < MAX_FILES; ++i) {
-        ft = &toxic->friends->list[friendnum].file_receiver[i];
-
-        if (ft->state == FILE_TRANSFER_INACTIVE) {
-            continue;
-        }
+    size_t cursor = 0;
+    struct FileTransfer *ft;
 
+    while ((ft = file_transfer_iterate(toxic->friends, friendnum, FILE_TRANSFER_RECV, &cursor)) != NULL) {
         if (memcmp(ft->file_id, file_id, TOX_FILE_ID_LENGTH) == 0) {
-            ft->filenumber = filenumber;
+            set_file_transfer_filenumber(toxic->friends, ft, filenumber);
             ft->state = FILE_TRANSFER_STARTED;
             resuming = true;
             break;
@@ -1312,6 +1307,24 @@ static void send_action(ToxWindow *self, ChatContext *ctx, Toxic *toxic, char *a
     cqueue_add(ctx->cqueue, action, strlen(action), OUT_ACTION, id);
 }
 
+static void send_message(ToxWindow *self, ChatContext *ctx, Toxic *toxic, const char *msg)
+{
+    char selfname[TOX_MAX_NAME_LENGTH + 1];
+    tox_self_get_name(toxic->tox, (uint8_t *) selfname);
+
+    const size_t len = tox_self_get_name_size(toxic->tox);
+    selfname[len] = '\0';
+
+    const int id = line_info_add(self, toxic->c_config, true, selfname, NULL, OUT_MSG, 0, 0, "%s", msg);
+    cqueue_add(ctx->cqueue, msg, strlen(msg), OUT_MSG, id);
+}
+
+static bool chat_onPasteLine(ToxWindow *self, Toxic *toxic, const char *line)
+{
+    send_message(self, self->chatwin, toxic, line);
+    return true;
+}
+
 /*
  * Return true if input is recognized by handler
  */
@@ -1321,7 +1334,6 @@ static bool chat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
         return false;
     }
 
-    Tox *tox = toxic->tox;
     const Client_Config *c_config = toxic->c_config;
 
     ChatContext *ctx = self->chatwin;
@@ -1352,7 +1364,7 @@ static bool chat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
     if (ltr || key == L'\n') {    /* char is printable */
         input_new_char(self, toxic, key, x, x2);
 
-        if (ctx->line[0] != '/' && !ctx->self_is_typing && statusbar->connection != TOX_CONNECTION_NONE) {
+        if (line_buf_char(ctx, 0) != '/' && !ctx->self_is_typing && statusbar->connection != TOX_CONNECTION_NONE) {
             set_self_typingstatus(self, toxic, true);
         }
 
@@ -1365,20 +1377,20 @@ static bool chat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
 
     bool input_ret = input_handle(self, toxic, key, x, x2);
 
-    if (key == L'\t' && ctx->len > 1 && ctx->line[0] == '/') {    /* TAB key: auto-complete */
+    if (key == L'\t' && ctx->len > 1 && line_buf_char(ctx, 0) == '/') {    /* TAB key: auto-complete */
         input_ret = true;
         int diff;
 
         /* TODO: make this not suck */
-        if (wcsncmp(ctx->line, L"/sendfile ", wcslen(L"/sendfile ")) == 0) {
-            diff = dir_match(self, toxic, ctx->line, L"/sendfile");
-        } else if (wcsncmp(ctx->line, L"/avatar ", wcslen(L"/avatar ")) == 0) {
-            diff = dir_match(self, toxic, ctx->line, L"/avatar");
+        if (wcsncmp(get_line_buf(ctx), L"/sendfile ", wcslen(L"/sendfile ")) == 0) {
+            diff = dir_match(self, toxic, get_line_buf(ctx), L"/sendfile");
+        } else if (wcsncmp(get_line_buf(ctx), L"/avatar ", wcslen(L"/avatar ")) == 0) {
+            diff = dir_match(self, toxic, get_line_buf(ctx), L"/avatar");
         }
 
 #ifdef PYTHON
-        else if (wcsncmp(ctx->line, L"/run ", wcslen(L"/run ")) == 0) {
-            diff = dir_match(self, toxic, ctx->line, L"/run");
+        else if (wcsncmp(get_line_buf(ctx), L"/run ", wcslen(L"/run ")) == 0) {
+            diff = dir_match(self, toxic, get_line_buf(ctx), L"/run");
         }
 
 #endif
@@ -1389,7 +1401,7 @@ static bool chat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
 
         if (diff >= 0) {
             if (x + diff > x2 - 1) {
-                const int wlen = MAX(0, wcswidth(ctx->line, sizeof(ctx->line) / sizeof(wchar_t)));
+                const int wlen = ctx->line_width;
                 ctx->start = wlen < x2 ? 0 : wlen - x2 + 1;
             }
         } else {
@@ -1400,11 +1412,11 @@ static bool chat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
         input_ret = true;
         rm_trailing_spaces_buf(ctx);
 
-        wstrsubst(ctx->line, L'¶', L'\n');
+        wstrsubst(get_line_buf(ctx), L'¶', L'\n');
 
         char line[MAX_STR_SIZE];
 
-        if (wcs_to_mbs_buf(line, ctx->line, MAX_STR_SIZE) == -1) {
+        if (wcs_to_mbs_buf(line, get_line_buf(ctx), MAX_STR_SIZE) == -1) {
             memset(line, 0, sizeof(line));
             line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, RED, " * Failed to parse message.");
         }
@@ -1412,7 +1424,7 @@ static bool chat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
         const bool contains_blocked_word = string_contains_blocked_word(line, &toxic->client_data);
 
         if (line[0] != '\0' && !contains_blocked_word) {
-            add_line_to_hist(ctx);
+            add_line_to_hist(ctx, &toxic->client_data.input_history, line);
 
             if (line[0] == '/') {
                 if (strcmp(line, "/close") == 0) {
@@ -1424,14 +1436,7 @@ static bool chat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
                     execute(ctx->history, self, toxic, line, CHAT_COMMAND_MODE);
                 }
             } else {
-                char selfname[TOX_MAX_NAME_LENGTH + 1];
-                tox_self_get_name(tox, (uint8_t *) selfname);
-
-                const size_t len = tox_self_get_name_size(tox);
-                selfname[len] = '\0';
-
-                const int id = line_info_add(self, c_config, true, selfname, NULL, OUT_MSG, 0, 0, "%s", line);
-                cqueue_add(ctx->cqueue, line, strlen(line), OUT_MSG, id);
+                send_message(self, ctx, toxic, line);
             }
         }
 
@@ -1482,7 +1487,9 @@ static void chat_onDraw(ToxWindow *self, Toxic *toxic)
     wclear(ctx->linewin);
 
     if (ctx->len > 0) {
-        mvwprintw(ctx->linewin, 0, 0, "%ls", &ctx->line[ctx->start]);
+        wchar_t line[MAX_STR_SIZE];
+        copy_line_buf(ctx, ctx->start, line);
+        mvwprintw(ctx->linewin, 0, 0, "%ls", line);
     }
 
     curs_set(1);
@@ -1646,7 +1653,7 @@ static void chat_onDraw(ToxWindow *self, Toxic *toxic)
 
     UNUSED_VAR(x);
 
-    const int new_x = ctx->start ? x2 - 1 : MAX(0, wcswidth(ctx->line, ctx->pos));
+    const int new_x = ctx->start ? x2 - 1 : line_buf_cursor_width(ctx);
     wmove(self->window, y, new_x);
 
     draw_window_bar(self, toxic->windows);
@@ -1763,6 +1770,10 @@ static void chat_onInit(ToxWindow *self, Toxic *toxic)
 
     line_info_init(ctx->hst);
 
+    uint8_t public_key[TOX_PUBLIC_KEY_SIZE] = {0};
+    tox_friend_get_public_key(tox, self->num, public_key, NULL);
+    init_line_hist(ctx, &toxic->client_data.input_history, public_key, sizeof(public_key));
+
     const int tab_name_colour = friend_config_get_tab_name_colour(toxic->friends, self->num);
     self->colour = tab_name_colour > 0 ? tab_name_colour : WHITE_BAR_FG;
 
@@ -1790,6 +1801,7 @@ ToxWindow *new_chat(FriendsList *friends, uint32_t friendnum)
     ret->type = WINDOW_TYPE_CHAT;
 
     ret->onKey = &chat_onKey;
+    ret->onPasteLine = &chat_onPasteLine;
     ret->onDraw = &chat_onDraw;
     ret->onInit = &chat_onInit;
     ret->onNickRefresh = &chat_onNickRefresh;
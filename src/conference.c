@@ -34,6 +34,7 @@
 #endif /* AUDIO */
 
 #include "audio_device.h"
+#include "audio_mixer.h"
 #include "autocomplete.h"
 #include "conference.h"
 #include "execute.h"
@@ -76,6 +77,9 @@ static const char *const conference_cmd_list[] = {
     "/connect",
     "/decline",
     "/exit",
+#ifdef AUDIO
+    "/gain",
+#endif
     "/group",
 #ifdef GAMES
     "/game",
@@ -93,8 +97,12 @@ static const char *const conference_cmd_list[] = {
     "/nick",
     "/note",
     "/nospam",
+#ifdef AUDIO
+    "/pan",
+#endif
     "/quit",
     "/requests",
+    "/savestats",
 #ifdef AUDIO
     "/ptt",
     "/sense",
@@ -141,6 +149,7 @@ static void kill_conference_window(ToxWindow *self, Windows *windows, const Clie
     if (ctx != NULL) {
         log_disable(ctx->log);
         line_info_cleanup(ctx->hst);
+        free_line_hist(ctx);
         delwin(ctx->linewin);
         delwin(ctx->history);
         delwin(ctx->sidebar);
@@ -246,6 +255,8 @@ int init_conference_win(Toxic *toxic, uint32_t conferencenum, uint8_t type, cons
 
             init_conference_logging(self, toxic, conferencenum);
 
+            settings_load_conference(toxic->windows, toxic->settings_tree, (const uint8_t *) conferences[i].id);
+
             return conferences[i].window_id;
         }
     }
@@ -255,26 +266,48 @@ int init_conference_win(Toxic *toxic, uint32_t conferencenum, uint8_t type, cons
     return -1;
 }
 
-static void free_peer(ConferencePeer *peer)
+static void free_peer(ConferenceChat *chat, ConferencePeer *peer)
 {
 #ifdef AUDIO
 
     if (peer->sending_audio) {
-        close_device(output, peer->audio_out_idx);
+        audio_mixer_remove_input(chat->audio_mixer, peer->mixer_input);
+        peer->sending_audio = false;
     }
 
+#else
+    UNUSED_VAR(chat);
+    UNUSED_VAR(peer);
 #endif
 }
 
+#ifdef AUDIO
+/* Closes the audio output of a conference along with its mixer. */
+static void close_conference_audio_output(ConferenceChat *chat)
+{
+    for (uint32_t i = 0; i < chat->max_idx; ++i) {
+        chat->peer_list[i].sending_audio = false;
+    }
+
+    if (chat->audio_out_open) {
+        close_device(output, chat->audio_out_idx);
+        chat->audio_out_open = false;
+    }
+
+    audio_mixer_free(chat->audio_mixer);
+    chat->audio_mixer = NULL;
+}
+#endif /* AUDIO */
+
 void free_conference(ToxWindow *self, Windows *windows, const Client_Config *c_config, uint32_t conferencenum)
 {
     ConferenceChat *chat = &conferences[conferencenum];
 
-    for (uint32_t i = 0; i < chat->num_peers; ++i) {
+    for (uint32_t i = 0; i < chat->max_idx; ++i) {
         ConferencePeer *peer = &chat->peer_list[i];
 
         if (peer->active) {
-            free_peer(peer);
+            free_peer(chat, peer);
         }
     }
 
@@ -284,10 +317,11 @@ void free_conference(ToxWindow *self, Windows *windows, const Client_Config *c_c
         close_device(input, chat->audio_in_idx);
     }
 
+    close_conference_audio_output(chat);
+
 #endif
 
-    free(chat->name_list);
-    free(chat->peer_list);
+    conference_free_peer_list(chat);
     conferences[conferencenum] = (ConferenceChat) {
         0
     };
@@ -388,6 +422,10 @@ static void conference_onConferenceMessage(ToxWindow *self, Toxic *toxic, uint32
         return;
     }
 
+    if (c_config->filter_blocked_words && string_contains_blocked_word(msg, &toxic->client_data)) {
+        return;
+    }
+
     ChatContext *ctx = self->chatwin;
 
     char nick[TOX_MAX_NAME_LENGTH];
@@ -465,134 +503,288 @@ static void conference_onConferenceTitleChange(ToxWindow *self, Toxic *toxic, ui
     write_to_log(ctx->log, c_config, tmp_event, NULL, LOG_HINT_TOPIC);
 }
 
-/* Puts `(NameListEntry *)`s in `entries` for each matched peer, up to a
- * maximum of `maxpeers`.
- * Maches each peer whose name or pubkey begins with `prefix`.
- * If `prefix` is exactly the pubkey of a peer, matches only that peer.
- * return number of entries placed in `entries`.
- */
-uint32_t get_name_list_entries_by_prefix(uint32_t conferencenum, const char *prefix, NameListEntry **entries,
-        uint32_t maxpeers)
+static int compare_name_list_entries(const void *a, const void *b)
 {
-    ConferenceChat *chat = &conferences[conferencenum];
+    const int cmp1 = qsort_strcasecmp_hlpr(
+                         ((const NameListEntry *)a)->name,
+                         ((const NameListEntry *)b)->name);
 
-    if (!chat->active) {
-        return 0;
+    if (cmp1 == 0) {
+        return qsort_strcasecmp_hlpr(
+                   ((const NameListEntry *)a)->pubkey_str,
+                   ((const NameListEntry *)b)->pubkey_str);
     }
 
-    const size_t len = strlen(prefix);
+    return cmp1;
+}
+
+static void name_list_entry_init(NameListEntry *entry, const ConferencePeer *peer)
+{
+    memcpy(entry->name, peer->name, peer->name_length + 1);
+    snprintf(entry->sidebar_name, sizeof(entry->sidebar_name), "%s", peer->name);
+    tox_pk_bytes_to_str(peer->pubkey, sizeof(peer->pubkey), entry->pubkey_str, sizeof(entry->pubkey_str));
+    entry->peernum = peer->peernum;
+}
 
-    if (len == 2 * TOX_PUBLIC_KEY_SIZE) {
-        for (uint32_t i = 0; i < chat->num_peers; ++i) {
-            NameListEntry *entry = &chat->name_list[i];
+/* Returns the position in the name list where `entry` belongs. */
+static uint32_t name_list_lower_bound(const ConferenceChat *chat, const NameListEntry *entry)
+{
+    uint32_t lo = 0;
+    uint32_t hi = chat->num_peers;
 
-            if (strcasecmp(prefix, entry->pubkey_str) == 0) {
-                entries[0] = entry;
-                return 1;
-            }
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+
+        if (compare_name_list_entries(&chat->name_list[mid], entry) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
 
-    uint32_t n = 0;
+    return lo;
+}
 
-    for (uint32_t i = 0; i < chat->num_peers; ++i) {
-        NameListEntry *entry = &chat->name_list[i];
+/* Returns the name list position of `peer`, or -1 if it isn't in the list. */
+static int64_t name_list_find(const ConferenceChat *chat, const ConferencePeer *peer)
+{
+    NameListEntry entry;
+    name_list_entry_init(&entry, peer);
 
-        if (strncmp(prefix, entry->name, len) == 0
-                || strncasecmp(prefix, entry->pubkey_str, len) == 0) {
-            entries[n] = entry;
-            ++n;
+    const uint32_t pos = name_list_lower_bound(chat, &entry);
 
-            if (n == maxpeers) {
-                return n;
-            }
-        }
+    if (pos >= chat->num_peers || compare_name_list_entries(&chat->name_list[pos], &entry) != 0) {
+        return -1;
     }
 
-    return n;
+    return pos;
 }
 
+static void name_list_add(ConferenceChat *chat, const ConferencePeer *peer)
+{
+    NameListEntry entry;
+    name_list_entry_init(&entry, peer);
 
-static int compare_name_list_entries(const void *a, const void *b)
+    const uint32_t pos = name_list_lower_bound(chat, &entry);
+
+    memmove(&chat->name_list[pos + 1], &chat->name_list[pos], (chat->num_peers - pos) * sizeof(NameListEntry));
+    chat->name_list[pos] = entry;
+    ++chat->num_peers;
+}
+
+static void name_list_remove(ConferenceChat *chat, const ConferencePeer *peer)
 {
-    const int cmp1 = qsort_strcasecmp_hlpr(
-                         ((const NameListEntry *)a)->name,
-                         ((const NameListEntry *)b)->name);
+    const int64_t pos = name_list_find(chat, peer);
 
-    if (cmp1 == 0) {
-        return qsort_strcasecmp_hlpr(
-                   ((const NameListEntry *)a)->pubkey_str,
-                   ((const NameListEntry *)b)->pubkey_str);
+    if (pos < 0) {
+        return;
     }
 
-    return cmp1;
+    memmove(&chat->name_list[pos], &chat->name_list[pos + 1], (chat->num_peers - pos - 1) * sizeof(NameListEntry));
+    --chat->num_peers;
 }
 
-static void conference_update_name_list(uint32_t conferencenum)
+/* Returns the position in the key order of the first peer whose public key compares greater than or
+ * equal to `pubkey`, out of the first `n` entries.
+ */
+static uint32_t key_order_lower_bound(const ConferenceChat *chat, uint32_t n, const uint8_t *pubkey)
+{
+    uint32_t lo = 0;
+    uint32_t hi = n;
+
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+
+        if (memcmp(chat->peer_list[chat->key_order[mid]].pubkey, pubkey, TOX_PUBLIC_KEY_SIZE) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/* Compares the hex string of `pubkey` with the first `length` bytes of `prefix`, ignoring case.
+ * Hex strings sort the same way as the keys they encode. */
+static int key_prefix_cmp(const uint8_t *pubkey, const char *prefix, size_t length)
+{
+    char pubkey_str[PUBKEY_STRING_SIZE];
+    tox_pk_bytes_to_str(pubkey, TOX_PUBLIC_KEY_SIZE, pubkey_str, sizeof(pubkey_str));
+
+    return strncasecmp(pubkey_str, prefix, length);
+}
+
+/* Adds the peer at `peernum` to the first `n` entries of the key order. */
+static void key_order_add(ConferenceChat *chat, uint32_t n, uint32_t peernum)
+{
+    const uint32_t pos = key_order_lower_bound(chat, n, chat->peer_list[peernum].pubkey);
+
+    memmove(&chat->key_order[pos + 1], &chat->key_order[pos], (n - pos) * sizeof(uint32_t));
+    chat->key_order[pos] = peernum;
+}
+
+/* Removes the peer at `peernum` from the first `n` entries of the key order. */
+static void key_order_remove(ConferenceChat *chat, uint32_t n, uint32_t peernum)
+{
+    const uint32_t pos = key_order_lower_bound(chat, n, chat->peer_list[peernum].pubkey);
+
+    if (pos < n && chat->key_order[pos] == peernum) {
+        memmove(&chat->key_order[pos], &chat->key_order[pos + 1], (n - pos - 1) * sizeof(uint32_t));
+    }
+}
+
+/* Puts `(NameListEntry *)`s in `entries` for each matched peer, up to a
+ * maximum of `maxpeers`.
+ * Maches each peer whose name or pubkey begins with `prefix`, name matches first.
+ * If `prefix` is exactly the pubkey of a peer, matches only that peer.
+ * return number of entries placed in `entries`.
+ */
+uint32_t get_name_list_entries_by_prefix(uint32_t conferencenum, const char *prefix, NameListEntry **entries,
+        uint32_t maxpeers)
 {
     ConferenceChat *chat = &conferences[conferencenum];
 
     if (!chat->active) {
-        return;
+        return 0;
     }
 
-    free(chat->name_list);
+    const size_t len = strlen(prefix);
+
+    // Both lists are sorted, so the matches are found by binary search on the case-folded prefix
+    uint32_t key_lo = 0;
+    uint32_t key_hi = chat->num_peers;
 
-    chat->name_list = malloc(chat->num_peers * sizeof(NameListEntry));
+    while (key_lo < key_hi) {
+        const uint32_t mid = key_lo + (key_hi - key_lo) / 2;
 
-    if (chat->name_list == NULL) {
-        exit_toxic_err(FATALERR_MEMORY, "failed in conference_update_name_list");
+        if (key_prefix_cmp(chat->peer_list[chat->key_order[mid]].pubkey, prefix, len) < 0) {
+            key_lo = mid + 1;
+        } else {
+            key_hi = mid;
+        }
     }
 
-    uint32_t count = 0;
+    if (len == 2 * TOX_PUBLIC_KEY_SIZE && key_lo < chat->num_peers
+            && key_prefix_cmp(chat->peer_list[chat->key_order[key_lo]].pubkey, prefix, len) == 0) {
+        const int64_t pos = name_list_find(chat, &chat->peer_list[chat->key_order[key_lo]]);
 
-    for (uint32_t i = 0; i < chat->max_idx; ++i) {
-        const ConferencePeer *peer = &chat->peer_list[i];
-        NameListEntry *entry = &chat->name_list[count];
+        if (pos >= 0 && maxpeers > 0) {
+            entries[0] = &chat->name_list[pos];
+            return 1;
+        }
+    }
 
-        if (peer->active) {
-            memcpy(entry->name, peer->name, peer->name_length + 1);
-            tox_pk_bytes_to_str(peer->pubkey, sizeof(peer->pubkey), entry->pubkey_str, sizeof(entry->pubkey_str));
-            entry->peernum = i;
-            ++count;
+    uint32_t n = 0;
+    uint32_t lo = 0;
+    uint32_t hi = chat->num_peers;
+
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+
+        if (strncasecmp(chat->name_list[mid].name, prefix, len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
 
-    if (count != chat->num_peers) {
-        fprintf(stderr, "WARNING: count != chat->num_peers\n");
+    for (uint32_t i = lo; i < chat->num_peers && n < maxpeers; ++i) {
+        NameListEntry *entry = &chat->name_list[i];
+
+        if (strncasecmp(entry->name, prefix, len) != 0) {
+            break;
+        }
+
+        if (strncmp(prefix, entry->name, len) == 0) {
+            entries[n++] = entry;
+        }
     }
 
-    qsort(chat->name_list, count, sizeof(NameListEntry), compare_name_list_entries);
+    for (uint32_t i = key_lo; i < chat->num_peers && n < maxpeers; ++i) {
+        const ConferencePeer *peer = &chat->peer_list[chat->key_order[i]];
+
+        if (key_prefix_cmp(peer->pubkey, prefix, len) != 0) {
+            break;
+        }
+
+        // Already listed by name
+        if (strncmp(prefix, peer->name, len) == 0) {
+            continue;
+        }
+
+        const int64_t pos = name_list_find(chat, peer);
+
+        if (pos >= 0) {
+            entries[n++] = &chat->name_list[pos];
+        }
+    }
+
+    return n;
 }
 
-/* Reallocates conferencenum's peer list.
+/* Makes room for `num_peers` peers in conferencenum's peer list and name list, growing them geometrically.
+ * New peer list entries are inactive.
  *
  * Returns 0 on success.
  * Returns -1 on failure.
  */
-static int realloc_peer_list(ConferenceChat *chat, uint32_t num_peers)
+static int reserve_peer_list(ConferenceChat *chat, uint32_t num_peers)
 {
-    if (!chat) {
-        return -1;
+    if (num_peers <= chat->peer_list_capacity) {
+        return 0;
     }
 
-    if (num_peers == 0) {
-        free(chat->peer_list);
-        chat->peer_list = NULL;
-        return 0;
+    uint32_t capacity = chat->peer_list_capacity > 0 ? chat->peer_list_capacity : 8;
+
+    while (capacity < num_peers) {
+        capacity *= 2;
     }
 
-    ConferencePeer *tmp_list = realloc(chat->peer_list, num_peers * sizeof(ConferencePeer));
+    ConferencePeer *tmp_list = realloc(chat->peer_list, capacity * sizeof(ConferencePeer));
 
-    if (!tmp_list) {
+    if (tmp_list == NULL) {
         return -1;
     }
 
+    memset(&tmp_list[chat->peer_list_capacity], 0, (capacity - chat->peer_list_capacity) * sizeof(ConferencePeer));
     chat->peer_list = tmp_list;
 
+    NameListEntry *tmp_names = realloc(chat->name_list, capacity * sizeof(NameListEntry));
+
+    if (tmp_names == NULL) {
+        return -1;
+    }
+
+    chat->name_list = tmp_names;
+
+    uint32_t *tmp_order = realloc(chat->key_order, capacity * sizeof(uint32_t));
+
+    if (tmp_order == NULL) {
+        return -1;
+    }
+
+    chat->key_order = tmp_order;
+    chat->peer_list_capacity = capacity;
+
     return 0;
 }
 
+void conference_free_peer_list(ConferenceChat *chat)
+{
+    free(chat->peer_list);
+    free(chat->name_list);
+    free(chat->key_order);
+    hash_index_free(&chat->key_index);
+
+    chat->peer_list = NULL;
+    chat->name_list = NULL;
+    chat->key_order = NULL;
+    chat->peer_list_capacity = 0;
+    chat->max_idx = 0;
+    chat->num_peers = 0;
+}
+
 /* return NULL if peer or conference doesn't exist */
 static ConferencePeer *peer_in_conference(uint32_t conferencenum, uint32_t peernum)
 {
@@ -602,7 +794,7 @@ static ConferencePeer *peer_in_conference(uint32_t conferencenum, uint32_t peern
 
     const ConferenceChat *chat = &conferences[conferencenum];
 
-    if (!chat->active || peernum > chat->max_idx) {
+    if (!chat->active || peernum >= chat->max_idx) {
         return NULL;
     }
 
@@ -641,13 +833,12 @@ static void set_peer_audio_position(Tox *tox, uint32_t conferencenum, uint32_t p
         return;
     }
 
-    // Position peers at distance 1 in front of listener,
-    // ordered left to right by order in peerlist excluding self.
-    uint32_t num_posns = chat->num_peers;
+    // Spread peers evenly from left to right by order in peerlist excluding self.
+    uint32_t num_posns = chat->max_idx;
     uint32_t peer_posn = peernum;
 
-    for (uint32_t i = 0; i < chat->num_peers; ++i) {
-        if (tox_conference_peer_number_is_ours(tox, conferencenum, peernum, NULL)) {
+    for (uint32_t i = 0; i < chat->max_idx; ++i) {
+        if (tox_conference_peer_number_is_ours(tox, conferencenum, i, NULL)) {
             if (i == peernum) {
                 return;
             }
@@ -660,133 +851,288 @@ static void set_peer_audio_position(Tox *tox, uint32_t conferencenum, uint32_t p
         }
     }
 
-    const float angle = asinf(peer_posn - (float)(num_posns - 1) / 2);
-    set_source_position(peer->audio_out_idx, sinf(angle), cosf(angle), 0);
+    const float pan = num_posns > 1 ? 2.0f * peer_posn / (num_posns - 1) - 1.0f : 0.0f;
+    audio_mixer_set_pan(chat->audio_mixer, peer->mixer_input, pan);
 }
 
 #endif // AUDIO
 
 
-static bool find_peer_by_pubkey(const ConferencePeer *list, uint32_t num_peers, uint8_t *pubkey, uint32_t *idx)
+static uint32_t conference_key_hash(const uint8_t *public_key)
 {
-    for (uint32_t i = 0; i < num_peers; ++i) {
-        const ConferencePeer *peer = &list[i];
+    return hash_index_bytes(public_key, TOX_PUBLIC_KEY_SIZE);
+}
 
-        if (peer->active && memcmp(peer->pubkey, pubkey, TOX_PUBLIC_KEY_SIZE) == 0) {
-            if (idx) {
-                *idx = i;
-            }
+typedef struct PeerSlotChange {
+    uint32_t peernum;
+    bool     exists;
+    uint8_t  pubkey[TOX_PUBLIC_KEY_SIZE];
+} PeerSlotChange;
 
-            return true;
-        }
+bool conference_update_peer_list(ConferenceChat *chat, uint32_t num_peers, const ConferencePeerQuery *query)
+{
+    if (reserve_peer_list(chat, num_peers) != 0) {
+        fprintf(stderr, "Warning: reserve_peer_list() failed in conference_update_peer_list()\n");
+        return false;
     }
 
-    return false;
-}
+    const uint32_t num_slots = MAX(num_peers, chat->max_idx);
 
-static void update_peer_list(ToxWindow *self, Toxic *toxic, uint32_t conferencenum, uint32_t num_peers,
-                             uint32_t old_num_peers)
-{
-    ConferenceChat *chat = &conferences[conferencenum];
+    PeerSlotChange *changes = NULL;
+    uint32_t num_changes = 0;
+    uint32_t changes_capacity = 0;
 
-    if (!chat->active) {
-        return;
-    }
+    /* Find the peer numbers whose peer changed. When a peer leaves, toxcore moves its last peer into
+     * the gap, so a leave usually changes two slots no matter how large the conference is. */
+    for (uint32_t i = 0; i < num_slots; ++i) {
+        uint8_t pubkey[TOX_PUBLIC_KEY_SIZE];
+        const bool exists = i < num_peers && query->get_public_key(query->userdata, i, pubkey);
+        const ConferencePeer *peer = &chat->peer_list[i];
 
-    Tox *tox = toxic->tox;
-    const Client_Config *c_config = toxic->c_config;
+        if (exists == peer->active && (!exists || memcmp(peer->pubkey, pubkey, TOX_PUBLIC_KEY_SIZE) == 0)) {
+            continue;
+        }
 
-    ChatContext *ctx = self->chatwin;
+        if (num_changes == changes_capacity) {
+            changes_capacity = changes_capacity > 0 ? changes_capacity * 2 : 8;
+            PeerSlotChange *tmp = realloc(changes, changes_capacity * sizeof(PeerSlotChange));
 
-    ConferencePeer *old_peer_list = malloc(old_num_peers * sizeof(ConferencePeer));
+            if (tmp == NULL) {
+                exit_toxic_err(FATALERR_MEMORY, "failed in conference_update_peer_list");
+            }
+
+            changes = tmp;
+        }
 
-    if (!old_peer_list) {
-        exit_toxic_err(FATALERR_MEMORY, "failed in update_peer_list");
+        PeerSlotChange *change = &changes[num_changes++];
+        change->peernum = i;
+        change->exists = exists;
+
+        if (exists) {
+            memcpy(change->pubkey, pubkey, TOX_PUBLIC_KEY_SIZE);
+        }
     }
 
-    if (chat->peer_list != NULL) {
-        memcpy(old_peer_list, chat->peer_list, old_num_peers * sizeof(ConferencePeer));
+    chat->max_idx = num_peers;
+
+    if (num_changes == 0) {
+        return false;
     }
 
-    if (realloc_peer_list(chat, num_peers) != 0) {
-        free(old_peer_list);
-        fprintf(stderr, "Warning: realloc_peer_list() failed in update_peer_list()\n");
-        return;
+    /* Take the previous occupants out of the changed slots. Those that reappear under another
+     * peer number are found by key; the rest have left. */
+    ConferencePeer *displaced = malloc(num_changes * sizeof(ConferencePeer));
+
+    if (displaced == NULL) {
+        exit_toxic_err(FATALERR_MEMORY, "failed in conference_update_peer_list");
     }
 
-    for (uint32_t i = 0; i < num_peers; ++i) {
-        ConferencePeer *peer = &chat->peer_list[i];
+    HashIndex displaced_index = {0};
+    uint32_t num_keys = chat->num_peers;
+
+    for (uint32_t k = 0; k < num_changes; ++k) {
+        ConferencePeer *peer = &chat->peer_list[changes[k].peernum];
+        displaced[k] = *peer;
+
+        if (peer->active) {
+            const uint32_t hash = conference_key_hash(peer->pubkey);
+            hash_index_remove(&chat->key_index, hash, changes[k].peernum);
+            key_order_remove(chat, num_keys--, changes[k].peernum);
 
-        *peer = (struct ConferencePeer) {
+            if (!hash_index_add(&displaced_index, hash, k)) {
+                exit_toxic_err(FATALERR_MEMORY, "failed in conference_update_peer_list");
+            }
+        }
+
+        *peer = (ConferencePeer) {
             0
         };
+    }
 
-        Tox_Err_Conference_Peer_Query err;
-        tox_conference_peer_get_public_key(tox, conferencenum, i, peer->pubkey, &err);
+    for (uint32_t k = 0; k < num_changes; ++k) {
+        const PeerSlotChange *change = &changes[k];
 
-        if (err != TOX_ERR_CONFERENCE_PEER_QUERY_OK) {
+        if (!change->exists) {
             continue;
         }
 
-        bool new_peer = true;
-        uint32_t j;
+        ConferencePeer *peer = &chat->peer_list[change->peernum];
+        const uint32_t hash = conference_key_hash(change->pubkey);
+        size_t cursor = hash;
+        uint32_t d;
+        bool moved = false;
 
-        if (find_peer_by_pubkey(old_peer_list, old_num_peers, peer->pubkey, &j)) {
-            ConferencePeer *old_peer = &old_peer_list[j];
-            memcpy(peer, old_peer, sizeof(ConferencePeer));
-            old_peer->active = false;
-            new_peer = false;
+        while (hash_index_next(&displaced_index, hash, &cursor, &d)) {
+            if (displaced[d].active && memcmp(displaced[d].pubkey, change->pubkey, TOX_PUBLIC_KEY_SIZE) == 0) {
+                moved = true;
+                break;
+            }
         }
 
-        size_t length = tox_conference_peer_get_name_size(tox, conferencenum, i, &err);
+        if (moved) {
+            const int64_t pos = name_list_find(chat, &displaced[d]);
 
-        if (err != TOX_ERR_CONFERENCE_PEER_QUERY_OK) {
-            continue;
+            *peer = displaced[d];
+            peer->peernum = change->peernum;
+            displaced[d].active = false;
+
+            if (pos >= 0) {
+                chat->name_list[pos].peernum = peer->peernum;
+            } else {
+                name_list_add(chat, peer);
+            }
+        } else {
+            memcpy(peer->pubkey, change->pubkey, TOX_PUBLIC_KEY_SIZE);
+            peer->name_length = query->get_name(query->userdata, change->peernum, peer->name);
+            peer->peernum = change->peernum;
+            peer->active = true;
+
+            name_list_add(chat, peer);
         }
 
-        if (length >= TOX_MAX_NAME_LENGTH) {
-            length = TOX_MAX_NAME_LENGTH - 1;
+        if (!hash_index_add(&chat->key_index, hash, peer->peernum)) {
+            exit_toxic_err(FATALERR_MEMORY, "failed in conference_update_peer_list");
         }
 
-        tox_conference_peer_get_name(tox, conferencenum, i, (uint8_t *) peer->name, &err);
-        peer->name[length] = '\0';
+        key_order_add(chat, num_keys++, peer->peernum);
 
-        if (err != TOX_ERR_CONFERENCE_PEER_QUERY_OK) {
+        if (!moved && query->on_peer_change != NULL) {
+            query->on_peer_change(query->userdata, peer, true);
+        }
+    }
+
+    for (uint32_t k = 0; k < num_changes; ++k) {
+        ConferencePeer *old_peer = &displaced[k];
+
+        if (!old_peer->active) {
             continue;
         }
 
-        peer->active = true;
-        peer->name_length = length;
-        peer->peernum = i;
+        name_list_remove(chat, old_peer);
 
-        if (new_peer && peer->name_length > 0 && timed_out(chat->start_time, CONFERENCE_EVENT_WAIT)) {
-            const char *msg = "has joined the conference";
-            line_info_add(self, c_config, true, peer->name, NULL, CONNECTION, 0, GREEN, "%s", msg);
-            write_to_log(ctx->log, c_config, msg, peer->name, LOG_HINT_CONNECT);
+        if (query->on_peer_change != NULL) {
+            query->on_peer_change(query->userdata, old_peer, false);
         }
 
-#ifdef AUDIO
-        set_peer_audio_position(tox, conferencenum, i);
-#endif
+        free_peer(chat, old_peer);
     }
 
-    conference_update_name_list(conferencenum);
+    hash_index_free(&displaced_index);
+    free(displaced);
+    free(changes);
 
-    for (uint32_t i = 0; i < old_num_peers; ++i) {
-        ConferencePeer *old_peer = &old_peer_list[i];
+    return true;
+}
 
-        if (old_peer->active) {
-            if (old_peer->name_length > 0 && !find_peer_by_pubkey(chat->peer_list, chat->num_peers, old_peer->pubkey, NULL)) {
-                const char *msg = "has left the conference";
-                line_info_add(self, c_config, true, old_peer->name, NULL, DISCONNECTION, 0, RED, "%s", msg);
-                write_to_log(ctx->log, c_config, msg, old_peer->name, LOG_HINT_DISCONNECT);
-            }
+typedef struct ConferenceQueryData {
+    ToxWindow *self;
+    Toxic *toxic;
+    uint32_t conferencenum;
+} ConferenceQueryData;
 
-            free_peer(old_peer);
+static bool conference_query_public_key(void *userdata, uint32_t peernum, uint8_t *public_key)
+{
+    const ConferenceQueryData *data = (const ConferenceQueryData *) userdata;
+
+    Tox_Err_Conference_Peer_Query err;
+    tox_conference_peer_get_public_key(data->toxic->tox, data->conferencenum, peernum, public_key, &err);
+
+    return err == TOX_ERR_CONFERENCE_PEER_QUERY_OK;
+}
+
+static size_t conference_query_name(void *userdata, uint32_t peernum, char *name)
+{
+    const ConferenceQueryData *data = (const ConferenceQueryData *) userdata;
+    Tox *tox = data->toxic->tox;
+
+    Tox_Err_Conference_Peer_Query err;
+    size_t length = tox_conference_peer_get_name_size(tox, data->conferencenum, peernum, &err);
+
+    if (err != TOX_ERR_CONFERENCE_PEER_QUERY_OK || length >= TOX_MAX_NAME_LENGTH) {
+        name[0] = '\0';
+        return 0;
+    }
+
+    tox_conference_peer_get_name(tox, data->conferencenum, peernum, (uint8_t *) name, &err);
+
+    if (err != TOX_ERR_CONFERENCE_PEER_QUERY_OK) {
+        length = 0;
+    }
+
+    name[length] = '\0';
+
+    return length;
+}
+
+static void conference_on_peer_change(void *userdata, const ConferencePeer *peer, bool joined)
+{
+    const ConferenceQueryData *data = (const ConferenceQueryData *) userdata;
+    const Client_Config *c_config = data->toxic->c_config;
+    ChatContext *ctx = data->self->chatwin;
+
+    // peers join with no name set; their join is announced when the name arrives
+    if (peer->name_length == 0) {
+        return;
+    }
+
+    if (joined) {
+        if (!timed_out(conferences[data->conferencenum].start_time, CONFERENCE_EVENT_WAIT)) {
+            return;
         }
+
+        const char *msg = "has joined the conference";
+        line_info_add(data->self, c_config, true, peer->name, NULL, CONNECTION, 0, GREEN, "%s", msg);
+        write_to_log(ctx->log, c_config, msg, peer->name, LOG_HINT_CONNECT);
+    } else {
+        const char *msg = "has left the conference";
+        line_info_add(data->self, c_config, true, peer->name, NULL, DISCONNECTION, 0, RED, "%s", msg);
+        write_to_log(ctx->log, c_config, msg, peer->name, LOG_HINT_DISCONNECT);
+    }
+}
+
+static void update_peer_list(ToxWindow *self, Toxic *toxic, uint32_t conferencenum, uint32_t num_peers)
+{
+    ConferenceChat *chat = &conferences[conferencenum];
+
+    if (!chat->active) {
+        return;
+    }
+
+    ConferenceQueryData data = {
+        self, toxic, conferencenum
+    };
+
+    const ConferencePeerQuery query = {
+        conference_query_public_key, conference_query_name, conference_on_peer_change, &data
+    };
+
+    if (!conference_update_peer_list(chat, num_peers, &query)) {
+        return;
+    }
+
+#ifdef AUDIO
+
+    // Stereo positions follow peer numbers, which may have shifted
+    for (uint32_t i = 0; i < chat->max_idx; ++i) {
+        set_peer_audio_position(toxic->tox, conferencenum, i);
     }
 
-    free(old_peer_list);
+#endif
+}
+
+/* Updates the name of `peernum`, keeping the name list sorted. */
+static void conference_set_peer_name(ConferenceChat *chat, uint32_t peernum, const char *name, size_t length)
+{
+    ConferencePeer *peer = &chat->peer_list[peernum];
+
+    name_list_remove(chat, peer);
+
+    length = MIN(length, TOX_MAX_NAME_LENGTH - 1);
+    memcpy(peer->name, name, length);
+    peer->name[length] = '\0';
+    peer->name_length = length;
+
+    name_list_add(chat, peer);
 }
 
 static void conference_onConferenceNameListChange(ToxWindow *self, Toxic *toxic, uint32_t conferencenum)
@@ -820,19 +1166,13 @@ static void conference_onConferenceNameListChange(ToxWindow *self, Toxic *toxic,
         return;
     }
 
-    const uint32_t old_num = chat->num_peers;
-
-    chat->num_peers = num_peers;
-    chat->max_idx = num_peers;
-    update_peer_list(self, toxic, conferencenum, num_peers, old_num);
+    update_peer_list(self, toxic, conferencenum, num_peers);
 }
 
 static void conference_onConferencePeerNameChange(ToxWindow *self, Toxic *toxic, uint32_t conferencenum,
         uint32_t peernum,
         const char *name, size_t length)
 {
-    UNUSED_VAR(length);
-
     if (toxic == NULL || self == NULL) {
         return;
     }
@@ -862,6 +1202,8 @@ static void conference_onConferencePeerNameChange(ToxWindow *self, Toxic *toxic,
             line_info_add(self, c_config, true, name, NULL, CONNECTION, 0, GREEN, "%s", msg);
             write_to_log(ctx->log, c_config, msg, name, LOG_HINT_CONNECT);
         }
+
+        conference_set_peer_name(&conferences[conferencenum], peernum, name, length);
     }
 
     conference_onConferenceNameListChange(self, toxic, conferencenum);
@@ -883,6 +1225,28 @@ static void send_conference_action(ToxWindow *self, ChatContext *ctx, Toxic *tox
     }
 }
 
+/*
+ * Return true if the message was sent.
+ */
+static bool send_conference_message(ToxWindow *self, Toxic *toxic, const char *msg)
+{
+    Tox_Err_Conference_Send_Message err;
+
+    if (!tox_conference_send_message(toxic->tox, self->num, TOX_MESSAGE_TYPE_NORMAL, (const uint8_t *) msg,
+                                     strlen(msg), &err)) {
+        line_info_add(self, toxic->c_config, false, NULL, NULL, SYS_MSG, 0, RED,
+                      " * Failed to send message (error %d)", err);
+        return false;
+    }
+
+    return true;
+}
+
+static bool conference_onPasteLine(ToxWindow *self, Toxic *toxic, const char *line)
+{
+    return send_conference_message(self, toxic, line);
+}
+
 /* Offset for the peer number box at the top of the statusbar */
 static int sidebar_offset(uint32_t conferencenum)
 {
@@ -898,7 +1262,6 @@ static bool conference_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr
         return false;
     }
 
-    Tox *tox = toxic->tox;
     const Client_Config *c_config = toxic->c_config;
 
     ChatContext *ctx = self->chatwin;
@@ -954,7 +1317,7 @@ static bool conference_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr
             int diff = -1;
 
             /* TODO: make this not suck */
-            if (ctx->line[0] != L'/' || wcscmp(ctx->line, L"/me") == 0) {
+            if (line_buf_char(ctx, 0) != L'/' || wcscmp(get_line_buf(ctx), L"/me") == 0) {
                 const char **complete_strs = calloc(chat->num_peers, sizeof(const char *));
 
                 if (complete_strs) {
@@ -962,12 +1325,12 @@ static bool conference_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr
                         complete_strs[i] = (const char *) chat->name_list[i].name;
                     }
 
-                    diff = complete_line(self, toxic, complete_strs, chat->num_peers);
+                    diff = complete_sorted_line(self, toxic, complete_strs, chat->num_peers);
                     free(complete_strs);
                 }
-            } else if (wcsncmp(ctx->line, L"/avatar ", wcslen(L"/avatar ")) == 0) {
-                diff = dir_match(self, toxic, ctx->line, L"/avatar");
-            } else if (wcsncmp(ctx->line, L"/cinvite ", wcslen(L"/cinvite ")) == 0) {
+            } else if (wcsncmp(get_line_buf(ctx), L"/avatar ", wcslen(L"/avatar ")) == 0) {
+                diff = dir_match(self, toxic, get_line_buf(ctx), L"/avatar");
+            } else if (wcsncmp(get_line_buf(ctx), L"/cinvite ", wcslen(L"/cinvite ")) == 0) {
                 size_t num_friends = friendlist_get_count(toxic->friends);
                 char **friend_names = (char **) malloc_ptr_array(num_friends, TOX_MAX_NAME_LENGTH);
 
@@ -983,12 +1346,12 @@ static bool conference_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr
             }
 
 #ifdef PYTHON
-            else if (wcsncmp(ctx->line, L"/run ", wcslen(L"/run ")) == 0) {
-                diff = dir_match(self, toxic, ctx->line, L"/run");
+            else if (wcsncmp(get_line_buf(ctx), L"/run ", wcslen(L"/run ")) == 0) {
+                diff = dir_match(self, toxic, get_line_buf(ctx), L"/run");
             }
 
 #endif
-            else if (wcsncmp(ctx->line, L"/mute ", wcslen(L"/mute ")) == 0) {
+            else if (wcsncmp(get_line_buf(ctx), L"/mute ", wcslen(L"/mute ")) == 0) {
                 const char **complete_strs = calloc(chat->num_peers, sizeof(const char *));
 
                 if (complete_strs) {
@@ -996,7 +1359,7 @@ static bool conference_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr
                         complete_strs[i] = (const char *) chat->name_list[i].name;
                     }
 
-                    diff = complete_line(self, toxic, complete_strs, chat->num_peers);
+                    diff = complete_sorted_line(self, toxic, complete_strs, chat->num_peers);
 
                     if (diff == -1) {
                         for (uint32_t i = 0; i < chat->num_peers; ++i) {
@@ -1015,7 +1378,7 @@ static bool conference_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr
 
             if (diff != -1) {
                 if (x + diff > x2 - 1) {
-                    int wlen = MAX(0, wcswidth(ctx->line, sizeof(ctx->line) / sizeof(wchar_t)));
+                    int wlen = ctx->line_width;
                     ctx->start = wlen < x2 ? 0 : wlen - x2 + 1;
                 }
             } else {
@@ -1041,11 +1404,11 @@ static bool conference_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr
         input_ret = true;
         rm_trailing_spaces_buf(ctx);
 
-        wstrsubst(ctx->line, L'¶', L'\n');
+        wstrsubst(get_line_buf(ctx), L'¶', L'\n');
 
         char line[MAX_STR_SIZE];
 
-        if (wcs_to_mbs_buf(line, ctx->line, MAX_STR_SIZE) == -1) {
+        if (wcs_to_mbs_buf(line, get_line_buf(ctx), MAX_STR_SIZE) == -1) {
             memset(line, 0, sizeof(line));
             line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, RED, " * Failed to parse message.");
         }
@@ -1053,7 +1416,7 @@ static bool conference_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr
         const bool contains_blocked_word = string_contains_blocked_word(line, &toxic->client_data);
 
         if (line[0] != '\0' && !contains_blocked_word) {
-            add_line_to_hist(ctx);
+            add_line_to_hist(ctx, &toxic->client_data.input_history, line);
 
             if (line[0] == '/') {
                 if (strcmp(line, "/close") == 0) {
@@ -1065,11 +1428,7 @@ static bool conference_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr
                     execute(ctx->history, self, toxic, line, CONFERENCE_COMMAND_MODE);
                 }
             } else {
-                Tox_Err_Conference_Send_Message err;
-
-                if (!tox_conference_send_message(tox, self->num, TOX_MESSAGE_TYPE_NORMAL, (uint8_t *) line, strlen(line), &err)) {
-                    line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, RED, " * Failed to send message (error %d)", err);
-                }
+                send_conference_message(self, toxic, line);
             }
         }
 
@@ -1085,10 +1444,9 @@ static bool conference_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr
     return input_ret;
 }
 
-static void draw_peer(ToxWindow *self, Toxic *toxic, ChatContext *ctx, uint32_t i)
+static void draw_peer(ToxWindow *self, Toxic *toxic, ChatContext *ctx, const NameListEntry *entry)
 {
-    const uint32_t peer_idx = i + conferences[self->num].side_pos;
-    const uint32_t peernum = conferences[self->num].name_list[peer_idx].peernum;
+    const uint32_t peernum = entry->peernum;
     const bool is_self = tox_conference_peer_number_is_ours(toxic->tox, self->num, peernum, NULL);
     const bool audio = conferences[self->num].audio_enabled;
 
@@ -1101,7 +1459,8 @@ static void draw_peer(ToxWindow *self, Toxic *toxic, ChatContext *ctx, uint32_t
         const bool mute = audio_active &&
                           (is_self
                            ? device_is_muted(input, conferences[self->num].audio_in_idx)
-                           : peer != NULL && device_is_muted(output, peer->audio_out_idx));
+                           : peer != NULL && audio_mixer_is_muted(conferences[self->num].audio_mixer,
+                                   peer->mixer_input));
 
         const int aud_attr = A_BOLD | COLOR_PAIR(audio_active && !mute ? GREEN : RED);
         wattron(ctx->sidebar, aud_attr);
@@ -1111,18 +1470,14 @@ static void draw_peer(ToxWindow *self, Toxic *toxic, ChatContext *ctx, uint32_t
 #endif
     }
 
-    /* truncate nick to fit in side panel without modifying list */
-    char tmpnick[TOX_MAX_NAME_LENGTH];
+    /* the audio indicator takes two columns from the pre-truncated nick */
     const int maxlen = SIDEBAR_WIDTH - 2 - 2 * audio;
 
-    memcpy(tmpnick, &conferences[self->num].name_list[peer_idx].name, maxlen);
-    tmpnick[maxlen] = '\0';
-
     if (is_self) {
         wattron(ctx->sidebar, COLOR_PAIR(GREEN));
     }
 
-    wprintw(ctx->sidebar, "%s\n", tmpnick);
+    wprintw(ctx->sidebar, "%.*s\n", maxlen, entry->sidebar_name);
 
     if (is_self) {
         wattroff(ctx->sidebar, COLOR_PAIR(GREEN));
@@ -1166,7 +1521,9 @@ static void conference_onDraw(ToxWindow *self, Toxic *toxic)
     self->x = x2;
 
     if (ctx->len > 0) {
-        mvwprintw(ctx->linewin, 0, 0, "%ls", &ctx->line[ctx->start]);
+        wchar_t line[MAX_STR_SIZE];
+        copy_line_buf(ctx, ctx->start, line);
+        mvwprintw(ctx->linewin, 0, 0, "%ls", line);
     }
 
     wclear(ctx->sidebar);
@@ -1243,11 +1600,16 @@ static void conference_onDraw(ToxWindow *self, Toxic *toxic)
         mvwhline(ctx->sidebar, line, 1, ACS_HLINE, SIDEBAR_WIDTH - 1);
         wattroff(ctx->sidebar, COLOR_PAIR(PEERLIST_LINE));
 
+        const int maxlines = y2 - header_lines - CHATBOX_HEIGHT;
+
         pthread_mutex_lock(&Winthread.lock);
 
-        for (uint32_t i = 0; i < chat->num_peers && i < y2 - header_lines - CHATBOX_HEIGHT; ++i) {
+        /* Keep the last page full after peers leave */
+        chat->side_pos = MAX(0, MIN(chat->side_pos, (int64_t) chat->num_peers - maxlines));
+
+        for (uint32_t i = 0; (int) i < maxlines && chat->side_pos + i < chat->num_peers; ++i) {
             wmove(ctx->sidebar, i + header_lines, 1);
-            draw_peer(self, toxic, ctx, i);
+            draw_peer(self, toxic, ctx, &chat->name_list[chat->side_pos + i]);
         }
 
         pthread_mutex_unlock(&Winthread.lock);
@@ -1258,7 +1620,7 @@ static void conference_onDraw(ToxWindow *self, Toxic *toxic)
 
     UNUSED_VAR(x);
 
-    int new_x = ctx->start ? x2 - 1 : MAX(0, wcswidth(ctx->line, ctx->pos));
+    int new_x = ctx->start ? x2 - 1 : line_buf_cursor_width(ctx);
     wmove(self->window, y, new_x);
 
     draw_window_bar(self, toxic->windows);
@@ -1299,6 +1661,10 @@ static void conference_onInit(ToxWindow *self, Toxic *toxic)
 
     line_info_init(ctx->hst);
 
+    uint8_t conference_id[TOX_CONFERENCE_ID_SIZE] = {0};
+    tox_conference_get_id(toxic->tox, self->num, conference_id);
+    init_line_hist(ctx, &toxic->client_data.input_history, conference_id, sizeof(conference_id));
+
     scrollok(ctx->history, 0);
     wmove(self->window, y2 - CURS_Y_OFFSET, 0);
 }
@@ -1391,6 +1757,7 @@ static ToxWindow *new_conference_chat(uint32_t conferencenum)
     ret->type = WINDOW_TYPE_CONFERENCE;
 
     ret->onKey = &conference_onKey;
+    ret->onPasteLine = &conference_onPasteLine;
     ret->onDraw = &conference_onDraw;
     ret->onInit = &conference_onInit;
     ret->onConferenceMessage = &conference_onConferenceMessage;
@@ -1434,27 +1801,55 @@ void audio_conference_callback(void *tox, uint32_t conferencenum, uint32_t peern
 
     ConferencePeer *peer = peer_in_conference(conferencenum, peernum);
 
-    if (peer == NULL) {
+    if (peer == NULL || sample_rate != CONFAV_SAMPLE_RATE) {
         return;
     }
 
-    if (!peer->sending_audio) {
-        if (open_output_device(&peer->audio_out_idx,
-                               sample_rate, CONFAV_FRAME_DURATION, channels, c_config->VAD_threshold) != de_None) {
+    ConferenceChat *chat = &conferences[conferencenum];
+
+    if (chat->audio_mixer == NULL) {
+        chat->audio_mixer = audio_mixer_new(CONFAV_SAMPLE_RATE, CONFAV_SAMPLES_PER_FRAME);
+
+        if (chat->audio_mixer == NULL) {
+            return;
+        }
+
+        audio_mixer_set_panning(chat->audio_mixer, chat->audio_panning);
+    }
+
+    if (!chat->audio_out_open) {
+        if (open_output_device(&chat->audio_out_idx, CONFAV_SAMPLE_RATE, CONFAV_FRAME_DURATION,
+                               chat->audio_panning ? 2 : 1, c_config->VAD_threshold) != de_None) {
             // TODO: error message?
             return;
         }
 
+        chat->audio_out_open = true;
+    }
+
+    if (!peer->sending_audio) {
+        peer->mixer_input = audio_mixer_add_input(chat->audio_mixer);
+
+        if (peer->mixer_input < 0) {
+            return;
+        }
+
         peer->sending_audio = true;
 
         set_peer_audio_position(tox, conferencenum, peernum);
     }
 
-    write_out(peer->audio_out_idx, pcm, samples, channels, sample_rate);
+    audio_mixer_push(chat->audio_mixer, peer->mixer_input, pcm, samples, channels);
 
     peer->last_audio_time = get_unix_time();
 
-    return;
+    // Peers' frames arrive one at a time; play each mix as soon as every live peer has contributed
+    while (audio_mixer_ready(chat->audio_mixer)) {
+        uint8_t mix_channels;
+        const int16_t *mix = audio_mixer_mix(chat->audio_mixer, &mix_channels);
+
+        write_out(chat->audio_out_idx, mix, CONFAV_SAMPLES_PER_FRAME, mix_channels, CONFAV_SAMPLE_RATE);
+    }
 }
 
 static void conference_read_device_callback(const int16_t *captured, uint32_t size, void *data)
@@ -1564,6 +1959,8 @@ bool disable_conference_audio(ToxWindow *self, Toxic *toxic, uint32_t conference
 
     const bool success = toxav_groupchat_disable_av(toxic->tox, conferencenum) == 0;
 
+    close_conference_audio_output(chat);
+
     if (success) {
         self->is_call = false;
     }
@@ -1593,7 +1990,26 @@ bool conference_mute_peer(const Tox *tox, uint32_t conferencenum, uint32_t peern
     const ConferenceChat *chat = &conferences[conferencenum];
 
     if (!chat->active || !chat->audio_enabled
-            || peernum > chat->max_idx) {
+            || peernum >= chat->max_idx) {
+        return false;
+    }
+
+    const ConferencePeer *peer = peer_in_conference(conferencenum, peernum);
+
+    if (peer == NULL || !peer->sending_audio) {
+        return false;
+    }
+
+    const bool muted = audio_mixer_is_muted(chat->audio_mixer, peer->mixer_input);
+    audio_mixer_set_muted(chat->audio_mixer, peer->mixer_input, !muted);
+    return true;
+}
+
+bool conference_set_peer_gain(uint32_t conferencenum, uint32_t peernum, float gain)
+{
+    const ConferenceChat *chat = &conferences[conferencenum];
+
+    if (!chat->active || !chat->audio_enabled || peernum >= chat->max_idx) {
         return false;
     }
 
@@ -1603,7 +2019,31 @@ bool conference_mute_peer(const Tox *tox, uint32_t conferencenum, uint32_t peern
         return false;
     }
 
-    device_mute(output, peer->audio_out_idx);
+    audio_mixer_set_gain(chat->audio_mixer, peer->mixer_input, gain);
+    return true;
+}
+
+bool conference_set_audio_panning(uint32_t conferencenum, bool enabled)
+{
+    ConferenceChat *chat = &conferences[conferencenum];
+
+    if (!chat->active) {
+        return false;
+    }
+
+    if (chat->audio_panning == enabled) {
+        return true;
+    }
+
+    chat->audio_panning = enabled;
+    audio_mixer_set_panning(chat->audio_mixer, enabled);
+
+    // The output device was opened for the old number of channels; the next frame reopens it
+    if (chat->audio_out_open) {
+        close_device(output, chat->audio_out_idx);
+        chat->audio_out_open = false;
+    }
+
     return true;
 }
 
@@ -11,12 +11,17 @@
 
 #include <time.h>
 
+#include "hash_index.h"
 #include "toxic.h"
 #include "windows.h"
 
 #define CONFERENCE_MAX_TITLE_LENGTH TOX_MAX_NAME_LENGTH
 #define SIDEBAR_WIDTH 16
 
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
 typedef struct ConferencePeer {
     bool       active;
 
@@ -27,7 +32,7 @@ typedef struct ConferencePeer {
     size_t     name_length;
 
     bool       sending_audio;
-    uint32_t   audio_out_idx;
+    int32_t    mixer_input;    /* the peer's input in the conference's audio mixer while sending audio */
     time_t     last_audio_time;
 } ConferencePeer;
 
@@ -40,6 +45,7 @@ typedef struct AudioInputCallbackData {
 #define PUBKEY_STRING_SIZE (2 * TOX_PUBLIC_KEY_SIZE + 1)
 typedef struct NameListEntry {
     char name[TOX_MAX_NAME_LENGTH];
+    char sidebar_name[SIDEBAR_WIDTH - 1];    /* name truncated to fit in the sidebar */
     char pubkey_str[PUBKEY_STRING_SIZE];
     uint32_t peernum;
 } NameListEntry;
@@ -58,11 +64,14 @@ typedef struct {
     char title[CONFERENCE_MAX_TITLE_LENGTH + 1];
     size_t title_length;
 
-    ConferencePeer *peer_list;
-    uint32_t max_idx;
+    ConferencePeer *peer_list;    /* Indexed by peer number */
+    uint32_t max_idx;             /* Number of peers toxcore reports */
+    uint32_t peer_list_capacity;
+    HashIndex key_index;          /* public key -> peer_list index */
 
-    NameListEntry *name_list;
-    uint32_t num_peers;
+    NameListEntry *name_list;     /* Sorted by name then public key */
+    uint32_t *key_order;          /* Peer numbers sorted by public key */
+    uint32_t num_peers;           /* Number of active peers in peer_list and entries in name_list and key_order */
 
     bool push_to_talk_enabled;
     time_t ptt_last_pushed;
@@ -71,8 +80,42 @@ typedef struct {
     time_t last_sent_audio;
     uint32_t audio_in_idx;
     AudioInputCallbackData audio_input_callback_data;
+
+    /* Received audio is mixed into a single output device */
+    struct AudioMixer *audio_mixer;
+    bool audio_out_open;
+    uint32_t audio_out_idx;
+    bool audio_panning;
 } ConferenceChat;
 
+typedef struct ConferencePeerQuery {
+    /* Puts the public key of peer `peernum` in `public_key`. Returns false if the query fails. */
+    bool (*get_public_key)(void *userdata, uint32_t peernum, uint8_t *public_key);
+
+    /* Puts the null terminated name of peer `peernum` in `name`, which holds TOX_MAX_NAME_LENGTH bytes.
+     * Returns the length of the name. */
+    size_t (*get_name)(void *userdata, uint32_t peernum, char *name);
+
+    /* Called for each peer that joined or left. May be NULL. */
+    void (*on_peer_change)(void *userdata, const ConferencePeer *peer, bool joined);
+
+    void *userdata;
+} ConferencePeerQuery;
+
+/*
+ * Brings `chat`'s peer list in line with the `num_peers` peers described by `query`.
+ *
+ * Each peer number's public key is compared against the one already stored for it; only the peer
+ * numbers whose key changed are looked up in the key index and have their names queried, so a
+ * single join or leave costs one key query per peer and O(1) work for everyone who stayed put.
+ *
+ * Returns true if any peer joined, left or changed peer number.
+ */
+bool conference_update_peer_list(ConferenceChat *chat, uint32_t num_peers, const ConferencePeerQuery *query);
+
+/* Frees `chat`'s peer list, name list and key index. */
+void conference_free_peer_list(ConferenceChat *chat);
+
 /* Frees all Toxic associated data structures for a conference (does not call tox_conference_delete() ) */
 void free_conference(ToxWindow *self, Windows *windows, const Client_Config *c_config, uint32_t conferencenum);
 
@@ -132,7 +175,21 @@ void audio_conference_callback(void *tox, uint32_t conferencenum, uint32_t peern
 
 bool conference_mute_self(uint32_t conferencenum);
 bool conference_mute_peer(const Tox *tox, uint32_t conferencenum, uint32_t peernum);
+
+/* Sets the playback gain of a peer, from 0.0 up to AUDIO_MIXER_MAX_GAIN.
+ *
+ * Return true on success.
+ */
+bool conference_set_peer_gain(uint32_t conferencenum, uint32_t peernum, float gain);
+
+/* Enables or disables spreading peers from left to right in stereo. The audio output is reopened
+   with the matching number of channels. */
+bool conference_set_audio_panning(uint32_t conferencenum, bool enabled);
 bool conference_set_VAD_threshold(uint32_t conferencenum, float threshold);
 float conference_get_VAD_threshold(uint32_t conferencenum);
 
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
 #endif /* CONFERENCE_H */
@@ -0,0 +1,116 @@
+/* Churn benchmark for the legacy conference peer list.
+ *
+ * Fills a simulated conference with 1000 peers, then times conference_update_peer_list() over a
+ * stream of single joins and leaves, reporting the average cost per event along with the number
+ * of key and name queries it made. Run with an optional peer count and event count.
+ */
+
+#include "conference.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* Mirrors toxcore's legacy conference, which moves its last peer into the gap left by a departing one. */
+struct FakeConference {
+    std::vector<std::array<uint8_t, TOX_PUBLIC_KEY_SIZE>> keys;
+    std::mt19937 rng{1234};
+    uint64_t key_queries = 0;
+    uint64_t name_queries = 0;
+
+    void add()
+    {
+        std::array<uint8_t, TOX_PUBLIC_KEY_SIZE> key;
+
+        for (uint8_t &byte : key) {
+            byte = rng();
+        }
+
+        keys.push_back(key);
+    }
+
+    void remove(uint32_t peernum)
+    {
+        keys[peernum] = keys.back();
+        keys.pop_back();
+    }
+
+    static bool get_public_key(void *userdata, uint32_t peernum, uint8_t *public_key)
+    {
+        FakeConference *conf = static_cast<FakeConference *>(userdata);
+        ++conf->key_queries;
+        memcpy(public_key, conf->keys[peernum].data(), TOX_PUBLIC_KEY_SIZE);
+        return true;
+    }
+
+    static size_t get_name(void *userdata, uint32_t peernum, char *name)
+    {
+        FakeConference *conf = static_cast<FakeConference *>(userdata);
+        ++conf->name_queries;
+        return snprintf(name, TOX_MAX_NAME_LENGTH, "Peer%02x%02x", conf->keys[peernum][0], conf->keys[peernum][1]);
+    }
+};
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const uint32_t num_peers = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000;
+    const uint32_t num_events = argc > 2 ? strtoul(argv[2], nullptr, 10) : 10000;
+
+    FakeConference conf;
+    ConferenceChat chat{};
+    const ConferencePeerQuery query = {FakeConference::get_public_key, FakeConference::get_name, nullptr, &conf};
+
+    for (uint32_t i = 0; i < num_peers; ++i) {
+        conf.add();
+    }
+
+    const auto fill_start = Clock::now();
+    conference_update_peer_list(&chat, conf.keys.size(), &query);
+    printf("initial fill of %u peers: %8.3f ms\n", num_peers, ms_since(fill_start));
+
+    conf.key_queries = 0;
+    conf.name_queries = 0;
+
+    const auto churn_start = Clock::now();
+
+    // Alternate leaves and joins so the conference stays around num_peers
+    for (uint32_t i = 0; i < num_events; ++i) {
+        if (i % 2 == 0 && !conf.keys.empty()) {
+            conf.remove(conf.rng() % conf.keys.size());
+        } else {
+            conf.add();
+        }
+
+        conference_update_peer_list(&chat, conf.keys.size(), &query);
+    }
+
+    const double churn_ms = ms_since(churn_start);
+
+    printf("%u churn events:        %8.3f ms  (%.2f us/event)\n", num_events, churn_ms, churn_ms * 1000 / num_events);
+    printf("queries per event:      %8.1f keys, %.2f names\n", (double) conf.key_queries / num_events,
+           (double) conf.name_queries / num_events);
+
+    if (chat.num_peers != conf.keys.size()) {
+        fprintf(stderr, "peer count mismatch: %u != %zu\n", chat.num_peers, conf.keys.size());
+        return 1;
+    }
+
+    conference_free_peer_list(&chat);
+
+    return 0;
+}
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "audio_mixer.h"
 #include "conference.h"
 #include "friendlist.h"
 #include "line_info.h"
@@ -168,6 +169,37 @@ void cmd_conference_set_title(WINDOW *window, ToxWindow *self, Toxic *toxic, int
 }
 
 #ifdef AUDIO
+/* Looks up the single peer whose name or public key begins with `prefix`, listing the
+ * candidates if more than one matches.
+ *
+ * Return NULL if no single peer matches.
+ */
+static const NameListEntry *find_conference_peer(ToxWindow *self, const Client_Config *c_config,
+        const char *prefix, const char *cmd)
+{
+    NameListEntry *entries[16];
+    const uint32_t n = get_name_list_entries_by_prefix(self->num, prefix, entries, 16);
+
+    if (n == 0) {
+        print_err(self, c_config, "No such peer");
+        return NULL;
+    }
+
+    if (n > 1) {
+        line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0,
+                      "Multiple matching peers (use %s [public key] to disambiguate):", cmd);
+
+        for (uint32_t i = 0; i < n; ++i) {
+            line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "%s: %s", entries[i]->pubkey_str,
+                          entries[i]->name);
+        }
+
+        return NULL;
+    }
+
+    return entries[0];
+}
+
 void cmd_enable_audio(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
 {
     UNUSED_VAR(window);
@@ -214,34 +246,88 @@ void cmd_conference_mute(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc
             print_err(self, c_config, "No audio input to mute");
         }
     } else {
-        NameListEntry *entries[16];
-        uint32_t n = get_name_list_entries_by_prefix(self->num, argv[1], entries, 16);
+        const NameListEntry *entry = find_conference_peer(self, c_config, argv[1], "/mute");
 
-        if (n == 0) {
-            print_err(self, c_config, "No such peer");
+        if (entry == NULL) {
             return;
         }
 
-        if (n > 1) {
-            print_err(self, c_config, "Multiple matching peers (use /mute [public key] to disambiguate):");
-
-            for (uint32_t i = 0; i < n; ++i) {
-                line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "%s: %s", entries[i]->pubkey_str,
-                              entries[i]->name);
-            }
-
-            return;
-        }
-
-        if (conference_mute_peer(tox, self->num, entries[0]->peernum)) {
+        if (conference_mute_peer(tox, self->num, entry->peernum)) {
             line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "Toggled audio mute status of %s",
-                          entries[0]->name);
+                          entry->name);
         } else {
             print_err(self, c_config, "Peer is not on the call");
         }
     }
 }
 
+void cmd_conference_gain(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
+{
+    UNUSED_VAR(window);
+
+    if (toxic == NULL || self == NULL) {
+        return;
+    }
+
+    const Client_Config *c_config = toxic->c_config;
+
+    if (argc != 2) {
+        print_err(self, c_config, "Usage: /gain <nick>|<pubkey> <percent>");
+        return;
+    }
+
+    char *end;
+    const long percent = strtol(argv[2], &end, 10);
+
+    if (*end || percent < 0 || percent > (long)(AUDIO_MIXER_MAX_GAIN * 100)) {
+        print_err(self, c_config, "Gain must be a percentage from 0 to 200.");
+        return;
+    }
+
+    const NameListEntry *entry = find_conference_peer(self, c_config, argv[1], "/gain");
+
+    if (entry == NULL) {
+        return;
+    }
+
+    if (conference_set_peer_gain(self->num, entry->peernum, percent / 100.0f)) {
+        line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "Set playback volume of %s to %ld%%",
+                      entry->name, percent);
+    } else {
+        print_err(self, c_config, "Peer is not on the call");
+    }
+}
+
+void cmd_conference_pan(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
+{
+    UNUSED_VAR(window);
+
+    if (toxic == NULL || self == NULL) {
+        return;
+    }
+
+    const Client_Config *c_config = toxic->c_config;
+
+    bool enable;
+
+    if (argc == 1 && !strcasecmp(argv[1], "on")) {
+        enable = true;
+    } else if (argc == 1 && !strcasecmp(argv[1], "off")) {
+        enable = false;
+    } else {
+        print_err(self, c_config, "Please specify: on | off");
+        return;
+    }
+
+    if (!conference_set_audio_panning(self->num, enable)) {
+        print_err(self, c_config, "Failed to toggle stereo panning.");
+        return;
+    }
+
+    line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "Stereo panning is %s",
+                  enable ? "enabled" : "disabled");
+}
+
 void cmd_conference_sense(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
 {
     UNUSED_VAR(window);
@@ -0,0 +1,166 @@
+#include "conference.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Key = std::array<uint8_t, TOX_PUBLIC_KEY_SIZE>;
+
+/* Stands in for toxcore's legacy conference peer list, which fills the gap left by a
+ * departing peer with its last peer. */
+struct FakeConference {
+    std::vector<Key> keys;
+    std::vector<std::string> names;
+    uint32_t next_id = 0;
+    uint32_t key_queries = 0;
+    uint32_t name_queries = 0;
+    uint32_t joins = 0;
+    uint32_t leaves = 0;
+
+    void add()
+    {
+        Key key{};
+        const uint32_t id = next_id++;
+        memcpy(key.data(), &id, sizeof(id));
+        keys.push_back(key);
+        names.push_back("Peer" + std::to_string(id % 50));
+    }
+
+    void remove(uint32_t peernum)
+    {
+        keys[peernum] = keys.back();
+        names[peernum] = names.back();
+        keys.pop_back();
+        names.pop_back();
+    }
+
+    ConferencePeerQuery query()
+    {
+        return ConferencePeerQuery{get_public_key, get_name, on_peer_change, this};
+    }
+
+    static bool get_public_key(void *userdata, uint32_t peernum, uint8_t *public_key)
+    {
+        FakeConference *conf = static_cast<FakeConference *>(userdata);
+        ++conf->key_queries;
+        memcpy(public_key, conf->keys[peernum].data(), TOX_PUBLIC_KEY_SIZE);
+        return true;
+    }
+
+    static size_t get_name(void *userdata, uint32_t peernum, char *name)
+    {
+        FakeConference *conf = static_cast<FakeConference *>(userdata);
+        ++conf->name_queries;
+        snprintf(name, TOX_MAX_NAME_LENGTH, "%s", conf->names[peernum].c_str());
+        return strlen(name);
+    }
+
+    static void on_peer_change(void *userdata, const ConferencePeer * /* peer */, bool joined)
+    {
+        FakeConference *conf = static_cast<FakeConference *>(userdata);
+        ++(joined ? conf->joins : conf->leaves);
+    }
+};
+
+class ConferencePeerListTest : public ::testing::Test {
+protected:
+    void TearDown() override
+    {
+        conference_free_peer_list(&chat_);
+    }
+
+    void sync()
+    {
+        const ConferencePeerQuery query = conf_.query();
+        conference_update_peer_list(&chat_, conf_.keys.size(), &query);
+    }
+
+    void expect_matches()
+    {
+        ASSERT_EQ(chat_.max_idx, conf_.keys.size());
+        ASSERT_EQ(chat_.num_peers, conf_.keys.size());
+
+        for (uint32_t i = 0; i < chat_.max_idx; ++i) {
+            const ConferencePeer &peer = chat_.peer_list[i];
+            ASSERT_TRUE(peer.active);
+            ASSERT_EQ(peer.peernum, i);
+            ASSERT_EQ(memcmp(peer.pubkey, conf_.keys[i].data(), TOX_PUBLIC_KEY_SIZE), 0) << "peer " << i;
+        }
+
+        for (uint32_t i = 1; i < chat_.num_peers; ++i) {
+            const uint8_t *prev = chat_.peer_list[chat_.key_order[i - 1]].pubkey;
+            ASSERT_LT(memcmp(prev, chat_.peer_list[chat_.key_order[i]].pubkey, TOX_PUBLIC_KEY_SIZE), 0);
+        }
+
+        for (uint32_t i = 0; i < chat_.num_peers; ++i) {
+            const NameListEntry &entry = chat_.name_list[i];
+            ASSERT_STREQ(entry.name, chat_.peer_list[entry.peernum].name);
+
+            if (i > 0) {
+                const NameListEntry &prev = chat_.name_list[i - 1];
+                const int cmp = strcasecmp(prev.name, entry.name);
+                ASSERT_TRUE(cmp < 0 || (cmp == 0 && strcasecmp(prev.pubkey_str, entry.pubkey_str) < 0));
+            }
+        }
+    }
+
+    ConferenceChat chat_{};
+    FakeConference conf_;
+};
+
+TEST_F(ConferencePeerListTest, TracksChurn)
+{
+    std::mt19937 rng(3);
+
+    for (int i = 0; i < 100; ++i) {
+        conf_.add();
+    }
+
+    sync();
+    expect_matches();
+    EXPECT_EQ(conf_.joins, 100u);
+
+    for (int i = 0; i < 2000; ++i) {
+        if (conf_.keys.empty() || rng() % 2) {
+            conf_.add();
+        } else {
+            conf_.remove(rng() % conf_.keys.size());
+        }
+
+        sync();
+        ASSERT_NO_FATAL_FAILURE(expect_matches()) << "after event " << i;
+    }
+
+    EXPECT_EQ(conf_.joins, conf_.next_id);
+    EXPECT_EQ(conf_.joins - conf_.leaves, conf_.keys.size());
+}
+
+TEST_F(ConferencePeerListTest, QueriesNamesOnlyForNewPeers)
+{
+    for (int i = 0; i < 100; ++i) {
+        conf_.add();
+    }
+
+    sync();
+    conf_.name_queries = 0;
+
+    conf_.remove(10);
+    sync();
+    EXPECT_EQ(conf_.name_queries, 0u);
+    EXPECT_EQ(conf_.leaves, 1u);
+
+    conf_.add();
+    sync();
+    EXPECT_EQ(conf_.name_queries, 1u);
+    expect_matches();
+}
+
+}  // namespace
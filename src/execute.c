@@ -6,6 +6,7 @@
  *  under the GNU General Public License 3.0.
  */
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -53,6 +54,7 @@ static struct cmd_func global_commands[] = {
     { "/q",         cmd_quit          },
     { "/quit",      cmd_quit          },
     { "/requests",  cmd_requests      },
+    { "/savestats", cmd_savestats     },
     { "/status",    cmd_status        },
 #ifdef AUDIO
     { "/lsdev",     cmd_list_devices  },
@@ -88,6 +90,7 @@ static struct cmd_func chat_commands[] = {
     { "/mute",      cmd_mute              },
     { "/sense",     cmd_sense             },
     { "/bitrate",   cmd_bitrate           },
+    { "/audiostats", cmd_audiostats       },
 #endif /* AUDIO */
 #ifdef VIDEO
     { "/vcall",     cmd_vcall             },
@@ -104,7 +107,9 @@ static struct cmd_func conference_commands[] = {
 
 #ifdef AUDIO
     { "/audio",     cmd_enable_audio },
+    { "/gain",      cmd_conference_gain   },
     { "/mute",      cmd_conference_mute   },
+    { "/pan",       cmd_conference_pan    },
     { "/ptt",       cmd_conference_push_to_talk },
     { "/sense",     cmd_conference_sense  },
 #endif /* AUDIO */
@@ -165,13 +170,52 @@ static const char special_commands[][MAX_CMDNAME_SIZE] = {
     "",
 };
 
-/* Returns true if input command is in the special_commands array. */
-static bool is_special_command(const char *input)
+typedef struct CommandEntry {
+    const char *name;
+    size_t length;
+    int mode;          /* The command mode of the table the command comes from */
+    bool special;
+    void (*func)(WINDOW *w, ToxWindow *, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE]);
+} CommandEntry;
+
+#define NUM_TABLE_COMMANDS(table) (sizeof(table) / sizeof(table[0]) - 1)  /* Excludes the NULL terminator */
+
+#define NUM_COMMANDS (NUM_TABLE_COMMANDS(global_commands) + NUM_TABLE_COMMANDS(chat_commands) \
+                      + NUM_TABLE_COMMANDS(conference_commands) + NUM_TABLE_COMMANDS(groupchat_commands))
+
+/* Every command from the tables above, sorted by name length and then by name. Built once on first use. */
+static struct CommandTable {
+    CommandEntry entries[NUM_COMMANDS];
+    size_t count;
+} command_table;
+
+static pthread_once_t command_table_once = PTHREAD_ONCE_INIT;
+
+/* A slice of the input line */
+typedef struct CommandArg {
+    const char *start;
+    size_t length;
+} CommandArg;
+
+static int compare_command_name(const char *name, size_t length, const CommandEntry *entry)
+{
+    if (length != entry->length) {
+        return length < entry->length ? -1 : 1;
+    }
+
+    return memcmp(name, entry->name, length);
+}
+
+static int compare_command_entries(const void *a, const void *b)
 {
-    const int s = char_find(0, input, ' ');
+    const CommandEntry *entry = a;
+    return compare_command_name(entry->name, entry->length, b);
+}
 
-    for (int i = 0; special_commands[i][0] != '\0'; ++i) {
-        if (strncmp(input, special_commands[i], s) == 0) {
+static bool is_special_command(const char *name)
+{
+    for (size_t i = 0; special_commands[i][0] != '\0'; ++i) {
+        if (strcmp(name, special_commands[i]) == 0) {
             return true;
         }
     }
@@ -179,82 +223,118 @@ static bool is_special_command(const char *input)
     return false;
 }
 
-/* Parses commands in the special_commands array. Unlike parse_command, this function
- * does not split the input string at spaces.
- *
- * Returns the number of arguments.
- */
-static int parse_special_command(const char *input, char (*args)[MAX_STR_SIZE])
+static void command_table_add(const struct cmd_func *commands, int mode)
 {
-    int len = strlen(input);
-    int s = char_find(0, input, ' ');
-
-    memcpy(args[0], input, s);
-    args[0][s++] = '\0';    // increment to remove space after "/command "
-
-    if (s >= len) {
-        return 1;  // No additional args
+    for (size_t i = 0; commands[i].name != NULL; ++i) {
+        command_table.entries[command_table.count++] = (CommandEntry) {
+            commands[i].name, strlen(commands[i].name), mode, is_special_command(commands[i].name), commands[i].func
+        };
     }
+}
 
-    memcpy(args[1], input + s, len - s);
-    args[1][len - s] = '\0';
+static void command_table_init(void)
+{
+    command_table_add(global_commands, GLOBAL_COMMAND_MODE);
+    command_table_add(chat_commands, CHAT_COMMAND_MODE);
+    command_table_add(conference_commands, CONFERENCE_COMMAND_MODE);
+    command_table_add(groupchat_commands, GROUPCHAT_COMMAND_MODE);
 
-    return 2;
+    qsort(command_table.entries, command_table.count, sizeof(CommandEntry), compare_command_entries);
 }
 
-/* Parses input command and puts args into arg array.
+/*
+ * Looks up the command `name` of length `length` for `mode`. A command from the mode's own table
+ * takes precedence over a global command of the same name.
  *
- * Returns the number of arguments.
+ * `special` is set to true if the name belongs to a special command in any mode.
+ *
+ * Returns NULL if neither `mode` nor the global commands have the command.
  */
-static int parse_command(const char *input, char (*args)[MAX_STR_SIZE])
+static const CommandEntry *find_command(const char *name, size_t length, int mode, bool *special)
 {
-    if (is_special_command(input)) {
-        return parse_special_command(input, args);
-    }
+    size_t lo = 0;
+    size_t hi = command_table.count;
 
-    char *cmd = strdup(input);
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
 
-    if (cmd == NULL) {
-        return -1;
+        if (compare_command_name(name, length, &command_table.entries[mid]) > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
     }
 
-    int num_args = 0;
+    const CommandEntry *global = NULL;
+    const CommandEntry *own = NULL;
+    *special = false;
 
-    /* characters wrapped in double quotes count as one arg */
-    while (num_args < MAX_NUM_ARGS) {
-        int i = char_find(0, cmd, ' ');    // index of last char in an argument
-        memcpy(args[num_args], cmd, i);
-        args[num_args++][i] = '\0';
+    for (size_t i = lo; i < command_table.count; ++i) {
+        const CommandEntry *entry = &command_table.entries[i];
 
-        if (cmd[i] == '\0') {  // no more args
+        if (compare_command_name(name, length, entry) != 0) {
             break;
         }
 
-        char tmp[MAX_STR_SIZE];
-        snprintf(tmp, sizeof(tmp), "%s", &cmd[i + 1]);
-        strcpy(cmd, tmp);    // tmp will always fit inside cmd
+        *special |= entry->special;
+
+        if (entry->mode == GLOBAL_COMMAND_MODE) {
+            global = entry;
+        } else if (entry->mode == mode) {
+            own = entry;
+        }
     }
 
-    free(cmd);
-    return num_args;
+    return own != NULL ? own : global;
 }
 
-/* Matches command to respective function.
+/* Splits a special command into the command and the rest of the input, spaces included.
  *
- * Returns 0 on match.
- * Returns 1 on no match
+ * Returns the number of arguments.
  */
-static int do_command(WINDOW *w, ToxWindow *self, Toxic *toxic, int num_args, struct cmd_func *commands,
-                      char (*args)[MAX_STR_SIZE])
+static int parse_special_command(const char *input, size_t name_length, CommandArg *args)
 {
-    for (size_t i = 0; commands[i].name != NULL; ++i) {
-        if (strcmp(args[0], commands[i].name) == 0) {
-            (commands[i].func)(w, self, toxic, num_args - 1, args);
-            return 0;
+    args[0] = (CommandArg) {
+        input, name_length
+    };
+
+    if (input[name_length] == '\0' || input[name_length + 1] == '\0') {
+        return 1;  // No additional args
+    }
+
+    const char *rest = input + name_length + 1;
+
+    args[1] = (CommandArg) {
+        rest, strlen(rest)
+    };
+
+    return 2;
+}
+
+/* Splits the input at every space into at most MAX_NUM_ARGS arguments. Input past the last argument
+ * is dropped.
+ *
+ * Returns the number of arguments.
+ */
+static int parse_command(const char *input, CommandArg *args)
+{
+    int num_args = 0;
+
+    while (num_args < MAX_NUM_ARGS) {
+        const size_t length = char_find(0, input, ' ');
+
+        args[num_args++] = (CommandArg) {
+            input, length
+        };
+
+        if (input[length] == '\0') {  // no more args
+            break;
         }
+
+        input += length + 1;
     }
 
-    return 1;
+    return num_args;
 }
 
 void execute(WINDOW *w, ToxWindow *self, Toxic *toxic, const char *input, int mode)
@@ -263,46 +343,29 @@ void execute(WINDOW *w, ToxWindow *self, Toxic *toxic, const char *input, int mo
         return;
     }
 
-    char args[MAX_NUM_ARGS][MAX_STR_SIZE];
-    const int num_args = parse_command(input, args);
-
-    if (num_args <= 0) {
-        fprintf(stderr, "Warning: parse_command(%s, %d) failed in execute()\n", input, mode);
-        return;
-    }
+    pthread_once(&command_table_once, command_table_init);
 
     /* Try to match input command to command functions. If non-global command mode is specified,
-     * try specified mode's commands first, then upon failure try global commands.
-     *
-     * Note: Global commands must come last in case of duplicate command names
+     * the specified mode's commands take precedence over global commands of the same name.
      */
-    switch (mode) {
-        case CHAT_COMMAND_MODE: {
-            if (do_command(w, self, toxic, num_args, chat_commands, args) == 0) {
-                return;
-            }
+    const size_t name_length = char_find(0, input, ' ');
+    bool special;
+    const CommandEntry *command = find_command(input, name_length, mode, &special);
 
-            break;
-        }
-
-        case CONFERENCE_COMMAND_MODE: {
-            if (do_command(w, self, toxic, num_args, conference_commands, args) == 0) {
-                return;
-            }
-
-            break;
-        }
+    CommandArg slices[MAX_NUM_ARGS];
+    const int num_args = special ? parse_special_command(input, name_length, slices) : parse_command(input, slices);
 
-        case GROUPCHAT_COMMAND_MODE: {
-            if (do_command(w, self, toxic, num_args, groupchat_commands, args) == 0) {
-                return;
-            }
+    // Command functions take their arguments as strings, so only the rows in use are filled in
+    char args[MAX_NUM_ARGS][MAX_STR_SIZE];
 
-            break;
-        }
+    for (int i = 0; i < num_args; ++i) {
+        const size_t length = MIN(slices[i].length, MAX_STR_SIZE - 1);
+        memcpy(args[i], slices[i].start, length);
+        args[i][length] = '\0';
     }
 
-    if (do_command(w, self, toxic, num_args, global_commands, args) == 0) {
+    if (command != NULL) {
+        command->func(w, self, toxic, num_args - 1, args);
         return;
     }
 
@@ -14,6 +14,7 @@
 #include "execute.h"
 #include "file_transfers.h"
 #include "friendlist.h"
+#include "hash_index.h"
 #include "line_info.h"
 #include "misc_tools.h"
 #include "notify.h"
@@ -107,20 +108,18 @@ static void refresh_progress_helper(ToxWindow *self, FileTransfer *ft)
  */
 bool refresh_file_transfer_progress(FriendsList *friends, ToxWindow *self, uint32_t friendnumber)
 {
-    bool active = false;
-
     if (friends == NULL) {
         return false;
     }
 
-    for (size_t i = 0; i < MAX_FILES; ++i) {
-        FileTransfer *ft_r = &friends->list[friendnumber].file_receiver[i];
-        FileTransfer *ft_s = &friends->list[friendnumber].file_sender[i];
+    bool active = false;
 
-        refresh_progress_helper(self, ft_r);
-        refresh_progress_helper(self, ft_s);
+    for (int direction = FILE_TRANSFER_SEND; direction <= FILE_TRANSFER_RECV; ++direction) {
+        size_t cursor = 0;
+        FileTransfer *ft;
 
-        if (ft_r->state !=  FILE_TRANSFER_INACTIVE || ft_s->state != FILE_TRANSFER_INACTIVE) {
+        while ((ft = file_transfer_iterate(friends, friendnumber, direction, &cursor)) != NULL) {
+            refresh_progress_helper(self, ft);
             active = true;
         }
     }
@@ -135,80 +134,126 @@ static void clear_file_transfer(FileTransfer *ft)
     };
 }
 
-/* Returns a pointer to friendnumber's FileTransfer struct associated with filenumber.
- * Returns NULL if filenumber is invalid.
- */
-FileTransfer *get_file_transfer_struct(FriendsList *friends, uint32_t friendnumber, uint32_t filenumber)
+static uint32_t transfer_hash(uint32_t friendnumber, uint32_t filenumber, FILE_TRANSFER_DIRECTION direction)
 {
-    if (friends == NULL) {
-        return NULL;
-    }
+    const uint32_t key[3] = {friendnumber, filenumber, (uint32_t) direction};
+    return hash_index_bytes(key, sizeof(key));
+}
 
-    for (size_t i = 0; i < MAX_FILES; ++i) {
-        FileTransfer *ft_send = &friends->list[friendnumber].file_sender[i];
+/* Returns the slot of the active transfer matching the key, or -1 if there is none. */
+static long transfer_find_slot(const FileTransferTable *table, uint32_t friendnumber, uint32_t filenumber,
+                               FILE_TRANSFER_DIRECTION direction)
+{
+    const uint32_t hash = transfer_hash(friendnumber, filenumber, direction);
+    size_t cursor = hash;
+    uint32_t slot;
 
-        if (ft_send->state != FILE_TRANSFER_INACTIVE && ft_send->filenumber == filenumber) {
-            return ft_send;
+    while (hash_index_next(&table->index, hash, &cursor, &slot)) {
+        const FileTransfer *ft = table->slots[slot];
+
+        if (ft->friendnumber == friendnumber && ft->filenumber == filenumber && ft->direction == direction) {
+            return slot;
         }
+    }
 
-        FileTransfer *ft_recv = &friends->list[friendnumber].file_receiver[i];
+    return -1;
+}
 
-        if (ft_recv->state != FILE_TRANSFER_INACTIVE && ft_recv->filenumber == filenumber) {
-            return ft_recv;
-        }
+static FileTransfer *transfer_lookup(const FileTransferTable *table, uint32_t friendnumber, uint32_t filenumber,
+                                     FILE_TRANSFER_DIRECTION direction)
+{
+    const long slot = transfer_find_slot(table, friendnumber, filenumber, direction);
+    return slot >= 0 ? table->slots[slot] : NULL;
+}
+
+/* Adds the transfer in `slot` to the hash index. */
+static bool transfer_index_add(FileTransferTable *table, uint32_t slot)
+{
+    const FileTransfer *ft = table->slots[slot];
+    const uint32_t hash = transfer_hash(ft->friendnumber, ft->filenumber, ft->direction);
+    const long old_slot = transfer_find_slot(table, ft->friendnumber, ft->filenumber, ft->direction);
+
+    // A paused transfer may still hold a filenumber Tox has since reused; the new transfer takes its place
+    if (old_slot >= 0) {
+        hash_index_remove(&table->index, hash, (uint32_t) old_slot);
     }
 
-    return NULL;
+    return hash_index_add(&table->index, hash, slot);
 }
 
-/* Returns a pointer to the FileTransfer struct associated with index with the direction specified.
- * Returns NULL on failure.
+/* Removes `ft` from the hash index, unless another transfer has taken its place there. */
+static void transfer_index_remove(FileTransferTable *table, const FileTransfer *ft)
+{
+    const long slot = transfer_find_slot(table, ft->friendnumber, ft->filenumber, ft->direction);
+
+    if (slot >= 0 && table->slots[slot] == ft) {
+        hash_index_remove(&table->index, transfer_hash(ft->friendnumber, ft->filenumber, ft->direction),
+                          (uint32_t) slot);
+    }
+}
+
+/* Returns the number of an inactive slot, allocating a new one if all are in use.
+ * Returns -1 on allocation failure.
  */
-FileTransfer *get_file_transfer_struct_index(FriendsList *friends, uint32_t friendnumber, uint32_t index,
-        FILE_TRANSFER_DIRECTION direction)
+static long transfer_get_free_slot(FileTransferTable *table)
 {
-    if (direction != FILE_TRANSFER_RECV && direction != FILE_TRANSFER_SEND) {
-        return NULL;
+    for (size_t i = 0; i < table->num_slots; ++i) {
+        if (table->slots[i]->state == FILE_TRANSFER_INACTIVE) {
+            return (long) i;
+        }
+    }
+
+    FileTransfer **slots = realloc(table->slots, (table->num_slots + 1) * sizeof(FileTransfer *));
+
+    if (slots == NULL) {
+        return -1;
     }
 
+    table->slots = slots;
+
+    FileTransfer *ft = calloc(1, sizeof(FileTransfer));
+
+    if (ft == NULL) {
+        return -1;
+    }
+
+    table->slots[table->num_slots] = ft;
+
+    return (long) table->num_slots++;
+}
+
+/* Returns a pointer to friendnumber's FileTransfer struct associated with filenumber.
+ * Returns NULL if filenumber is invalid.
+ */
+FileTransfer *get_file_transfer_struct(FriendsList *friends, uint32_t friendnumber, uint32_t filenumber)
+{
     if (friends == NULL) {
         return NULL;
     }
 
-    for (size_t i = 0; i < MAX_FILES; ++i) {
-        FileTransfer *ft = direction == FILE_TRANSFER_SEND ?
-                           &friends->list[friendnumber].file_sender[i] :
-                           &friends->list[friendnumber].file_receiver[i];
+    FileTransfer *ft = transfer_lookup(&friends->file_transfers, friendnumber, filenumber, FILE_TRANSFER_SEND);
 
-        if (ft->state != FILE_TRANSFER_INACTIVE && ft->index == index) {
-            return ft;
-        }
+    if (ft != NULL) {
+        return ft;
     }
 
-    return NULL;
+    return transfer_lookup(&friends->file_transfers, friendnumber, filenumber, FILE_TRANSFER_RECV);
 }
 
-/* Returns a pointer to an unused file sender.
- * Returns NULL if all file senders are in use.
- */
-static FileTransfer *new_file_sender(FriendsList *friends, ToxWindow *window, uint32_t friendnumber,
-                                     uint32_t filenumber, uint8_t type)
+FileTransfer *file_transfer_iterate(FriendsList *friends, uint32_t friendnumber, FILE_TRANSFER_DIRECTION direction,
+                                    size_t *cursor)
 {
     if (friends == NULL) {
         return NULL;
     }
 
-    for (size_t i = 0; i < MAX_FILES; ++i) {
-        FileTransfer *ft = &friends->list[friendnumber].file_sender[i];
-
-        if (ft->state == FILE_TRANSFER_INACTIVE) {
-            clear_file_transfer(ft);
-            ft->window = window;
-            ft->index = i;
-            ft->friendnumber = friendnumber;
-            ft->filenumber = filenumber;
-            ft->file_type = type;
-            ft->state = FILE_TRANSFER_PENDING;
+    const FileTransferTable *table = &friends->file_transfers;
+
+    while (*cursor < table->num_slots) {
+        FileTransfer *ft = table->slots[*cursor];
+        ++*cursor;
+
+        if (ft->state != FILE_TRANSFER_INACTIVE && ft->friendnumber == friendnumber && ft->direction == direction) {
             return ft;
         }
     }
@@ -216,28 +261,21 @@ static FileTransfer *new_file_sender(FriendsList *friends, ToxWindow *window, ui
     return NULL;
 }
 
-/* Returns a pointer to an unused file receiver.
- * Returns NULL if all file receivers are in use.
+/* Returns a pointer to the FileTransfer struct associated with index with the direction specified.
+ * Returns NULL on failure.
  */
-static FileTransfer *new_file_receiver(FriendsList *friends, ToxWindow *window, uint32_t friendnumber,
-                                       uint32_t filenumber,
-                                       uint8_t type)
+FileTransfer *get_file_transfer_struct_index(FriendsList *friends, uint32_t friendnumber, uint32_t index,
+        FILE_TRANSFER_DIRECTION direction)
 {
-    if (friends == NULL) {
+    if (direction != FILE_TRANSFER_RECV && direction != FILE_TRANSFER_SEND) {
         return NULL;
     }
 
-    for (size_t i = 0; i < MAX_FILES; ++i) {
-        FileTransfer *ft = &friends->list[friendnumber].file_receiver[i];
-
-        if (ft->state == FILE_TRANSFER_INACTIVE) {
-            clear_file_transfer(ft);
-            ft->window = window;
-            ft->index = i;
-            ft->friendnumber = friendnumber;
-            ft->filenumber = filenumber;
-            ft->file_type = type;
-            ft->state = FILE_TRANSFER_PENDING;
+    size_t cursor = 0;
+    FileTransfer *ft;
+
+    while ((ft = file_transfer_iterate(friends, friendnumber, direction, &cursor)) != NULL) {
+        if (ft->index == index) {
             return ft;
         }
     }
@@ -245,21 +283,89 @@ static FileTransfer *new_file_receiver(FriendsList *friends, ToxWindow *window,
     return NULL;
 }
 
+void set_file_transfer_filenumber(FriendsList *friends, FileTransfer *ft, uint32_t filenumber)
+{
+    if (friends == NULL || ft == NULL || ft->state == FILE_TRANSFER_INACTIVE) {
+        return;
+    }
+
+    FileTransferTable *table = &friends->file_transfers;
+
+    // The old key may already belong to a newer transfer that reused the filenumber, so the
+    // slot can't be looked up by key
+    size_t slot = 0;
+
+    while (slot < table->num_slots && table->slots[slot] != ft) {
+        ++slot;
+    }
+
+    if (slot == table->num_slots) {
+        return;
+    }
+
+    transfer_index_remove(table, ft);
+    ft->filenumber = filenumber;
+
+    if (!transfer_index_add(table, (uint32_t) slot)) {
+        fprintf(stderr, "Failed to index file transfer under filenumber %u\n", filenumber);
+    }
+}
+
 /* Initializes an unused file transfer and returns its pointer.
  * Returns NULL on failure.
  */
 FileTransfer *new_file_transfer(FriendsList *friends, ToxWindow *window, uint32_t friendnumber, uint32_t filenumber,
                                 FILE_TRANSFER_DIRECTION direction, uint8_t type)
 {
-    if (direction == FILE_TRANSFER_RECV) {
-        return new_file_receiver(friends, window, friendnumber, filenumber, type);
+    if (friends == NULL || (direction != FILE_TRANSFER_RECV && direction != FILE_TRANSFER_SEND)) {
+        return NULL;
     }
 
-    if (direction == FILE_TRANSFER_SEND) {
-        return new_file_sender(friends, window, friendnumber, filenumber, type);
+    // Transfers are numbered per friend and direction, lowest free number first
+    uint32_t used_indices = 0;
+    size_t cursor = 0;
+    const FileTransfer *other;
+
+    static_assert(MAX_FILES <= 32, "used_indices must have a bit for each index");
+
+    while ((other = file_transfer_iterate(friends, friendnumber, direction, &cursor)) != NULL) {
+        used_indices |= 1U << other->index;
     }
 
-    return NULL;
+    size_t index = 0;
+
+    while (index < MAX_FILES && (used_indices & (1U << index))) {
+        ++index;
+    }
+
+    if (index == MAX_FILES) {
+        return NULL;
+    }
+
+    FileTransferTable *table = &friends->file_transfers;
+    const long slot = transfer_get_free_slot(table);
+
+    if (slot < 0) {
+        return NULL;
+    }
+
+    FileTransfer *ft = table->slots[slot];
+
+    clear_file_transfer(ft);
+    ft->window = window;
+    ft->index = index;
+    ft->friendnumber = friendnumber;
+    ft->filenumber = filenumber;
+    ft->direction = direction;
+    ft->file_type = type;
+    ft->state = FILE_TRANSFER_PENDING;
+
+    if (!transfer_index_add(table, (uint32_t) slot)) {
+        clear_file_transfer(ft);
+        return NULL;
+    }
+
+    return ft;
 }
 
 int file_send_queue_add(FriendsList *friends, uint32_t friendnumber, const char *file_path, size_t length)
@@ -272,23 +378,72 @@ int file_send_queue_add(FriendsList *friends, uint32_t friendnumber, const char
         return -2;
     }
 
-    for (size_t i = 0; i < MAX_FILES; ++i) {
-        PendingFileTransfer *pending_slot = &friends->list[friendnumber].file_send_queue[i];
+    FileTransferTable *table = &friends->file_transfers;
+    uint32_t used_indices = 0;
 
-        if (pending_slot->pending) {
-            continue;
+    for (size_t i = 0; i < table->send_queue_length; ++i) {
+        if (table->send_queue[i].friendnumber == friendnumber) {
+            used_indices |= 1U << table->send_queue[i].index;
         }
+    }
 
-        pending_slot->pending = true;
+    size_t index = 0;
 
-        memcpy(pending_slot->file_path, file_path, length);
-        pending_slot->file_path[length] = 0;
-        pending_slot->length = length;
+    while (index < MAX_FILES && (used_indices & (1U << index))) {
+        ++index;
+    }
 
-        return i;
+    if (index == MAX_FILES) {
+        return -3;
     }
 
-    return -3;
+    PendingFileTransfer *tmp = realloc(table->send_queue, (table->send_queue_length + 1) * sizeof(PendingFileTransfer));
+
+    if (tmp == NULL) {
+        return -3;
+    }
+
+    table->send_queue = tmp;
+
+    PendingFileTransfer *pending = &table->send_queue[table->send_queue_length];
+    ++table->send_queue_length;
+
+    memcpy(pending->file_path, file_path, length);
+    pending->file_path[length] = 0;
+    pending->length = length;
+    pending->friendnumber = friendnumber;
+    pending->index = index;
+
+    return index;
+}
+
+/* Returns the position in the send queue of the item of `friendnumber` with the lowest index,
+ * or -1 if the friend has nothing queued.
+ */
+static long file_send_queue_first(const FileTransferTable *table, uint32_t friendnumber)
+{
+    long first = -1;
+
+    for (size_t i = 0; i < table->send_queue_length; ++i) {
+        const PendingFileTransfer *pending = &table->send_queue[i];
+
+        if (pending->friendnumber == friendnumber && (first < 0 || pending->index < table->send_queue[first].index)) {
+            first = (long) i;
+        }
+    }
+
+    return first;
+}
+
+static void file_send_queue_delete(FileTransferTable *table, size_t pos)
+{
+    --table->send_queue_length;
+    table->send_queue[pos] = table->send_queue[table->send_queue_length];
+
+    if (table->send_queue_length == 0) {
+        free(table->send_queue);
+        table->send_queue = NULL;
+    }
 }
 
 #define FILE_TRANSFER_SEND_CMD "/sendfile "
@@ -300,21 +455,17 @@ void file_send_queue_check(ToxWindow *self, Toxic *toxic, uint32_t friendnumber)
         return;
     }
 
-    for (size_t i = 0; i < MAX_FILES; ++i) {
-        PendingFileTransfer *pending_slot = &toxic->friends->list[friendnumber].file_send_queue[i];
-
-        if (!pending_slot->pending) {
-            continue;
-        }
+    FileTransferTable *table = &toxic->friends->file_transfers;
+    long pos;
 
+    // Items are removed before their command runs, as the command may modify the queue
+    while ((pos = file_send_queue_first(table, friendnumber)) >= 0) {
         char command[TOX_MAX_FILENAME_LENGTH + FILE_TRANSFER_SEND_LEN + 1];
-        snprintf(command, sizeof(command), "%s%s", FILE_TRANSFER_SEND_CMD, pending_slot->file_path);
+        snprintf(command, sizeof(command), "%s%s", FILE_TRANSFER_SEND_CMD, table->send_queue[pos].file_path);
 
-        execute(self->window, self, toxic, command, CHAT_COMMAND_MODE);
+        file_send_queue_delete(table, (size_t) pos);
 
-        *pending_slot = (PendingFileTransfer) {
-            0,
-        };
+        execute(self->window, self, toxic, command, CHAT_COMMAND_MODE);
     }
 }
 
@@ -324,17 +475,18 @@ int file_send_queue_remove(FriendsList *friends, uint32_t friendnumber, size_t i
         return -1;
     }
 
-    PendingFileTransfer *pending_slot = &friends->list[friendnumber].file_send_queue[index];
+    FileTransferTable *table = &friends->file_transfers;
 
-    if (!pending_slot->pending) {
-        return -1;
-    }
+    for (size_t i = 0; i < table->send_queue_length; ++i) {
+        const PendingFileTransfer *pending = &table->send_queue[i];
 
-    *pending_slot = (PendingFileTransfer) {
-        0,
-    };
+        if (pending->friendnumber == friendnumber && pending->index == index) {
+            file_send_queue_delete(table, i);
+            return 0;
+        }
+    }
 
-    return 0;
+    return -1;
 }
 
 /* Closes file transfer ft.
@@ -375,6 +527,7 @@ void close_file_transfer(ToxWindow *self, const Toxic *toxic, FileTransfer *ft,
         line_info_add(self, toxic->c_config, false, NULL, NULL, SYS_MSG, 0, 0, "%s", message);
     }
 
+    transfer_index_remove(&toxic->friends->file_transfers, ft);
     clear_file_transfer(ft);
 }
 
@@ -385,9 +538,10 @@ void kill_avatar_file_transfers_friend(Toxic *toxic, uint32_t friendnumber)
         return;
     }
 
-    for (size_t i = 0; i < MAX_FILES; ++i) {
-        FileTransfer *ft = &toxic->friends->list[friendnumber].file_sender[i];
+    size_t cursor = 0;
+    FileTransfer *ft;
 
+    while ((ft = file_transfer_iterate(toxic->friends, friendnumber, FILE_TRANSFER_SEND, &cursor)) != NULL) {
         if (ft->file_type == TOX_FILE_KIND_AVATAR) {
             close_file_transfer(NULL, toxic, ft, TOX_FILE_CONTROL_CANCEL, NULL, silent);
         }
@@ -401,24 +555,56 @@ void kill_all_file_transfers_friend(Toxic *toxic, uint32_t friendnumber)
         return;
     }
 
+    for (int direction = FILE_TRANSFER_SEND; direction <= FILE_TRANSFER_RECV; ++direction) {
+        size_t cursor = 0;
+        FileTransfer *ft;
+
+        while ((ft = file_transfer_iterate(toxic->friends, friendnumber, direction, &cursor)) != NULL) {
+            close_file_transfer(NULL, toxic, ft, TOX_FILE_CONTROL_CANCEL, NULL, silent);
+        }
+    }
+
     for (size_t i = 0; i < MAX_FILES; ++i) {
-        close_file_transfer(NULL, toxic, &toxic->friends->list[friendnumber].file_sender[i], TOX_FILE_CONTROL_CANCEL, NULL,
-                            silent);
-        close_file_transfer(NULL, toxic, &toxic->friends->list[friendnumber].file_receiver[i], TOX_FILE_CONTROL_CANCEL, NULL,
-                            silent);
         file_send_queue_remove(toxic->friends, friendnumber, i);
     }
 }
 
 void kill_all_file_transfers(Toxic *toxic)
 {
-    if (toxic == NULL) {
+    if (toxic == NULL || toxic->friends == NULL) {
         return;
     }
 
-    for (size_t i = 0; i < toxic->friends->max_idx; ++i) {
-        kill_all_file_transfers_friend(toxic, toxic->friends->list[i].num);
+    const FileTransferTable *table = &toxic->friends->file_transfers;
+
+    for (size_t i = 0; i < table->num_slots; ++i) {
+        close_file_transfer(NULL, toxic, table->slots[i], TOX_FILE_CONTROL_CANCEL, NULL, silent);
+    }
+
+    while (table->send_queue_length > 0) {
+        file_send_queue_delete(&toxic->friends->file_transfers, 0);
+    }
+}
+
+void free_file_transfers(FriendsList *friends)
+{
+    if (friends == NULL) {
+        return;
+    }
+
+    FileTransferTable *table = &friends->file_transfers;
+
+    for (size_t i = 0; i < table->num_slots; ++i) {
+        free(table->slots[i]);
     }
+
+    free(table->slots);
+    hash_index_free(&table->index);
+    free(table->send_queue);
+
+    *table = (FileTransferTable) {
+        0
+    };
 }
 
 bool file_transfer_recv_path_exists(const FriendsList *friends, const char *path)
@@ -427,21 +613,17 @@ bool file_transfer_recv_path_exists(const FriendsList *friends, const char *path
         return false;
     }
 
-    for (size_t friendnumber = 0; friendnumber < friends->max_idx; ++friendnumber) {
-        if (!friends->list[friendnumber].active) {
-            continue;
-        }
+    const FileTransferTable *table = &friends->file_transfers;
 
-        for (size_t i = 0; i < MAX_FILES; ++i) {
-            FileTransfer *ft = &friends->list[friendnumber].file_receiver[i];
+    for (size_t i = 0; i < table->num_slots; ++i) {
+        const FileTransfer *ft = table->slots[i];
 
-            if (ft->state == FILE_TRANSFER_INACTIVE) {
-                continue;
-            }
+        if (ft->state == FILE_TRANSFER_INACTIVE || ft->direction != FILE_TRANSFER_RECV) {
+            continue;
+        }
 
-            if (strcmp(path, ft->file_path) == 0) {
-                return true;
-            }
+        if (strcmp(path, ft->file_path) == 0) {
+            return true;
         }
     }
 
@@ -12,10 +12,15 @@
 #include <limits.h>
 #include <time.h>
 
+#include "hash_index.h"
 #include "notify.h"
 #include "toxic.h"
 #include "windows.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
 #define KiB (uint32_t)  1024
 #define MiB (uint32_t) (1024 << 10)  /* 1024^2 */
 #define GiB (uint32_t) (1024 << 20)  /* 1024^3 */
@@ -40,6 +45,7 @@ typedef struct FileTransfer {
     ToxWindow *window;
     FILE *file;
     FILE_TRANSFER_STATE state;
+    FILE_TRANSFER_DIRECTION direction;
     uint8_t file_type;
     char file_name[TOX_MAX_FILENAME_LENGTH + 1];
     char file_path[TOXIC_MAX_PATH_LENGTH + 1];    /* Not used by senders */
@@ -58,9 +64,26 @@ typedef struct PendingFileTransfer {
     char      file_path[TOX_MAX_FILENAME_LENGTH + 1];
     size_t    length;
     uint32_t  friendnumber;
-    bool      pending;
+    size_t    index;
 } PendingFileTransfer;
 
+/* The file transfers of all friends. Memory is only taken by transfers in progress, so
+ * friends who never exchange files cost nothing here.
+ *
+ * Each transfer lives in a slot of its own that is reused once the transfer closes but
+ * never moves, so FileTransfer pointers stay valid. Active transfers are indexed by
+ * (friendnumber, filenumber, direction) in a hash index over the slots.
+ */
+typedef struct FileTransferTable {
+    FileTransfer **slots;
+    size_t num_slots;
+
+    HashIndex index;
+
+    PendingFileTransfer *send_queue;
+    size_t send_queue_length;
+} FileTransferTable;
+
 
 /* creates initial progress line that will be updated during file transfer.
    progline must be at lesat MAX_STR_SIZE bytes */
@@ -87,6 +110,17 @@ struct FileTransfer *get_file_transfer_struct(FriendsList *friends, uint32_t fri
 struct FileTransfer *get_file_transfer_struct_index(FriendsList *friends, uint32_t friendnumber, uint32_t index,
         FILE_TRANSFER_DIRECTION direction);
 
+/* Iterates over the active file transfers of `friendnumber` in `direction`. `cursor` must
+ * be set to 0 before the first call. Transfers may be closed while iterating.
+ *
+ * Returns NULL once every transfer has been visited.
+ */
+struct FileTransfer *file_transfer_iterate(FriendsList *friends, uint32_t friendnumber,
+        FILE_TRANSFER_DIRECTION direction, size_t *cursor);
+
+/* Changes the Tox filenumber of `ft`, as happens when a broken transfer is resumed. */
+void set_file_transfer_filenumber(FriendsList *friends, struct FileTransfer *ft, uint32_t filenumber);
+
 /* Initializes an unused file transfer and returns its pointer.
  * Returns NULL on failure.
  */
@@ -135,7 +169,14 @@ void kill_all_file_transfers_friend(Toxic *toxic, uint32_t friendnumber);
 
 void kill_all_file_transfers(Toxic *toxic);
 
+/* Frees the memory held by the file transfer table of `friends`. All transfers must be closed. */
+void free_file_transfers(FriendsList *friends);
+
 /* Return true if any pending or active file receiver has the path `path`. */
 bool file_transfer_recv_path_exists(const FriendsList *friends, const char *path);
 
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
 #endif /* FILE_TRANSFERS_H */
@@ -0,0 +1,138 @@
+#include "file_transfers.h"
+#include "friendlist.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+class FileTransfersTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        toxic_.friends = &friends_;
+    }
+
+    void TearDown() override
+    {
+        free_file_transfers(&friends_);
+    }
+
+    void close(FileTransfer *ft)
+    {
+        close_file_transfer(nullptr, &toxic_, ft, -1, nullptr, silent);
+    }
+
+    FriendsList friends_{};
+    Toxic toxic_{};
+};
+
+TEST_F(FileTransfersTest, FindsTransfersByFilenumberAndIndex)
+{
+    FileTransfer *send = new_file_transfer(&friends_, nullptr, 3, 0, FILE_TRANSFER_SEND, TOX_FILE_KIND_DATA);
+    FileTransfer *recv = new_file_transfer(&friends_, nullptr, 3, 1 << 16, FILE_TRANSFER_RECV, TOX_FILE_KIND_DATA);
+    ASSERT_NE(send, nullptr);
+    ASSERT_NE(recv, nullptr);
+
+    EXPECT_EQ(get_file_transfer_struct(&friends_, 3, 0), send);
+    EXPECT_EQ(get_file_transfer_struct(&friends_, 3, 1 << 16), recv);
+    EXPECT_EQ(get_file_transfer_struct(&friends_, 4, 0), nullptr);
+
+    // Indices are counted per friend and direction
+    EXPECT_EQ(send->index, 0u);
+    EXPECT_EQ(recv->index, 0u);
+    EXPECT_EQ(get_file_transfer_struct_index(&friends_, 3, 0, FILE_TRANSFER_RECV), recv);
+
+    close(send);
+    EXPECT_EQ(get_file_transfer_struct(&friends_, 3, 0), nullptr);
+    EXPECT_EQ(get_file_transfer_struct(&friends_, 3, 1 << 16), recv);
+}
+
+TEST_F(FileTransfersTest, ManyFriendsSurviveRehashAndRemoval)
+{
+    std::vector<FileTransfer *> transfers;
+
+    for (uint32_t friendnumber = 0; friendnumber < 500; ++friendnumber) {
+        for (uint32_t filenumber = 0; filenumber < 4; ++filenumber) {
+            FileTransfer *ft = new_file_transfer(&friends_, nullptr, friendnumber, filenumber, FILE_TRANSFER_SEND,
+                                                 TOX_FILE_KIND_DATA);
+            ASSERT_NE(ft, nullptr);
+            EXPECT_EQ(ft->index, filenumber);
+            transfers.push_back(ft);
+        }
+    }
+
+    // Close every other transfer, then check the rest are still found
+    for (size_t i = 0; i < transfers.size(); i += 2) {
+        close(transfers[i]);
+    }
+
+    for (size_t i = 0; i < transfers.size(); ++i) {
+        const uint32_t friendnumber = i / 4;
+        const uint32_t filenumber = i % 4;
+        FileTransfer *expected = i % 2 ? transfers[i] : nullptr;
+
+        ASSERT_EQ(get_file_transfer_struct(&friends_, friendnumber, filenumber), expected) << "transfer " << i;
+    }
+
+    // Closed slots are reused, so the table doesn't grow past its peak
+    FileTransfer *reused = new_file_transfer(&friends_, nullptr, 0, 100, FILE_TRANSFER_RECV, TOX_FILE_KIND_DATA);
+    EXPECT_EQ(reused, transfers[0]);
+    EXPECT_EQ(friends_.file_transfers.num_slots, transfers.size());
+}
+
+TEST_F(FileTransfersTest, LimitsTransfersPerFriend)
+{
+    for (uint32_t i = 0; i < MAX_FILES; ++i) {
+        ASSERT_NE(new_file_transfer(&friends_, nullptr, 7, i, FILE_TRANSFER_RECV, TOX_FILE_KIND_DATA), nullptr);
+    }
+
+    EXPECT_EQ(new_file_transfer(&friends_, nullptr, 7, MAX_FILES, FILE_TRANSFER_RECV, TOX_FILE_KIND_DATA), nullptr);
+    EXPECT_NE(new_file_transfer(&friends_, nullptr, 7, MAX_FILES, FILE_TRANSFER_SEND, TOX_FILE_KIND_DATA), nullptr);
+    EXPECT_NE(new_file_transfer(&friends_, nullptr, 8, MAX_FILES, FILE_TRANSFER_RECV, TOX_FILE_KIND_DATA), nullptr);
+}
+
+TEST_F(FileTransfersTest, RekeysResumedTransfers)
+{
+    FileTransfer *ft = new_file_transfer(&friends_, nullptr, 1, 5, FILE_TRANSFER_SEND, TOX_FILE_KIND_DATA);
+    ASSERT_NE(ft, nullptr);
+
+    set_file_transfer_filenumber(&friends_, ft, 9);
+
+    EXPECT_EQ(get_file_transfer_struct(&friends_, 1, 5), nullptr);
+    EXPECT_EQ(get_file_transfer_struct(&friends_, 1, 9), ft);
+}
+
+TEST_F(FileTransfersTest, RekeysPausedTransferWhoseFilenumberWasReused)
+{
+    FileTransfer *paused = new_file_transfer(&friends_, nullptr, 1, 5, FILE_TRANSFER_SEND, TOX_FILE_KIND_DATA);
+    ASSERT_NE(paused, nullptr);
+    paused->state = FILE_TRANSFER_PAUSED;
+
+    FileTransfer *avatar = new_file_transfer(&friends_, nullptr, 1, 5, FILE_TRANSFER_SEND, TOX_FILE_KIND_AVATAR);
+    ASSERT_NE(avatar, nullptr);
+    EXPECT_EQ(get_file_transfer_struct(&friends_, 1, 5), avatar);
+
+    set_file_transfer_filenumber(&friends_, paused, 9);
+
+    EXPECT_EQ(get_file_transfer_struct(&friends_, 1, 9), paused);
+    EXPECT_EQ(get_file_transfer_struct(&friends_, 1, 5), avatar);
+}
+
+TEST_F(FileTransfersTest, SendQueueIsPerFriend)
+{
+    const char *path = "/tmp/file";
+
+    EXPECT_EQ(file_send_queue_add(&friends_, 1, path, strlen(path)), 0);
+    EXPECT_EQ(file_send_queue_add(&friends_, 1, path, strlen(path)), 1);
+    EXPECT_EQ(file_send_queue_add(&friends_, 2, path, strlen(path)), 0);
+
+    EXPECT_EQ(file_send_queue_remove(&friends_, 1, 0), 0);
+    EXPECT_EQ(file_send_queue_remove(&friends_, 1, 0), -1);
+    EXPECT_EQ(file_send_queue_add(&friends_, 1, path, strlen(path)), 0);
+    EXPECT_EQ(friends_.file_transfers.send_queue_length, 3u);
+}
+
+}  // namespace
@@ -7,6 +7,7 @@
  */
 
 #include <arpa/inet.h>
+#include <ctype.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,6 +23,7 @@
 #include "log.h"
 #include "misc_tools.h"
 #include "notify.h"
+#include "profile_save.h"
 #include "prompt.h"
 #include "settings.h"
 #include "toxic.h"
@@ -37,6 +39,7 @@ struct BlockedList {
     int num_blocked;
     uint32_t *index;
     BlockedFriend *list;
+    HashIndex key_index;
 };
 
 void init_friendlist(Toxic *toxic)
@@ -94,13 +97,49 @@ void friend_reset_default_config_settings(FriendsList *friends, const Client_Con
     }
 }
 
-static void realloc_friends(FriendsList *friends, int n)
+static void friend_hash_add(HashIndex *index, uint32_t hash, uint32_t slot)
 {
-    if (n <= 0) {
-        free(friends->list);
-        free(friends->index);
-        friends->list = NULL;
-        friends->index = NULL;
+    if (!hash_index_add(index, hash, slot)) {
+        exit_toxic_err(FATALERR_MEMORY, "failed in friend_hash_add");
+    }
+}
+
+static uint32_t friend_key_hash(const char *public_key)
+{
+    return hash_index_bytes(public_key, TOX_PUBLIC_KEY_SIZE);
+}
+
+#define MIN_FRIENDS_CAPACITY 16
+
+static void clear_friendlist_index(FriendsList *friends, size_t idx)
+{
+    friends->list[idx] = (ToxicFriend) {
+        0
+    };
+}
+
+static void free_friends(FriendsList *friends)
+{
+    free(friends->list);
+    free(friends->index);
+    free(friends->free_slots);
+    hash_index_free(&friends->key_index);
+    hash_index_free(&friends->name_index);
+    friends->list = NULL;
+    friends->index = NULL;
+    friends->free_slots = NULL;
+    friends->capacity = 0;
+    friends->num_free_slots = 0;
+    friends->free_slots_capacity = 0;
+}
+
+/*
+ * Resizes the friend list to hold exactly `n` entries. `n` must not be less than max_idx.
+ */
+static void realloc_friends(FriendsList *friends, size_t n)
+{
+    if (n == 0) {
+        free_friends(friends);
         return;
     }
 
@@ -113,11 +152,132 @@ static void realloc_friends(FriendsList *friends, int n)
 
     friends->list = f;
     friends->index = f_idx;
+    friends->capacity = n;
+}
+
+/*
+ * Makes room for at least `n` entries, growing the list geometrically so that adding
+ * friends one at a time is amortized O(1).
+ */
+static void reserve_friends(FriendsList *friends, size_t n)
+{
+    if (n <= friends->capacity) {
+        return;
+    }
+
+    size_t capacity = friends->capacity > 0 ? friends->capacity : MIN_FRIENDS_CAPACITY;
+
+    while (capacity < n) {
+        capacity *= 2;
+    }
+
+    realloc_friends(friends, capacity);
+}
+
+/*
+ * Releases memory once the list has shrunk to a quarter of its capacity. Halving rather
+ * than trimming to fit keeps alternating adds and deletes from reallocating each time.
+ */
+static void shrink_friends(FriendsList *friends)
+{
+    if (friends->max_idx == 0) {
+        free_friends(friends);
+        return;
+    }
+
+    if (friends->capacity <= MIN_FRIENDS_CAPACITY || friends->max_idx > friends->capacity / 4) {
+        return;
+    }
+
+    realloc_friends(friends, friends->capacity / 2);
+}
+
+static void free_slot_push(FriendsList *friends, uint32_t slot)
+{
+    if (friends->num_free_slots == friends->free_slots_capacity) {
+        const size_t capacity = friends->free_slots_capacity > 0 ? friends->free_slots_capacity * 2 : 8;
+        uint32_t *tmp = realloc(friends->free_slots, capacity * sizeof(uint32_t));
+
+        if (tmp == NULL) {
+            exit_toxic_err(FATALERR_MEMORY, "failed in free_slot_push");
+        }
+
+        friends->free_slots = tmp;
+        friends->free_slots_capacity = capacity;
+    }
+
+    uint32_t *heap = friends->free_slots;
+    size_t i = friends->num_free_slots++;
+
+    while (i > 0 && heap[(i - 1) / 2] > slot) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+
+    heap[i] = slot;
+}
+
+static uint32_t free_slot_pop(FriendsList *friends)
+{
+    uint32_t *heap = friends->free_slots;
+    const uint32_t top = heap[0];
+    const uint32_t last = heap[--friends->num_free_slots];
+    const size_t n = friends->num_free_slots;
+    size_t i = 0;
+
+    while (2 * i + 1 < n) {
+        size_t child = 2 * i + 1;
+
+        if (child + 1 < n && heap[child + 1] < heap[child]) {
+            ++child;
+        }
+
+        if (heap[child] >= last) {
+            break;
+        }
+
+        heap[i] = heap[child];
+        i = child;
+    }
+
+    if (n > 0) {
+        heap[i] = last;
+    }
+
+    return top;
+}
+
+/*
+ * Returns the lowest inactive slot in the friend list, appending a new one if there are no
+ * gaps, and clears it. This mirrors how toxcore numbers friends so slot and friend number agree.
+ *
+ * Deleted slots stay in the free list when max_idx shrinks past them or when they're reused by
+ * an append, so stale entries are skipped here.
+ */
+static uint32_t take_friend_slot(FriendsList *friends)
+{
+    while (friends->num_free_slots > 0) {
+        const uint32_t slot = free_slot_pop(friends);
+
+        if (slot < friends->max_idx && !friends->list[slot].active) {
+            clear_friendlist_index(friends, slot);
+            return slot;
+        }
+    }
+
+    reserve_friends(friends, friends->max_idx + 1);
+
+    const uint32_t slot = friends->max_idx;
+    clear_friendlist_index(friends, slot);
+    ++friends->max_idx;
+
+    return slot;
 }
 
 static void realloc_blocklist(BlockedList *blocked, int n)
 {
     if (n <= 0) {
+        hash_index_free(&blocked->key_index);
         free(blocked->list);
         free(blocked->index);
         blocked->list = NULL;
@@ -154,8 +314,9 @@ void kill_friendlist(ToxWindow *self, FriendsList *friends, BlockedList *blocked
         free(friends->list[i].group_invite.data);
     }
 
+    free_file_transfers(friends);
     realloc_blocklist(blocked, 0);
-    realloc_friends(friends, 0);
+    free_friends(friends);
     free(self->help);
     del_window(self, windows, c_config);
 }
@@ -168,13 +329,6 @@ static void clear_blocklist_index(BlockedList *blocked, size_t idx)
     };
 }
 
-static void clear_friendlist_index(FriendsList *friends, size_t idx)
-{
-    friends->list[idx] = (ToxicFriend) {
-        0
-    };
-}
-
 /* Saves the blocklist to path. If there are no items in the blocklist the
  * empty file will be removed.
  *
@@ -338,6 +492,7 @@ int load_blocklist(const char *path, BlockedList *blocked)
         blocked->list[i].num = i;
         memcpy(blocked->list[i].name, tmp.name, blocked->list[i].namelength + 1);   // copy null byte
         memcpy(blocked->list[i].pub_key, tmp.pub_key, TOX_PUBLIC_KEY_SIZE);
+        friend_hash_add(&blocked->key_index, friend_key_hash(blocked->list[i].pub_key), i);
 
         uint8_t lastonline[sizeof(uint64_t)];
         memcpy(lastonline, &tmp.last_on, sizeof(uint64_t));
@@ -354,21 +509,68 @@ int load_blocklist(const char *path, BlockedList *blocked)
     return 0;
 }
 
-#define S_WEIGHT 100000
-static int index_name_cmp(const void *n1, const void *n2, void *arg)
+/* Lowercases the first `length` bytes of `name` into `buf`, which must be at least `length` + 1 bytes. */
+static size_t fold_friend_name(char *buf, const char *name, size_t length)
+{
+    size_t i;
+
+    for (i = 0; i < length && name[i] != '\0'; ++i) {
+        buf[i] = (char) tolower((unsigned char) name[i]);
+    }
+
+    buf[i] = '\0';
+
+    return i;
+}
+
+static void friend_name_index_remove(FriendsList *friends, uint32_t slot)
+{
+    ToxicFriend *friend = &friends->list[slot];
+
+    if (!friend->name_indexed) {
+        return;
+    }
+
+    hash_index_remove(&friends->name_index, hash_index_bytes(friend->sort_key, strlen(friend->sort_key)), slot);
+    friend->name_indexed = false;
+}
+
+/* Refreshes the friend's sort key from its current name and connection status, and rehashes its name. */
+static void update_friend_sort_key(FriendsList *friends, uint32_t slot)
 {
-    FriendsList *friends = arg;
-    int res = qsort_strcasecmp_hlpr(friends->list[*(const uint32_t *) n1].name,
-                                    friends->list[*(const uint32_t *) n2].name);
+    ToxicFriend *friend = &friends->list[slot];
+
+    friend_name_index_remove(friends, slot);
 
-    /* Use weight to make qsort always put online friends before offline */
-    res = friends->list[*(const uint32_t *) n1].connection_status ? (res - S_WEIGHT) : (res + S_WEIGHT);
-    res = friends->list[*(const uint32_t *) n2].connection_status ? (res + S_WEIGHT) : (res - S_WEIGHT);
+    const size_t length = fold_friend_name(friend->sort_key, friend->name, sizeof(friend->sort_key) - 1);
+    friend->sort_online = friend->connection_status != TOX_CONNECTION_NONE;
 
-    return res;
+    friend_hash_add(&friends->name_index, hash_index_bytes(friend->sort_key, length), slot);
+    friend->name_indexed = true;
+}
+
+/* Orders online friends before offline ones, then by case-folded name, then by friend number. */
+static int friend_order_cmp(const ToxicFriend *f1, const ToxicFriend *f2)
+{
+    if (f1->sort_online != f2->sort_online) {
+        return f1->sort_online ? -1 : 1;
+    }
+
+    const int res = strcmp(f1->sort_key, f2->sort_key);
+
+    if (res != 0) {
+        return res;
+    }
+
+    return (f1->num > f2->num) - (f1->num < f2->num);
+}
+
+static int index_name_cmp(const void *n1, const void *n2, void *arg)
+{
+    const FriendsList *friends = arg;
+    return friend_order_cmp(&friends->list[*(const uint32_t *) n1], &friends->list[*(const uint32_t *) n2]);
 }
 
-/* sorts friends->index first by connection status then alphabetically */
 void sort_friendlist_index(FriendsList *friends)
 {
     size_t i;
@@ -376,6 +578,7 @@ void sort_friendlist_index(FriendsList *friends)
 
     for (i = 0; i < friends->max_idx; ++i) {
         if (friends->list[i].active) {
+            update_friend_sort_key(friends, i);
             friends->index[n++] = friends->list[i].num;
         }
     }
@@ -385,6 +588,76 @@ void sort_friendlist_index(FriendsList *friends)
     }
 }
 
+/* Returns the first position in the first `n` entries of friends->index that doesn't sort before `friend`. */
+static size_t friend_index_lower_bound(const FriendsList *friends, size_t n, const ToxicFriend *friend)
+{
+    size_t lo = 0;
+    size_t hi = n;
+
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+
+        if (friend_order_cmp(&friends->list[friends->index[mid]], friend) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/*
+ * Inserts the friend into friends->index by its current name and connection status. The index
+ * must hold num_friends - 1 entries, i.e. num_friends has already been incremented.
+ */
+static void friend_index_insert(FriendsList *friends, uint32_t friendnumber)
+{
+    ToxicFriend *friend = &friends->list[friendnumber];
+    const size_t n = friends->num_friends - 1;
+
+    update_friend_sort_key(friends, friendnumber);
+
+    const size_t pos = friend_index_lower_bound(friends, n, friend);
+
+    memmove(&friends->index[pos + 1], &friends->index[pos], (n - pos) * sizeof(uint32_t));
+    friends->index[pos] = friendnumber;
+}
+
+/*
+ * Removes the friend from friends->index. The index must hold num_friends entries, i.e.
+ * num_friends has not been decremented yet.
+ *
+ * Returns false if the friend wasn't found.
+ */
+static bool friend_index_remove(FriendsList *friends, uint32_t friendnumber)
+{
+    const size_t n = friends->num_friends;
+    const size_t pos = friend_index_lower_bound(friends, n, &friends->list[friendnumber]);
+
+    if (pos >= n || friends->index[pos] != friendnumber) {
+        return false;
+    }
+
+    memmove(&friends->index[pos], &friends->index[pos + 1], (n - pos - 1) * sizeof(uint32_t));
+
+    return true;
+}
+
+void friendlist_reposition(FriendsList *friends, uint32_t friendnumber)
+{
+    if (friendnumber >= friends->max_idx || !friends->list[friendnumber].active) {
+        return;
+    }
+
+    if (!friend_index_remove(friends, friendnumber)) {
+        sort_friendlist_index(friends);
+        return;
+    }
+
+    friend_index_insert(friends, friendnumber);
+}
+
 static int index_name_cmp_block(const void *n1, const void *n2, void *arg)
 {
     BlockedList *blocked = arg;
@@ -474,8 +747,8 @@ static void friendlist_onConnectionChange(ToxWindow *self, Toxic *toxic, uint32_
 
     friends->list[num].connection_status = connection_status;
     update_friend_last_online(friends, num, get_unix_time(), toxic->c_config->timestamp_format);
-    store_data(toxic);
-    sort_friendlist_index(friends);
+    profile_save_request();
+    friendlist_reposition(friends, num);
 }
 
 static void friendlist_onNickChange(ToxWindow *self, Toxic *toxic, uint32_t num, const char *nick, size_t length)
@@ -510,7 +783,7 @@ static void friendlist_onNickChange(ToxWindow *self, Toxic *toxic, uint32_t num,
         }
     }
 
-    sort_friendlist_index(friends);
+    friendlist_reposition(friends, num);
 }
 
 static void friendlist_onNickRefresh(ToxWindow *self, Toxic *toxic)
@@ -552,6 +825,49 @@ static void friendlist_onStatusMessageChange(ToxWindow *self, Toxic *toxic, uint
     friends->list[num].statusmsg_len = strlen(friends->list[num].statusmsg);
 }
 
+/* Initializes the cleared slot `slot` in the friend list for friend number `num`. */
+static void init_friend_slot(Toxic *toxic, uint32_t slot, uint32_t num)
+{
+    Tox *tox = toxic->tox;
+    const Client_Config *c_config = toxic->c_config;
+    FriendsList *friends = toxic->friends;
+    ToxicFriend *friend = &friends->list[slot];
+
+    ++friends->num_friends;
+
+    friend->num = num;
+    friend->active = true;
+    friend->window_id = -1;
+    friend->auto_accept_files = false;  // do not change
+    friend->connection_status = TOX_CONNECTION_NONE;
+    friend->status = TOX_USER_STATUS_NONE;
+    set_default_friend_config_settings(friend, c_config);
+
+    Tox_Err_Friend_Get_Public_Key pkerr;
+    tox_friend_get_public_key(tox, num, (uint8_t *) friend->pub_key, &pkerr);
+
+    if (pkerr != TOX_ERR_FRIEND_GET_PUBLIC_KEY_OK) {
+        fprintf(stderr, "tox_friend_get_public_key failed (error %d)\n", pkerr);
+    }
+
+    friend_hash_add(&friends->key_index, friend_key_hash(friend->pub_key), slot);
+
+    Tox_Err_Friend_Get_Last_Online loerr;
+    time_t t = tox_friend_get_last_online(tox, num, &loerr);
+
+    if (loerr != TOX_ERR_FRIEND_GET_LAST_ONLINE_OK) {
+        t = 0;
+    }
+
+    update_friend_last_online(friends, slot, t, c_config->timestamp_format);
+
+    char tempname[TOXIC_MAX_NAME_LENGTH + 1];
+    const size_t name_len = get_nick_truncate(tox, tempname, sizeof(tempname), num);
+
+    snprintf(friend->name, sizeof(friend->name), "%s", tempname);
+    friend->namelength = name_len;
+}
+
 void friendlist_onFriendAdded(ToxWindow *self, Toxic *toxic, uint32_t num, bool sort)
 {
     UNUSED_VAR(self);
@@ -561,110 +877,138 @@ void friendlist_onFriendAdded(ToxWindow *self, Toxic *toxic, uint32_t num, bool
         return;
     }
 
+    FriendsList *friends = toxic->friends;
+
+    const uint32_t i = take_friend_slot(friends);
+    init_friend_slot(toxic, i, num);
+
+    settings_load_friend(friends, toxic->settings_tree, (const uint8_t *) friends->list[i].pub_key);
+
+    if (sort) {
+        friend_index_insert(friends, i);
+    } else {
+        friends->index[friends->num_friends - 1] = i;  // caller sorts the index
+    }
+
+#ifdef AUDIO
+
+    if (!init_friend_AV(toxic->call_control, i)) {
+        fprintf(stderr, "Failed to init AV for friend %u\n", i);
+    }
+
+#endif
+}
+
+void load_friendlist(Toxic *toxic)
+{
+    if (toxic == NULL) {
+        return;
+    }
+
     Tox *tox = toxic->tox;
-    const Client_Config *c_config = toxic->c_config;
     FriendsList *friends = toxic->friends;
 
-    realloc_friends(friends, friends->max_idx + 1);
-    clear_friendlist_index(friends, friends->max_idx);
+    const size_t num_friends = tox_self_get_friend_list_size(tox);
 
-    for (uint32_t i = 0; i <= friends->max_idx; ++i) {
-        if (friends->list[i].active) {
-            continue;
-        }
+    if (num_friends == 0) {
+        return;
+    }
 
-        ++friends->num_friends;
+    uint32_t *friend_list = malloc(num_friends * sizeof(uint32_t));
 
-        friends->list[i].num = num;
-        friends->list[i].active = true;
-        friends->list[i].window_id = -1;
-        friends->list[i].auto_accept_files = false;  // do not change
-        friends->list[i].connection_status = TOX_CONNECTION_NONE;
-        friends->list[i].status = TOX_USER_STATUS_NONE;
-        set_default_friend_config_settings(&friends->list[i], c_config);
+    if (friend_list == NULL) {
+        exit_toxic_err(FATALERR_MEMORY, "failed in load_friendlist");
+    }
 
-        Tox_Err_Friend_Get_Public_Key pkerr;
-        tox_friend_get_public_key(tox, num, (uint8_t *) friends->list[i].pub_key, &pkerr);
+    tox_self_get_friend_list(tox, friend_list);
 
-        if (pkerr != TOX_ERR_FRIEND_GET_PUBLIC_KEY_OK) {
-            fprintf(stderr, "tox_friend_get_public_key failed (error %d)\n", pkerr);
-        }
+    uint32_t max_num = 0;
 
-        Tox_Err_Friend_Get_Last_Online loerr;
-        time_t t = tox_friend_get_last_online(tox, num, &loerr);
+    for (size_t i = 0; i < num_friends; ++i) {
+        max_num = MAX(max_num, friend_list[i]);
+    }
 
-        if (loerr != TOX_ERR_FRIEND_GET_LAST_ONLINE_OK) {
-            t = 0;
-        }
+    const size_t max_idx = MAX((size_t) max_num + 1, friends->max_idx);
 
-        update_friend_last_online(friends, i, t, c_config->timestamp_format);
+    if (max_idx > friends->capacity) {
+        realloc_friends(friends, max_idx);
+    }
 
-        char tempname[TOXIC_MAX_NAME_LENGTH + 1];
-        const size_t name_len = get_nick_truncate(tox, tempname, sizeof(tempname), num);
+    for (size_t i = friends->max_idx; i < max_idx; ++i) {
+        clear_friendlist_index(friends, i);
+    }
 
-        snprintf(friends->list[i].name, sizeof(friends->list[i].name), "%s", tempname);
-        friends->list[i].namelength = name_len;
+    friends->max_idx = max_idx;
 
-        if (i == friends->max_idx) {
-            ++friends->max_idx;
-        }
+#ifdef AUDIO
+
+    /* Size the call list once for the highest friend number instead of growing it per friend */
+    if (!init_friend_AV(toxic->call_control, max_num)) {
+        fprintf(stderr, "Failed to init AV for friend %u\n", max_num);
+    }
 
-        if (sort) {
-            sort_friendlist_index(friends);
+#endif
+
+    for (size_t i = 0; i < num_friends; ++i) {
+        const uint32_t num = friend_list[i];
+
+        if (friends->list[num].active) {
+            continue;
         }
 
+        init_friend_slot(toxic, num, num);
+
 #ifdef AUDIO
 
-        if (!init_friend_AV(toxic->call_control, i)) {
-            fprintf(stderr, "Failed to init AV for friend %u\n", i);
+        if (!init_friend_AV(toxic->call_control, num)) {
+            fprintf(stderr, "Failed to init AV for friend %u\n", num);
         }
 
 #endif
+    }
 
-        return;
+    /* Gaps left by deleted friends; pushed in ascending order so the heap needs no sifting */
+    for (uint32_t i = 0; i < friends->max_idx; ++i) {
+        if (!friends->list[i].active) {
+            free_slot_push(friends, i);
+        }
     }
+
+    free(friend_list);
+
+    sort_friendlist_index(friends);
 }
 
 /* Puts blocked friend back in friendlist. fnum is new friend number, bnum is blocked number. */
 static void friendlist_add_blocked(FriendsList *friends, BlockedList *blocked, const Client_Config *c_config,
                                    struct CallControl *cc, uint32_t fnum, uint32_t bnum)
 {
-    realloc_friends(friends, friends->max_idx + 1);
-    clear_friendlist_index(friends, friends->max_idx);
-
-    for (int i = 0; i <= (int) friends->max_idx; ++i) {
-        if (friends->list[i].active) {
-            continue;
-        }
+    const uint32_t i = take_friend_slot(friends);
 
-        ++friends->num_friends;
+    ++friends->num_friends;
 
-        friends->list[i].num = fnum;
-        friends->list[i].active = true;
-        friends->list[i].window_id = -1;
-        friends->list[i].status = TOX_USER_STATUS_NONE;
-        friends->list[i].namelength = blocked->list[bnum].namelength;
-        update_friend_last_online(friends, i, blocked->list[bnum].last_on, c_config->timestamp_format);
-        memcpy(friends->list[i].name, blocked->list[bnum].name, friends->list[i].namelength + 1);
-        memcpy(friends->list[i].pub_key, blocked->list[bnum].pub_key, TOX_PUBLIC_KEY_SIZE);
-        set_default_friend_config_settings(&friends->list[i], c_config);
+    friends->list[i].num = fnum;
+    friends->list[i].active = true;
+    friends->list[i].window_id = -1;
+    friends->list[i].status = TOX_USER_STATUS_NONE;
+    friends->list[i].namelength = blocked->list[bnum].namelength;
+    update_friend_last_online(friends, i, blocked->list[bnum].last_on, c_config->timestamp_format);
+    memcpy(friends->list[i].name, blocked->list[bnum].name, friends->list[i].namelength + 1);
+    memcpy(friends->list[i].pub_key, blocked->list[bnum].pub_key, TOX_PUBLIC_KEY_SIZE);
+    set_default_friend_config_settings(&friends->list[i], c_config);
 
-        if (i == (int) friends->max_idx) {
-            ++friends->max_idx;
-        }
+    friend_hash_add(&friends->key_index, friend_key_hash(friends->list[i].pub_key), i);
 
-        sort_blocklist_index(blocked);
-        sort_friendlist_index(friends);
+    sort_blocklist_index(blocked);
+    friend_index_insert(friends, i);
 
 #ifdef AUDIO
 
-        if (!init_friend_AV(cc, i)) {
-            fprintf(stderr, "Failed to init AV for friend %d\n", i);
-        }
+    if (!init_friend_AV(cc, i)) {
+        fprintf(stderr, "Failed to init AV for friend %u\n", i);
+    }
 
 #endif
-        return;
-    }
 }
 
 #ifdef GAMES
@@ -829,6 +1173,9 @@ static void delete_friend(Toxic *toxic, uint32_t f_num)
         return;
     }
 
+    friend_index_remove(friends, f_num);
+    friend_name_index_remove(friends, f_num);
+    hash_index_remove(&friends->key_index, friend_key_hash(friends->list[f_num].pub_key), f_num);
     --friends->num_friends;
 
     if (friends->list[f_num].connection_status != TOX_CONNECTION_NONE) {
@@ -848,8 +1195,9 @@ static void delete_friend(Toxic *toxic, uint32_t f_num)
     free(friends->list[f_num].conference_invite.key);
 
     clear_friendlist_index(friends, f_num);
+    free_slot_push(friends, f_num);
 
-    int i;
+    size_t i;
 
     for (i = friends->max_idx; i > 0; --i) {
         if (friends->list[i - 1].active) {
@@ -858,7 +1206,7 @@ static void delete_friend(Toxic *toxic, uint32_t f_num)
     }
 
     friends->max_idx = i;
-    realloc_friends(friends, i);
+    shrink_friends(friends);
 
 #ifdef AUDIO
     del_friend_AV(toxic->call_control, i);
@@ -869,7 +1217,7 @@ static void delete_friend(Toxic *toxic, uint32_t f_num)
         --friends->num_selected;
     }
 
-    store_data(toxic);
+    profile_save_request();
 }
 
 /* activates delete friend popup */
@@ -888,7 +1236,6 @@ static void del_friend_deactivate(Toxic *toxic, wint_t key)
     if (key == L'y') {
         if (toxic->blocklist_view == 0) {
             delete_friend(toxic, PendingDelete.num);
-            sort_friendlist_index(toxic->friends);
         } else {
             delete_blocked_friend(toxic, PendingDelete.num);
             sort_blocklist_index(toxic->blocked);
@@ -947,6 +1294,7 @@ static void delete_blocked_friend(Toxic *toxic, uint32_t bnum)
         }
     }
 
+    hash_index_remove(&blocked->key_index, friend_key_hash(blocked->list[bnum].pub_key), bnum);
     clear_blocklist_index(blocked, bnum);
 
     --blocked->num_blocked;
@@ -985,6 +1333,7 @@ static void block_friend(Toxic *toxic, uint32_t fnum)
         blocked->list[i].last_on = friends->list[fnum].last_online.last_on;
         memcpy(blocked->list[i].pub_key, friends->list[fnum].pub_key, TOX_PUBLIC_KEY_SIZE);
         memcpy(blocked->list[i].name, friends->list[fnum].name, friends->list[fnum].namelength + 1);
+        friend_hash_add(&blocked->key_index, friend_key_hash(blocked->list[i].pub_key), i);
 
         ++blocked->num_blocked;
 
@@ -995,7 +1344,6 @@ static void block_friend(Toxic *toxic, uint32_t fnum)
         delete_friend(toxic, fnum);
         save_blocklist(toxic->client_data.block_path, blocked);
         sort_blocklist_index(blocked);
-        sort_friendlist_index(friends);
 
         return;
     }
@@ -1020,7 +1368,6 @@ static void unblock_friend(Toxic *toxic, uint32_t bnum)
     friendlist_add_blocked(toxic->friends, toxic->blocked, toxic->c_config, toxic->call_control, friendnum, bnum);
     delete_blocked_friend(toxic, bnum);
     sort_blocklist_index(toxic->blocked);
-    sort_friendlist_index(toxic->friends);
 }
 
 /*
@@ -1538,26 +1885,32 @@ Tox_Connection get_friend_connection_status(const FriendsList *friends, uint32_t
 
 int64_t get_friend_number_name(const FriendsList *friends, const char *name, uint16_t length)
 {
-    if (friends == NULL) {
+    if (friends == NULL || length > TOXIC_MAX_NAME_LENGTH) {
         return -1;
     }
 
+    char folded[TOXIC_MAX_NAME_LENGTH + 1];
+    const size_t folded_length = fold_friend_name(folded, name, length);
+    const uint32_t hash = hash_index_bytes(folded, folded_length);
+
     int64_t num = -1;
     bool match_found = false;
+    size_t cursor = hash;
+    uint32_t slot;
 
-    for (size_t i = 0; i < friends->max_idx; ++i) {
-        if (length != friends->list[i].namelength) {
+    while (hash_index_next(&friends->name_index, hash, &cursor, &slot)) {
+        const ToxicFriend *friend = &friends->list[slot];
+
+        if (length != friend->namelength || memcmp(name, friend->name, length) != 0) {
             continue;
         }
 
-        if (memcmp(name, friends->list[i].name, length) == 0) {
-            if (match_found) {
-                return -2;
-            }
-
-            num = friends->list[i].num;
-            match_found = true;
+        if (match_found) {
+            return -2;
         }
+
+        num = friend->num;
+        match_found = true;
     }
 
     return num;
@@ -1570,12 +1923,12 @@ int64_t get_friend_number_name(const FriendsList *friends, const char *name, uin
  */
 bool friend_is_blocked(const BlockedList *blocked, const char *public_key)
 {
-    for (size_t i = 0; i < blocked->max_idx; ++i) {
-        if (!blocked->list[i].active) {
-            continue;
-        }
+    const uint32_t hash = friend_key_hash(public_key);
+    size_t cursor = hash;
+    uint32_t slot;
 
-        if (memcmp(public_key, blocked->list[i].pub_key, TOX_PUBLIC_KEY_SIZE) == 0) {
+    while (hash_index_next(&blocked->key_index, hash, &cursor, &slot)) {
+        if (memcmp(public_key, blocked->list[slot].pub_key, TOX_PUBLIC_KEY_SIZE) == 0) {
             return true;
         }
     }
@@ -1699,12 +2052,12 @@ static Friend_Settings *get_friend_settings_by_key(FriendsList *friends, const c
         return NULL;
     }
 
-    for (size_t i = 0; i < friends->max_idx; ++i) {
-        ToxicFriend *friend = &friends->list[i];
+    const uint32_t hash = friend_key_hash(pk_bin);
+    size_t cursor = hash;
+    uint32_t slot;
 
-        if (!friend->active) {
-            continue;
-        }
+    while (hash_index_next(&friends->key_index, hash, &cursor, &slot)) {
+        ToxicFriend *friend = &friends->list[slot];
 
         if (memcmp(pk_bin, friend->pub_key, sizeof(friend->pub_key)) == 0) {
             if (friendnumber != NULL) {
@@ -1718,6 +2071,19 @@ static Friend_Settings *get_friend_settings_by_key(FriendsList *friends, const c
     return NULL;
 }
 
+bool friend_config_reset(FriendsList *friends, const char *public_key, const Client_Config *c_config)
+{
+    uint32_t friendnumber;
+
+    if (get_friend_settings_by_key(friends, public_key, &friendnumber) == NULL) {
+        return false;
+    }
+
+    set_default_friend_config_settings(&friends->list[friendnumber], c_config);
+
+    return true;
+}
+
 bool friend_config_set_show_connection_msg(FriendsList *friends, const char *public_key, bool show_connection_msg)
 {
     Friend_Settings *settings = get_friend_settings_by_key(friends, public_key, NULL);
@@ -1894,6 +2260,8 @@ bool friend_config_set_alias(FriendsList *friends, const char *public_key, const
 
     settings->alias_set = true;
 
+    friendlist_reposition(friends, friendnumber);
+
     return true;
 }
 
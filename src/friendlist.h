@@ -12,6 +12,7 @@
 #include <time.h>
 
 #include "file_transfers.h"
+#include "hash_index.h"
 #include "toxic.h"
 #include "windows.h"
 
@@ -19,6 +20,10 @@
 #include "game_base.h"
 #endif
 
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
 struct LastOnline {
     uint64_t last_on;
     struct tm tm;
@@ -79,6 +84,12 @@ typedef struct {
     bool auto_accept_files;  /* same as above; default should always be false */
     Tox_User_Status status;
 
+    /* The friend's position in FriendsList.index is ordered by these copies of the name and
+     * connection status, so it can still be found after they change. */
+    char sort_key[TOXIC_MAX_NAME_LENGTH + 1];  /* lowercased name, also the key of FriendsList.name_index */
+    bool sort_online;
+    bool name_indexed;
+
     struct LastOnline last_online;
 
 #ifdef GAMES
@@ -88,10 +99,6 @@ typedef struct {
     struct ConferenceInvite conference_invite;
     struct GroupInvite group_invite;
 
-    struct FileTransfer file_receiver[MAX_FILES];
-    struct FileTransfer file_sender[MAX_FILES];
-    PendingFileTransfer file_send_queue[MAX_FILES];
-
     Friend_Settings settings;
 } ToxicFriend;
 
@@ -109,8 +116,19 @@ typedef struct FriendsList {
     size_t num_friends;
     size_t num_online;
     size_t max_idx;    /* 1 + the index of the last friend in list */
-    uint32_t *index;
+    size_t capacity;   /* number of allocated entries in list and index */
+    uint32_t *index;   /* friend numbers, online first then alphabetically */
     ToxicFriend *list;
+
+    /* min-heap of inactive slots below max_idx; entries may be stale and are checked when popped */
+    uint32_t *free_slots;
+    size_t num_free_slots;
+    size_t free_slots_capacity;
+
+    HashIndex  key_index;    /* by public key */
+    HashIndex  name_index;   /* by lowercased name */
+
+    FileTransferTable file_transfers;
 } FriendsList;
 
 typedef struct BlockedList BlockedList;
@@ -124,6 +142,13 @@ int get_friendnum(uint8_t *name);
 void kill_friendlist(ToxWindow *self, FriendsList *friends, BlockedList *blocked, Windows *windows,
                      const Client_Config *c_config);
 void friendlist_onFriendAdded(ToxWindow *self, Toxic *toxic, uint32_t num, bool sort);
+
+/*
+ * Adds every friend in the Tox instance to the friend list, sizing the list once
+ * and sorting it once. Used on startup instead of calling friendlist_onFriendAdded()
+ * for each friend.
+ */
+void load_friendlist(Toxic *toxic);
 Tox_User_Status get_friend_status(const FriendsList *friends, uint32_t friendnumber);
 Tox_Connection get_friend_connection_status(const FriendsList *friends, uint32_t friendnumber);
 
@@ -149,9 +174,15 @@ void friendlist_get_names(const FriendsList *friends, char **names, size_t max_n
  */
 int load_blocklist(const char *path, BlockedList *blocked);
 
-/* sorts friendlist_index first by connection status then alphabetically */
+/* Rebuilds friends->index from scratch, sorted first by connection status then alphabetically. */
 void sort_friendlist_index(FriendsList *friends);
 
+/*
+ * Moves a friend to its new place in friends->index after its name or connection
+ * status changed. This takes O(log n) comparisons rather than a full sort.
+ */
+void friendlist_reposition(FriendsList *friends, uint32_t friendnumber);
+
 /*
  * Returns true if friend associated with `public_key` is in the block list.
  *
@@ -276,4 +307,15 @@ bool friend_config_alias_is_set(const FriendsList *friends, uint32_t friendnumbe
 /* Sets config settings to global defaults for all friends, ignoring friend-specific settings. */
 void friend_reset_default_config_settings(FriendsList *friends, const Client_Config *c_config);
 
+/*
+ * Sets config settings to global defaults for the friend associated with `public_key`.
+ *
+ * Return true on success.
+ */
+bool friend_config_reset(FriendsList *friends, const char *public_key, const Client_Config *c_config);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
 #endif /* end of include guard: FRIENDLIST_H */
@@ -0,0 +1,169 @@
+/* Startup benchmark for the friend list.
+ *
+ * Builds a synthetic profile with 10k friends, then times loading it back into Tox from
+ * savedata and into the friend list with load_friendlist(), next to adding the same friends
+ * one at a time with friendlist_onFriendAdded(). Run with an optional friend count.
+ */
+
+#include "friendlist.h"
+#include "settings.h"
+
+#ifdef AUDIO
+#include "audio_call.h"
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+Tox *new_tox(const std::vector<uint8_t> *savedata)
+{
+    Tox_Options *opts = tox_options_new(nullptr);
+
+    if (opts == nullptr) {
+        return nullptr;
+    }
+
+    tox_options_set_udp_enabled(opts, false);
+    tox_options_set_local_discovery_enabled(opts, false);
+
+    if (savedata != nullptr) {
+        tox_options_set_savedata_type(opts, TOX_SAVEDATA_TYPE_TOX_SAVE);
+        tox_options_set_savedata_data(opts, savedata->data(), savedata->size());
+    }
+
+    Tox *tox = tox_new(opts, nullptr);
+    tox_options_free(opts);
+
+    return tox;
+}
+
+std::vector<uint8_t> make_profile(uint32_t num_friends)
+{
+    Tox *tox = new_tox(nullptr);
+
+    if (tox == nullptr) {
+        fprintf(stderr, "Failed to create Tox instance\n");
+        exit(1);
+    }
+
+    std::mt19937 rng(1234);
+    uint8_t public_key[TOX_PUBLIC_KEY_SIZE];
+
+    for (uint32_t i = 0; i < num_friends; ++i) {
+        for (uint8_t &byte : public_key) {
+            byte = rng();
+        }
+
+        public_key[TOX_PUBLIC_KEY_SIZE - 1] &= 0x7f;  // toxcore rejects keys with the high bit set
+
+        if (tox_friend_add_norequest(tox, public_key, nullptr) == UINT32_MAX) {
+            fprintf(stderr, "Failed to add friend %u\n", i);
+            exit(1);
+        }
+    }
+
+    std::vector<uint8_t> savedata(tox_get_savedata_size(tox));
+    tox_get_savedata(tox, savedata.data());
+    tox_kill(tox);
+
+    return savedata;
+}
+
+struct Session {
+    Toxic toxic{};
+    Client_Config c_config{};
+#ifdef AUDIO
+    CallControl call_control{};
+#endif
+
+    explicit Session(Tox *tox)
+    {
+        toxic.tox = tox;
+        toxic.c_config = &c_config;
+        snprintf(c_config.timestamp_format, sizeof(c_config.timestamp_format), "%%H:%%M");
+#ifdef AUDIO
+        toxic.call_control = &call_control;
+#endif
+        init_friendlist(&toxic);
+    }
+
+    ~Session()
+    {
+        FriendsList *friends = toxic.friends;
+
+        free(friends->list);
+        free(friends->index);
+        free(friends->free_slots);
+        free(friends->key_index.buckets);
+        free(friends->name_index.buckets);
+        free(friends);
+        free(toxic.blocked);
+#ifdef AUDIO
+
+        for (uint32_t i = 0; i < call_control.max_calls; ++i) {
+            free(call_control.calls[i]);
+        }
+
+        free(call_control.calls);
+#endif
+    }
+};
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const uint32_t num_friends = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+
+    const auto profile_start = Clock::now();
+    const std::vector<uint8_t> savedata = make_profile(num_friends);
+    printf("profile with %u friends: %zu bytes, built in %.1f ms\n", num_friends, savedata.size(),
+           ms_since(profile_start));
+
+    const auto tox_start = Clock::now();
+    Tox *tox = new_tox(&savedata);
+
+    if (tox == nullptr) {
+        fprintf(stderr, "Failed to load profile\n");
+        return 1;
+    }
+
+    printf("tox_new from savedata:    %8.1f ms\n", ms_since(tox_start));
+
+    {
+        Session session(tox);
+        const auto start = Clock::now();
+        load_friendlist(&session.toxic);
+        printf("load_friendlist:          %8.1f ms  (%zu friends, capacity %zu)\n", ms_since(start),
+               session.toxic.friends->num_friends, session.toxic.friends->capacity);
+    }
+
+    {
+        Session session(tox);
+        const auto start = Clock::now();
+
+        for (uint32_t i = 0; i < num_friends; ++i) {
+            friendlist_onFriendAdded(nullptr, &session.toxic, i, false);
+        }
+
+        sort_friendlist_index(session.toxic.friends);
+        printf("friendlist_onFriendAdded: %8.1f ms  (%zu friends, capacity %zu)\n", ms_since(start),
+               session.toxic.friends->num_friends, session.toxic.friends->capacity);
+    }
+
+    tox_kill(tox);
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "friendlist.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <strings.h>
+#include <vector>
+
+namespace {
+
+class FriendlistOrderTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        list_.resize(kFriends);
+        index_.resize(kFriends);
+
+        friends_.list = list_.data();
+        friends_.index = index_.data();
+        friends_.max_idx = kFriends;
+        friends_.capacity = kFriends;
+        friends_.num_friends = kFriends;
+
+        for (uint32_t i = 0; i < kFriends; ++i) {
+            list_[i].num = i;
+            list_[i].active = true;
+            list_[i].connection_status = TOX_CONNECTION_NONE;
+            rename(i, rng_() % 20);
+        }
+
+        sort_friendlist_index(&friends_);
+    }
+
+    void TearDown() override
+    {
+        free(friends_.name_index.buckets);
+    }
+
+    void rename(uint32_t friendnumber, uint32_t id)
+    {
+        // Mixed case so ordering has to ignore case
+        ToxicFriend &f = list_[friendnumber];
+        snprintf(f.name, sizeof(f.name), id % 2 ? "Friend%03u" : "fRIEND%03u", id);
+        f.namelength = strlen(f.name);
+    }
+
+    std::vector<uint32_t> sorted_copy()
+    {
+        const std::vector<uint32_t> incremental = index_;
+        sort_friendlist_index(&friends_);
+        std::vector<uint32_t> full = index_;
+        index_ = incremental;
+        friends_.index = index_.data();
+        return full;
+    }
+
+    static constexpr uint32_t kFriends = 200;
+
+    std::mt19937 rng_{42};
+    std::vector<ToxicFriend> list_;
+    std::vector<uint32_t> index_;
+    FriendsList friends_{};
+};
+
+TEST_F(FriendlistOrderTest, SortsOnlineFirstThenByName)
+{
+    list_[7].connection_status = TOX_CONNECTION_UDP;
+    friendlist_reposition(&friends_, 7);
+    EXPECT_EQ(index_[0], 7u);
+
+    for (uint32_t i = 1; i < kFriends - 1; ++i) {
+        const ToxicFriend &a = list_[index_[i]];
+        const ToxicFriend &b = list_[index_[i + 1]];
+        ASSERT_LE(strcasecmp(a.name, b.name), 0) << "position " << i;
+    }
+}
+
+TEST_F(FriendlistOrderTest, RepositionMatchesFullSort)
+{
+    for (int i = 0; i < 1000; ++i) {
+        const uint32_t friendnumber = rng_() % kFriends;
+
+        if (rng_() % 2) {
+            list_[friendnumber].connection_status = list_[friendnumber].connection_status == TOX_CONNECTION_NONE
+                                                    ? TOX_CONNECTION_TCP : TOX_CONNECTION_NONE;
+        } else {
+            rename(friendnumber, rng_() % 20);
+        }
+
+        friendlist_reposition(&friends_, friendnumber);
+
+        ASSERT_EQ(index_, sorted_copy()) << "after change " << i;
+    }
+}
+
+TEST_F(FriendlistOrderTest, FindsFriendsByExactName)
+{
+    for (int i = 0; i < 500; ++i) {
+        const uint32_t friendnumber = rng_() % kFriends;
+        rename(friendnumber, rng_() % 400);
+        friendlist_reposition(&friends_, friendnumber);
+    }
+
+    for (uint32_t id = 0; id < 400; ++id) {
+        char name[TOXIC_MAX_NAME_LENGTH + 1];
+        snprintf(name, sizeof(name), id % 2 ? "Friend%03u" : "fRIEND%03u", id);
+
+        int64_t expected = -1;
+
+        for (uint32_t i = 0; i < kFriends; ++i) {
+            if (strcmp(list_[i].name, name) == 0) {
+                expected = expected == -1 ? static_cast<int64_t>(i) : -2;
+            }
+        }
+
+        EXPECT_EQ(get_friend_number_name(&friends_, name, strlen(name)), expected) << name;
+    }
+
+    // Lookups are exact; the case-folded index only narrows the search
+    EXPECT_EQ(get_friend_number_name(&friends_, "FRIEND001", 9), -1);
+    EXPECT_EQ(get_friend_number_name(&friends_, "nobody", 6), -1);
+}
+
+}  // namespace
@@ -147,22 +147,22 @@ struct GameData {
     uint32_t id;  // indentifies multiplayer instance
     uint32_t friend_number; // friendnumber associated with parent window
 
-    cb_game_update_state *cb_game_update_state;
+    void (*cb_game_update_state)(GameData *game, void *cb_data);
     void *cb_game_update_state_data;
 
-    cb_game_render_window *cb_game_render_window;
+    void (*cb_game_render_window)(GameData *game, WINDOW *window, void *cb_data);
     void *cb_game_render_window_data;
 
-    cb_game_kill *cb_game_kill;
+    void (*cb_game_kill)(GameData *game, void *cb_data);
     void *cb_game_kill_data;
 
-    cb_game_pause *cb_game_pause;
+    void (*cb_game_pause)(GameData *game, bool is_paused, void *cb_data);
     void *cb_game_pause_data;
 
-    cb_game_key_press *cb_game_key_press;
+    void (*cb_game_key_press)(GameData *game, int key, void *cb_data);
     void *cb_game_key_press_data;
 
-    cb_game_on_packet *cb_game_on_packet;
+    void (*cb_game_on_packet)(GameData *game, const uint8_t *data, size_t length, void *cb_data);
     void *cb_game_on_packet_data;
 };
 
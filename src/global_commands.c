@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include "avatars.h"
+#include "batch.h"
 #include "conference.h"
 #include "friendlist.h"
 #include "groupchats.h"
@@ -20,6 +21,7 @@
 #include "log.h"
 #include "misc_tools.h"
 #include "name_lookup.h"
+#include "profile_save.h"
 #include "prompt.h"
 #include "qr_code.h"
 #include "term_mplex.h"
@@ -68,7 +70,7 @@ void cmd_accept(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*
         return;
     } else {
         line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "Friend request accepted.");
-        on_friend_added(toxic, friendnum, true);
+        on_friend_added(toxic, friendnum, !batch_is_running());
     }
 
     toxic->frnd_requests.request[req] = (struct friend_request) {
@@ -125,7 +127,7 @@ void cmd_add_helper(ToxWindow *self, Toxic *toxic, const char *id_bin, const cha
 
         case TOX_ERR_FRIEND_ADD_OK:
             errmsg = "Friend request sent.";
-            on_friend_added(toxic, f_num, true);
+            on_friend_added(toxic, f_num, !batch_is_running());
             break;
 
         case TOX_ERR_FRIEND_ADD_NULL:
@@ -899,7 +901,7 @@ void cmd_nick(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*ar
     tox_self_set_name(tox, (uint8_t *) nick, len, NULL);
     prompt_update_nick(toxic->home_window, nick);
 
-    store_data(toxic);
+    profile_save_request();
 }
 
 void cmd_note(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
@@ -1017,6 +1019,44 @@ void cmd_requests(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char
     }
 }
 
+void cmd_savestats(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
+{
+    UNUSED_VAR(window);
+    UNUSED_VAR(argc);
+    UNUSED_VAR(argv);
+
+    if (toxic == NULL || self == NULL) {
+        return;
+    }
+
+    const Client_Config *c_config = toxic->c_config;
+
+    ProfileSaveStats stats;
+    profile_save_get_stats(&stats);
+
+    const time_t now = get_unix_time();
+    const double hours = MAX(1, now - stats.start_time) / 3600.0;
+
+    line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0,
+                  "Profile saves: %llu requested, %llu written (%.1f/hour), %llu failed",
+                  (unsigned long long) stats.requests, (unsigned long long) stats.writes, stats.writes / hours,
+                  (unsigned long long) stats.failures);
+
+    if (stats.writes == 0) {
+        return;
+    }
+
+    line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0,
+                  "Snapshot under lock: avg %.2f ms, max %.2f ms. Encrypt and write: avg %.2f ms, max %.2f ms",
+                  stats.snapshot_usec / 1000.0 / stats.writes, stats.max_snapshot_usec / 1000.0,
+                  stats.write_usec / 1000.0 / stats.writes, stats.max_write_usec / 1000.0);
+
+    if (stats.last_write_time > 0) {
+        line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "Last saved %llu seconds ago",
+                      (unsigned long long)(now - stats.last_write_time));
+    }
+}
+
 void cmd_status(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
 {
     UNUSED_VAR(window);
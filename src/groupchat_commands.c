@@ -16,9 +16,13 @@
 #include "line_info.h"
 #include "log.h"
 #include "misc_tools.h"
+#include "profile_save.h"
 #include "toxic.h"
 #include "windows.h"
 
+/* Maximum number of peers sharing a nick that /whois lists */
+#define MAX_WHOIS_PEERS 16
+
 extern GroupChat groupchats[MAX_GROUPCHAT_NUM];
 
 void cmd_chatid(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
@@ -114,7 +118,7 @@ void cmd_group_nick(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, cha
 
     set_nick_this_group(self, toxic, nick, len);
 
-    store_data(toxic);
+    profile_save_request();
 }
 
 void cmd_ignore(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
@@ -166,7 +170,7 @@ void cmd_ignore(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*
 
     line_info_add(self, c_config, true, NULL, NULL, SYS_MSG, 1, BLUE, "-!- Ignoring %s", nick);
 
-    group_toggle_peer_ignore(self->num, peer_id, true);
+    group_toggle_peer_ignore(toxic, self->num, peer_id, true);
 }
 
 void cmd_group_invite(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
@@ -1100,7 +1104,7 @@ void cmd_unignore(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char
 
     line_info_add(self, c_config, true, NULL, NULL, SYS_MSG, 1, BLUE, "-!- You are no longer ignoring %s", nick);
 
-    group_toggle_peer_ignore(self->num, peer_id, false);
+    group_toggle_peer_ignore(toxic, self->num, peer_id, false);
 }
 
 void cmd_whois(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*argv)[MAX_STR_SIZE])
@@ -1127,27 +1131,15 @@ void cmd_whois(WINDOW *window, ToxWindow *self, Toxic *toxic, int argc, char (*a
     }
 
     const char *identifier = argv[1];
-    bool is_public_key = false;
-
-    for (size_t i = 0; i < chat->max_idx && !is_public_key; ++i) {
-        uint32_t peer_id;
-
-        if (group_get_public_key_peer_id(self->num, identifier, &peer_id) == 0) {
-            is_public_key = true;
-        } else {
-            GroupPeer *peer = &chat->peer_list[i];
-
-            if (!peer->active) {
-                continue;
-            }
-
-            if (strcmp(identifier, peer->name) != 0) {
-                continue;
-            }
+    uint32_t peer_ids[MAX_WHOIS_PEERS];
+    uint32_t num_peers = 1;
 
-            peer_id = peer->peer_id;
-        }
+    if (group_get_public_key_peer_id(self->num, identifier, &peer_ids[0]) != 0) {
+        num_peers = group_get_nick_peer_ids(self->num, identifier, peer_ids, MAX_WHOIS_PEERS);
+    }
 
+    for (uint32_t i = 0; i < num_peers; ++i) {
+        const uint32_t peer_id = peer_ids[i];
         const int peer_index = get_peer_index(self->num, peer_id);
 
         if (peer_index < 0) {
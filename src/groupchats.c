@@ -44,6 +44,7 @@
 #include "input.h"
 #include "help.h"
 #include "notify.h"
+#include "profile_save.h"
 #include "autocomplete.h"
 
 extern char *DATA_FILE;
@@ -92,6 +93,7 @@ static const char *const group_cmd_list[] = {
     "/quit",
     "/rejoin",
     "/requests",
+    "/savestats",
 #ifdef PYTHON
     "/run",
 #endif /* PYTHON */
@@ -110,9 +112,8 @@ static GroupChat groupchats[MAX_GROUPCHAT_NUM];
 
 static ToxWindow *new_group_chat(Tox *tox, uint32_t groupnumber, const char *groupname, int length);
 static void groupchat_set_group_name(ToxWindow *self, Toxic *toxic, uint32_t groupnumber);
-static void groupchat_update_name_list(uint32_t groupnumber);
 static void groupchat_onGroupPeerJoin(ToxWindow *self, Toxic *toxic, uint32_t groupnumber, uint32_t peer_id);
-static int realloc_peer_list(uint32_t groupnumber, uint32_t n);
+static void free_peer_list(GroupChat *chat);
 static void groupchat_onGroupNickChange(ToxWindow *self, Toxic *toxic, uint32_t groupnumber, uint32_t peer_id,
                                         const char *new_nick, size_t len);
 static void groupchat_onGroupStatusChange(ToxWindow *self, Toxic *toxic, uint32_t groupnumber, uint32_t peer_id,
@@ -120,6 +121,7 @@ static void groupchat_onGroupStatusChange(ToxWindow *self, Toxic *toxic, uint32_
 static void groupchat_onGroupSelfNickChange(ToxWindow *self, Toxic *toxic, uint32_t groupnumber, const char *old_nick,
         size_t old_length, const char *new_nick, size_t length);
 static void ignore_list_cleanup(GroupChat *chat);
+static void ignore_list_load(GroupChat *chat, const char *path);
 
 /*
  * Return a GroupChat pointer associated with groupnumber.
@@ -212,13 +214,7 @@ void groupchat_rejoin(ToxWindow *self, Toxic *toxic)
         return;
     }
 
-    for (uint32_t i = 0; i < chat->max_idx; ++i) {
-        clear_peer(&chat->peer_list[i]);
-    }
-
-    chat->num_peers = 0;
-    chat->max_idx = 0;
-    realloc_peer_list(self->num, 0);
+    free_peer_list(chat);
 
     groupchat_onGroupPeerJoin(self, toxic, self->num, self_peer_id);
 }
@@ -235,6 +231,7 @@ static void kill_groupchat_window(ToxWindow *self, Windows *windows, const Clien
     if (ctx != NULL) {
         log_disable(ctx->log);
         line_info_cleanup(ctx->hst);
+        free_line_hist(ctx);
         delwin(ctx->linewin);
         delwin(ctx->history);
         delwin(ctx->sidebar);
@@ -262,9 +259,7 @@ static void close_groupchat(ToxWindow *self, Toxic *toxic, uint32_t groupnumber)
 
     ignore_list_cleanup(chat);
 
-    realloc_peer_list(groupnumber, 0);
-
-    free_ptr_array((void **) chat->name_list);
+    free_peer_list(chat);
 
     *chat = (GroupChat) {
         0
@@ -389,8 +384,10 @@ int init_groupchat_win(Toxic *toxic, uint32_t groupnumber, const char *groupname
                 return -1;
             }
 
+            ignore_list_load(&groupchats[i], toxic->client_data.group_ignore_path);
+
             set_active_window_by_id(toxic->windows, groupchats[i].window_id);
-            store_data(toxic);
+            profile_save_request();
 
             Tox_Err_Group_Self_Query err;
             const uint32_t peer_id = tox_group_self_get_peer_id(tox, groupnumber, &err);
@@ -406,6 +403,8 @@ int init_groupchat_win(Toxic *toxic, uint32_t groupnumber, const char *groupname
 
             groupchat_onGroupPeerJoin(self, toxic, groupnumber, peer_id);
 
+            settings_load_group(toxic->windows, toxic->settings_tree, (const uint8_t *) groupchats[i].chat_id);
+
             return 0;
         }
     }
@@ -531,43 +530,275 @@ void set_status_all_groups(Toxic *toxic, uint8_t status)
     }
 }
 
-/* Returns a weight for peer_sort_cmp based on the peer's role. */
-#define PEER_CMP_BASE_WEIGHT 100000
-static int peer_sort_cmp_weight(const struct GroupPeer *peer)
+/* Returns a weight for peer_order_cmp based on the peer's role. */
+static int peer_sort_weight(const GroupPeer *peer)
 {
-    int w = PEER_CMP_BASE_WEIGHT;
+    switch (peer->role) {
+        case TOX_GROUP_ROLE_FOUNDER:
+            return 3;
 
-    if (peer->role == TOX_GROUP_ROLE_FOUNDER) {
-        w <<= 2;
-    } else if (peer->role == TOX_GROUP_ROLE_MODERATOR) {
-        w <<= 1;
-    } else if (peer->role == TOX_GROUP_ROLE_OBSERVER) {
-        w >>= 1;
+        case TOX_GROUP_ROLE_MODERATOR:
+            return 2;
+
+        case TOX_GROUP_ROLE_OBSERVER:
+            return 0;
+
+        default:
+            return 1;
+    }
+}
+
+/* Orders peers by role, then by name, then by peer_id so that no two peers compare equal. */
+static int peer_order_cmp(const GroupPeer *peer1, const GroupPeer *peer2)
+{
+    const int w1 = peer_sort_weight(peer1);
+    const int w2 = peer_sort_weight(peer2);
+
+    if (w1 != w2) {
+        return w2 - w1;
     }
 
-    return w;
+    const int res = qsort_strcasecmp_hlpr(peer1->name, peer2->name);
+
+    if (res != 0) {
+        return res;
+    }
+
+    return (peer1->peer_id > peer2->peer_id) - (peer1->peer_id < peer2->peer_id);
 }
 
-static int peer_sort_cmp(const void *n1, const void *n2)
+/* Orders peers by name ignoring case, then by peer_id, so that nicks sharing a prefix are adjacent. */
+static int peer_nick_cmp(const GroupPeer *peer1, const GroupPeer *peer2)
 {
-    const struct GroupPeer *peer1 = (const struct GroupPeer *) n1;
-    const struct GroupPeer *peer2 = (const struct GroupPeer *) n2;
+    const int res = qsort_strcasecmp_hlpr(peer1->name, peer2->name);
 
-    int res = qsort_strcasecmp_hlpr(peer1->name, peer2->name);
-    return res - peer_sort_cmp_weight(peer1) + peer_sort_cmp_weight(peer2);
+    if (res != 0) {
+        return res;
+    }
 
+    return (peer1->peer_id > peer2->peer_id) - (peer1->peer_id < peer2->peer_id);
 }
 
-/* Sorts the peer list, first by role, then by name. */
-static void sort_peerlist(uint32_t groupnumber)
+typedef int peer_cmp_cb(const GroupPeer *peer1, const GroupPeer *peer2);
+
+/* Returns the position in `order`, which holds `num_peers` indices sorted by `cmp`, where the peer
+ * at `index` belongs. */
+static uint32_t peer_lower_bound(const GroupChat *chat, const uint32_t *order, peer_cmp_cb *cmp, uint32_t index)
 {
-    GroupChat *chat = get_groupchat(groupnumber);
+    const GroupPeer *peer = &chat->peer_list[index];
+    uint32_t lo = 0;
+    uint32_t hi = chat->num_peers;
 
-    if (!chat) {
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+
+        if (cmp(&chat->peer_list[order[mid]], peer) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static void peer_order_insert(GroupChat *chat, uint32_t *order, peer_cmp_cb *cmp, uint32_t index)
+{
+    const uint32_t pos = peer_lower_bound(chat, order, cmp, index);
+
+    memmove(&order[pos + 1], &order[pos], (chat->num_peers - pos) * sizeof(uint32_t));
+    order[pos] = index;
+}
+
+static bool peer_order_remove(GroupChat *chat, uint32_t *order, peer_cmp_cb *cmp, uint32_t index)
+{
+    const uint32_t pos = peer_lower_bound(chat, order, cmp, index);
+
+    if (pos >= chat->num_peers || order[pos] != index) {
+        return false;
+    }
+
+    memmove(&order[pos], &order[pos + 1], (chat->num_peers - pos - 1) * sizeof(uint32_t));
+
+    return true;
+}
+
+static uint32_t peer_nick_hash(const GroupPeer *peer)
+{
+    return hash_index_bytes(peer->name, peer->name_length);
+}
+
+static uint32_t peer_key_hash(const uint8_t *public_key)
+{
+    return hash_index_bytes(public_key, TOX_GROUP_PEER_PUBLIC_KEY_SIZE);
+}
+
+/*
+ * Places the active peer at `index` in the display order, the nick order and the nick index. Must
+ * be undone with peer_unlink() before the peer's name or role changes, and redone afterwards.
+ *
+ * `num_peers` must not count the peer yet.
+ */
+static void peer_link(GroupChat *chat, uint32_t index)
+{
+    peer_order_insert(chat, chat->peer_order, peer_order_cmp, index);
+    peer_order_insert(chat, chat->nick_order, peer_nick_cmp, index);
+    ++chat->num_peers;
+
+    if (!hash_index_add(&chat->nick_index, peer_nick_hash(&chat->peer_list[index]), index)) {
+        fprintf(stderr, "WARNING: Out of memory in peer_link()\n");
+    }
+
+    chat->name_list_dirty = true;
+}
+
+static void peer_unlink(GroupChat *chat, uint32_t index)
+{
+    if (!peer_order_remove(chat, chat->peer_order, peer_order_cmp, index)) {
+        return;
+    }
+
+    peer_order_remove(chat, chat->nick_order, peer_nick_cmp, index);
+    --chat->num_peers;
+
+    hash_index_remove(&chat->nick_index, peer_nick_hash(&chat->peer_list[index]), index);
+
+    chat->name_list_dirty = true;
+}
+
+static void peer_set_role(GroupChat *chat, uint32_t index, Tox_Group_Role role)
+{
+    if (chat->peer_list[index].role == role) {
         return;
     }
 
-    qsort(chat->peer_list, chat->max_idx, sizeof(struct GroupPeer), peer_sort_cmp);
+    peer_unlink(chat, index);
+    chat->peer_list[index].role = role;
+    chat->peer_list[index].sidebar.valid = false;
+    peer_link(chat, index);
+}
+
+static void peer_set_name(GroupChat *chat, uint32_t index, const char *name, size_t length)
+{
+    GroupPeer *peer = &chat->peer_list[index];
+
+    peer_unlink(chat, index);
+
+    length = MIN(length, TOX_MAX_NAME_LENGTH - 1);
+    memcpy(peer->name, name, length);
+    peer->name[length] = '\0';
+    peer->name_length = length;
+    peer->sidebar.valid = false;
+
+    peer_link(chat, index);
+}
+
+static void free_peer_list(GroupChat *chat)
+{
+    free(chat->peer_list);
+    free(chat->peer_order);
+    free(chat->nick_order);
+    free(chat->free_peers);
+    free(chat->name_list);
+    hash_index_free(&chat->id_index);
+    hash_index_free(&chat->key_index);
+    hash_index_free(&chat->nick_index);
+
+    chat->peer_list = NULL;
+    chat->peer_order = NULL;
+    chat->nick_order = NULL;
+    chat->free_peers = NULL;
+    chat->name_list = NULL;
+    chat->peer_list_capacity = 0;
+    chat->num_free_peers = 0;
+    chat->num_peers = 0;
+    chat->max_idx = 0;
+    chat->name_list_dirty = false;
+}
+
+/* Returns the index of an unused entry in the peer list, growing the list geometrically if it's full.
+ *
+ * Returns -1 on failure.
+ */
+static int64_t take_peer_slot(GroupChat *chat)
+{
+    if (chat->num_free_peers > 0) {
+        return chat->free_peers[--chat->num_free_peers];
+    }
+
+    if (chat->max_idx == chat->peer_list_capacity) {
+        const uint32_t capacity = chat->peer_list_capacity > 0 ? chat->peer_list_capacity * 2 : 8;
+
+        GroupPeer *tmp_list = realloc(chat->peer_list, capacity * sizeof(GroupPeer));
+
+        if (tmp_list == NULL) {
+            return -1;
+        }
+
+        chat->peer_list = tmp_list;
+
+        // Names point into the old peer list
+        chat->name_list_dirty = true;
+
+        uint32_t *tmp_order = realloc(chat->peer_order, capacity * sizeof(uint32_t));
+
+        if (tmp_order == NULL) {
+            return -1;
+        }
+
+        chat->peer_order = tmp_order;
+
+        uint32_t *tmp_nick_order = realloc(chat->nick_order, capacity * sizeof(uint32_t));
+
+        if (tmp_nick_order == NULL) {
+            return -1;
+        }
+
+        chat->nick_order = tmp_nick_order;
+
+        uint32_t *tmp_free = realloc(chat->free_peers, capacity * sizeof(uint32_t));
+
+        if (tmp_free == NULL) {
+            return -1;
+        }
+
+        chat->free_peers = tmp_free;
+
+        // The name list is null terminated
+        const char **tmp_names = realloc(chat->name_list, (capacity + 1) * sizeof(char *));
+
+        if (tmp_names == NULL) {
+            return -1;
+        }
+
+        chat->name_list = tmp_names;
+        chat->peer_list_capacity = capacity;
+    }
+
+    return chat->max_idx++;
+}
+
+/* Returns the unused entry at `index` to the peer list. */
+static void release_peer_slot(GroupChat *chat, uint32_t index)
+{
+    clear_peer(&chat->peer_list[index]);
+    chat->free_peers[chat->num_free_peers++] = index;
+}
+
+/* Refreshes the name list used for tab completion if peers joined, left or changed names since the last call. */
+static void groupchat_update_name_list(GroupChat *chat)
+{
+    if (!chat->name_list_dirty || chat->name_list == NULL) {
+        return;
+    }
+
+    chat->name_list_dirty = false;
+
+    for (uint32_t i = 0; i < chat->num_peers; ++i) {
+        chat->name_list[i] = chat->peer_list[chat->nick_order[i]].name;
+    }
+
+    chat->name_list[chat->num_peers] = NULL;
 }
 
 /* Puts the peer_id associated with nick in `peer_id`.
@@ -578,35 +809,43 @@ static void sort_peerlist(uint32_t groupnumber)
  */
 static int group_get_nick_peer_id(uint32_t groupnumber, const char *nick, uint32_t *peer_id)
 {
-    GroupChat *chat = get_groupchat(groupnumber);
+    uint32_t peer_ids[2];
 
-    if (!chat) {
-        return -1;
-    }
+    switch (group_get_nick_peer_ids(groupnumber, nick, peer_ids, 2)) {
+        case 0:
+            return -1;
 
-    if (nick == NULL) {
-        return -1;
+        case 1:
+            *peer_id = peer_ids[0];
+            return 0;
+
+        default:
+            return -2;
     }
+}
 
-    size_t count = 0;
+uint32_t group_get_nick_peer_ids(uint32_t groupnumber, const char *nick, uint32_t *peer_ids, uint32_t max_peers)
+{
+    const GroupChat *chat = get_groupchat(groupnumber);
 
-    for (uint32_t i = 0; i < chat->max_idx; ++i) {
-        GroupPeer *peer = &chat->peer_list[i];
+    if (chat == NULL || nick == NULL) {
+        return 0;
+    }
 
-        if (!peer->active) {
-            continue;
-        }
+    const uint32_t hash = hash_index_bytes(nick, strlen(nick));
+    size_t cursor = hash;
+    uint32_t index;
+    uint32_t count = 0;
 
-        if (strcmp(nick, peer->name) == 0) {
-            if (++count > 1) {
-                return -2;
-            }
+    while (count < max_peers && hash_index_next(&chat->nick_index, hash, &cursor, &index)) {
+        const GroupPeer *peer = &chat->peer_list[index];
 
-            *peer_id = peer->peer_id;
+        if (strcmp(nick, peer->name) == 0) {
+            peer_ids[count++] = peer->peer_id;
         }
     }
 
-    return count > 0 ? 0 : -1;
+    return count;
 }
 
 /* Gets the peer_id associated with `public_key`.
@@ -636,12 +875,12 @@ int group_get_public_key_peer_id(uint32_t groupnumber, const char *public_key, u
         return -1;
     }
 
-    for (uint32_t i = 0; i < chat->max_idx; ++i) {
-        GroupPeer *peer = &chat->peer_list[i];
+    const uint32_t hash = peer_key_hash((const uint8_t *) key_bin);
+    size_t cursor = hash;
+    uint32_t index;
 
-        if (!peer->active) {
-            continue;
-        }
+    while (hash_index_next(&chat->key_index, hash, &cursor, &index)) {
+        const GroupPeer *peer = &chat->peer_list[index];
 
         if (memcmp(key_bin, peer->public_key, TOX_GROUP_PEER_PUBLIC_KEY_SIZE) == 0) {
             *peer_id = peer->peer_id;
@@ -725,13 +964,29 @@ int get_peer_index(uint32_t groupnumber, uint32_t peer_id)
         return -1;
     }
 
-    for (uint32_t i = 0; i < chat->max_idx; ++i) {
-        if (!chat->peer_list[i].active) {
-            continue;
+    const uint32_t hash = hash_index_u32(peer_id);
+    size_t cursor = hash;
+    uint32_t index;
+
+    while (hash_index_next(&chat->id_index, hash, &cursor, &index)) {
+        if (chat->peer_list[index].peer_id == peer_id) {
+            return index;
         }
+    }
+
+    return -1;
+}
+
+/* Returns the index of `key` in the ignore list of `chat`, or -1 if it isn't there. */
+static long ignore_list_find(const GroupChat *chat, const uint8_t *key)
+{
+    const uint32_t hash = hash_index_bytes(key, TOX_GROUP_PEER_PUBLIC_KEY_SIZE);
+    size_t cursor = hash;
+    uint32_t slot;
 
-        if (chat->peer_list[i].peer_id == peer_id) {
-            return i;
+    while (hash_index_next(&chat->ignored_index, hash, &cursor, &slot)) {
+        if (memcmp(chat->ignored_keys[slot], key, TOX_GROUP_PEER_PUBLIC_KEY_SIZE) == 0) {
+            return slot;
         }
     }
 
@@ -743,93 +998,263 @@ int get_peer_index(uint32_t groupnumber, uint32_t peer_id)
  */
 static bool peer_is_ignored(const GroupChat *chat, const uint8_t *key)
 {
-    for (uint16_t i = 0; i < chat->num_ignored; ++i) {
-        if (memcmp(chat->ignored_list[i], key, TOX_GROUP_PEER_PUBLIC_KEY_SIZE) == 0) {
-            return true;
-        }
+    return ignore_list_find(chat, key) >= 0;
+}
+
+/*
+ * Makes sure the ignore list of `chat` has room for `count` keys.
+ *
+ * Returns false on allocation failure.
+ */
+static bool ignore_list_reserve(GroupChat *chat, uint32_t count)
+{
+    if (count <= chat->ignored_capacity) {
+        return true;
     }
 
-    return false;
+    uint32_t capacity = chat->ignored_capacity > 0 ? chat->ignored_capacity : 8;
+
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    uint8_t (*keys)[TOX_GROUP_PEER_PUBLIC_KEY_SIZE] = realloc(chat->ignored_keys, capacity * sizeof(*keys));
+
+    if (keys == NULL) {
+        return false;
+    }
+
+    chat->ignored_keys = keys;
+    chat->ignored_capacity = capacity;
+
+    return true;
 }
 
-static bool ignore_list_add_key(GroupChat *chat, const uint8_t *key)
+/*
+ * Adds `key` to the ignore list of `chat`. Adding a key that's already there does nothing.
+ *
+ * Returns false on allocation failure, in which case the list is unchanged.
+ */
+static bool ignore_list_add(GroupChat *chat, const uint8_t *key)
 {
-    uint8_t **tmp_list = (uint8_t **)realloc(chat->ignored_list, (chat->num_ignored + 1) * sizeof(uint8_t *));
+    if (ignore_list_find(chat, key) >= 0) {
+        return true;
+    }
 
-    if (tmp_list == NULL) {
+    if (!ignore_list_reserve(chat, chat->num_ignored + 1)) {
         return false;
     }
 
-    chat->ignored_list = tmp_list;
-
-    tmp_list[chat->num_ignored] = (uint8_t *)malloc(sizeof(uint8_t) * TOX_GROUP_PEER_PUBLIC_KEY_SIZE);
+    const uint32_t hash = hash_index_bytes(key, TOX_GROUP_PEER_PUBLIC_KEY_SIZE);
 
-    if (tmp_list[chat->num_ignored] == NULL) {
+    if (!hash_index_add(&chat->ignored_index, hash, chat->num_ignored)) {
         return false;
     }
 
-    memcpy(tmp_list[chat->num_ignored], key, TOX_GROUP_PEER_PUBLIC_KEY_SIZE);
+    memcpy(chat->ignored_keys[chat->num_ignored], key, TOX_GROUP_PEER_PUBLIC_KEY_SIZE);
     ++chat->num_ignored;
 
     return true;
 }
 
-static void ignore_list_cleanup(GroupChat *chat)
+/*
+ * Removes `key` from the ignore list of `chat`, moving the last key into its place.
+ *
+ * Returns false if `key` wasn't in the list.
+ */
+static bool ignore_list_remove(GroupChat *chat, const uint8_t *key)
 {
-    for (uint16_t i = 0; i < chat->num_ignored; ++i) {
-        free(chat->ignored_list[i]);
+    const long slot = ignore_list_find(chat, key);
+
+    if (slot < 0) {
+        return false;
     }
 
-    free(chat->ignored_list);
-    chat->ignored_list = NULL;
+    const uint32_t last = chat->num_ignored - 1;
+
+    hash_index_remove(&chat->ignored_index, hash_index_bytes(key, TOX_GROUP_PEER_PUBLIC_KEY_SIZE), (uint32_t) slot);
+
+    if ((uint32_t) slot != last) {
+        const uint32_t last_hash = hash_index_bytes(chat->ignored_keys[last], TOX_GROUP_PEER_PUBLIC_KEY_SIZE);
+
+        // Can't fail: the index had room for this entry a moment ago
+        hash_index_remove(&chat->ignored_index, last_hash, last);
+        hash_index_add(&chat->ignored_index, last_hash, (uint32_t) slot);
+
+        memcpy(chat->ignored_keys[slot], chat->ignored_keys[last], TOX_GROUP_PEER_PUBLIC_KEY_SIZE);
+    }
+
+    --chat->num_ignored;
+
+    return true;
+}
+
+static void ignore_list_cleanup(GroupChat *chat)
+{
+    free(chat->ignored_keys);
+    chat->ignored_keys = NULL;
     chat->num_ignored = 0;
+    chat->ignored_capacity = 0;
+
+    hash_index_free(&chat->ignored_index);
 }
 
-static bool ignore_list_rm_key(GroupChat *chat, const uint8_t *key)
+/*
+ * The ignore lists of all groups share one file at `path`, made of records holding a group's chat
+ * ID followed by the public key of a peer ignored in that group.
+ */
+#define IGNORE_RECORD_SIZE (TOX_GROUP_CHAT_ID_SIZE + TOX_GROUP_PEER_PUBLIC_KEY_SIZE)
+#define TEMP_IGNORE_LIST_EXT ".tmp"
+
+/* Reads the ignore list file at `path`, putting its length in `length`.
+ *
+ * Returns NULL if the file is missing, malformed, or can't be read.
+ */
+static uint8_t *ignore_list_read_file(const char *path, size_t *length)
 {
-    if (chat->num_ignored == 0) {
-        return false;
+    *length = 0;
+
+    if (path == NULL || !file_exists(path)) {
+        return NULL;
     }
 
-    int32_t idx = -1;
+    const off_t len = file_size(path);
 
-    for (uint16_t i = 0; i < chat->num_ignored; ++i) {
-        if (memcmp(chat->ignored_list[i], key, TOX_GROUP_PEER_PUBLIC_KEY_SIZE) == 0) {
-            idx = i;
-            break;
+    if (len <= 0 || len % IGNORE_RECORD_SIZE != 0) {
+        return NULL;
+    }
+
+    FILE *fp = fopen(path, "rb");
+
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    uint8_t *data = malloc(len);
+
+    if (data == NULL || fread(data, len, 1, fp) != 1) {
+        fclose(fp);
+        free(data);
+        return NULL;
+    }
+
+    fclose(fp);
+    *length = len;
+
+    return data;
+}
+
+/* Adds the keys stored for `chat` in the ignore list file at `path` to its ignore list. */
+static void ignore_list_load(GroupChat *chat, const char *path)
+{
+    size_t length;
+    uint8_t *data = ignore_list_read_file(path, &length);
+
+    if (data == NULL) {
+        return;
+    }
+
+    uint32_t num_keys = 0;
+
+    for (size_t i = 0; i < length; i += IGNORE_RECORD_SIZE) {
+        num_keys += memcmp(&data[i], chat->chat_id, TOX_GROUP_CHAT_ID_SIZE) == 0;
+    }
+
+    // Failing here only means the list grows as the keys are added
+    ignore_list_reserve(chat, chat->num_ignored + num_keys);
+
+    for (size_t i = 0; i < length; i += IGNORE_RECORD_SIZE) {
+        if (memcmp(&data[i], chat->chat_id, TOX_GROUP_CHAT_ID_SIZE) != 0) {
+            continue;
+        }
+
+        if (!ignore_list_add(chat, &data[i + TOX_GROUP_CHAT_ID_SIZE])) {
+            fprintf(stderr, "Failed to load group ignore list entry\n");
         }
     }
 
-    if (idx == -1) {
-        fprintf(stderr, "Key not found in ignore list\n");
-        return false;
+    free(data);
+}
+
+/* Replaces the keys stored for `chat` in the ignore list file at `path` with its current ignore
+ * list, keeping the entries of other groups. If no entries are left the file is removed.
+ *
+ * Returns 0 on success.
+ * Returns -1 on failure.
+ */
+static int ignore_list_save(const GroupChat *chat, const char *path)
+{
+    if (path == NULL) {
+        return -1;
     }
 
-    if ((chat->num_ignored - 1) == 0) {
-        ignore_list_cleanup(chat);
-        return true;
+    size_t old_length;
+    uint8_t *old_data = ignore_list_read_file(path, &old_length);
+
+    uint8_t *data = malloc(old_length + chat->num_ignored * IGNORE_RECORD_SIZE + 1);
+
+    if (data == NULL) {
+        free(old_data);
+        return -1;
     }
 
-    --chat->num_ignored;
+    size_t length = 0;
 
-    if (idx != chat->num_ignored) {
-        memcpy(chat->ignored_list[idx], chat->ignored_list[chat->num_ignored], TOX_GROUP_PEER_PUBLIC_KEY_SIZE);
+    for (size_t i = 0; i < old_length; i += IGNORE_RECORD_SIZE) {
+        if (memcmp(&old_data[i], chat->chat_id, TOX_GROUP_CHAT_ID_SIZE) != 0) {
+            memcpy(&data[length], &old_data[i], IGNORE_RECORD_SIZE);
+            length += IGNORE_RECORD_SIZE;
+        }
     }
 
-    free(chat->ignored_list[chat->num_ignored]);
+    free(old_data);
 
-    uint8_t **tmp_list = realloc(chat->ignored_list, chat->num_ignored * sizeof(uint8_t *));
+    for (uint32_t i = 0; i < chat->num_ignored; ++i) {
+        memcpy(&data[length], chat->chat_id, TOX_GROUP_CHAT_ID_SIZE);
+        memcpy(&data[length + TOX_GROUP_CHAT_ID_SIZE], chat->ignored_keys[i], TOX_GROUP_PEER_PUBLIC_KEY_SIZE);
+        length += IGNORE_RECORD_SIZE;
+    }
 
-    if (tmp_list == NULL) {
-        return false;
+    if (length == 0) {
+        free(data);
+        return file_exists(path) && remove(path) != 0 ? -1 : 0;
     }
 
-    chat->ignored_list = tmp_list;
+    const size_t temp_buf_size = strlen(path) + strlen(TEMP_IGNORE_LIST_EXT) + 1;
+    char *temp_path = malloc(temp_buf_size);
 
-    return true;
+    if (temp_path == NULL) {
+        free(data);
+        return -1;
+    }
+
+    snprintf(temp_path, temp_buf_size, "%s%s", path, TEMP_IGNORE_LIST_EXT);
+
+    FILE *fp = fopen(temp_path, "wb");
+
+    if (fp == NULL) {
+        free(data);
+        free(temp_path);
+        return -1;
+    }
+
+    const bool written = fwrite(data, length, 1, fp) == 1;
+
+    fclose(fp);
+    free(data);
+
+    if (!written || rename(temp_path, path) != 0) {
+        fprintf(stderr, "Failed to write group ignore list.\n");
+        free(temp_path);
+        return -1;
+    }
+
+    free(temp_path);
+
+    return 0;
 }
 
-void group_toggle_peer_ignore(uint32_t groupnumber, int peer_id, bool ignore)
+void group_toggle_peer_ignore(Toxic *toxic, uint32_t groupnumber, int peer_id, bool ignore)
 {
     int peer_index = get_peer_index(groupnumber, peer_id);
 
@@ -847,49 +1272,24 @@ void group_toggle_peer_ignore(uint32_t groupnumber, int peer_id, bool ignore)
     GroupPeer *peer = &chat->peer_list[peer_index];
 
     peer->is_ignored = ignore;
+    peer->sidebar.valid = false;
 
     bool ret;
 
     if (ignore) {
-        ret = ignore_list_add_key(chat, peer->public_key);
+        ret = ignore_list_add(chat, peer->public_key);
     } else {
-        ret = ignore_list_rm_key(chat, peer->public_key);
+        ret = ignore_list_remove(chat, peer->public_key);
     }
 
     if (!ret) {
         fprintf(stderr, "Client failed to modify ignore list\n");
-    }
-}
-
-static void groupchat_update_name_list(uint32_t groupnumber)
-{
-    GroupChat *chat = get_groupchat(groupnumber);
-
-    if (!chat) {
         return;
     }
 
-    free_ptr_array((void **) chat->name_list);
-
-    chat->name_list = (char **) malloc_ptr_array(chat->num_peers, TOX_MAX_NAME_LENGTH + 1);
-
-    if (!chat->name_list) {
-        fprintf(stderr, "WARNING: Out of memory in groupchat_update_name_list()\n");
-        return;
+    if (ignore_list_save(chat, toxic->client_data.group_ignore_path) != 0) {
+        fprintf(stderr, "Failed to save group ignore list\n");
     }
-
-    uint32_t count = 0;
-
-    for (uint32_t i = 0; i < chat->max_idx; ++i) {
-        if (chat->peer_list[i].active) {
-            size_t length = chat->peer_list[i].name_length;
-            memcpy(chat->name_list[count], chat->peer_list[i].name, length);
-            chat->name_list[count][length] = 0;
-            ++count;
-        }
-    }
-
-    sort_peerlist(groupnumber);
 }
 
 /* destroys and re-creates groupchat window */
@@ -984,6 +1384,10 @@ static void groupchat_onGroupMessage(ToxWindow *self, Toxic *toxic, uint32_t gro
 
     groupchat_update_last_seen(groupnumber, peer_id);
 
+    if (c_config->filter_blocked_words && string_contains_blocked_word(msg, &toxic->client_data)) {
+        return;
+    }
+
     if (type == TOX_MESSAGE_TYPE_ACTION) {
         group_onAction(self, toxic, groupnumber, peer_id, msg, len);
         return;
@@ -1034,6 +1438,10 @@ static void groupchat_onGroupPrivateMessage(ToxWindow *self, Toxic *toxic, uint3
 
     groupchat_update_last_seen(groupnumber, peer_id);
 
+    if (c_config->filter_blocked_words && string_contains_blocked_word(msg, &toxic->client_data)) {
+        return;
+    }
+
     ChatContext *ctx = self->chatwin;
 
     char nick[TOX_MAX_NAME_LENGTH + 1];
@@ -1215,36 +1623,6 @@ static void groupchat_onGroupPassword(ToxWindow *self, Toxic *toxic, uint32_t gr
     }
 }
 
-/* Reallocates groupnumber's peer list to size n.
- *
- * Returns 0 on success.
- * Returns -1 on failure.
- */
-static int realloc_peer_list(uint32_t groupnumber, uint32_t n)
-{
-    GroupChat *chat = get_groupchat(groupnumber);
-
-    if (chat == NULL) {
-        return -1;
-    }
-
-    if (n == 0) {
-        free(chat->peer_list);
-        chat->peer_list = NULL;
-        return 0;
-    }
-
-    struct GroupPeer *tmp_list = realloc(chat->peer_list, n * sizeof(struct GroupPeer));
-
-    if (!tmp_list) {
-        return -1;
-    }
-
-    chat->peer_list = tmp_list;
-
-    return 0;
-}
-
 static void groupchat_onGroupPeerJoin(ToxWindow *self, Toxic *toxic, uint32_t groupnumber, uint32_t peer_id)
 {
     if (toxic == NULL || self == NULL) {
@@ -1265,51 +1643,54 @@ static void groupchat_onGroupPeerJoin(ToxWindow *self, Toxic *toxic, uint32_t gr
         return;
     }
 
-    if (realloc_peer_list(groupnumber, chat->max_idx + 1) == -1) {
+    if (get_peer_index(groupnumber, peer_id) >= 0) {
         return;
     }
 
-    clear_peer(&chat->peer_list[chat->max_idx]);
+    const int64_t slot = take_peer_slot(chat);
 
-    for (uint32_t i = 0; i <= chat->max_idx; ++i) {
-        GroupPeer *peer = &chat->peer_list[i];
+    if (slot == -1) {
+        return;
+    }
 
-        if (peer->active) {
-            continue;
-        }
+    const uint32_t i = (uint32_t) slot;
+    GroupPeer *peer = &chat->peer_list[i];
 
-        ++chat->num_peers;
-
-        peer->active = true;
-        peer->peer_id = peer_id;
-        get_group_nick_truncate(tox, peer->name, sizeof(peer->name), peer_id, groupnumber);
-        peer->name_length = strlen(peer->name);
-        snprintf(peer->prev_name, sizeof(peer->prev_name), "%s", peer->name);
-        peer->status = tox_group_peer_get_status(tox, groupnumber, peer_id, NULL);
-        peer->role = tox_group_peer_get_role(tox, groupnumber, peer_id, NULL);
-        peer->last_active = get_unix_time();
-        tox_group_peer_get_public_key(tox, groupnumber, peer_id, (uint8_t *)peer->public_key, NULL);
-        peer->is_ignored = peer_is_ignored(chat, peer->public_key);
-
-        if (peer->is_ignored) {
-            tox_group_set_ignore(tox, groupnumber, peer_id, true, NULL);
-        }
+    clear_peer(peer);
 
-        if (i == chat->max_idx) {
-            ++chat->max_idx;
-        }
+    peer->active = true;
+    peer->peer_id = peer_id;
+    get_group_nick_truncate(tox, peer->name, sizeof(peer->name), peer_id, groupnumber);
+    peer->name_length = strlen(peer->name);
+    snprintf(peer->prev_name, sizeof(peer->prev_name), "%s", peer->name);
+    peer->status = tox_group_peer_get_status(tox, groupnumber, peer_id, NULL);
+    peer->role = tox_group_peer_get_role(tox, groupnumber, peer_id, NULL);
+    peer->last_active = get_unix_time();
+    tox_group_peer_get_public_key(tox, groupnumber, peer_id, (uint8_t *)peer->public_key, NULL);
+    peer->is_ignored = peer_is_ignored(chat, peer->public_key);
 
-        /* ignore join messages when we first connect to the group */
-        if (timed_out(chat->time_connected, 60) && c_config->show_group_connection_msg) {
-            line_info_add(self, c_config, true, peer->name, NULL, CONNECTION, 0, GREEN, "has joined the room");
+    if (peer->is_ignored) {
+        tox_group_set_ignore(tox, groupnumber, peer_id, true, NULL);
+    }
 
-            write_to_log(ctx->log, c_config, "has joined the room", peer->name, LOG_HINT_CONNECT);
-            sound_notify(self, toxic, silent, NT_WNDALERT_2, NULL);
-        }
+    if (!hash_index_add(&chat->id_index, hash_index_u32(peer_id), i)) {
+        fprintf(stderr, "Failed to index group peer %u\n", peer_id);
+        release_peer_slot(chat, i);
+        return;
+    }
 
-        groupchat_update_name_list(groupnumber);
+    if (!hash_index_add(&chat->key_index, peer_key_hash(peer->public_key), i)) {
+        fprintf(stderr, "Failed to index group peer %u\n", peer_id);
+    }
 
-        return;
+    peer_link(chat, i);
+
+    /* ignore join messages when we first connect to the group */
+    if (timed_out(chat->time_connected, 60) && c_config->show_group_connection_msg) {
+        line_info_add(self, c_config, true, peer->name, NULL, CONNECTION, 0, GREEN, "has joined the room");
+
+        write_to_log(ctx->log, c_config, "has joined the room", peer->name, LOG_HINT_CONNECT);
+        sound_notify(self, toxic, silent, NT_WNDALERT_2, NULL);
     }
 }
 
@@ -1355,30 +1736,19 @@ void groupchat_onGroupPeerExit(ToxWindow *self, Toxic *toxic, uint32_t groupnumb
 
     }
 
-    int peer_index = get_peer_index(groupnumber, peer_id);
+    const int peer_index = get_peer_index(groupnumber, peer_id);
 
     if (peer_index < 0) {
         return;
     }
 
-    clear_peer(&chat->peer_list[peer_index]);
-
-    uint32_t i;
-
-    for (i = chat->max_idx; i > 0; --i) {
-        if (chat->peer_list[i - 1].active) {
-            break;
-        }
-    }
+    GroupPeer *peer = &chat->peer_list[peer_index];
 
-    if (realloc_peer_list(groupnumber, i) == -1) {
-        return;
-    }
+    peer_unlink(chat, peer_index);
+    hash_index_remove(&chat->id_index, hash_index_u32(peer_id), peer_index);
+    hash_index_remove(&chat->key_index, peer_key_hash(peer->public_key), peer_index);
 
-    --chat->num_peers;
-    chat->max_idx = i;
-
-    groupchat_update_name_list(groupnumber);
+    release_peer_slot(chat, peer_index);
 }
 
 static void groupchat_set_group_name(ToxWindow *self, Toxic *toxic, uint32_t groupnumber)
@@ -1486,9 +1856,7 @@ static void groupchat_onGroupSelfJoin(ToxWindow *self, Toxic *toxic, uint32_t gr
         return;
     }
 
-    chat->peer_list[idx].role = role;
-
-    sort_peerlist(groupnumber);
+    peer_set_role(chat, idx, role);
 }
 
 static void groupchat_onGroupRejected(ToxWindow *self, Toxic *toxic, uint32_t groupnumber, Tox_Group_Join_Fail type)
@@ -1539,7 +1907,7 @@ static void groupchat_update_roles(Tox *tox, uint32_t groupnumber)
         Tox_Group_Role role = tox_group_peer_get_role(tox, groupnumber, peer->peer_id, &err);
 
         if (err == TOX_ERR_GROUP_PEER_QUERY_OK) {
-            peer->role = role;
+            peer_set_role(chat, i, role);
         }
     }
 }
@@ -1588,24 +1956,21 @@ void groupchat_onGroupModeration(ToxWindow *self, Toxic *toxic, uint32_t groupnu
             break;
 
         case TOX_GROUP_MOD_EVENT_OBSERVER:
-            chat->peer_list[tgt_index].role = TOX_GROUP_ROLE_OBSERVER;
+            peer_set_role(chat, tgt_index, TOX_GROUP_ROLE_OBSERVER);
             snprintf(msg, sizeof(msg), "-!- %s has set %s's role to observer", src_name, tgt_name);
             line_info_add(self, c_config, true, NULL, NULL, SYS_MSG, 1, BLUE, "%s", msg);
-            sort_peerlist(groupnumber);
             break;
 
         case TOX_GROUP_MOD_EVENT_USER:
-            chat->peer_list[tgt_index].role = TOX_GROUP_ROLE_USER;
+            peer_set_role(chat, tgt_index, TOX_GROUP_ROLE_USER);
             snprintf(msg, sizeof(msg), "-!- %s has set %s's role to user", src_name, tgt_name);
             line_info_add(self, c_config, true, NULL, NULL, SYS_MSG, 1, BLUE, "%s", msg);
-            sort_peerlist(groupnumber);
             break;
 
         case TOX_GROUP_MOD_EVENT_MODERATOR:
-            chat->peer_list[tgt_index].role = TOX_GROUP_ROLE_MODERATOR;
+            peer_set_role(chat, tgt_index, TOX_GROUP_ROLE_MODERATOR);
             snprintf(msg, sizeof(msg), "-!- %s has set %s's role to moderator", src_name, tgt_name);
             line_info_add(self, c_config, true, NULL, NULL, SYS_MSG, 1, BLUE, "%s", msg);
-            sort_peerlist(groupnumber);
             break;
 
         default:
@@ -1650,16 +2015,12 @@ static void groupchat_onGroupSelfNickChange(ToxWindow *self, Toxic *toxic, uint3
         return;
     }
 
-    length = MIN(length, TOX_MAX_NAME_LENGTH - 1);
-    memcpy(chat->peer_list[peer_index].name, new_nick, length);
-    chat->peer_list[peer_index].name[length] = '\0';
-    chat->peer_list[peer_index].name_length = length;
+    peer_set_name(chat, peer_index, new_nick, length);
 
     line_info_add(self, toxic->c_config, true, old_nick, chat->peer_list[peer_index].name, NAME_CHANGE, 0,
                   MAGENTA, " is now known as ");
 
     groupchat_update_last_seen(groupnumber, peer_id);
-    groupchat_update_name_list(groupnumber);
 
     ChatContext *ctx = self->chatwin;
 
@@ -1695,10 +2056,7 @@ static void groupchat_onGroupNickChange(ToxWindow *self, Toxic *toxic, uint32_t
 
     GroupPeer *peer = &chat->peer_list[peer_index];
 
-    length = MIN(length, TOX_MAX_NAME_LENGTH - 1);
-    memcpy(peer->name, new_nick, length);
-    peer->name[length] = '\0';
-    peer->name_length = length;
+    peer_set_name(chat, peer_index, new_nick, length);
 
     line_info_add(self, toxic->c_config, true, peer->prev_name, peer->name, NAME_CHANGE, 0, MAGENTA,
                   " is now known as ");
@@ -1710,8 +2068,6 @@ static void groupchat_onGroupNickChange(ToxWindow *self, Toxic *toxic, uint32_t
     write_to_log(ctx->log, toxic->c_config, log_event, peer->prev_name, LOG_HINT_NAME);
 
     snprintf(peer->prev_name, sizeof(peer->prev_name), "%s", peer->name);
-
-    groupchat_update_name_list(groupnumber);
 }
 
 static void groupchat_onGroupStatusChange(ToxWindow *self, Toxic *toxic, uint32_t groupnumber, uint32_t peer_id,
@@ -1741,13 +2097,17 @@ static void groupchat_onGroupStatusChange(ToxWindow *self, Toxic *toxic, uint32_
 
     groupchat_update_last_seen(groupnumber, peer_id);
     chat->peer_list[peer_index].status = status;
+    chat->peer_list[peer_index].sidebar.valid = false;
 }
 
-static void send_group_message(ToxWindow *self, Toxic *toxic, uint32_t groupnumber, const char *msg,
+/*
+ * Return true if the message was sent.
+ */
+static bool send_group_message(ToxWindow *self, Toxic *toxic, uint32_t groupnumber, const char *msg,
                                Tox_Message_Type type)
 {
     if (toxic == NULL || self == NULL) {
-        return;
+        return false;
     }
 
     Tox *tox = toxic->tox;
@@ -1757,7 +2117,7 @@ static void send_group_message(ToxWindow *self, Toxic *toxic, uint32_t groupnumb
 
     if (msg == NULL) {
         wprintw(ctx->history, "Message is empty.\n");
-        return;
+        return false;
     }
 
     Tox_Err_Group_Send_Message err;
@@ -1776,7 +2136,7 @@ static void send_group_message(ToxWindow *self, Toxic *toxic, uint32_t groupnumb
             line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, RED, " * Failed to send message (Error %d).", err);
         }
 
-        return;
+        return false;
     }
 
     char self_nick[TOX_MAX_NAME_LENGTH + 1];
@@ -1789,6 +2149,13 @@ static void send_group_message(ToxWindow *self, Toxic *toxic, uint32_t groupnumb
         line_info_add(self, c_config, true, self_nick, NULL, OUT_ACTION_READ, 0, 0, "%s", msg);
         write_to_log(ctx->log, c_config, msg, self_nick, LOG_HINT_ACTION);
     }
+
+    return true;
+}
+
+static bool groupchat_onPasteLine(ToxWindow *self, Toxic *toxic, const char *line)
+{
+    return send_group_message(self, toxic, self->num, line, TOX_MESSAGE_TYPE_NORMAL);
 }
 
 static void send_group_prvt_message(ToxWindow *self, Toxic *toxic, uint32_t groupnumber, const char *data,
@@ -1934,7 +2301,7 @@ static bool groupchat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
         if (ctx->len > 0) {
             int diff;
 
-            if (wcsncmp(ctx->line, L"/invite ", wcslen(L"/invite ")) == 0) {
+            if (wcsncmp(get_line_buf(ctx), L"/invite ", wcslen(L"/invite ")) == 0) {
                 size_t num_friends = friendlist_get_count(toxic->friends);
                 char **friend_names = (char **) malloc_ptr_array(num_friends, TOX_MAX_NAME_LENGTH);
 
@@ -1948,17 +2315,18 @@ static bool groupchat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
                     fprintf(stderr, "Failed to allocate memory for friends name list\n");
                 }
 
-            } else if (wcsncmp(ctx->line, L"/avatar ", wcslen(L"/avatar ")) == 0) {
-                diff = dir_match(self, toxic, ctx->line, L"/avatar");
-            } else if (ctx->line[0] != L'/' || wcschr(ctx->line, L' ') != NULL) {
-                diff = complete_line(self, toxic, (const char *const *) chat->name_list, chat->num_peers);
+            } else if (wcsncmp(get_line_buf(ctx), L"/avatar ", wcslen(L"/avatar ")) == 0) {
+                diff = dir_match(self, toxic, get_line_buf(ctx), L"/avatar");
+            } else if (line_buf_char(ctx, 0) != L'/' || wcschr(get_line_buf(ctx), L' ') != NULL) {
+                groupchat_update_name_list(chat);
+                diff = complete_sorted_line(self, toxic, chat->name_list, chat->num_peers);
             } else {
                 diff = complete_line(self, toxic, group_cmd_list, sizeof(group_cmd_list) / sizeof(char *));
             }
 
             if (diff != -1) {
                 if (x + diff > x2 - 1) {
-                    int wlen = MAX(0, wcswidth(ctx->line, sizeof(ctx->line) / sizeof(wchar_t)));
+                    int wlen = ctx->line_width;
                     ctx->start = wlen < x2 ? 0 : wlen - x2 + 1;
                 }
             } else {
@@ -1984,11 +2352,11 @@ static bool groupchat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
         input_ret = true;
         rm_trailing_spaces_buf(ctx);
 
-        wstrsubst(ctx->line, L'¶', L'\n');
+        wstrsubst(get_line_buf(ctx), L'¶', L'\n');
 
         char line[MAX_STR_SIZE];
 
-        if (wcs_to_mbs_buf(line, ctx->line, MAX_STR_SIZE) == -1) {
+        if (wcs_to_mbs_buf(line, get_line_buf(ctx), MAX_STR_SIZE) == -1) {
             memset(line, 0, sizeof(line));
             line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, RED, " * Failed to parse message.");
         }
@@ -1996,7 +2364,7 @@ static bool groupchat_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
         const bool contains_blocked_word = string_contains_blocked_word(line, &toxic->client_data);
 
         if (line[0] != '\0' && !contains_blocked_word) {
-            add_line_to_hist(ctx);
+            add_line_to_hist(ctx, &toxic->client_data.input_history, line);
 
             if (line[0] == '/') {
                 if (strncmp(line, "/close", strlen("/close")) == 0) {
@@ -2080,6 +2448,50 @@ static void draw_groupchat_top_bar(ToxWindow *self, const Toxic *toxic, int x2)
     wattroff(statusbar->topline, COLOR_PAIR(BAR_TEXT));
 }
 
+/*
+ * Returns `peer`'s sidebar row, formatting it first if the peer changed since it was last drawn.
+ * Only the rows in view are ever formatted, so drawing costs the same however many peers there are.
+ */
+static const GroupSidebarRow *group_sidebar_row(GroupPeer *peer)
+{
+    GroupSidebarRow *row = &peer->sidebar;
+
+    if (row->valid) {
+        return row;
+    }
+
+    row->ignored = peer->is_ignored;
+    row->role_sig = '\0';
+    row->role_colour = WHITE;
+    row->name_colour = WHITE;
+
+    if (peer->status == TOX_USER_STATUS_AWAY) {
+        row->name_colour = YELLOW;
+    } else if (peer->status == TOX_USER_STATUS_BUSY) {
+        row->name_colour = RED;
+    }
+
+    /* Signify roles (e.g. founder, moderator) */
+    if (peer->role == TOX_GROUP_ROLE_FOUNDER) {
+        row->role_sig = '&';
+        row->role_colour = BLUE;
+    } else if (peer->role == TOX_GROUP_ROLE_MODERATOR) {
+        row->role_sig = '+';
+        row->role_colour = GREEN;
+    } else if (peer->role == TOX_GROUP_ROLE_OBSERVER) {
+        row->role_sig = '-';
+        row->role_colour = MAGENTA;
+    }
+
+    /* truncate nick to fit in side panel without modifying list */
+    const size_t maxlen = SIDEBAR_WIDTH - 2 - (row->role_sig != '\0') - row->ignored;
+    snprintf(row->name, maxlen + 1, "%s", peer->name);
+
+    row->valid = true;
+
+    return row;
+}
+
 static void groupchat_onDraw(ToxWindow *self, Toxic *toxic)
 {
     if (toxic == NULL || self == NULL) {
@@ -2112,7 +2524,9 @@ static void groupchat_onDraw(ToxWindow *self, Toxic *toxic)
     wclear(ctx->linewin);
 
     if (ctx->len > 0) {
-        mvwprintw(ctx->linewin, 0, 0, "%ls", &ctx->line[ctx->start]);
+        wchar_t line[MAX_STR_SIZE];
+        copy_line_buf(ctx, ctx->start, line);
+        mvwprintw(ctx->linewin, 0, 0, "%ls", line);
     }
 
     curs_set(1);
@@ -2164,61 +2578,30 @@ static void groupchat_onDraw(ToxWindow *self, Toxic *toxic)
 
         pthread_mutex_lock(&Winthread.lock);
 
-        for (uint32_t i = chat->side_pos; i < chat->max_idx && offset < maxlines; ++i) {
-            if (!chat->peer_list[i].active) {
-                continue;
-            }
+        /* Keep the last page full after peers leave */
+        chat->side_pos = MAX(0, MIN(chat->side_pos, (int) chat->num_peers - maxlines));
 
+        for (uint32_t i = chat->side_pos; i < chat->num_peers && offset < maxlines; ++i) {
             wmove(ctx->sidebar, offset + 2, 1);
 
-            const bool is_ignored = chat->peer_list[i].is_ignored;
-            uint16_t maxlen_offset = chat->peer_list[i].role == TOX_GROUP_ROLE_USER ? 2 : 3;
-
-            if (is_ignored) {
-                ++maxlen_offset;
-            }
-
-            /* truncate nick to fit in side panel without modifying list */
-            char tmpnck[TOX_MAX_NAME_LENGTH];
-            const size_t maxlen = SIDEBAR_WIDTH - maxlen_offset;
-            snprintf(tmpnck, maxlen + 1, "%s", chat->peer_list[i].name);
-
-            int namecolour = WHITE;
+            const GroupSidebarRow *row = group_sidebar_row(&chat->peer_list[chat->peer_order[i]]);
 
-            if (chat->peer_list[i].status == TOX_USER_STATUS_AWAY) {
-                namecolour = YELLOW;
-            } else if (chat->peer_list[i].status == TOX_USER_STATUS_BUSY) {
-                namecolour = RED;
-            }
-
-            /* Signify roles (e.g. founder, moderator) */
-            const char *rolesig = "";
-            int rolecolour = WHITE;
-
-            if (chat->peer_list[i].role == TOX_GROUP_ROLE_FOUNDER) {
-                rolesig = "&";
-                rolecolour = BLUE;
-            } else if (chat->peer_list[i].role == TOX_GROUP_ROLE_MODERATOR) {
-                rolesig = "+";
-                rolecolour = GREEN;
-            } else if (chat->peer_list[i].role == TOX_GROUP_ROLE_OBSERVER) {
-                rolesig = "-";
-                rolecolour = MAGENTA;
-            }
-
-            if (is_ignored) {
+            if (row->ignored) {
                 wattron(ctx->sidebar, COLOR_PAIR(RED) | A_BOLD);
-                wprintw(ctx->sidebar, "#");
+                waddch(ctx->sidebar, '#');
                 wattroff(ctx->sidebar, COLOR_PAIR(RED) | A_BOLD);
             }
 
-            wattron(ctx->sidebar, COLOR_PAIR(rolecolour) | A_BOLD);
-            wprintw(ctx->sidebar, "%s", rolesig);
-            wattroff(ctx->sidebar, COLOR_PAIR(rolecolour) | A_BOLD);
+            if (row->role_sig != '\0') {
+                wattron(ctx->sidebar, COLOR_PAIR(row->role_colour) | A_BOLD);
+                waddch(ctx->sidebar, row->role_sig);
+                wattroff(ctx->sidebar, COLOR_PAIR(row->role_colour) | A_BOLD);
+            }
 
-            wattron(ctx->sidebar, COLOR_PAIR(namecolour));
-            wprintw(ctx->sidebar, "%s\n", tmpnck);
-            wattroff(ctx->sidebar, COLOR_PAIR(namecolour));
+            wattron(ctx->sidebar, COLOR_PAIR(row->name_colour));
+            waddstr(ctx->sidebar, row->name);
+            waddch(ctx->sidebar, '\n');
+            wattroff(ctx->sidebar, COLOR_PAIR(row->name_colour));
 
             ++offset;
         }
@@ -2231,7 +2614,7 @@ static void groupchat_onDraw(ToxWindow *self, Toxic *toxic)
     getyx(self->window, y, x);
     UNUSED_VAR(x);
 
-    const int new_x = ctx->start ? x2 - 1 : MAX(0, wcswidth(ctx->line, ctx->pos));
+    const int new_x = ctx->start ? x2 - 1 : line_buf_cursor_width(ctx);
     wmove(self->window, y, new_x);
 
     draw_window_bar(self, toxic->windows);
@@ -2280,6 +2663,10 @@ static void groupchat_onInit(ToxWindow *self, Toxic *toxic)
 
     line_info_init(ctx->hst);
 
+    uint8_t chat_id[TOX_GROUP_CHAT_ID_SIZE] = {0};
+    tox_group_get_chat_id(toxic->tox, self->num, chat_id, NULL);
+    init_line_hist(ctx, &toxic->client_data.input_history, chat_id, sizeof(chat_id));
+
     scrollok(ctx->history, 0);
     wmove(self->window, y2 - CURS_Y_OFFSET, 0);
 }
@@ -2343,6 +2730,7 @@ static ToxWindow *new_group_chat(Tox *tox, uint32_t groupnumber, const char *gro
     ret->type = WINDOW_TYPE_GROUPCHAT;
 
     ret->onKey = &groupchat_onKey;
+    ret->onPasteLine = &groupchat_onPasteLine;
     ret->onDraw = &groupchat_onDraw;
     ret->onInit = &groupchat_onInit;
     ret->onGroupMessage = &groupchat_onGroupMessage;
@@ -9,6 +9,7 @@
 #ifndef GROUPCHATS_H
 #define GROUPCHATS_H
 
+#include "hash_index.h"
 #include "toxic.h"
 #include "windows.h"
 
@@ -24,6 +25,16 @@ typedef enum Group_Join_Type {
     Group_Join_Type_Load,
 } Group_Join_Type;
 
+/* A peer's sidebar entry, formatted once and redrawn as is until the peer changes. */
+typedef struct GroupSidebarRow {
+    bool  valid;                      /* Cleared when the peer's name, status, role or ignore flag changes */
+    bool  ignored;
+    char  role_sig;                   /* '\0' for peers with the user role */
+    int   role_colour;
+    int   name_colour;
+    char  name[SIDEBAR_WIDTH + 1];    /* Truncated to fit beside the marks */
+} GroupSidebarRow;
+
 typedef struct GroupPeer {
     bool             active;
     char             name[TOX_MAX_NAME_LENGTH];
@@ -35,17 +46,33 @@ typedef struct GroupPeer {
     Tox_Group_Role   role;
     bool             is_ignored;
     uint64_t         last_active;
+    GroupSidebarRow  sidebar;
 } GroupPeer;
 
 typedef struct {
     char       chat_id[TOX_GROUP_CHAT_ID_SIZE];
-    GroupPeer  *peer_list;
-    char       **name_list;   /* List of peer names, needed for tab completion */
-    uint32_t   num_peers;     /* Number of peers in the chat/name_list array */
+    GroupPeer  *peer_list;    /* Peers keep their index for as long as they're in the group; may have gaps */
+    uint32_t   peer_list_capacity;
+    uint32_t   num_peers;     /* Number of active peers in the chat/peer_order/nick_order/name_list arrays */
     uint32_t   max_idx;       /* Maximum peer list index - 1 */
 
-    uint8_t    **ignored_list; /* List of keys of peers that we're ignoring */
-    uint16_t   num_ignored;
+    uint32_t   *free_peers;   /* Indices of the inactive entries below max_idx */
+    uint32_t   num_free_peers;
+
+    uint32_t   *peer_order;   /* Indices of active peers sorted by role then name, as shown in the sidebar */
+    uint32_t   *nick_order;   /* Indices of active peers sorted by name ignoring case, for prefix searches */
+    const char **name_list;   /* Peer names in nick_order pointing into peer_list, needed for tab completion */
+    bool       name_list_dirty;
+
+    HashIndex  id_index;      /* peer_id -> peer_list index */
+    HashIndex  key_index;     /* public key -> peer_list index */
+    HashIndex  nick_index;    /* name -> peer_list index */
+
+    /* Keys of peers that we're ignoring; saved across sessions */
+    uint8_t    (*ignored_keys)[TOX_GROUP_PEER_PUBLIC_KEY_SIZE];
+    uint32_t   num_ignored;
+    uint32_t   ignored_capacity;
+    HashIndex  ignored_index; /* public key -> ignored_keys index */
 
     char       group_name[TOX_GROUP_MAX_GROUP_NAME_LENGTH + 1];
     size_t     group_name_length;
@@ -96,6 +123,12 @@ void groupchat_update_statusbar_topic(ToxWindow *self, const Tox *tox);
 int group_get_peer_id_of_identifier(ToxWindow *self, const Client_Config *c_config, const char *identifier,
                                     uint32_t *peer_id);
 
+/* Puts the peer_ids of up to `max_peers` peers whose nick is exactly `nick` in `peer_ids`.
+ *
+ * Returns the number of peers found.
+ */
+uint32_t group_get_nick_peer_ids(uint32_t groupnumber, const char *nick, uint32_t *peer_ids, uint32_t max_peers);
+
 /* Gets the peer_id associated with `public_key`.
  *
  * Returns 0 on success.
@@ -113,9 +146,9 @@ void redraw_groupchat_win(ToxWindow *self);
 GroupChat *get_groupchat(uint32_t groupnumber);
 
 /**
- * Toggles the ignore status of the peer associated with `peer_id`.
+ * Toggles the ignore status of the peer associated with `peer_id` and saves the group's ignore list.
  */
-void group_toggle_peer_ignore(uint32_t groupnumber, int peer_id, bool ignore);
+void group_toggle_peer_ignore(Toxic *toxic, uint32_t groupnumber, int peer_id, bool ignore);
 
 /*
  * Sets the tab name colour config option for the groupchat associated with `public_key` to `colour`.
@@ -0,0 +1,169 @@
+/*  hash_index.c
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+#include "hash_index.h"
+
+#include <stdlib.h>
+
+#define HASH_INDEX_MIN_BUCKETS 16
+#define HASH_INDEX_EMPTY UINT32_MAX
+
+uint32_t hash_index_bytes(const void *data, size_t length)
+{
+    const uint8_t *bytes = data;
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+uint32_t hash_index_u32(uint32_t key)
+{
+    key ^= key >> 16;
+    key *= 0x7feb352dU;
+    key ^= key >> 15;
+    key *= 0x846ca68bU;
+    key ^= key >> 16;
+
+    return key;
+}
+
+static size_t hash_index_empty_bucket(const HashIndex *index, uint32_t hash)
+{
+    const size_t mask = index->num_buckets - 1;
+    size_t i = hash & mask;
+
+    while (index->buckets[i].slot != HASH_INDEX_EMPTY) {
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+static bool hash_index_rehash(HashIndex *index, size_t num_buckets)
+{
+    HashIndexEntry *buckets = malloc(num_buckets * sizeof(HashIndexEntry));
+
+    if (buckets == NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; i < num_buckets; ++i) {
+        buckets[i].slot = HASH_INDEX_EMPTY;
+    }
+
+    HashIndexEntry *old_buckets = index->buckets;
+    const size_t old_num_buckets = index->num_buckets;
+
+    index->buckets = buckets;
+    index->num_buckets = num_buckets;
+
+    for (size_t i = 0; i < old_num_buckets; ++i) {
+        if (old_buckets[i].slot != HASH_INDEX_EMPTY) {
+            index->buckets[hash_index_empty_bucket(index, old_buckets[i].hash)] = old_buckets[i];
+        }
+    }
+
+    free(old_buckets);
+
+    return true;
+}
+
+bool hash_index_add(HashIndex *index, uint32_t hash, uint32_t slot)
+{
+    // Keep the load factor at or below one half so probe sequences stay short
+    if ((index->count + 1) * 2 > index->num_buckets) {
+        const size_t num_buckets = index->num_buckets == 0 ? HASH_INDEX_MIN_BUCKETS : index->num_buckets * 2;
+
+        if (!hash_index_rehash(index, num_buckets)) {
+            return false;
+        }
+    }
+
+    index->buckets[hash_index_empty_bucket(index, hash)] = (HashIndexEntry) {
+        hash, slot
+    };
+
+    ++index->count;
+
+    return true;
+}
+
+void hash_index_remove(HashIndex *index, uint32_t hash, uint32_t slot)
+{
+    if (index->count == 0) {
+        return;
+    }
+
+    const size_t mask = index->num_buckets - 1;
+    size_t hole = hash & mask;
+
+    while (index->buckets[hole].slot != slot || index->buckets[hole].hash != hash) {
+        if (index->buckets[hole].slot == HASH_INDEX_EMPTY) {
+            return;
+        }
+
+        hole = (hole + 1) & mask;
+    }
+
+    index->buckets[hole].slot = HASH_INDEX_EMPTY;
+    --index->count;
+
+    // Shift back the entries that probed past the hole
+    for (size_t i = (hole + 1) & mask; index->buckets[i].slot != HASH_INDEX_EMPTY; i = (i + 1) & mask) {
+        const size_t home = index->buckets[i].hash & mask;
+
+        // Move the entry into the hole unless its home bucket lies after the hole
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            index->buckets[hole] = index->buckets[i];
+            index->buckets[i].slot = HASH_INDEX_EMPTY;
+            hole = i;
+        }
+    }
+}
+
+bool hash_index_next(const HashIndex *index, uint32_t hash, size_t *cursor, uint32_t *slot)
+{
+    if (index->count == 0) {
+        return false;
+    }
+
+    const size_t mask = index->num_buckets - 1;
+
+    for (size_t i = *cursor & mask; index->buckets[i].slot != HASH_INDEX_EMPTY; i = (i + 1) & mask) {
+        if (index->buckets[i].hash == hash) {
+            *slot = index->buckets[i].slot;
+            *cursor = i + 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void hash_index_clear(HashIndex *index)
+{
+    for (size_t i = 0; i < index->num_buckets; ++i) {
+        index->buckets[i].slot = HASH_INDEX_EMPTY;
+    }
+
+    index->count = 0;
+}
+
+void hash_index_free(HashIndex *index)
+{
+    free(index->buckets);
+
+    *index = (HashIndex) {
+        0
+    };
+}
@@ -0,0 +1,69 @@
+/*  hash_index.h
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+/*
+ * Maps hashes to slots of an array owned by the caller, e.g. a friend's index in the friend
+ * list or a peer's index in a group's peer list. The keys themselves stay in that array: several
+ * slots may share a hash, so lookups return each candidate slot and the caller compares its key.
+ */
+
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct HashIndexEntry {
+    uint32_t hash;
+    uint32_t slot;
+} HashIndexEntry;
+
+typedef struct HashIndex {
+    HashIndexEntry *buckets;   /* Power of two sized with linear probing; slot UINT32_MAX marks an empty bucket */
+    size_t num_buckets;
+    size_t count;
+} HashIndex;
+
+/* Returns the FNV-1a hash of `length` bytes of `data`. */
+uint32_t hash_index_bytes(const void *data, size_t length);
+
+/* Returns a hash of an integer key such as a peer id. */
+uint32_t hash_index_u32(uint32_t key);
+
+/*
+ * Adds `slot` under `hash`.
+ *
+ * Returns false on allocation failure.
+ */
+bool hash_index_add(HashIndex *index, uint32_t hash, uint32_t slot);
+
+/* Removes `slot` from under `hash`, if it's there. */
+void hash_index_remove(HashIndex *index, uint32_t hash, uint32_t slot);
+
+/*
+ * Iterates over the slots stored under `hash`. `cursor` must be set to `hash` before the first call.
+ *
+ * Returns false once there are no more slots.
+ */
+bool hash_index_next(const HashIndex *index, uint32_t hash, size_t *cursor, uint32_t *slot);
+
+/* Removes every entry while keeping the buckets allocated. */
+void hash_index_clear(HashIndex *index);
+
+void hash_index_free(HashIndex *index);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* HASH_INDEX_H */
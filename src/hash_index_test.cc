@@ -0,0 +1,74 @@
+#include "hash_index.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<uint32_t> lookup(const HashIndex &index, uint32_t hash)
+{
+    std::vector<uint32_t> slots;
+    size_t cursor = hash;
+    uint32_t slot;
+
+    while (hash_index_next(&index, hash, &cursor, &slot)) {
+        slots.push_back(slot);
+    }
+
+    std::sort(slots.begin(), slots.end());
+    return slots;
+}
+
+TEST(HashIndex, EmptyIndexFindsNothing)
+{
+    HashIndex index{};
+    EXPECT_TRUE(lookup(index, 1234).empty());
+    hash_index_remove(&index, 1234, 0);
+    hash_index_free(&index);
+}
+
+TEST(HashIndex, MatchesReferenceUnderChurn)
+{
+    HashIndex index{};
+    std::multimap<uint32_t, uint32_t> reference;
+    std::mt19937 rng(7);
+
+    // Few distinct hashes so probe chains collide and wrap around
+    for (uint32_t slot = 0; slot < 5000; ++slot) {
+        if (!reference.empty() && rng() % 3 == 0) {
+            auto it = reference.begin();
+            std::advance(it, rng() % reference.size());
+            hash_index_remove(&index, it->first, it->second);
+            reference.erase(it);
+        }
+
+        const uint32_t hash = rng() % 64;
+        ASSERT_TRUE(hash_index_add(&index, hash, slot));
+        reference.emplace(hash, slot);
+    }
+
+    ASSERT_EQ(index.count, reference.size());
+    ASSERT_LE(index.count * 2, index.num_buckets);
+
+    for (uint32_t hash = 0; hash < 64; ++hash) {
+        std::vector<uint32_t> expected;
+        auto range = reference.equal_range(hash);
+
+        for (auto it = range.first; it != range.second; ++it) {
+            expected.push_back(it->second);
+        }
+
+        std::sort(expected.begin(), expected.end());
+        EXPECT_EQ(lookup(index, hash), expected) << "hash " << hash;
+    }
+
+    hash_index_clear(&index);
+    EXPECT_TRUE(lookup(index, 0).empty());
+    hash_index_free(&index);
+}
+
+}  // namespace
@@ -168,6 +168,7 @@ static void help_draw_global(ToxWindow *self)
     wprintw(win, "  /connect <ip> <port> <key> : Manually connect to a DHT node\n");
     wprintw(win, "  /decline <id>              : Decline friend request\n");
     wprintw(win, "  /requests                  : List pending friend requests\n");
+    wprintw(win, "  /savestats                 : Show how often and how fast the profile is saved\n");
     wprintw(win, "  /status <type>             : Set status (Online, Busy, Away)\n");
     wprintw(win, "  /note <msg>                : Set a personal note\n");
     wprintw(win, "  /nick <name>               : Set your global name (doesn't affect groups)\n");
@@ -197,7 +198,7 @@ static void help_draw_global(ToxWindow *self)
     wattroff(win, A_BOLD);
 
     wprintw(win, "  /lsdev <type>              : List devices where type: in|out\n");
-    wprintw(win, "  /sdev <type> <id>          : Set active device\n");
+    wprintw(win, "  /sdev <type> <id> [file]   : Set active device, file for WAV pseudo devices\n");
 #endif /* AUDIO */
 
 #ifdef VIDEO
@@ -206,7 +207,7 @@ static void help_draw_global(ToxWindow *self)
     wattroff(win, A_BOLD);
 
     wprintw(win, "  /lsvdev <type>             : List video devices where type: in|out\n");
-    wprintw(win, "  /svdev <type> <id>         : Set active video device\n");
+    wprintw(win, "  /svdev <type> <id> [file]  : Set active video device, file for Y4M pseudo devices\n");
 #endif /* VIDEO */
 
 #ifdef PYTHON
@@ -255,10 +256,11 @@ static void help_draw_chat(ToxWindow *self)
     wprintw(win, "  /answer                    : Answer incoming call\n");
     wprintw(win, "  /reject                    : Reject incoming call\n");
     wprintw(win, "  /hangup                    : Hangup active call\n");
-    wprintw(win, "  /sdev <type> <id>          : Change active device\n");
+    wprintw(win, "  /sdev <type> <id> [file]   : Change active device\n");
     wprintw(win, "  /mute <type>               : Mute active device if in call\n");
     wprintw(win, "  /sense <n>                 : VAD sensitivity threshold\n");
     wprintw(win, "  /bitrate <n>               : Set the audio encoding bitrate\n");
+    wprintw(win, "  /audiostats                : Show audio latency and buffer stats for this call\n");
 #endif /* AUDIO */
 
 #ifdef VIDEO
@@ -334,7 +336,8 @@ static void help_draw_keys(ToxWindow *self)
     wprintw(win, "  Ctrl+B                    : Toggle groupchat/conference peer list\n");
     wprintw(win, "  Ctrl+J                    : Insert new line\n");
     wprintw(win, "  Ctrl+T                    : Toggle paste mode\n");
-    wprintw(win, "  Ctrl+R                    : Reload the Toxic config file\n\n");
+    wprintw(win, "  Ctrl+R                    : Reload the Toxic config file\n");
+    wprintw(win, "  Ctrl+G                    : Search input history (Esc to cancel)\n\n");
     wprintw(win, "  (Note: Custom keybindings override these defaults.)\n");
 
     help_draw_bottom_menu(win);
@@ -363,6 +366,8 @@ static void help_draw_conference(ToxWindow *self)
     wprintw(win, "  /audio <on>|<off>       : Enable/disable audio in an audio conference\n");
     wprintw(win, "  /mute                   : Toggle self audio mute status\n");
     wprintw(win, "  /mute <nick>|<pubkey>   : Toggle peer audio mute status\n");
+    wprintw(win, "  /gain <peer> <percent>  : Set peer playback volume from 0 to 200 percent\n");
+    wprintw(win, "  /pan <on>|<off>         : Spread peers from left to right in stereo\n");
     wprintw(win, "  /ptt <on>|<off>         : Toggle audio input Push-To-Talk (F2 to activate)\n");
     wprintw(win, "  /sense <n>              : VAD sensitivity threshold\n\n");
 #endif
@@ -429,9 +434,9 @@ void help_onKey(ToxWindow *self, wint_t key)
         case L'c':
             height = 13;
 #ifdef VIDEO
-            height += 15;
+            height += 16;
 #elif AUDIO
-            height += 5;
+            height += 6;
 #endif
 #ifdef GAMES
             height += 1;
@@ -441,7 +446,7 @@ void help_onKey(ToxWindow *self, wint_t key)
             break;
 
         case L'g':
-            height = 25;
+            height = 26;
 #ifdef VIDEO
             height += 8;
 #elif AUDIO
@@ -460,7 +465,7 @@ void help_onKey(ToxWindow *self, wint_t key)
         case L'o':
             height = 8;
 #ifdef AUDIO
-            height += 7;
+            height += 9;
 #endif
             help_init_window(self, height, 80);
             self->help->type = HELP_CONFERENCE;
@@ -480,7 +485,7 @@ void help_onKey(ToxWindow *self, wint_t key)
             break;
 
         case L'k':
-            help_init_window(self, 16, 80);
+            help_init_window(self, 17, 80);
             self->help->type = HELP_KEYS;
             break;
 
@@ -13,6 +13,7 @@
 #include "input.h"
 
 #include <wchar.h>
+#include <wctype.h>
 
 #include "conference.h"
 #include "line_info.h"
@@ -24,30 +25,183 @@
 #include "toxic_strings.h"
 #include "windows.h"
 
+/* Returns the display width of the char at position `i` in the input line. */
+static int char_width(const ChatContext *ctx, int i)
+{
+    return line_buf_width(ctx, i, i + 1);
+}
+
+/* The longest history search query, leaving room in the input field for the line it matched */
+#define MAX_HIST_QUERY_LEN (MAX_STR_SIZE / 2)
+
+/* Scrolls the input field to the end of the line. */
+static void input_show_end(ChatContext *ctx, int mx_x)
+{
+    const int wlen = ctx->line_width;
+    ctx->start = wlen < mx_x ? 0 : wlen - mx_x + 1;
+}
+
+/* Puts the history entry at `index` in `line`, with line breaks shown as they're typed.
+   Return the length of the line, or -1 if there is no such entry or it can't be converted. */
+static int get_hist_entry(const Input_History *history, size_t index, wchar_t *line)
+{
+    const Input_History_Entry *entry = input_history_get(history, index);
+
+    if (entry == NULL) {
+        return -1;
+    }
+
+    const int len = mbs_to_wcs_buf(line, entry->line, MAX_STR_SIZE);
+
+    if (len == -1) {
+        return -1;
+    }
+
+    wstrsubst(line, L'\n', L'¶');
+
+    return len;
+}
+
+/* Shows the history search query and the line it matched in the input field. */
+static void input_search_show(ChatContext *ctx, const Input_History *global, int mx_x)
+{
+    wchar_t line[MAX_STR_SIZE];
+    int len = swprintf(line, MAX_STR_SIZE, L"(%ls)`%ls': ",
+                       ctx->hst_search_failed ? L"failed history search" : L"history search", ctx->hst_query);
+
+    wchar_t match[MAX_STR_SIZE];
+    const int match_len = get_hist_entry(global, ctx->hst_match, match);
+
+    if (match_len > 0) {
+        const int n = MIN(match_len, MAX_STR_SIZE - 1 - len);
+        wmemcpy(&line[len], match, n);
+        len += n;
+    }
+
+    set_line_buf(ctx, line, len, len);
+    input_show_end(ctx, mx_x);
+}
+
+/* Looks for the query in the global history, going back from the entry before `before`.
+   The previous match stays in place if nothing is found. */
+static void input_search_find(ChatContext *ctx, const Input_History *global, size_t before)
+{
+    char query[MAX_STR_SIZE];
+    const int query_len = wcs_to_mbs_buf(query, ctx->hst_query, sizeof(query));
+    size_t index;
+
+    if (query_len != -1 && input_history_search(global, query, query_len, before, &index)) {
+        ctx->hst_match = index;
+        ctx->hst_search_failed = false;
+    } else {
+        ctx->hst_search_failed = true;
+    }
+}
+
+static void input_search_start(ChatContext *ctx, const Input_History *global, int mx_x)
+{
+    copy_line_buf(ctx, 0, ctx->hst_saved_line);
+    ctx->hst_saved_len = ctx->len;
+
+    ctx->hst_query[0] = L'\0';
+    ctx->hst_query_len = 0;
+    ctx->hst_match = global->count;
+    ctx->hst_search_failed = false;
+    ctx->hst_searching = true;
+
+    input_search_show(ctx, global, mx_x);
+}
+
+/* Ends the history search. The line that matched is left in the input field if `accept` is true and
+   there is one, and the line from before the search otherwise. */
+static void input_search_end(ChatContext *ctx, const Input_History *global, bool accept, int mx_x)
+{
+    wchar_t line[MAX_STR_SIZE];
+    const int len = accept ? get_hist_entry(global, ctx->hst_match, line) : -1;
+
+    if (len != -1) {
+        set_line_buf(ctx, line, len, len);
+    } else {
+        set_line_buf(ctx, ctx->hst_saved_line, ctx->hst_saved_len, ctx->hst_saved_len);
+    }
+
+    ctx->hst_searching = false;
+    ctx->hst_pos = ctx->line_hist.count;
+    input_show_end(ctx, mx_x);
+}
+
+/* Adds a typed char to the history search query. Matches of the longer query can only be in the
+   current match or older entries, so the search carries on from there. */
+static void input_search_add_char(ChatContext *ctx, const Input_History *global, wint_t key, int mx_x)
+{
+    if (!iswprint(key) || ctx->hst_query_len >= MAX_HIST_QUERY_LEN) {
+        return;
+    }
+
+    ctx->hst_query[ctx->hst_query_len++] = key;
+    ctx->hst_query[ctx->hst_query_len] = L'\0';
+
+    if (!ctx->hst_search_failed) {
+        input_search_find(ctx, global, MIN(ctx->hst_match + 1, global->count));
+    }
+
+    input_search_show(ctx, global, mx_x);
+}
+
+/* Handles a key pressed during a history search. Keys that don't edit or repeat the search end it
+   and then act as usual, except for escape, which puts the line from before the search back.
+   Return true if the key was used up by the search. */
+static bool input_search_key(ChatContext *ctx, const Toxic *toxic, wint_t key, int mx_x)
+{
+    const Input_History *global = &toxic->client_data.input_history;
+
+    if (key == toxic->c_config->key_history_search) {
+        input_search_find(ctx, global, ctx->hst_match);
+    } else if (key == 0x7f || key == KEY_BACKSPACE) {
+        if (ctx->hst_query_len > 0) {
+            ctx->hst_query[--ctx->hst_query_len] = L'\0';
+        }
+
+        ctx->hst_match = global->count;
+        ctx->hst_search_failed = false;
+
+        if (ctx->hst_query_len > 0) {
+            input_search_find(ctx, global, global->count);
+        }
+    } else {
+        input_search_end(ctx, global, key != T_KEY_ESC, mx_x);
+        return false;
+    }
+
+    input_search_show(ctx, global, mx_x);
+
+    return true;
+}
+
 /* add a char to input field and buffer */
 void input_new_char(ToxWindow *self, const Toxic *toxic, wint_t key, int x, int mx_x)
 {
     ChatContext *ctx = self->chatwin;
 
+    if (ctx->hst_searching) {
+        input_search_add_char(ctx, &toxic->client_data.input_history, key, mx_x);
+        return;
+    }
+
     /* this is the only place we need to do this check */
     if (key == '\n') {
         key = L'¶';
     }
 
-    int cur_len = wcwidth(key);
-
-    if (cur_len == -1) {
-        sound_notify(self, toxic, notif_error, 0, NULL);
-        return;
-    }
-
     if (add_char_to_buf(ctx, key) == -1) {
         sound_notify(self, toxic, notif_error, 0, NULL);
         return;
     }
 
+    const int cur_len = char_width(ctx, ctx->pos - 1);
+
     if (x + cur_len >= mx_x) {
-        int s_len = wcwidth(ctx->line[ctx->start]);
+        int s_len = char_width(ctx, ctx->start);
         ctx->start += 1 + MAX(0, cur_len - s_len);
     }
 }
@@ -62,8 +216,8 @@ static void input_backspace(ToxWindow *self, const Toxic *toxic, int x, int mx_x
         return;
     }
 
-    int cur_len = ctx->pos > 0 ? wcwidth(ctx->line[ctx->pos - 1]) : 0;
-    int s_len = ctx->start > 0 ? wcwidth(ctx->line[ctx->start - 1]) : 0;
+    int cur_len = ctx->pos > 0 ? char_width(ctx, ctx->pos - 1) : 0;
+    int s_len = ctx->start > 0 ? char_width(ctx, ctx->start - 1) : 0;
 
     if (ctx->start && (x >= mx_x - cur_len)) {
         ctx->start = MAX(0, ctx->start - 1 + (s_len - cur_len));
@@ -119,7 +273,7 @@ static void input_yank(ToxWindow *self, const Toxic *toxic, int x, int mx_x)
 
     if (x + yank_cols >= mx_x) {
         int rmdr = MAX(0, (x + yank_cols) - mx_x);
-        int s_len = MAX(0, wcswidth(&ctx->line[ctx->start], rmdr));
+        int s_len = line_buf_width(ctx, ctx->start, MIN(ctx->len, ctx->start + rmdr));
         ctx->start += s_len + 1;
     }
 }
@@ -131,7 +285,7 @@ static void input_mv_end(ToxWindow *self, int mx_x)
 
     ctx->pos = ctx->len;
 
-    int wlen = MAX(0, wcswidth(ctx->line, sizeof(ctx->line) / sizeof(wchar_t)));
+    int wlen = ctx->line_width;
     ctx->start = MAX(0, 1 + (mx_x * (wlen / mx_x) - mx_x) + (wlen % mx_x));
 }
 
@@ -157,12 +311,12 @@ static void input_mv_left(ToxWindow *self, int x, int mx_x)
         return;
     }
 
-    int cur_len = ctx->pos > 0 ? wcwidth(ctx->line[ctx->pos - 1]) : 0;
+    int cur_len = ctx->pos > 0 ? char_width(ctx, ctx->pos - 1) : 0;
 
     --ctx->pos;
 
     if (ctx->start > 0 && (x >= mx_x - cur_len)) {
-        int s_len = wcwidth(ctx->line[ctx->start - 1]);
+        int s_len = char_width(ctx, ctx->start - 1);
         ctx->start = MAX(0, ctx->start - 1 + (s_len - cur_len));
     } else if (ctx->start > 0) {
         ctx->start = MAX(0, ctx->start - cur_len);
@@ -182,11 +336,11 @@ static void input_skip_left(ToxWindow *self, int x, int mx_x)
 
     do {
         --ctx->pos;
-        count += wcwidth(ctx->line[ctx->pos]);
-    } while (ctx->pos > 0 && (ctx->line[ctx->pos - 1] != L' ' || ctx->line[ctx->pos] == L' '));
+        count += char_width(ctx, ctx->pos);
+    } while (ctx->pos > 0 && (line_buf_char(ctx, ctx->pos - 1) != L' ' || line_buf_char(ctx, ctx->pos) == L' '));
 
     if (ctx->start > 0 && (x >= mx_x - count)) {
-        int s_len = wcwidth(ctx->line[ctx->start - 1]);
+        int s_len = char_width(ctx, ctx->start - 1);
         ctx->start = MAX(0, ctx->start - 1 + (s_len - count));
     } else if (ctx->start > 0) {
         ctx->start = MAX(0, ctx->start - count);
@@ -204,10 +358,10 @@ static void input_mv_right(ToxWindow *self, int x, int mx_x)
 
     ++ctx->pos;
 
-    int cur_len = wcwidth(ctx->line[ctx->pos - 1]);
+    int cur_len = char_width(ctx, ctx->pos - 1);
 
     if (x + cur_len >= mx_x) {
-        int s_len = wcwidth(ctx->line[ctx->start]);
+        int s_len = char_width(ctx, ctx->start);
         ctx->start += 1 + MAX(0, cur_len - s_len);
     }
 }
@@ -224,9 +378,10 @@ static void input_skip_right(ToxWindow *self, int x, int mx_x)
     int count = 0;
 
     do {
-        count += wcwidth(ctx->line[ctx->pos]);
+        count += char_width(ctx, ctx->pos);
         ++ctx->pos;
-    } while (ctx->pos < ctx->len && !(ctx->line[ctx->pos] == L' ' && ctx->line[ctx->pos - 1] != L' '));
+    } while (ctx->pos < ctx->len
+             && !(line_buf_char(ctx, ctx->pos) == L' ' && line_buf_char(ctx, ctx->pos - 1) != L' '));
 
     int newpos = x + count;
 
@@ -241,7 +396,7 @@ static void input_history(ToxWindow *self, const Client_Config *c_config, wint_t
     ChatContext *ctx = self->chatwin;
 
     fetch_hist_item(c_config, ctx, key);
-    int wlen = MAX(0, wcswidth(ctx->line, sizeof(ctx->line) / sizeof(wchar_t)));
+    int wlen = ctx->line_width;
     ctx->start = wlen < mx_x ? 0 : wlen - mx_x + 1;
 }
 
@@ -251,6 +406,11 @@ bool input_handle(ToxWindow *self, Toxic *toxic, wint_t key, int x, int mx_x)
 {
     const Client_Config *c_config = toxic->c_config;
 
+    if (self->chatwin->hst_searching && input_search_key(self->chatwin, toxic, key, mx_x)) {
+        flag_interface_refresh();
+        return true;
+    }
+
     bool match = true;
 
     switch (key) {
@@ -338,6 +498,9 @@ bool input_handle(ToxWindow *self, Toxic *toxic, wint_t key, int x, int mx_x)
         } else if (key == c_config->key_toggle_pastemode) {
             self->chatwin->pastemode ^= 1;
             match = true;
+        } else if (key == c_config->key_history_search) {
+            input_search_start(self->chatwin, &toxic->client_data.input_history, mx_x);
+            match = true;
         }
     }
 
@@ -347,3 +510,130 @@ bool input_handle(ToxWindow *self, Toxic *toxic, wint_t key, int x, int mx_x)
 
     return match;
 }
+
+/* Adds the first `n` chars of `s` to the input line, dropping whatever doesn't fit.
+   Return false if anything was dropped. */
+static bool input_paste_segment(ChatContext *ctx, const wchar_t *s, int n)
+{
+    const int room = MAX(0, MAX_STR_SIZE - 1 - ctx->len);
+    const int length = MIN(n, room);
+
+    if (length > 0 && add_str_to_buf(ctx, s, length) == -1) {
+        return false;
+    }
+
+    return length == n;
+}
+
+/* Sends the input line as a message through the window's paste handler and clears it.
+   Return false if the line was left in place: it is a command, it can't be converted or sent,
+   or it contains a blocked word. */
+static bool input_paste_send_line(ToxWindow *self, Toxic *toxic)
+{
+    ChatContext *ctx = self->chatwin;
+
+    rm_trailing_spaces_buf(ctx);
+
+    if (ctx->len == 0) {
+        return true;
+    }
+
+    if (line_buf_char(ctx, 0) == L'/') {
+        return false;
+    }
+
+    char line[MAX_STR_SIZE];
+
+    if (wcs_to_mbs_buf(line, get_line_buf(ctx), sizeof(line)) == -1) {
+        return false;
+    }
+
+    if (string_contains_blocked_word(line, &toxic->client_data)) {
+        line_info_add(self, toxic->c_config, false, NULL, NULL, SYS_MSG, 0, RED, "* Message contains blocked word");
+        return false;
+    }
+
+    if (!self->onPasteLine(self, toxic, line)) {
+        return false;
+    }
+
+    reset_buf(ctx);
+
+    return true;
+}
+
+void input_paste(ToxWindow *self, Toxic *toxic, const wchar_t *text, size_t length)
+{
+    ChatContext *ctx = self->chatwin;
+
+    if (ctx == NULL || (self->help != NULL && self->help->active)) {
+        return;
+    }
+
+    int mx_x;
+    int mx_y;
+    getmaxyx(self->window, mx_y, mx_x);
+
+    UNUSED_VAR(mx_y);
+
+    if (ctx->hst_searching) {
+        input_search_end(ctx, &toxic->client_data.input_history, true, mx_x);
+    }
+
+    /* Once a line can't be sent, it and the rest of the paste stay in the input line for the user to deal with */
+    bool send_lines = !ctx->pastemode && self->onPasteLine != NULL;
+
+    wchar_t segment[MAX_STR_SIZE];
+    int segment_len = 0;
+    bool fits = true;
+
+    for (size_t i = 0; i < length; ++i) {
+        wchar_t ch = text[i];
+
+        if (ch == L'\n' && i > 0 && text[i - 1] == L'\r') {
+            continue;
+        }
+
+        if (ch == L'\r' || ch == L'\n') {
+            if (send_lines) {
+                fits &= input_paste_segment(ctx, segment, segment_len);
+                segment_len = 0;
+
+                send_lines = input_paste_send_line(self, toxic);
+
+                if (send_lines) {
+                    continue;
+                }
+            }
+
+            ch = L'¶';
+        } else if (ch == L'\t') {
+            ch = L' ';
+        } else if (!iswprint(ch)) {
+            continue;
+        }
+
+        if (segment_len == MAX_STR_SIZE - 1) {
+            fits &= input_paste_segment(ctx, segment, segment_len);
+            segment_len = 0;
+        }
+
+        segment[segment_len++] = ch;
+    }
+
+    fits &= input_paste_segment(ctx, segment, segment_len);
+
+    if (!fits) {
+        sound_notify(self, toxic, notif_error, 0, NULL);
+    }
+
+    /* scroll the input field just far enough to keep the cursor in view */
+    int width = line_buf_width(ctx, ctx->start, ctx->pos);
+
+    while (ctx->start < ctx->pos && width >= mx_x) {
+        width -= char_width(ctx, ctx->start);
+        ++ctx->start;
+    }
+
+    flag_interface_refresh();
+}
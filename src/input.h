@@ -19,4 +19,13 @@ void input_new_char(ToxWindow *self, const Toxic *toxic, wint_t key, int x, int
    return true if key matches a function, false otherwise */
 bool input_handle(ToxWindow *self, Toxic *toxic, wint_t key, int x, int mx_x);
 
+/* Inserts `length` chars of pasted text into the input line in one step. Each newline in the text sends
+   the line as a message through the window's onPasteLine handler. Pasted lines are never run as commands:
+   the first line that is a command, or that can't be sent, is kept along with the rest of the paste, with
+   its newlines shown as in paste mode. Without a handler, or in paste mode, every newline is kept.
+   Tabs become spaces and other unprintable chars are dropped.
+
+   The caller must hold Winthread.lock. */
+void input_paste(ToxWindow *self, Toxic *toxic, const wchar_t *text, size_t length);
+
 #endif /* INPUT_H */
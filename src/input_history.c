@@ -0,0 +1,294 @@
+/*  input_history.c
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE    /* needed for memmem() */
+#endif
+
+#include "input_history.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hash_index.h"
+
+/* The length of an owner as written at the start of each line of a saved history */
+#define OWNER_HEX_LENGTH 8
+
+uint32_t input_history_owner(const uint8_t *id, size_t length)
+{
+    return hash_index_bytes(id, length);
+}
+
+bool input_history_init(Input_History *history, size_t capacity)
+{
+    *history = (Input_History) {
+        NULL
+    };
+
+    if (capacity == 0) {
+        return true;
+    }
+
+    history->entries = calloc(capacity, sizeof(Input_History_Entry));
+
+    if (history->entries == NULL) {
+        return false;
+    }
+
+    history->capacity = capacity;
+
+    return true;
+}
+
+void input_history_free(Input_History *history)
+{
+    for (size_t i = 0; i < history->count; ++i) {
+        free(history->entries[(history->head + i) % history->capacity].line);
+    }
+
+    free(history->entries);
+
+    *history = (Input_History) {
+        NULL
+    };
+}
+
+bool input_history_add(Input_History *history, const char *line, size_t length, uint32_t owner)
+{
+    if (history->capacity == 0) {
+        return true;
+    }
+
+    if (length > UINT32_MAX - 1) {
+        return false;
+    }
+
+    char *copy = malloc(length + 1);
+
+    if (copy == NULL) {
+        return false;
+    }
+
+    memcpy(copy, line, length);
+    copy[length] = '\0';
+
+    Input_History_Entry *entry;
+
+    if (history->count == history->capacity) {
+        entry = &history->entries[history->head];
+        free(entry->line);
+        history->head = (history->head + 1) % history->capacity;
+    } else {
+        entry = &history->entries[(history->head + history->count) % history->capacity];
+        ++history->count;
+    }
+
+    *entry = (Input_History_Entry) {
+        copy, (uint32_t) length, owner
+    };
+
+    return true;
+}
+
+const Input_History_Entry *input_history_get(const Input_History *history, size_t index)
+{
+    if (index >= history->count) {
+        return NULL;
+    }
+
+    return &history->entries[(history->head + index) % history->capacity];
+}
+
+bool input_history_search(const Input_History *history, const char *query, size_t query_length, size_t before,
+                          size_t *index)
+{
+    for (size_t i = before < history->count ? before : history->count; i > 0; --i) {
+        const Input_History_Entry *entry = input_history_get(history, i - 1);
+
+        if (memmem(entry->line, entry->length, query, query_length) != NULL) {
+            *index = i - 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool input_history_copy_owner(Input_History *history, const Input_History *source, uint32_t owner)
+{
+    size_t first = source->count;
+    size_t found = 0;
+
+    while (first > 0 && found < history->capacity) {
+        --first;
+
+        if (input_history_get(source, first)->owner == owner) {
+            ++found;
+        }
+    }
+
+    for (size_t i = first; i < source->count; ++i) {
+        const Input_History_Entry *entry = input_history_get(source, i);
+
+        if (entry->owner != owner) {
+            continue;
+        }
+
+        if (!input_history_add(history, entry->line, entry->length, owner)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Writes `line` to `fp` with backslashes and line breaks escaped, so that it takes up one line. */
+static void write_escaped(FILE *fp, const char *line, size_t length)
+{
+    for (size_t i = 0; i < length; ++i) {
+        switch (line[i]) {
+            case '\\':
+                fputs("\\\\", fp);
+                break;
+
+            case '\n':
+                fputs("\\n", fp);
+                break;
+
+            case '\r':
+                fputs("\\r", fp);
+                break;
+
+            default:
+                fputc(line[i], fp);
+                break;
+        }
+    }
+}
+
+/* Undoes write_escaped() in place. Returns the new length of `line`. */
+static size_t unescape(char *line, size_t length)
+{
+    size_t out = 0;
+
+    for (size_t i = 0; i < length; ++i) {
+        if (line[i] != '\\' || i + 1 == length) {
+            line[out++] = line[i];
+            continue;
+        }
+
+        const char c = line[++i];
+        line[out++] = c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+    }
+
+    return out;
+}
+
+int input_history_load(Input_History *history, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL) {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    char *buf = NULL;
+    size_t buf_size = 0;
+    ssize_t length;
+    int ret = 0;
+
+    while ((length = getline(&buf, &buf_size, fp)) != -1) {
+        if (length > 0 && buf[length - 1] == '\n') {
+            buf[--length] = '\0';
+        }
+
+        if (length <= OWNER_HEX_LENGTH || buf[OWNER_HEX_LENGTH] != ' ') {
+            continue;
+        }
+
+        buf[OWNER_HEX_LENGTH] = '\0';
+
+        char *end;
+        const unsigned long owner = strtoul(buf, &end, 16);
+
+        if (end != buf + OWNER_HEX_LENGTH) {
+            continue;
+        }
+
+        char *line = buf + OWNER_HEX_LENGTH + 1;
+        const size_t line_length = unescape(line, length - (OWNER_HEX_LENGTH + 1));
+
+        if (!input_history_add(history, line, line_length, (uint32_t) owner)) {
+            ret = -1;
+            break;
+        }
+    }
+
+    if (ferror(fp)) {
+        ret = -1;
+    }
+
+    free(buf);
+    fclose(fp);
+
+    return ret;
+}
+
+int input_history_save(const Input_History *history, const char *path)
+{
+    const size_t tmp_path_size = strlen(path) + sizeof(".tmp");
+    char *tmp_path = malloc(tmp_path_size);
+
+    if (tmp_path == NULL) {
+        return -1;
+    }
+
+    snprintf(tmp_path, tmp_path_size, "%s.tmp", path);
+
+    // The history holds everything typed, passwords included, so only the owner may read it
+    const int fd = open(tmp_path, O_CREAT | O_WRONLY | O_TRUNC, 0600);
+
+    if (fd == -1) {
+        free(tmp_path);
+        return -1;
+    }
+
+    FILE *fp = fdopen(fd, "w");
+
+    if (fp == NULL) {
+        close(fd);
+        remove(tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+
+    for (size_t i = 0; i < history->count; ++i) {
+        const Input_History_Entry *entry = input_history_get(history, i);
+
+        fprintf(fp, "%08x ", (unsigned int) entry->owner);
+        write_escaped(fp, entry->line, entry->length);
+        fputc('\n', fp);
+    }
+
+    const bool write_failed = ferror(fp) != 0;
+
+    if (fclose(fp) != 0 || write_failed || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+
+    free(tmp_path);
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*  input_history.h
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+/*
+ * The lines typed into the input field, kept in a ring that drops the oldest line once it's full.
+ * Each line is stored as a UTF-8 string of its own length, and records the window it was typed in
+ * so that one global history can be split up by window and saved to a single file.
+ */
+
+#ifndef INPUT_HISTORY_H
+#define INPUT_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct Input_History_Entry {
+    char     *line;      /* UTF-8 and null terminated */
+    uint32_t length;
+    uint32_t owner;      /* The window the line was typed in; see input_history_owner() */
+} Input_History_Entry;
+
+typedef struct Input_History {
+    Input_History_Entry *entries;
+    size_t capacity;
+    size_t head;     /* The slot of the oldest entry */
+    size_t count;
+} Input_History;
+
+/*
+ * Returns the owner of lines typed in the window identified by `length` bytes of `id`, such as a
+ * friend's public key or a group's chat id.
+ */
+uint32_t input_history_owner(const uint8_t *id, size_t length);
+
+/*
+ * Initializes `history` to hold up to `capacity` lines. A history with no capacity drops every
+ * line added to it.
+ *
+ * Return false on allocation failure.
+ */
+bool input_history_init(Input_History *history, size_t capacity);
+
+void input_history_free(Input_History *history);
+
+/*
+ * Adds the first `length` bytes of `line` as the newest entry, dropping the oldest entry if the
+ * history is full.
+ *
+ * Return false on allocation failure.
+ */
+bool input_history_add(Input_History *history, const char *line, size_t length, uint32_t owner);
+
+/*
+ * Returns the entry at `index`, counting from 0 for the oldest, or NULL if there is no such entry.
+ */
+const Input_History_Entry *input_history_get(const Input_History *history, size_t index);
+
+/*
+ * Looks for the newest entry older than the one at index `before` that contains the first
+ * `query_length` bytes of `query`. Pass the history's count as `before` to search all of it.
+ *
+ * Return true and puts the entry's index in `index` if one is found.
+ */
+bool input_history_search(const Input_History *history, const char *query, size_t query_length, size_t before,
+                          size_t *index);
+
+/*
+ * Adds the newest lines in `source` that belong to `owner` to `history`, oldest first, up to the
+ * capacity of `history`.
+ *
+ * Return false on allocation failure.
+ */
+bool input_history_copy_owner(Input_History *history, const Input_History *source, uint32_t owner);
+
+/*
+ * Adds the lines saved to `path` by input_history_save() to `history`. Lines that can't be parsed
+ * are skipped.
+ *
+ * Return 0 on success or if the file doesn't exist.
+ * Return -1 on read or allocation failure.
+ */
+int input_history_load(Input_History *history, const char *path);
+
+/*
+ * Writes `history` to `path`, one entry per line, replacing the file in one step. The new file
+ * can only be read and written by its owner.
+ *
+ * Return 0 on success.
+ * Return -1 on failure.
+ */
+int input_history_save(const Input_History *history, const char *path);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* INPUT_HISTORY_H */
@@ -0,0 +1,162 @@
+#include "input_history.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+class InputHistoryTest : public ::testing::Test {
+protected:
+    void TearDown() override
+    {
+        input_history_free(&history_);
+    }
+
+    void init(size_t capacity)
+    {
+        ASSERT_TRUE(input_history_init(&history_, capacity));
+    }
+
+    void add(const std::string &line, uint32_t owner = 1)
+    {
+        ASSERT_TRUE(input_history_add(&history_, line.data(), line.size(), owner));
+    }
+
+    std::string line(size_t index) const
+    {
+        const Input_History_Entry *entry = input_history_get(&history_, index);
+        return entry != nullptr ? std::string(entry->line, entry->length) : "<none>";
+    }
+
+    bool search(const std::string &query, size_t before, size_t *index) const
+    {
+        return input_history_search(&history_, query.data(), query.size(), before, index);
+    }
+
+    Input_History history_{};
+};
+
+TEST_F(InputHistoryTest, DropsOldestWhenFull)
+{
+    init(3);
+
+    for (int i = 0; i < 5; ++i) {
+        add("line " + std::to_string(i));
+    }
+
+    EXPECT_EQ(history_.count, 3);
+    EXPECT_EQ(line(0), "line 2");
+    EXPECT_EQ(line(2), "line 4");
+    EXPECT_EQ(input_history_get(&history_, 3), nullptr);
+}
+
+TEST_F(InputHistoryTest, ZeroCapacityKeepsNothing)
+{
+    init(0);
+    add("hello");
+    EXPECT_EQ(history_.count, 0);
+}
+
+TEST_F(InputHistoryTest, SearchesBackFromBefore)
+{
+    init(10);
+    add("/nick alice");
+    add("hello there");
+    add("/nick bob");
+    add("goodbye");
+
+    size_t index;
+    ASSERT_TRUE(search("nick", history_.count, &index));
+    EXPECT_EQ(index, 2);
+    ASSERT_TRUE(search("nick", index, &index));
+    EXPECT_EQ(index, 0);
+    EXPECT_FALSE(search("nick", index, &index));
+    EXPECT_FALSE(search("carol", history_.count, &index));
+}
+
+TEST_F(InputHistoryTest, CopiesNewestLinesOfOwner)
+{
+    init(10);
+
+    for (int i = 0; i < 6; ++i) {
+        add("a" + std::to_string(i), 7);
+        add("b" + std::to_string(i), 8);
+    }
+
+    Input_History window;
+    ASSERT_TRUE(input_history_init(&window, 4));
+    ASSERT_TRUE(input_history_copy_owner(&window, &history_, 7));
+
+    ASSERT_EQ(window.count, 4);
+    EXPECT_STREQ(input_history_get(&window, 0)->line, "a2");
+    EXPECT_STREQ(input_history_get(&window, 3)->line, "a5");
+
+    input_history_free(&window);
+}
+
+TEST_F(InputHistoryTest, SavesAndLoadsEscapedLines)
+{
+    init(10);
+    add("first line\nsecond line", 0xdeadbeef);
+    add("back\\slash and \\n literally", 2);
+    add("", 3);
+
+    char path[] = "/tmp/input_history_testXXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_NE(fd, -1);
+    close(fd);
+
+    ASSERT_EQ(input_history_save(&history_, path), 0);
+
+    Input_History loaded;
+    ASSERT_TRUE(input_history_init(&loaded, 10));
+    ASSERT_EQ(input_history_load(&loaded, path), 0);
+    remove(path);
+
+    ASSERT_EQ(loaded.count, 3);
+
+    for (size_t i = 0; i < loaded.count; ++i) {
+        const Input_History_Entry *entry = input_history_get(&loaded, i);
+        EXPECT_EQ(std::string(entry->line, entry->length), line(i));
+        EXPECT_EQ(entry->owner, input_history_get(&history_, i)->owner);
+    }
+
+    input_history_free(&loaded);
+}
+
+TEST_F(InputHistoryTest, SavedFileIsPrivate)
+{
+    init(10);
+    add("/join secret-group hunter2");
+
+    char path[] = "/tmp/input_history_testXXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_NE(fd, -1);
+    close(fd);
+    remove(path);
+
+    const mode_t old_mask = umask(0);
+    const int ret = input_history_save(&history_, path);
+    umask(old_mask);
+    ASSERT_EQ(ret, 0);
+
+    struct stat st;
+    ASSERT_EQ(stat(path, &st), 0);
+    remove(path);
+
+    EXPECT_EQ(st.st_mode & 0777, 0600);
+}
+
+TEST_F(InputHistoryTest, LoadingMissingFileIsNotAnError)
+{
+    init(10);
+    EXPECT_EQ(input_history_load(&history_, "/nonexistent/input_history"), 0);
+    EXPECT_EQ(history_.count, 0);
+}
+
+}  // namespace
@@ -34,6 +34,7 @@
 #include <tox/tox.h>
 
 #include "audio_device.h"
+#include "batch.h"
 #include "bootstrap.h"
 #include "conference.h"
 #include "configdir.h"
@@ -42,6 +43,7 @@
 #include "friendlist.h"
 #include "groupchats.h"
 #include "init_queue.h"
+#include "input_history.h"
 #include "line_info.h"
 #include "log.h"
 #include "message_queue.h"
@@ -49,6 +51,7 @@
 #include "name_lookup.h"
 #include "notify.h"
 #include "paths.h"
+#include "profile_save.h"
 #include "prompt.h"
 #include "run_options.h"
 #include "settings.h"
@@ -74,6 +77,8 @@
 
 #define DATANAME  "toxic_profile.tox"
 #define BLOCKNAME "toxic_blocklist"
+#define GROUP_IGNORE_NAME "toxic_group_ignores"
+#define INPUT_HISTORY_NAME "toxic_input_history"
 
 static struct cqueue_thread cqueue_thread;
 
@@ -173,17 +178,6 @@ static void cb_toxcore_logger(Tox *tox, Tox_Log_Level level, const char *file, u
     fflush(fp);
 }
 
-static void load_friendlist(Toxic *toxic)
-{
-    const size_t numfriends = tox_self_get_friend_list_size(toxic->tox);
-
-    for (size_t i = 0; i < numfriends; ++i) {
-        friendlist_onFriendAdded(NULL, toxic, i, false);
-    }
-
-    sort_friendlist_index(toxic->friends);
-}
-
 static void load_groups(Toxic *toxic)
 {
     if (toxic == NULL) {
@@ -361,6 +355,39 @@ static int password_eval(const Client_Config *c_config, char *buf, int size)
     return len;
 }
 
+/*
+ * Derives the encryption key for `client_data`'s password using `salt`, or a random salt if `salt`
+ * is NULL. Encrypted saves reuse the key instead of running the key derivation function each time.
+ *
+ * Returns NULL on failure.
+ */
+static Tox_Pass_Key *derive_pass_key(const Client_Data *client_data, const uint8_t *salt)
+{
+    const uint8_t *pass = (const uint8_t *) client_data->pass;
+
+    if (salt == NULL) {
+        return tox_pass_key_derive(pass, client_data->pass_len, NULL);
+    }
+
+    return tox_pass_key_derive_with_salt(pass, client_data->pass_len, salt, NULL);
+}
+
+/* Keeps `pass_key` for encrypted saves and wipes the password it was derived from. Saves fall back
+ * to encrypting with the password if `pass_key` is NULL.
+ */
+static void set_pass_key(Client_Data *client_data, Tox_Pass_Key *pass_key)
+{
+    if (pass_key == NULL) {
+        return;
+    }
+
+    tox_pass_key_free(client_data->pass_key);
+    client_data->pass_key = pass_key;
+
+    memset(client_data->pass, 0, sizeof(client_data->pass));
+    client_data->pass_len = 0;
+}
+
 /* Ask user if they would like to encrypt the data file and set password */
 static void first_time_encrypt(Client_Data *client_data, Init_Queue *init_q, const char *msg)
 {
@@ -424,6 +451,7 @@ static void first_time_encrypt(Client_Data *client_data, Init_Queue *init_q, con
         init_queue_add(init_q, "Data file '%s' is encrypted", client_data->data_path);
         memset(passconfirm, 0, sizeof(passconfirm));
         client_data->is_encrypted = true;
+        set_pass_key(client_data, derive_pass_key(client_data, NULL));
     }
 
     clear_screen();
@@ -620,11 +648,30 @@ static bool load_tox(Toxic *toxic, struct Tox_Options *tox_opts, Init_Queue *ini
                     continue;
                 }
 
+                /* Derive the key from the data file's salt once; it decrypts the data and encrypts later saves */
+                uint8_t salt[TOX_PASS_SALT_LENGTH];
+                Tox_Pass_Key *pass_key = NULL;
+
+                if (tox_get_salt((uint8_t *) data, salt, NULL)) {
+                    pass_key = derive_pass_key(client_data, salt);
+                }
+
                 Tox_Err_Decryption pwerr;
-                tox_pass_decrypt((uint8_t *) data, len, (uint8_t *) client_data->pass, pwlen,
-                                 (uint8_t *) plain, &pwerr);
+
+                if (pass_key != NULL) {
+                    tox_pass_key_decrypt(pass_key, (uint8_t *) data, len, (uint8_t *) plain, &pwerr);
+                } else {
+                    tox_pass_decrypt((uint8_t *) data, len, (uint8_t *) client_data->pass, pwlen,
+                                     (uint8_t *) plain, &pwerr);
+                }
 
                 if (pwerr == TOX_ERR_DECRYPTION_OK) {
+                    if (client_data->is_encrypted) {
+                        set_pass_key(client_data, pass_key);
+                    } else {
+                        tox_pass_key_free(pass_key);
+                    }
+
                     tox_options_set_savedata_type(tox_opts, TOX_SAVEDATA_TYPE_TOX_SAVE);
                     tox_options_set_savedata_data(tox_opts, (uint8_t *) plain, plain_len);
 
@@ -639,11 +686,13 @@ static bool load_tox(Toxic *toxic, struct Tox_Options *tox_opts, Init_Queue *ini
 
                     break;
                 } else if (pwerr == TOX_ERR_DECRYPTION_FAILED) {
+                    tox_pass_key_free(pass_key);
                     clear_screen();
                     sleep(1);
                     printf("Invalid password. Try again. ");
                     pweval = 0;
                 } else {
+                    tox_pass_key_free(pass_key);
                     fclose(fp);
                     free(data);
                     free(plain);
@@ -839,10 +888,18 @@ _Noreturn static void *thread_av(void *data)
     while (true) {
         pthread_mutex_lock(&Winthread.lock);
         toxav_iterate(av);
+        send_captured_audio();
+        const long int next_playout = service_output_devices();
         pthread_mutex_unlock(&Winthread.lock);
 
-        const long int sleep_duration = toxav_iteration_interval(av) * 1000;
-        sleep_thread(sleep_duration);
+        long int sleep_duration = toxav_iteration_interval(av) * 1000;
+
+        if (next_playout >= 0) {
+            sleep_duration = MIN(sleep_duration, next_playout);
+        }
+
+        // wakes early when the capture thread has frames for us to send
+        wait_captured_audio(sleep_duration);
     }
 }
 
@@ -856,6 +913,7 @@ static void print_usage(void)
     fprintf(stderr, "  -c, --config             Use specified config file\n");
     fprintf(stderr, "  -d, --default-locale     Use default POSIX locale\n");
     fprintf(stderr, "  -e, --encrypt-data       Encrypt an unencrypted data file\n");
+    fprintf(stderr, "  -E, --exec-file          Run the commands in a file at startup: Requires [path | -]\n");
     fprintf(stderr, "  -f, --file               Use specified data file\n");
     fprintf(stderr, "  -h, --help               Show this message and exit\n");
     fprintf(stderr, "  -l, --logging            Enable toxcore logging: Requires [log_path | stderr]\n");
@@ -905,6 +963,12 @@ static void handle_opt_data_file(Toxic *toxic, Run_Options *run_opts, Init_Queue
     free(client_data->block_path);
     client_data->block_path = NULL;
 
+    free(client_data->group_ignore_path);
+    client_data->group_ignore_path = NULL;
+
+    free(client_data->input_history_path);
+    client_data->input_history_path = NULL;
+
     client_data->data_path = strdup(arg_str);
 
     if (client_data->data_path == NULL) {
@@ -920,6 +984,24 @@ static void handle_opt_data_file(Toxic *toxic, Run_Options *run_opts, Init_Queue
 
     snprintf(client_data->block_path, block_path_len, "%s-blocklist", arg_str);
 
+    size_t group_ignore_path_len = strlen(arg_str) + strlen("-group-ignores") + 1;
+    client_data->group_ignore_path = malloc(group_ignore_path_len);
+
+    if (client_data->group_ignore_path == NULL) {
+        exit_toxic_err(FATALERR_MEMORY, "failed in parse_args");
+    }
+
+    snprintf(client_data->group_ignore_path, group_ignore_path_len, "%s-group-ignores", arg_str);
+
+    size_t input_history_path_len = strlen(arg_str) + strlen("-input-history") + 1;
+    client_data->input_history_path = malloc(input_history_path_len);
+
+    if (client_data->input_history_path == NULL) {
+        exit_toxic_err(FATALERR_MEMORY, "failed in parse_args");
+    }
+
+    snprintf(client_data->input_history_path, input_history_path_len, "%s-input-history", arg_str);
+
     init_queue_add(init_q, "Using '%s' tox profile", client_data->data_path);
 }
 
@@ -990,6 +1072,7 @@ static void parse_args(Toxic *toxic, Init_Queue *init_q, int argc, char *argv[])
         {"default-locale", no_argument, 0, 'd'},
         {"config", required_argument, 0, 'c'},
         {"encrypt-data", no_argument, 0, 'e'},
+        {"exec-file", required_argument, 0, 'E'},
         {"file", required_argument, 0, 'f'},
         {"logging", required_argument, 0, 'l'},
         {"no-lan", no_argument, 0, 'L'},
@@ -1010,9 +1093,9 @@ static void parse_args(Toxic *toxic, Init_Queue *init_q, int argc, char *argv[])
     };
 
 #ifdef TOX_EXPERIMENTAL
-    const char *opts_str = "4bdehLotuxvc:f:l:n:r:s:p:P:T:";
+    const char *opts_str = "4bdehLotuxvc:E:f:l:n:r:s:p:P:T:";
 #else
-    const char *opts_str = "4bdehLotuxvc:f:l:n:r:p:P:T:";
+    const char *opts_str = "4bdehLotuxvc:E:f:l:n:r:p:P:T:";
 #endif // TOX_EXPERIMENTAL
 
     int opt = 0;
@@ -1047,6 +1130,11 @@ static void parse_args(Toxic *toxic, Init_Queue *init_q, int argc, char *argv[])
                 break;
             }
 
+            case 'E': {
+                snprintf(run_opts->exec_path, sizeof(run_opts->exec_path), "%s", optarg);
+                break;
+            }
+
             case 'f': {
                 handle_opt_data_file(toxic, run_opts, init_q, optarg);
                 break;
@@ -1187,8 +1275,11 @@ static void init_default_data_files(Client_Data *client_data, const Paths *paths
     if (config_err == -1) {
         client_data->data_path = strdup(DATANAME);
         client_data->block_path = strdup(BLOCKNAME);
+        client_data->group_ignore_path = strdup(GROUP_IGNORE_NAME);
+        client_data->input_history_path = strdup(INPUT_HISTORY_NAME);
 
-        if (client_data->data_path == NULL || client_data->block_path == NULL) {
+        if (client_data->data_path == NULL || client_data->block_path == NULL
+                || client_data->group_ignore_path == NULL || client_data->input_history_path == NULL) {
             exit_toxic_err(FATALERR_MEMORY, "strdup() failed in init_default_data_files()");
         }
     } else {
@@ -1198,17 +1289,81 @@ static void init_default_data_files(Client_Data *client_data, const Paths *paths
         size_t block_path_len = strlen(user_config_dir) + strlen(CONFIGDIR) + strlen(BLOCKNAME) + 1;
         client_data->block_path = malloc(block_path_len);
 
-        if (client_data->data_path == NULL || client_data->block_path == NULL) {
+        size_t group_ignore_path_len = strlen(user_config_dir) + strlen(CONFIGDIR) + strlen(GROUP_IGNORE_NAME) + 1;
+        client_data->group_ignore_path = malloc(group_ignore_path_len);
+
+        size_t input_history_path_len = strlen(user_config_dir) + strlen(CONFIGDIR) + strlen(INPUT_HISTORY_NAME) + 1;
+        client_data->input_history_path = malloc(input_history_path_len);
+
+        if (client_data->data_path == NULL || client_data->block_path == NULL
+                || client_data->group_ignore_path == NULL || client_data->input_history_path == NULL) {
             exit_toxic_err(FATALERR_MEMORY, "malloc() failed in init_default_data_files()");
         }
 
         snprintf(client_data->data_path, data_path_len, "%s%s%s", user_config_dir, CONFIGDIR, DATANAME);
         snprintf(client_data->block_path, block_path_len, "%s%s%s", user_config_dir, CONFIGDIR, BLOCKNAME);
+        snprintf(client_data->group_ignore_path, group_ignore_path_len, "%s%s%s", user_config_dir, CONFIGDIR,
+                 GROUP_IGNORE_NAME);
+        snprintf(client_data->input_history_path, input_history_path_len, "%s%s%s", user_config_dir, CONFIGDIR,
+                 INPUT_HISTORY_NAME);
     }
 
     free(user_config_dir);
 }
 
+/*
+ * Sets up the input history shared by all windows, reading back the lines kept from the last session
+ * if they're saved. The history file isn't encrypted, so it's never used with an encrypted profile.
+ */
+static void init_input_history(Toxic *toxic, Init_Queue *init_q)
+{
+    const Client_Config *c_config = toxic->c_config;
+    Client_Data *client_data = &toxic->client_data;
+
+    if (!input_history_init(&client_data->input_history, c_config->input_history_size)) {
+        exit_toxic_err(FATALERR_MEMORY, "failed in init_input_history");
+    }
+
+    if (!c_config->save_input_history || client_data->is_encrypted) {
+        return;
+    }
+
+    if (input_history_load(&client_data->input_history, client_data->input_history_path) != 0) {
+        init_queue_add(init_q, "Failed to load input history");
+    }
+}
+
+/*
+ * Reads the --exec-file script. If it's read from stdin, stdin is handed back to the terminal
+ * afterwards so that the password prompt and curses can read keys from it.
+ */
+static Batch_Script *load_batch_script(const char *path, Init_Queue *init_q)
+{
+    const bool use_stdin = strcmp(path, "-") == 0;
+    FILE *fp = use_stdin ? stdin : fopen(path, "r");
+
+    if (fp == NULL) {
+        init_queue_add(init_q, "Failed to open command script '%s'", path);
+        return NULL;
+    }
+
+    Batch_Script *script = batch_script_read(fp);
+
+    if (use_stdin) {
+        if (freopen("/dev/tty", "r", stdin) == NULL) {
+            exit_toxic_err(FATALERR_FILEOP, "Failed to reopen the terminal after reading commands from stdin");
+        }
+    } else {
+        fclose(fp);
+    }
+
+    if (script == NULL) {
+        init_queue_add(init_q, "Failed to read command script '%s'", path);
+    }
+
+    return script;
+}
+
 static Toxic *toxic_init(void)
 {
     Toxic *toxic = (Toxic *) calloc(1, sizeof(Toxic));
@@ -1323,6 +1478,12 @@ int main(int argc, char **argv)
                        "Warning: Using --unencrypt-data and --encrypt-data simultaneously has no effect");
     }
 
+    Batch_Script *batch = NULL;
+
+    if (run_opts->exec_path[0] != '\0') {
+        batch = load_batch_script(run_opts->exec_path, init_q);
+    }
+
     if (!run_opts->use_custom_data) {
         init_default_data_files(&toxic->client_data, toxic->paths);
     }
@@ -1340,12 +1501,15 @@ int main(int argc, char **argv)
         init_queue_add(init_q, "Failed to load config file");
     }
 
-    const int ms_ret = settings_load_main(toxic->c_config, run_opts);
+    int settings_err;
+    toxic->settings_tree = settings_tree_read(run_opts, &settings_err);
 
-    if (ms_ret < 0) {
-        init_queue_add(init_q, "Failed to load user settings: error %d", ms_ret);
+    if (toxic->settings_tree == NULL) {
+        init_queue_add(init_q, "Failed to load user settings: error %d", settings_err);
     }
 
+    settings_load_main(toxic->c_config, toxic->settings_tree);
+
     if (!run_opts->use_custom_config_file && run_opts->use_custom_data) {
         init_queue_add(init_q, "Using '%s' config file", run_opts->config_path);
     }
@@ -1379,6 +1543,8 @@ int main(int argc, char **argv)
 
     init_term(c_config, init_q, run_opts->default_locale);
 
+    init_input_history(toxic, init_q);
+
     init_windows(toxic);
     ToxWindow *home_window = toxic->home_window;
 
@@ -1387,25 +1553,10 @@ int main(int argc, char **argv)
     load_groups(toxic);
     load_conferences(toxic);
 
-    const int fs_ret = settings_load_friends(toxic->friends, run_opts);
-
-    if (fs_ret != 0) {
-        init_queue_add(init_q, "Failed to load friend config settings: error %d", fs_ret);
-    }
-
-    const int gs_ret = settings_load_groups(windows, run_opts);
-
-    if (gs_ret != 0) {
-        init_queue_add(init_q, "Failed to load groupchat config settings: error %d", gs_ret);
-    }
-
-    const int cs_ret = settings_load_conferences(windows, run_opts);
-
-    if (cs_ret != 0) {
-        init_queue_add(init_q, "Failed to load conference config settings: error %d", cs_ret);
-    }
+    // Group and conference windows load their own settings when they're created
+    settings_load_friends(toxic->friends, toxic->settings_tree);
 
-    const int bl_ret = settings_load_blocked_words(&toxic->client_data, run_opts);
+    const int bl_ret = settings_load_blocked_words(&toxic->client_data, toxic->settings_tree);
 
     if (bl_ret != 0) {
         init_queue_add(init_q, "Failed to load blocked words list: error %d", bl_ret);
@@ -1460,6 +1611,11 @@ int main(int argc, char **argv)
         exit_toxic_err(FATALERR_THREAD_CREATE, "failed in main");
     }
 
+    /* thread for writing the profile to disk */
+    if (!profile_save_init(toxic)) {
+        exit_toxic_err(FATALERR_THREAD_CREATE, "failed in main");
+    }
+
 #ifdef PYTHON
 
     init_python(toxic);
@@ -1493,6 +1649,12 @@ int main(int argc, char **argv)
     snprintf(avatarstr, sizeof(avatarstr), "/avatar %s", c_config->avatar_path);
     execute(home_window->chatwin->history, home_window, toxic, avatarstr, GLOBAL_COMMAND_MODE);
 
+    if (batch != NULL) {
+        batch_script_run(batch, toxic);
+        batch_script_free(batch);
+        batch = NULL;
+    }
+
     time_t last_save = get_unix_time();
 
     while (true) {
@@ -1501,16 +1663,15 @@ int main(int argc, char **argv)
         const time_t cur_time = get_unix_time();
 
         if (c_config->autosave_freq > 0 && timed_out(last_save, c_config->autosave_freq)) {
-            pthread_mutex_lock(&Winthread.lock);
-
-            if (store_data(toxic) != 0) {
-                line_info_add(home_window, c_config, false, NULL, NULL, SYS_MSG, 0, RED,
-                              "WARNING: Failed to save to data file");
-            }
+            profile_save_request();
+            last_save = cur_time;
+        }
 
+        if (profile_save_do(toxic) > 0) {
+            pthread_mutex_lock(&Winthread.lock);
+            line_info_add(home_window, c_config, false, NULL, NULL, SYS_MSG, 0, RED,
+                          "WARNING: Failed to save to data file");
             pthread_mutex_unlock(&Winthread.lock);
-
-            last_save = cur_time;
         }
 
         const long int sleep_duration = tox_iteration_interval(toxic->tox) * 1000;
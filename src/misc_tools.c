@@ -14,6 +14,7 @@
 #include <arpa/inet.h>
 #include <ctype.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -76,6 +77,13 @@ void sleep_thread(long int usec)
     }
 }
 
+uint64_t get_monotonic_time_usec(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((uint64_t) t.tv_sec) * 1000000 + ((uint64_t) t.tv_nsec) / 1000;
+}
+
 /* Get the current local time */
 struct tm *get_time(void)
 {
@@ -85,23 +93,121 @@ struct tm *get_time(void)
     return timeinfo;
 }
 
-void get_time_str(char *buf, size_t bufsize, const char *format_string)
+/* The number of timestamp formats whose last output is cached */
+#define TIME_STR_CACHE_SLOTS 4
+
+typedef struct Time_Str_Cache_Slot {
+    bool   valid;
+    time_t second;                 /* The time that str was made for */
+    char   format[TIME_STR_SIZE];
+    char   str[MAX_STR_SIZE];
+    size_t length;
+} Time_Str_Cache_Slot;
+
+/*
+ * Formatted timestamps only change once a second, while a burst of messages asks for the same ones
+ * for the chat window and the log over and over. Each slot keeps the output of one format string for
+ * the second it was made in, sparing localtime() and strftime() for every message.
+ */
+static struct Time_Str_Cache {
+    pthread_mutex_t lock;
+    Time_Str_Cache_Slot slots[TIME_STR_CACHE_SLOTS];
+    size_t next_slot;    /* The slot to reuse for a format that isn't cached */
+} time_str_cache = {
+    PTHREAD_MUTEX_INITIALIZER
+};
+
+static void format_time(char *buf, size_t bufsize, const char *format_string, time_t t)
 {
-    if (buf == NULL || bufsize == 0) {
+    struct tm tm;
+
+    if (localtime_r(&t, &tm) == NULL) {
+        buf[0] = '\0';
         return;
     }
 
-    if (format_time_str(buf, bufsize, format_string, get_time()) > 0) {
+    if (format_time_str(buf, bufsize, format_string, &tm) > 0) {
         return;
     }
 
-    if (format_time_str(buf, bufsize, TIMESTAMP_DEFAULT, get_time()) > 0) {
+    if (format_time_str(buf, bufsize, TIMESTAMP_DEFAULT, &tm) > 0) {
         return;
     }
 
     buf[0] = '\0';
 }
 
+/* Returns the cache slot for `format_string`, taking over the least recently added slot if it has none.
+ * The caller must hold the cache lock. */
+static Time_Str_Cache_Slot *time_str_cache_slot(const char *format_string, size_t format_length)
+{
+    for (size_t i = 0; i < TIME_STR_CACHE_SLOTS; ++i) {
+        Time_Str_Cache_Slot *slot = &time_str_cache.slots[i];
+
+        if (slot->valid && memcmp(slot->format, format_string, format_length + 1) == 0) {
+            return slot;
+        }
+    }
+
+    Time_Str_Cache_Slot *slot = &time_str_cache.slots[time_str_cache.next_slot];
+    time_str_cache.next_slot = (time_str_cache.next_slot + 1) % TIME_STR_CACHE_SLOTS;
+
+    memcpy(slot->format, format_string, format_length + 1);
+    slot->second = 0;
+    slot->length = 0;
+    slot->valid = true;
+
+    return slot;
+}
+
+void get_time_str(char *buf, size_t bufsize, const char *format_string)
+{
+    if (buf == NULL || bufsize == 0) {
+        return;
+    }
+
+    const time_t now = get_unix_time();
+    const size_t format_length = strlen(format_string);
+
+    if (format_length >= TIME_STR_SIZE) {
+        format_time(buf, bufsize, format_string, now);
+        return;
+    }
+
+    pthread_mutex_lock(&time_str_cache.lock);
+
+    Time_Str_Cache_Slot *slot = time_str_cache_slot(format_string, format_length);
+
+    if (slot->second != now) {
+        format_time(slot->str, sizeof(slot->str), format_string, now);
+        slot->length = strlen(slot->str);
+        slot->second = now;
+    }
+
+    // A buffer too small for the cached string gets the same fallback it would have without the cache
+    if (slot->length < bufsize) {
+        memcpy(buf, slot->str, slot->length + 1);
+    } else {
+        format_time(buf, bufsize, format_string, now);
+    }
+
+    pthread_mutex_unlock(&time_str_cache.lock);
+}
+
+void reset_time_str_cache(void)
+{
+    pthread_mutex_lock(&time_str_cache.lock);
+
+    for (size_t i = 0; i < TIME_STR_CACHE_SLOTS; ++i) {
+        time_str_cache.slots[i].valid = false;
+    }
+
+    // localtime_r() doesn't look at TZ again by itself
+    tzset();
+
+    pthread_mutex_unlock(&time_str_cache.lock);
+}
+
 void get_elapsed_time_str(char *buf, int bufsize, uint64_t elapsed_seconds)
 {
     if (elapsed_seconds == 0) {
@@ -845,11 +951,5 @@ size_t format_time_str(char *s, size_t max, const char *format, const struct tm
 
 bool string_contains_blocked_word(const char *line, const Client_Data *client_data)
 {
-    for (size_t i = 0; i < client_data->num_blocked_words; ++i) {
-        if (strcasestr(line, client_data->blocked_words[i]) != NULL) {
-            return true;
-        }
-    }
-
-    return false;
+    return word_filter_match(&client_data->blocked_words, line);
 }
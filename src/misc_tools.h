@@ -89,9 +89,14 @@ time_t get_unix_time(void);
  *
  * If the passed format string is invalid, a default format will be tried. If that
  * fails, `buf` will be set to nul.
+ *
+ * The result for each format string is cached until the second changes. This function is thread safe.
  */
 void get_time_str(char *buf, size_t bufsize, const char *format_string);
 
+/* Drops the timestamps cached by get_time_str(), and picks up changes to the time zone. */
+void reset_time_str_cache(void);
+
 /* Converts `elapsed_seconds` to string in format "H hours, m minutes, s seconds" and puts the resulting
  * string in `buf`.
  *
@@ -142,6 +147,9 @@ int timed_out(time_t timestamp, time_t timeout);
 /* Attempts to sleep the caller's thread for `usec` microseconds */
 void sleep_thread(long int usec);
 
+/* Returns the current value of the monotonic clock in microseconds. */
+uint64_t get_monotonic_time_usec(void);
+
 /* Colours the window tab according to type. Beeps if is_beep is true */
 void alert_window(ToxWindow *self, int type, bool is_beep);
 
@@ -305,7 +313,7 @@ int colour_string_to_int(const char *colour);
 size_t format_time_str(char *s, size_t max, const char *format, const struct tm *tm);
 
 /*
- * Returns true if `line` contains a word that's in the client's blocked words list.
+ * Returns true if `line` contains a word that's in the client's blocked words list, ignoring case.
  */
 bool string_contains_blocked_word(const char *line, const Client_Data *client_data);
 
@@ -2,6 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
 namespace {
 
 TEST(MultiByteStrings, TextLength)
@@ -45,4 +50,64 @@ TEST(GetFileName, Empty)
     EXPECT_STREQ(buf, "");
 }
 
+TEST(GetTimeStr, MatchesStrftime)
+{
+    const char *format = "%Y-%m-%d %H:%M:%S";
+    char buf[64];
+    char expected[64];
+    time_t before;
+    time_t after;
+
+    // Retry if the second changes between the two calls
+    do {
+        before = time(nullptr);
+        get_time_str(buf, sizeof(buf), format);
+        get_time_str(buf, sizeof(buf), format);
+        after = time(nullptr);
+    } while (before != after);
+
+    struct tm tm;
+    localtime_r(&before, &tm);
+    strftime(expected, sizeof(expected), format, &tm);
+
+    EXPECT_STREQ(buf, expected);
+}
+
+TEST(GetTimeStr, SmallBufferGetsDefaultFormat)
+{
+    char buf[64];
+    get_time_str(buf, sizeof(buf), "%Y/%m/%d %H:%M:%S");
+    EXPECT_EQ(strlen(buf), 19);
+
+    char small[6];
+    get_time_str(small, sizeof(small), "%Y/%m/%d %H:%M:%S");
+    EXPECT_EQ(strlen(small), 5);
+    EXPECT_EQ(small[2], ':');
+}
+
+TEST(GetTimeStr, ResetPicksUpTimeZone)
+{
+    const char *old_tz = getenv("TZ");
+    const std::string saved_tz = old_tz != nullptr ? old_tz : "";
+    char buf[16];
+
+    setenv("TZ", "UTC", 1);
+    reset_time_str_cache();
+    get_time_str(buf, sizeof(buf), "%z");
+    EXPECT_STREQ(buf, "+0000");
+
+    setenv("TZ", "UTC-5", 1);
+    reset_time_str_cache();
+    get_time_str(buf, sizeof(buf), "%z");
+    EXPECT_STREQ(buf, "+0500");
+
+    if (old_tz != nullptr) {
+        setenv("TZ", saved_tz.c_str(), 1);
+    } else {
+        unsetenv("TZ");
+    }
+
+    reset_time_str_cache();
+}
+
 }  // namespace
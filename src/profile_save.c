@@ -0,0 +1,383 @@
+/*  profile_save.c
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+#include "profile_save.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tox/toxencryptsave.h>
+
+#include "misc_tools.h"
+#include "run_options.h"
+#include "windows.h"
+
+#define TEMP_PROFILE_EXT ".tmp"
+
+/* A save is started once no further save has been requested for this long */
+#define PROFILE_SAVE_DEBOUNCE_USEC (2 * 1000000ULL)
+
+/* A save is started no later than this long after the first request it covers */
+#define PROFILE_SAVE_MAX_DELAY_USEC (15 * 1000000ULL)
+
+typedef struct ProfileSnapshot {
+    uint8_t  *data;     /* NULL if there's no snapshot waiting to be written */
+    size_t   length;
+    uint64_t seq;       /* Snapshots are numbered in the order they were taken */
+} ProfileSnapshot;
+
+static struct ProfileSaver {
+    pthread_t tid;
+    bool running;                  /* True from profile_save_init() until profile_save_shutdown() */
+    const Toxic *toxic;
+
+    pthread_mutex_t lock;          /* Protects the fields below up to write_lock */
+    pthread_cond_t cond;
+    bool stop;                     /* Tells the save thread to exit once it has written the pending snapshot */
+    bool dirty;
+    uint64_t first_request_usec;   /* Time of the oldest request the next snapshot will cover */
+    uint64_t last_request_usec;
+    uint64_t next_seq;
+    ProfileSnapshot pending;
+    ProfileSaveStats stats;
+    uint64_t reported_failures;
+
+    pthread_mutex_t write_lock;    /* Serializes writes to the profile file */
+    uint64_t written_seq;          /* Sequence number of the newest snapshot written so far */
+} saver = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .write_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static uint64_t take_seq(void)
+{
+    pthread_mutex_lock(&saver.lock);
+    const uint64_t seq = ++saver.next_seq;
+    pthread_mutex_unlock(&saver.lock);
+
+    return seq;
+}
+
+static void record_write(bool success, uint64_t usec)
+{
+    pthread_mutex_lock(&saver.lock);
+
+    ++saver.stats.writes;
+    saver.stats.write_usec += usec;
+    saver.stats.max_write_usec = MAX(saver.stats.max_write_usec, usec);
+
+    if (success) {
+        saver.stats.last_write_time = get_unix_time();
+    } else {
+        ++saver.stats.failures;
+    }
+
+    pthread_mutex_unlock(&saver.lock);
+}
+
+static void record_snapshot(uint64_t usec)
+{
+    pthread_mutex_lock(&saver.lock);
+    saver.stats.snapshot_usec += usec;
+    saver.stats.max_snapshot_usec = MAX(saver.stats.max_snapshot_usec, usec);
+    pthread_mutex_unlock(&saver.lock);
+}
+
+/* Returns a copy of `toxic`'s savedata, or NULL on allocation failure. */
+static uint8_t *take_snapshot(const Toxic *toxic, size_t *length)
+{
+    const uint64_t start = get_monotonic_time_usec();
+
+    const size_t data_len = tox_get_savedata_size(toxic->tox);
+    uint8_t *data = malloc(data_len);
+
+    if (data == NULL) {
+        return NULL;
+    }
+
+    tox_get_savedata(toxic->tox, data);
+    *length = data_len;
+
+    record_snapshot(get_monotonic_time_usec() - start);
+
+    return data;
+}
+
+/*
+ * Encrypts `data` if the profile is encrypted and writes it to a temporary file, which then
+ * replaces the profile.
+ */
+static int write_profile_file(const Toxic *toxic, const uint8_t *data, size_t data_len)
+{
+    const char *path = toxic->client_data.data_path;
+
+    const size_t temp_buf_size = strlen(path) + strlen(TEMP_PROFILE_EXT) + 1;
+    char *temp_path = malloc(temp_buf_size);
+
+    if (temp_path == NULL) {
+        return -1;
+    }
+
+    snprintf(temp_path, temp_buf_size, "%s%s", path, TEMP_PROFILE_EXT);
+
+    const Client_Data *client_data = &toxic->client_data;
+    uint8_t *enc_data = NULL;
+
+    if (client_data->is_encrypted && !toxic->run_opts->unencrypt_data) {
+        const size_t enc_len = data_len + TOX_PASS_ENCRYPTION_EXTRA_LENGTH;
+        enc_data = malloc(enc_len);
+
+        if (enc_data == NULL) {
+            free(temp_path);
+            return -1;
+        }
+
+        Tox_Err_Encryption err;
+
+        // The cached key skips the key derivation function, which dominates the cost of a save
+        if (client_data->pass_key != NULL) {
+            tox_pass_key_encrypt(client_data->pass_key, data, data_len, enc_data, &err);
+        } else {
+            tox_pass_encrypt(data, data_len, (const uint8_t *) client_data->pass, client_data->pass_len, enc_data,
+                             &err);
+        }
+
+        if (err != TOX_ERR_ENCRYPTION_OK) {
+            fprintf(stderr, "Profile encryption failed with error %d\n", err);
+            free(temp_path);
+            free(enc_data);
+            return -1;
+        }
+
+        data = enc_data;
+        data_len = enc_len;
+    }
+
+    FILE *fp = fopen(temp_path, "wb");
+
+    if (fp == NULL) {
+        free(temp_path);
+        free(enc_data);
+        return -1;
+    }
+
+    const bool written = fwrite(data, data_len, 1, fp) == 1;
+
+    free(enc_data);
+
+    if (fclose(fp) != 0 || !written) {
+        fprintf(stderr, "Failed to write profile data.\n");
+        free(temp_path);
+        return -1;
+    }
+
+    if (rename(temp_path, path) != 0) {
+        free(temp_path);
+        return -1;
+    }
+
+    free(temp_path);
+
+    return 0;
+}
+
+/*
+ * Writes snapshot number `seq` unless a newer one has already been written, which happens when
+ * profile_save_now() overtakes the save thread.
+ */
+static int write_snapshot(const Toxic *toxic, const uint8_t *data, size_t length, uint64_t seq)
+{
+    pthread_mutex_lock(&saver.write_lock);
+
+    if (seq < saver.written_seq) {
+        pthread_mutex_unlock(&saver.write_lock);
+        return 0;
+    }
+
+    const uint64_t start = get_monotonic_time_usec();
+    const int ret = write_profile_file(toxic, data, length);
+
+    if (ret == 0) {
+        saver.written_seq = seq;
+    }
+
+    record_write(ret == 0, get_monotonic_time_usec() - start);
+
+    pthread_mutex_unlock(&saver.write_lock);
+
+    return ret;
+}
+
+static void *profile_save_thread(void *data)
+{
+    UNUSED_VAR(data);
+
+    const Toxic *toxic = saver.toxic;
+
+    while (true) {
+        pthread_mutex_lock(&saver.lock);
+
+        while (saver.pending.data == NULL && !saver.stop) {
+            pthread_cond_wait(&saver.cond, &saver.lock);
+        }
+
+        if (saver.pending.data == NULL) {
+            pthread_mutex_unlock(&saver.lock);
+            break;
+        }
+
+        const ProfileSnapshot snapshot = saver.pending;
+        saver.pending.data = NULL;
+
+        pthread_mutex_unlock(&saver.lock);
+
+        write_snapshot(toxic, snapshot.data, snapshot.length, snapshot.seq);
+        free(snapshot.data);
+    }
+
+    return NULL;
+}
+
+bool profile_save_init(const Toxic *toxic)
+{
+    saver.toxic = toxic;
+
+    pthread_mutex_lock(&saver.lock);
+    saver.stats.start_time = get_unix_time();
+    pthread_mutex_unlock(&saver.lock);
+
+    if (pthread_create(&saver.tid, NULL, profile_save_thread, NULL) != 0) {
+        return false;
+    }
+
+    saver.running = true;
+
+    return true;
+}
+
+void profile_save_shutdown(void)
+{
+    if (!saver.running) {
+        return;
+    }
+
+    pthread_mutex_lock(&saver.lock);
+    saver.stop = true;
+    pthread_cond_signal(&saver.cond);
+    pthread_mutex_unlock(&saver.lock);
+
+    pthread_join(saver.tid, NULL);
+
+    saver.running = false;
+}
+
+void profile_save_request(void)
+{
+    const uint64_t now = get_monotonic_time_usec();
+
+    pthread_mutex_lock(&saver.lock);
+
+    if (!saver.dirty) {
+        saver.dirty = true;
+        saver.first_request_usec = now;
+    }
+
+    saver.last_request_usec = now;
+    ++saver.stats.requests;
+
+    pthread_mutex_unlock(&saver.lock);
+}
+
+/* Returns true and clears the dirty flag if a snapshot is due. */
+static bool snapshot_due(void)
+{
+    const uint64_t now = get_monotonic_time_usec();
+
+    pthread_mutex_lock(&saver.lock);
+
+    const bool due = saver.dirty
+                     && (now - saver.last_request_usec >= PROFILE_SAVE_DEBOUNCE_USEC
+                         || now - saver.first_request_usec >= PROFILE_SAVE_MAX_DELAY_USEC);
+
+    if (due) {
+        saver.dirty = false;
+    }
+
+    pthread_mutex_unlock(&saver.lock);
+
+    return due;
+}
+
+uint64_t profile_save_do(Toxic *toxic)
+{
+    if (toxic->client_data.data_path != NULL && snapshot_due()) {
+        pthread_mutex_lock(&Winthread.lock);
+
+        size_t length = 0;
+        uint8_t *data = take_snapshot(toxic, &length);
+        const uint64_t seq = take_seq();
+
+        pthread_mutex_unlock(&Winthread.lock);
+
+        if (data == NULL) {
+            profile_save_request();  // try again later
+        } else {
+            pthread_mutex_lock(&saver.lock);
+
+            // A snapshot the save thread hasn't picked up yet is older than this one
+            free(saver.pending.data);
+            saver.pending = (ProfileSnapshot) {
+                data, length, seq
+            };
+
+            pthread_cond_signal(&saver.cond);
+            pthread_mutex_unlock(&saver.lock);
+        }
+    }
+
+    pthread_mutex_lock(&saver.lock);
+    const uint64_t failures = saver.stats.failures - saver.reported_failures;
+    saver.reported_failures = saver.stats.failures;
+    pthread_mutex_unlock(&saver.lock);
+
+    return failures;
+}
+
+int profile_save_now(const Toxic *toxic)
+{
+    if (toxic->client_data.data_path == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&saver.lock);
+    saver.dirty = false;
+    pthread_mutex_unlock(&saver.lock);
+
+    size_t length = 0;
+    uint8_t *data = take_snapshot(toxic, &length);
+
+    if (data == NULL) {
+        return -1;
+    }
+
+    const int ret = write_snapshot(toxic, data, length, take_seq());
+
+    free(data);
+
+    return ret;
+}
+
+void profile_save_get_stats(ProfileSaveStats *stats)
+{
+    pthread_mutex_lock(&saver.lock);
+    *stats = saver.stats;
+    pthread_mutex_unlock(&saver.lock);
+}
@@ -0,0 +1,90 @@
+/*  profile_save.h
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+/*
+ * Events that change the profile (a friend coming online, a nick change, joining a group) only mark
+ * it as dirty. The main loop snapshots it at most once per debounce window, and the snapshot is
+ * encrypted and written to disk on a background thread so that tox_iterate() never waits on the
+ * passphrase KDF or the filesystem.
+ */
+
+#ifndef PROFILE_SAVE_H
+#define PROFILE_SAVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "toxic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct ProfileSaveStats {
+    uint64_t requests;            /* Number of times a save was requested */
+    uint64_t writes;              /* Number of times the profile was written or failed to be */
+    uint64_t failures;
+    uint64_t snapshot_usec;       /* Total time spent copying savedata while holding Winthread.lock */
+    uint64_t max_snapshot_usec;
+    uint64_t write_usec;          /* Total time spent encrypting and writing savedata */
+    uint64_t max_write_usec;
+    time_t   start_time;
+    time_t   last_write_time;     /* 0 until the first successful write */
+} ProfileSaveStats;
+
+/*
+ * Starts the save thread. Must be called once, after the profile has been loaded.
+ *
+ * Returns false if the thread could not be created.
+ */
+bool profile_save_init(const Toxic *toxic);
+
+/*
+ * Writes the snapshot the save thread was handed, if it hasn't been written yet, and stops the
+ * thread. Must be called before the data path or the pass key are freed.
+ *
+ * Does nothing if the thread was never started.
+ */
+void profile_save_shutdown(void);
+
+/*
+ * Marks the profile as needing to be saved.
+ *
+ * This function is thread safe.
+ */
+void profile_save_request(void);
+
+/*
+ * Hands a snapshot of the profile to the save thread once no save has been requested for the
+ * debounce window, or once the oldest unsaved request is too old to keep waiting on.
+ *
+ * Must be called periodically from the main loop without holding Winthread.lock.
+ *
+ * Returns the number of writes that failed since the previous call.
+ */
+uint64_t profile_save_do(Toxic *toxic);
+
+/*
+ * Writes the profile to disk right away, superseding any save that is still pending.
+ *
+ * The caller must hold Winthread.lock once other threads are running.
+ *
+ * Return 0 if stored successfully.
+ * Return -1 on error.
+ */
+int profile_save_now(const Toxic *toxic);
+
+/* Copies the save statistics into `stats`. */
+void profile_save_get_stats(ProfileSaveStats *stats);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* PROFILE_SAVE_H */
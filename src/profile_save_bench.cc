@@ -0,0 +1,139 @@
+/* Encrypted profile save benchmark.
+ *
+ * Builds a synthetic profile with 1000 friends and times profile_save_now() on it, first
+ * encrypting with the password as every save used to, then with a key derived once up front.
+ * Run with optional friend and save counts.
+ */
+
+#include "profile_save.h"
+#include "run_options.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr char kPassword[] = "correct horse battery staple";
+
+double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+Tox *new_tox()
+{
+    Tox_Options *opts = tox_options_new(nullptr);
+
+    if (opts == nullptr) {
+        return nullptr;
+    }
+
+    tox_options_set_udp_enabled(opts, false);
+    tox_options_set_local_discovery_enabled(opts, false);
+
+    Tox *tox = tox_new(opts, nullptr);
+    tox_options_free(opts);
+
+    return tox;
+}
+
+void add_friends(Tox *tox, uint32_t num_friends)
+{
+    std::mt19937 rng(1234);
+    uint8_t public_key[TOX_PUBLIC_KEY_SIZE];
+
+    for (uint32_t i = 0; i < num_friends; ++i) {
+        for (uint8_t &byte : public_key) {
+            byte = rng();
+        }
+
+        public_key[TOX_PUBLIC_KEY_SIZE - 1] &= 0x7f;  // toxcore rejects keys with the high bit set
+
+        if (tox_friend_add_norequest(tox, public_key, nullptr) == UINT32_MAX) {
+            fprintf(stderr, "Failed to add friend %u\n", i);
+            exit(1);
+        }
+    }
+}
+
+double time_saves(const Toxic *toxic, uint32_t num_saves)
+{
+    const auto start = Clock::now();
+
+    for (uint32_t i = 0; i < num_saves; ++i) {
+        if (profile_save_now(toxic) != 0) {
+            fprintf(stderr, "Save %u failed\n", i);
+            exit(1);
+        }
+    }
+
+    return ms_since(start) / num_saves;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const uint32_t num_friends = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000;
+    const uint32_t num_saves = argc > 2 ? strtoul(argv[2], nullptr, 10) : 20;
+
+    Tox *tox = new_tox();
+
+    if (tox == nullptr) {
+        fprintf(stderr, "Failed to create Tox instance\n");
+        return 1;
+    }
+
+    add_friends(tox, num_friends);
+
+    char path[] = "/tmp/toxic_profile_save_bench_XXXXXX";
+    const int fd = mkstemp(path);
+
+    if (fd == -1) {
+        fprintf(stderr, "Failed to create temporary profile\n");
+        return 1;
+    }
+
+    close(fd);
+
+    Run_Options run_opts{};
+    Toxic toxic{};
+    toxic.tox = tox;
+    toxic.run_opts = &run_opts;
+    toxic.client_data.data_path = path;
+    toxic.client_data.is_encrypted = true;
+    snprintf(toxic.client_data.pass, sizeof(toxic.client_data.pass), "%s", kPassword);
+    toxic.client_data.pass_len = strlen(kPassword);
+
+    printf("profile with %u friends: %zu bytes, %u saves each\n", num_friends, tox_get_savedata_size(tox), num_saves);
+    printf("password per save:    %8.2f ms/save\n", time_saves(&toxic, num_saves));
+
+    const auto derive_start = Clock::now();
+    toxic.client_data.pass_key = tox_pass_key_derive(reinterpret_cast<const uint8_t *>(kPassword),
+                                 strlen(kPassword), nullptr);
+
+    if (toxic.client_data.pass_key == nullptr) {
+        fprintf(stderr, "Failed to derive key\n");
+        return 1;
+    }
+
+    printf("key derivation:       %8.2f ms (once)\n", ms_since(derive_start));
+    printf("cached key per save:  %8.2f ms/save\n", time_saves(&toxic, num_saves));
+
+    ProfileSaveStats stats;
+    profile_save_get_stats(&stats);
+    printf("max snapshot %.2f ms, max encrypt and write %.2f ms\n", stats.max_snapshot_usec / 1000.0,
+           stats.max_write_usec / 1000.0);
+
+    tox_pass_key_free(toxic.client_data.pass_key);
+    tox_kill(tox);
+    unlink(path);
+
+    return 0;
+}
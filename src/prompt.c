@@ -59,6 +59,7 @@ static const char *const glob_cmd_list[] = {
     "/nospam",
     "/quit",
     "/requests",
+    "/savestats",
     "/status",
 
 #ifdef AUDIO
@@ -91,6 +92,7 @@ void kill_prompt_window(ToxWindow *self, Windows *windows, const Client_Config *
     if (ctx != NULL)  {
         log_disable(ctx->log);
         line_info_cleanup(ctx->hst);
+        free_line_hist(ctx);
 
         delwin(ctx->linewin);
         delwin(ctx->history);
@@ -240,16 +242,16 @@ static bool prompt_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
     if (key == '\t') {    /* TAB key: auto-completes command */
         input_ret = true;
 
-        if (ctx->len > 1 && ctx->line[0] == '/') {
+        if (ctx->len > 1 && line_buf_char(ctx, 0) == '/') {
             int diff;
 
-            if (wcsncmp(ctx->line, L"/avatar ", wcslen(L"/avatar ")) == 0) {
-                diff = dir_match(self, toxic, ctx->line, L"/avatar");
+            if (wcsncmp(get_line_buf(ctx), L"/avatar ", wcslen(L"/avatar ")) == 0) {
+                diff = dir_match(self, toxic, get_line_buf(ctx), L"/avatar");
             }
 
 #ifdef PYTHON
-            else if (wcsncmp(ctx->line, L"/run ", wcslen(L"/run ")) == 0) {
-                diff = dir_match(self, toxic, ctx->line, L"/run");
+            else if (wcsncmp(get_line_buf(ctx), L"/run ", wcslen(L"/run ")) == 0) {
+                diff = dir_match(self, toxic, get_line_buf(ctx), L"/run");
             }
 
 #endif
@@ -260,7 +262,7 @@ static bool prompt_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
 
             if (diff != -1) {
                 if (x + diff > x2 - 1) {
-                    int wlen = MAX(0, wcswidth(ctx->line, sizeof(ctx->line) / sizeof(wchar_t)));
+                    int wlen = ctx->line_width;
                     ctx->start = wlen < x2 ? 0 : wlen - x2 + 1;
                 }
             } else {
@@ -274,11 +276,11 @@ static bool prompt_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
 
         rm_trailing_spaces_buf(ctx);
 
-        wstrsubst(ctx->line, L'¶', L'\n');
+        wstrsubst(get_line_buf(ctx), L'¶', L'\n');
 
         char line[MAX_STR_SIZE];
 
-        if (wcs_to_mbs_buf(line, ctx->line, MAX_STR_SIZE) == -1) {
+        if (wcs_to_mbs_buf(line, get_line_buf(ctx), MAX_STR_SIZE) == -1) {
             memset(line, 0, sizeof(line));
             line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, RED, " * Failed to parse message.");
         }
@@ -286,7 +288,7 @@ static bool prompt_onKey(ToxWindow *self, Toxic *toxic, wint_t key, bool ltr)
         const bool contains_blocked_word = string_contains_blocked_word(line, &toxic->client_data);
 
         if (line[0] != '\0' && !contains_blocked_word) {
-            add_line_to_hist(ctx);
+            add_line_to_hist(ctx, &toxic->client_data.input_history, line);
 
             if (strcmp(line, "/clear") != 0) {
                 line_info_add(self, c_config, false, NULL, NULL, PROMPT, 0, 0, "%s", line);
@@ -405,7 +407,9 @@ static void prompt_onDraw(ToxWindow *self, Toxic *toxic)
     wclear(ctx->linewin);
 
     if (ctx->len > 0) {
-        mvwprintw(ctx->linewin, 0, 0, "%ls", &ctx->line[ctx->start]);
+        wchar_t line[MAX_STR_SIZE];
+        copy_line_buf(ctx, ctx->start, line);
+        mvwprintw(ctx->linewin, 0, 0, "%ls", line);
     }
 
     curs_set(1);
@@ -557,7 +561,7 @@ static void prompt_onDraw(ToxWindow *self, Toxic *toxic)
 
     UNUSED_VAR(x);
 
-    const int new_x = ctx->start ? x2 - 1 : MAX(0, wcswidth(ctx->line, ctx->pos));
+    const int new_x = ctx->start ? x2 - 1 : line_buf_cursor_width(ctx);
     wmove(self->window, y, new_x);
 
     draw_window_bar(self, toxic->windows);
@@ -787,6 +791,7 @@ static void prompt_onInit(ToxWindow *self, Toxic *toxic)
     }
 
     line_info_init(ctx->hst);
+    init_line_hist(ctx, &toxic->client_data.input_history, (const uint8_t *) "prompt", strlen("prompt"));
 
     prompt_init_log(toxic);
 
@@ -10,6 +10,7 @@
 #include "python_api.h"
 
 #include "api.h"
+#include "hash_index.h"
 #include "toxic.h"
 #include "execute.h"
 
@@ -25,6 +26,47 @@ static struct python_registered_func {
     struct python_registered_func *next;
 } python_commands = {0};
 
+/* The registered commands in the order they were registered, indexed by the hash of their name */
+static struct python_registered_func **python_command_slots;
+static uint32_t python_num_commands;
+static HashIndex python_command_index;
+
+static struct python_registered_func *python_find_command(const char *name)
+{
+    const uint32_t hash = hash_index_bytes(name, strlen(name));
+    size_t cursor = hash;
+    uint32_t slot;
+
+    while (hash_index_next(&python_command_index, hash, &cursor, &slot)) {
+        if (strcmp(python_command_slots[slot]->name, name) == 0) {
+            return python_command_slots[slot];
+        }
+    }
+
+    return NULL;
+}
+
+/* Returns false on allocation failure. */
+static bool python_index_command(struct python_registered_func *func)
+{
+    struct python_registered_func **slots = realloc(python_command_slots,
+                                            (python_num_commands + 1) * sizeof(struct python_registered_func *));
+
+    if (slots == NULL) {
+        return false;
+    }
+
+    python_command_slots = slots;
+
+    if (!hash_index_add(&python_command_index, hash_index_bytes(func->name, strlen(func->name)), python_num_commands)) {
+        return false;
+    }
+
+    python_command_slots[python_num_commands++] = func;
+
+    return true;
+}
+
 static PyObject *python_api_display(PyObject *self, PyObject *args)
 {
     const char *msg;
@@ -209,6 +251,10 @@ static PyObject *python_api_register(PyObject *self, PyObject *args)
             cur->next->callback = callback;
             cur->next->next     = NULL;
 
+            if (!python_index_command(cur->next)) {
+                return PyErr_NoMemory();
+            }
+
             const size_t msg_len = command_len + 64;
             char *msg = malloc(msg_len);
 
@@ -269,6 +315,11 @@ PyMODINIT_FUNC PyInit_toxic_api(void)
 
 void terminate_python(void)
 {
+    free(python_command_slots);
+    python_command_slots = NULL;
+    python_num_commands = 0;
+    hash_index_free(&python_command_index);
+
     free(python_commands.name);
 
     struct python_registered_func *cur = NULL;
@@ -308,35 +359,29 @@ int do_python_command(int num_args, char (*args)[MAX_STR_SIZE])
 
     int i;
     PyObject *callback_args, *args_strings;
-    struct python_registered_func *cur;
-
-    for (cur = &python_commands; cur != NULL; cur = cur->next) {
-        if (cur->name == NULL) {
-            continue;
-        }
-
-        if (!strcmp(args[0], cur->name)) {
-            PyGILState_STATE gstate = PyGILState_Ensure();
+    struct python_registered_func *cur = python_find_command(args[0]);
 
-            args_strings = PyList_New(0);
+    if (cur == NULL) {
+        return 1;
+    }
 
-            for (i = 1; i < num_args; i++) {
-                PyList_Append(args_strings, Py_BuildValue("s", args[i]));
-            }
+    PyGILState_STATE gstate = PyGILState_Ensure();
 
-            callback_args = PyTuple_Pack(1, args_strings);
+    args_strings = PyList_New(0);
 
-            if (PyObject_CallObject(cur->callback, callback_args) == NULL) {
-                api_display("Exception raised in callback function");
-            }
+    for (i = 1; i < num_args; i++) {
+        PyList_Append(args_strings, Py_BuildValue("s", args[i]));
+    }
 
-            PyGILState_Release(gstate);
+    callback_args = PyTuple_Pack(1, args_strings);
 
-            return 0;
-        }
+    if (PyObject_CallObject(cur->callback, callback_args) == NULL) {
+        api_display("Exception raised in callback function");
     }
 
-    return 1;
+    PyGILState_Release(gstate);
+
+    return 0;
 }
 
 int python_num_registered_handlers(void)
@@ -16,6 +16,7 @@
 #include "configdir.h"
 #include "friendlist.h"
 #include "groupchats.h"
+#include "hash_index.h"
 #include "misc_tools.h"
 #include "term_mplex.h"
 #include "notify.h"
@@ -58,12 +59,15 @@ static struct ui_strings {
     const char *native_colors;
     const char *autolog;
     const char *history_size;
+    const char *input_history_size;
+    const char *save_input_history;
     const char *notification_timeout;
     const char *show_typing_self;
     const char *show_typing_other;
     const char *show_welcome_msg;
     const char *show_connection_msg;
     const char *show_group_connection_msg;
+    const char *filter_blocked_words;
     const char *show_network_info;
     const char *nodeslist_update_freq;
     const char *autosave_freq;
@@ -100,12 +104,15 @@ static struct ui_strings {
     "native_colors",
     "autolog",
     "history_size",
+    "input_history_size",
+    "save_input_history",
     "notification_timeout",
     "show_typing_self",
     "show_typing_other",
     "show_welcome_msg",
     "show_connection_msg",
     "show_group_connection_msg",
+    "filter_blocked_words",
     "show_network_info",
     "nodeslist_update_freq",
     "autosave_freq",
@@ -141,12 +148,15 @@ static void ui_defaults(Client_Config *settings)
     settings->bell_on_filetrans_accept = 0;
     settings->bell_on_invite = 0;
     settings->history_size = 700;
+    settings->input_history_size = 10000;
+    settings->save_input_history = false;
     settings->notification_timeout = 6000;
     settings->show_typing_self = true;
     settings->show_typing_other = true;
     settings->show_welcome_msg = true;
     settings->show_connection_msg = true;
     settings->show_group_connection_msg = true;
+    settings->filter_blocked_words = false;
     settings->show_network_info = false;
     settings->nodeslist_update_freq = 1;
     settings->autosave_freq = 600;
@@ -175,6 +185,7 @@ static const struct keys_strings {
     const char *toggle_peerlist;
     const char *toggle_pastemode;
     const char *reload_config;
+    const char *history_search;
 } key_strings = {
 
     "keys",
@@ -188,6 +199,7 @@ static const struct keys_strings {
     "toggle_peerlist",
     "toggle_paste_mode",
     "reload_config",
+    "history_search",
 };
 
 /* defines from toxic.h */
@@ -203,6 +215,7 @@ static void key_defaults(Client_Config *settings)
     settings->key_toggle_peerlist = T_KEY_C_B;
     settings->key_toggle_pastemode = T_KEY_C_T;
     settings->key_reload_config = T_KEY_C_R;
+    settings->key_history_search = T_KEY_C_G;
 }
 
 static const struct tox_strings {
@@ -448,234 +461,429 @@ static const char *extract_setting_public_key(const config_setting_t *keys)
     return &public_key[prefix_len];
 }
 
-/*
- * Initializes `cfg` with the contents from the toxic config file.
- *
- * Return 0 on success.
- * Return -1 if the config file was not set by the client.
- * Return -2 if the config file cannot be read or is invalid.
- */
-static int settings_init_config(config_t *cfg, const Run_Options *run_opts)
+struct Settings_Tree {
+    config_t cfg;
+};
+
+Settings_Tree *settings_tree_read(const Run_Options *run_opts, int *error)
 {
     if (string_is_empty(run_opts->config_path)) {
-        return -1;
+        *error = -1;
+        return NULL;
     }
 
-    if (!config_read_file(cfg, run_opts->config_path)) {
-        fprintf(stderr, "config_read_file() error: %s:%d - %s\n", config_error_file(cfg),
-                config_error_line(cfg), config_error_text(cfg));
-        return -2;
+    Settings_Tree *tree = malloc(sizeof(Settings_Tree));
+
+    if (tree == NULL) {
+        *error = -3;
+        return NULL;
     }
 
-    return 0;
+    config_init(&tree->cfg);
+
+    if (!config_read_file(&tree->cfg, run_opts->config_path)) {
+        fprintf(stderr, "config_read_file() error: %s:%d - %s\n", config_error_file(&tree->cfg),
+                config_error_line(&tree->cfg), config_error_text(&tree->cfg));
+        settings_tree_free(tree);
+        *error = -2;
+        return NULL;
+    }
+
+    *error = 0;
+
+    return tree;
 }
 
-int settings_load_conferences(Windows *windows, const Run_Options *run_opts)
+void settings_tree_free(Settings_Tree *tree)
 {
-    config_t cfg[1];
-    config_init(cfg);
+    if (tree == NULL) {
+        return;
+    }
 
-    const int c_ret = settings_init_config(cfg, run_opts);
+    config_destroy(&tree->cfg);
+    free(tree);
+}
 
-    if (c_ret < 0) {
-        config_destroy(cfg);
-        return c_ret;
+/* Returns the section named `name`, or NULL if `tree` is NULL or has no such section. */
+static const config_setting_t *settings_tree_section(const Settings_Tree *tree, const char *name)
+{
+    if (tree == NULL) {
+        return NULL;
     }
 
-    const char *str = NULL;
+    return config_lookup(&tree->cfg, name);
+}
+
+/* Returns true if `a` and `b` hold the same settings with the same values, in the same order. */
+static bool settings_equal(const config_setting_t *a, const config_setting_t *b)
+{
+    if (a == NULL || b == NULL) {
+        return a == b;
+    }
 
-    const config_setting_t *setting = config_lookup(cfg, conference_strings.self);
+    const int type = config_setting_type(a);
 
-    if (setting == NULL) {
-        config_destroy(cfg);
-        return 0;
+    if (type != config_setting_type(b)) {
+        return false;
     }
 
-    const int num_conferences = config_setting_length(setting);
+    switch (type) {
+        case CONFIG_TYPE_INT:
+            return config_setting_get_int(a) == config_setting_get_int(b);
 
-    for (int i = 0; i < num_conferences; ++i) {
-        const config_setting_t *keys = config_setting_get_elem(setting, i);
+        case CONFIG_TYPE_INT64:
+            return config_setting_get_int64(a) == config_setting_get_int64(b);
 
-        const char *public_key = extract_setting_public_key(keys);
+        case CONFIG_TYPE_FLOAT:
+            return config_setting_get_float(a) == config_setting_get_float(b);
 
-        if (public_key == NULL) {
-            continue;
+        case CONFIG_TYPE_BOOL:
+            return config_setting_get_bool(a) == config_setting_get_bool(b);
+
+        case CONFIG_TYPE_STRING: {
+            const char *str_a = config_setting_get_string(a);
+            const char *str_b = config_setting_get_string(b);
+            return str_a != NULL && str_b != NULL ? strcmp(str_a, str_b) == 0 : str_a == str_b;
         }
 
-        if (config_setting_lookup_string(keys, conference_strings.tab_name_color, &str)) {
-            if (!conference_config_set_tab_name_colour(windows, public_key, str)) {
-                fprintf(stderr, "config error: failed to set conference tab name color for %s: (color: %s)\n", public_key, str);
-            }
+        default:
+            break;
+    }
+
+    const int length = config_setting_length(a);
+
+    if (length != config_setting_length(b)) {
+        return false;
+    }
+
+    for (int i = 0; i < length; ++i) {
+        const config_setting_t *elem_a = config_setting_get_elem(a, i);
+        const config_setting_t *elem_b = config_setting_get_elem(b, i);
+        const char *name_a = config_setting_name(elem_a);
+        const char *name_b = config_setting_name(elem_b);
+
+        if (name_a != NULL && name_b != NULL ? strcmp(name_a, name_b) != 0 : name_a != name_b) {
+            return false;
         }
 
-        int autolog_enabled;
+        if (!settings_equal(elem_a, elem_b)) {
+            return false;
+        }
+    }
 
-        if (config_setting_lookup_bool(keys, conference_strings.autolog, &autolog_enabled)) {
-            if (!conference_config_set_autolog(windows, public_key, autolog_enabled != 0)) {
-                fprintf(stderr, "config error: failed to apply conference autolog setting for %s\n", public_key);
+    return true;
+}
+
+/* Returns true if any top level setting outside of the per-contact sections and the blocked
+ * words list differs between `a` and `b`.
+ */
+static bool settings_main_changed(const Settings_Tree *a, const Settings_Tree *b)
+{
+    const char *const skipped[] = {
+        friend_strings.self, groupchat_strings.self, conference_strings.self, blocked_words.self
+    };
+
+    const Settings_Tree *trees[] = { a, b };
+
+    for (size_t t = 0; t < 2; ++t) {
+        const config_setting_t *root = config_root_setting(&trees[t]->cfg);
+        const Settings_Tree *other = trees[1 - t];
+
+        for (int i = 0; i < config_setting_length(root); ++i) {
+            const config_setting_t *setting = config_setting_get_elem(root, i);
+            const char *name = config_setting_name(setting);
+            bool skip = false;
+
+            for (size_t j = 0; j < sizeof(skipped) / sizeof(skipped[0]); ++j) {
+                skip |= strcmp(name, skipped[j]) == 0;
+            }
+
+            if (!skip && !settings_equal(setting, config_lookup(&other->cfg, name))) {
+                return true;
             }
         }
     }
 
-    config_destroy(cfg);
+    return false;
+}
 
-    return 0;
+typedef void settings_entry_cb(void *object, const config_setting_t *keys, const char *public_key);
+
+/* Calls `apply` on each entry in `section` that has a valid public key. */
+static void settings_apply_section(const config_setting_t *section, settings_entry_cb *apply, void *object)
+{
+    if (section == NULL) {
+        return;
+    }
+
+    const int num_entries = config_setting_length(section);
+
+    for (int i = 0; i < num_entries; ++i) {
+        const config_setting_t *keys = config_setting_get_elem(section, i);
+        const char *public_key = extract_setting_public_key(keys);
+
+        if (public_key != NULL) {
+            apply(object, keys, public_key);
+        }
+    }
 }
 
-int settings_load_groups(Windows *windows, const Run_Options *run_opts)
+/*
+ * Calls `apply` on the entry in `section` for the contact with `public_key`, if it has one.
+ * Entries with invalid names are skipped quietly, since settings_apply_section() has already
+ * reported them.
+ */
+static void settings_apply_contact(const config_setting_t *section, const uint8_t *public_key,
+                                   settings_entry_cb *apply, void *object)
 {
-    config_t cfg[1];
-    config_init(cfg);
+    if (section == NULL) {
+        return;
+    }
+
+    const size_t prefix_len = strlen(TOXIC_CONFIG_PUBLIC_KEY_PREFIX);
+    const int num_entries = config_setting_length(section);
+
+    for (int i = 0; i < num_entries; ++i) {
+        const config_setting_t *keys = config_setting_get_elem(section, i);
+        const char *name = config_setting_name(keys);
+
+        if (name == NULL || strlen(name) != TOX_PUBLIC_KEY_SIZE * 2 + prefix_len
+                || memcmp(name, TOXIC_CONFIG_PUBLIC_KEY_PREFIX, prefix_len) != 0) {
+            continue;
+        }
 
-    const int c_ret = settings_init_config(cfg, run_opts);
+        char key[TOX_PUBLIC_KEY_SIZE];
 
-    if (c_ret < 0) {
-        config_destroy(cfg);
-        return c_ret;
+        if (tox_pk_string_to_bytes(&name[prefix_len], TOX_PUBLIC_KEY_SIZE * 2, key, sizeof(key)) == 0
+                && memcmp(key, public_key, TOX_PUBLIC_KEY_SIZE) == 0) {
+            apply(object, keys, &name[prefix_len]);
+            return;
+        }
     }
+}
 
-    const char *str = NULL;
+/*
+ * Calls `apply` on the entries of `new_section` that were added or changed since `old_section`,
+ * after calling `reset` (if non-NULL) on each entry that changed or was removed. Entries are
+ * matched by name through a hash index, so this is linear in the size of the sections.
+ *
+ * On allocation failure every entry of `new_section` is applied instead.
+ */
+static void settings_diff_section(const config_setting_t *old_section, const config_setting_t *new_section,
+                                 settings_entry_cb *apply, settings_entry_cb *reset, void *object)
+{
+    const int num_old = old_section != NULL ? config_setting_length(old_section) : 0;
+    const int num_new = new_section != NULL ? config_setting_length(new_section) : 0;
 
-    const config_setting_t *setting = config_lookup(cfg, groupchat_strings.self);
+    HashIndex old_index = {0};
+    bool *matched = calloc(MAX(1, num_old), sizeof(bool));
 
-    if (setting == NULL) {
-        config_destroy(cfg);
-        return 0;
+    if (matched == NULL) {
+        settings_apply_section(new_section, apply, object);
+        return;
     }
 
-    const int num_groups = config_setting_length(setting);
+    for (int i = 0; i < num_old; ++i) {
+        const char *name = config_setting_name(config_setting_get_elem(old_section, i));
 
-    for (int i = 0; i < num_groups; ++i) {
-        const config_setting_t *keys = config_setting_get_elem(setting, i);
+        if (name != NULL && !hash_index_add(&old_index, hash_index_bytes(name, strlen(name)), i)) {
+            hash_index_free(&old_index);
+            free(matched);
+            settings_apply_section(new_section, apply, object);
+            return;
+        }
+    }
 
+    for (int i = 0; i < num_new; ++i) {
+        const config_setting_t *keys = config_setting_get_elem(new_section, i);
         const char *public_key = extract_setting_public_key(keys);
 
         if (public_key == NULL) {
             continue;
         }
 
-        if (config_setting_lookup_string(keys, groupchat_strings.tab_name_color, &str)) {
-            if (!groupchat_config_set_tab_name_colour(windows, public_key, str)) {
-                fprintf(stderr, "config error: failed to set groupchat tab name color for %s: (color: %s)\n", public_key, str);
+        const char *name = config_setting_name(keys);
+        const uint32_t hash = hash_index_bytes(name, strlen(name));
+        size_t cursor = hash;
+        uint32_t slot;
+        const config_setting_t *old_keys = NULL;
+
+        while (hash_index_next(&old_index, hash, &cursor, &slot)) {
+            const config_setting_t *candidate = config_setting_get_elem(old_section, slot);
+
+            if (!matched[slot] && strcmp(config_setting_name(candidate), name) == 0) {
+                matched[slot] = true;
+                old_keys = candidate;
+                break;
             }
         }
 
-        int autolog_enabled;
+        if (old_keys != NULL && settings_equal(old_keys, keys)) {
+            continue;
+        }
 
-        if (config_setting_lookup_bool(keys, groupchat_strings.autolog, &autolog_enabled)) {
-            if (!groupchat_config_set_autolog(windows, public_key, autolog_enabled != 0)) {
-                fprintf(stderr, "config error: failed to apply groupchat autolog setting for %s\n", public_key);
-            }
+        if (old_keys != NULL && reset != NULL) {
+            reset(object, old_keys, public_key);
         }
+
+        apply(object, keys, public_key);
     }
 
-    config_destroy(cfg);
+    for (int i = 0; i < num_old && reset != NULL; ++i) {
+        const config_setting_t *keys = config_setting_get_elem(old_section, i);
+        const char *public_key = matched[i] ? NULL : extract_setting_public_key(keys);
 
-    return 0;
+        if (public_key != NULL) {
+            reset(object, keys, public_key);
+        }
+    }
+
+    hash_index_free(&old_index);
+    free(matched);
 }
 
-int settings_load_friends(FriendsList *friends, const Run_Options *run_opts)
+static void settings_apply_conference(void *object, const config_setting_t *keys, const char *public_key)
 {
-    config_t cfg[1];
-    config_init(cfg);
+    Windows *windows = (Windows *) object;
+    const char *str = NULL;
+
+    if (config_setting_lookup_string(keys, conference_strings.tab_name_color, &str)) {
+        if (!conference_config_set_tab_name_colour(windows, public_key, str)) {
+            fprintf(stderr, "config error: failed to set conference tab name color for %s: (color: %s)\n", public_key, str);
+        }
+    }
 
-    const int c_ret = settings_init_config(cfg, run_opts);
+    int autolog_enabled;
 
-    if (c_ret < 0) {
-        config_destroy(cfg);
-        return c_ret;
+    if (config_setting_lookup_bool(keys, conference_strings.autolog, &autolog_enabled)) {
+        if (!conference_config_set_autolog(windows, public_key, autolog_enabled != 0)) {
+            fprintf(stderr, "config error: failed to apply conference autolog setting for %s\n", public_key);
+        }
     }
+}
 
-    const char *str = NULL;
+void settings_load_conference(Windows *windows, const Settings_Tree *tree, const uint8_t *conference_id)
+{
+    settings_apply_contact(settings_tree_section(tree, conference_strings.self), conference_id,
+                           settings_apply_conference, windows);
+}
 
-    const config_setting_t *setting = config_lookup(cfg, friend_strings.self);
+static void settings_apply_group(void *object, const config_setting_t *keys, const char *public_key)
+{
+    Windows *windows = (Windows *) object;
+    const char *str = NULL;
 
-    if (setting == NULL) {
-        config_destroy(cfg);
-        return 0;
+    if (config_setting_lookup_string(keys, groupchat_strings.tab_name_color, &str)) {
+        if (!groupchat_config_set_tab_name_colour(windows, public_key, str)) {
+            fprintf(stderr, "config error: failed to set groupchat tab name color for %s: (color: %s)\n", public_key, str);
+        }
     }
 
-    const int num_friends = config_setting_length(setting);
+    int autolog_enabled;
 
-    for (int i = 0; i < num_friends; ++i) {
-        const config_setting_t *keys = config_setting_get_elem(setting, i);
+    if (config_setting_lookup_bool(keys, groupchat_strings.autolog, &autolog_enabled)) {
+        if (!groupchat_config_set_autolog(windows, public_key, autolog_enabled != 0)) {
+            fprintf(stderr, "config error: failed to apply groupchat autolog setting for %s\n", public_key);
+        }
+    }
+}
 
-        const char *public_key = extract_setting_public_key(keys);
+void settings_load_group(Windows *windows, const Settings_Tree *tree, const uint8_t *chat_id)
+{
+    settings_apply_contact(settings_tree_section(tree, groupchat_strings.self), chat_id, settings_apply_group,
+                           windows);
+}
 
-        if (public_key == NULL) {
-            continue;
-        }
+typedef struct Friend_Settings_Target {
+    FriendsList *friends;
+    const Client_Config *c_config;
+} Friend_Settings_Target;
 
-        if (config_setting_lookup_string(keys, friend_strings.tab_name_color, &str)) {
-            if (!friend_config_set_tab_name_colour(friends, public_key, str)) {
-                fprintf(stderr, "config error: failed to set friend tab name color for %s: (color: %s)\n",
-                        public_key, str);
-            }
+static void settings_apply_friend(void *object, const config_setting_t *keys, const char *public_key)
+{
+    FriendsList *friends = ((Friend_Settings_Target *) object)->friends;
+    const char *str = NULL;
+
+    if (config_setting_lookup_string(keys, friend_strings.tab_name_color, &str)) {
+        if (!friend_config_set_tab_name_colour(friends, public_key, str)) {
+            fprintf(stderr, "config error: failed to set friend tab name color for %s: (color: %s)\n",
+                    public_key, str);
         }
+    }
 
-        int autolog_enabled;
+    int autolog_enabled;
 
-        if (config_setting_lookup_bool(keys, friend_strings.autolog, &autolog_enabled)) {
-            if (!friend_config_set_autolog(friends, public_key, autolog_enabled != 0)) {
-                fprintf(stderr, "config error: failed to apply friend autolog setting for: %s\n", public_key);
-            }
+    if (config_setting_lookup_bool(keys, friend_strings.autolog, &autolog_enabled)) {
+        if (!friend_config_set_autolog(friends, public_key, autolog_enabled != 0)) {
+            fprintf(stderr, "config error: failed to apply friend autolog setting for: %s\n", public_key);
         }
+    }
 
-        int auto_accept_files;
+    int auto_accept_files;
 
-        if (config_setting_lookup_bool(keys, friend_strings.auto_accept_files, &auto_accept_files)) {
-            if (!friend_config_set_auto_accept_files(friends, public_key, auto_accept_files != 0)) {
-                fprintf(stderr,
-                        "config error: failed to apply friend auto-accept filetransfers setting for: %s\n",
-                        public_key);
-            }
+    if (config_setting_lookup_bool(keys, friend_strings.auto_accept_files, &auto_accept_files)) {
+        if (!friend_config_set_auto_accept_files(friends, public_key, auto_accept_files != 0)) {
+            fprintf(stderr,
+                    "config error: failed to apply friend auto-accept filetransfers setting for: %s\n",
+                    public_key);
         }
+    }
 
-        int show_connection_msg;
+    int show_connection_msg;
 
-        if (config_setting_lookup_bool(keys, friend_strings.show_connection_msg, &show_connection_msg)) {
-            if (!friend_config_set_show_connection_msg(friends, public_key, show_connection_msg != 0)) {
-                fprintf(stderr,
-                        "config error: failed to apply friend show connection message setting for: %s\n",
-                        public_key);
-            }
+    if (config_setting_lookup_bool(keys, friend_strings.show_connection_msg, &show_connection_msg)) {
+        if (!friend_config_set_show_connection_msg(friends, public_key, show_connection_msg != 0)) {
+            fprintf(stderr,
+                    "config error: failed to apply friend show connection message setting for: %s\n",
+                    public_key);
         }
+    }
 
-        if (config_setting_lookup_string(keys, friend_strings.alias, &str)) {
-            if (!friend_config_set_alias(friends, public_key, str, strlen(str))) {
-                fprintf(stderr, "config error: failed to apply alias '%s' for: %s\n", str, public_key);
-            }
+    if (config_setting_lookup_string(keys, friend_strings.alias, &str)) {
+        if (!friend_config_set_alias(friends, public_key, str, strlen(str))) {
+            fprintf(stderr, "config error: failed to apply alias '%s' for: %s\n", str, public_key);
         }
     }
+}
 
-    config_destroy(cfg);
+static void settings_reset_friend(void *object, const config_setting_t *keys, const char *public_key)
+{
+    UNUSED_VAR(keys);
 
-    return 0;
+    const Friend_Settings_Target *target = (const Friend_Settings_Target *) object;
+    friend_config_reset(target->friends, public_key, target->c_config);
 }
 
-int settings_load_blocked_words(Client_Data *client_data, const Run_Options *run_opts)
+void settings_load_friends(FriendsList *friends, const Settings_Tree *tree)
 {
-    config_t cfg[1];
-    config_init(cfg);
+    Friend_Settings_Target target = {
+        friends, NULL
+    };
 
-    const int c_ret = settings_init_config(cfg, run_opts);
+    settings_apply_section(settings_tree_section(tree, friend_strings.self), settings_apply_friend, &target);
+}
 
-    if (c_ret < 0) {
-        config_destroy(cfg);
-        return c_ret;
-    }
+void settings_load_friend(FriendsList *friends, const Settings_Tree *tree, const uint8_t *public_key)
+{
+    Friend_Settings_Target target = {
+        friends, NULL
+    };
 
-    const config_setting_t *setting = config_lookup(cfg, blocked_words.self);
+    settings_apply_contact(settings_tree_section(tree, friend_strings.self), public_key, settings_apply_friend,
+                           &target);
+}
+
+int settings_load_blocked_words(Client_Data *client_data, const Settings_Tree *tree)
+{
+    const config_setting_t *setting = settings_tree_section(tree, blocked_words.self);
 
     if (setting == NULL) {
-        config_destroy(cfg);
         return 0;
     }
 
     const int list_size = config_setting_length(setting);
 
     if (list_size <= 0) {
-        config_destroy(cfg);
         return 0;
     }
 
@@ -684,8 +892,7 @@ int settings_load_blocked_words(Client_Data *client_data, const Run_Options *run
 
     if (words_list == NULL) {
         fprintf(stderr, "config error: failed to allocate memory for blocked words list.\n");
-        config_destroy(cfg);
-        return -3;
+        return -1;
     }
 
     size_t num_blocked_words = 0;
@@ -705,15 +912,20 @@ int settings_load_blocked_words(Client_Data *client_data, const Run_Options *run
         ++num_blocked_words;
     }
 
-    client_data->blocked_words = words_list;
-    client_data->num_blocked_words = num_blocked_words;
+    const bool compiled = word_filter_init(&client_data->blocked_words, (const char *const *) words_list,
+                                           num_blocked_words);
 
-    config_destroy(cfg);
+    free_ptr_array((void **) words_list);
+
+    if (!compiled) {
+        fprintf(stderr, "config error: failed to compile blocked words list.\n");
+        return -1;
+    }
 
     return 0;
 }
 
-static void settings_load_ui(config_t *cfg, Client_Config *s)
+static void settings_load_ui(const config_t *cfg, Client_Config *s)
 {
     config_setting_t *setting = config_lookup(cfg, ui_strings.self);
     const char *str = NULL;
@@ -812,11 +1024,24 @@ static void settings_load_ui(config_t *cfg, Client_Config *s)
         s->show_group_connection_msg = bool_val != 0;
     }
 
+    if (config_setting_lookup_bool(setting, ui_strings.filter_blocked_words, &bool_val)) {
+        s->filter_blocked_words = bool_val != 0;
+    }
+
     if (config_setting_lookup_bool(setting, ui_strings.show_network_info, &bool_val)) {
         s->show_network_info = bool_val != 0;
     }
 
     config_setting_lookup_int(setting, ui_strings.history_size, &s->history_size);
+
+    if (config_setting_lookup_int(setting, ui_strings.input_history_size, &s->input_history_size)) {
+        s->input_history_size = MAX(0, MIN(s->input_history_size, MAX_INPUT_HISTORY));
+    }
+
+    if (config_setting_lookup_bool(setting, ui_strings.save_input_history, &bool_val)) {
+        s->save_input_history = bool_val != 0;
+    }
+
     config_setting_lookup_int(setting, ui_strings.notification_timeout, &s->notification_timeout);
     config_setting_lookup_int(setting, ui_strings.nodeslist_update_freq, &s->nodeslist_update_freq);
     config_setting_lookup_int(setting, ui_strings.autosave_freq, &s->autosave_freq);
@@ -859,7 +1084,7 @@ static void settings_load_ui(config_t *cfg, Client_Config *s)
     }
 }
 
-static void settings_load_paths(config_t *cfg, Client_Config *s)
+static void settings_load_paths(const config_t *cfg, Client_Config *s)
 {
     config_setting_t *setting = config_lookup(cfg, tox_strings.self);
     const char *str = NULL;
@@ -928,7 +1153,7 @@ static void settings_load_paths(config_t *cfg, Client_Config *s)
     }
 }
 
-static void settings_load_keys(config_t *cfg, Client_Config *s)
+static void settings_load_keys(const config_t *cfg, Client_Config *s)
 {
     config_setting_t *setting = config_lookup(cfg, key_strings.self);
     const char *tmp = NULL;
@@ -976,10 +1201,14 @@ static void settings_load_keys(config_t *cfg, Client_Config *s)
     if (config_setting_lookup_string(setting, key_strings.reload_config, &tmp)) {
         set_key_binding(&s->key_reload_config, &tmp);
     }
+
+    if (config_setting_lookup_string(setting, key_strings.history_search, &tmp)) {
+        set_key_binding(&s->key_history_search, &tmp);
+    }
 }
 
 #ifdef AUDIO
-static void settings_load_audio(config_t *cfg, Client_Config *s)
+static void settings_load_audio(const config_t *cfg, Client_Config *s)
 {
     config_setting_t *setting = config_lookup(cfg, audio_strings.self);
     int bool_val;
@@ -1011,7 +1240,7 @@ static void settings_load_audio(config_t *cfg, Client_Config *s)
 #endif
 
 #ifdef SOUND_NOTIFY
-static void settings_load_sounds(config_t *cfg, Client_Config *s)
+static void settings_load_sounds(const config_t *cfg, Client_Config *s)
 {
     config_setting_t *setting = config_lookup(cfg, sound_strings.self);
     const char *str = NULL;
@@ -1086,11 +1315,8 @@ static void settings_load_sounds(config_t *cfg, Client_Config *s)
 
 #endif
 
-int settings_load_main(Client_Config *s, const Run_Options *run_opts)
+void settings_load_main(Client_Config *s, const Settings_Tree *tree)
 {
-    config_t cfg[1];
-    config_init(cfg);
-
     /* Load default settings */
     ui_defaults(s);
     tox_defaults(s);
@@ -1100,13 +1326,12 @@ int settings_load_main(Client_Config *s, const Run_Options *run_opts)
     audio_defaults(s);
 #endif
 
-    const int c_ret = settings_init_config(cfg, run_opts);
-
-    if (c_ret < 0) {
-        config_destroy(cfg);
-        return c_ret;
+    if (tree == NULL) {
+        return;
     }
 
+    const config_t *cfg = &tree->cfg;
+
     settings_load_ui(cfg, s);
     settings_load_paths(cfg, s);
     settings_load_keys(cfg, s);
@@ -1118,9 +1343,6 @@ int settings_load_main(Client_Config *s, const Run_Options *run_opts)
 #ifdef SOUND_NOTIFY
     settings_load_sounds(cfg, s);
 #endif
-
-    config_destroy(cfg);
-    return 0;
 }
 
 void settings_reload(Toxic *toxic)
@@ -1130,46 +1352,64 @@ void settings_reload(Toxic *toxic)
     const Run_Options *run_opts = toxic->run_opts;
     Windows *windows = toxic->windows;
 
-    int ret = settings_load_main(c_config, run_opts);
+    int err;
+    Settings_Tree *tree = settings_tree_read(run_opts, &err);
 
-    if (ret < 0) {
-        fprintf(stderr, "Failed to reload global settings (error %d)\n", ret);
+    if (tree == NULL) {
+        fprintf(stderr, "Failed to reload settings (error %d)\n", err);
+        return;
     }
 
-    friend_reset_default_config_settings(toxic->friends, c_config);
+    const Settings_Tree *old_tree = toxic->settings_tree;
+    const bool main_changed = old_tree == NULL || settings_main_changed(old_tree, tree);
+
+    Friend_Settings_Target friend_target = {
+        toxic->friends, c_config
+    };
 
-    ret = settings_load_friends(toxic->friends, run_opts);
+    if (main_changed) {
+        settings_load_main(c_config, tree);
 
-    if (ret < 0) {
-        fprintf(stderr, "Failed to reload friend settings (error %d)\n", ret);
+        /* Friend defaults come from the main settings, so every friend has to be re-applied */
+        friend_reset_default_config_settings(toxic->friends, c_config);
+        settings_load_friends(toxic->friends, tree);
+    } else {
+        settings_diff_section(settings_tree_section(old_tree, friend_strings.self),
+                              settings_tree_section(tree, friend_strings.self),
+                              settings_apply_friend, settings_reset_friend, &friend_target);
     }
 
-    ret = settings_load_conferences(windows, run_opts);
+    settings_diff_section(settings_tree_section(old_tree, conference_strings.self),
+                          settings_tree_section(tree, conference_strings.self),
+                          settings_apply_conference, NULL, windows);
 
-    if (ret < 0) {
-        fprintf(stderr, "Failed to reload conference settings (error %d)\n", ret);
-    }
+    settings_diff_section(settings_tree_section(old_tree, groupchat_strings.self),
+                          settings_tree_section(tree, groupchat_strings.self),
+                          settings_apply_group, NULL, windows);
 
-    ret = settings_load_groups(windows, run_opts);
+    if (!settings_equal(settings_tree_section(old_tree, blocked_words.self),
+                        settings_tree_section(tree, blocked_words.self))) {
+        word_filter_free(&client_data->blocked_words);
 
-    if (ret < 0) {
-        fprintf(stderr, "Failed to reload group settings (error %d)\n", ret);
+        if (settings_load_blocked_words(client_data, tree) < 0) {
+            fprintf(stderr, "Failed to reload blocked words list\n");
+        }
     }
 
-    free_ptr_array((void **) client_data->blocked_words);
-    client_data->blocked_words = NULL;
+    settings_tree_free(toxic->settings_tree);
+    toxic->settings_tree = tree;
 
-    ret = settings_load_blocked_words(client_data, run_opts);
+    if (main_changed) {
+        if (init_mplex_away_timer(toxic) == -1) {
+            fprintf(stderr, "Failed to initialize mplex auto-away.\n");
+        }
 
-    if (ret < 0) {
-        fprintf(stderr, "Failed to reload blocked words list (error %d)\n", ret);
+        endwin();
+        init_term(c_config, NULL, run_opts->default_locale);
     }
 
-    if (init_mplex_away_timer(toxic) == -1) {
-        fprintf(stderr, "Failed to initialize mplex auto-away.\n");
-    }
+    // The timestamp formats may have changed
+    reset_time_str_cache();
 
-    endwin();
-    init_term(c_config, NULL, run_opts->default_locale);
     refresh_window_names(toxic);
 }
@@ -22,6 +22,9 @@
 
 #define PASSWORD_EVAL_MAX 512
 
+/* The most lines input_history_size can be set to */
+#define MAX_INPUT_HISTORY 1000000
+
 typedef struct Toxic Toxic;
 typedef struct Client_Data Client_Data;
 typedef struct FriendsList FriendsList;
@@ -36,6 +39,7 @@ typedef struct Client_Config {
     bool show_welcome_msg;
     bool show_connection_msg;
     bool show_group_connection_msg;
+    bool filter_blocked_words;    /* Hide incoming group and conference messages containing a blocked word */
     bool show_timestamps;
     bool show_network_info;
 
@@ -48,6 +52,8 @@ typedef struct Client_Config {
     char log_timestamp_format[TIME_STR_SIZE];
 
     int history_size;      /* int between MIN_HISTORY and MAX_HISTORY */
+    int input_history_size;    /* Lines typed in all windows that are kept for the history search */
+    bool save_input_history;
     int notification_timeout;
     int device_cooldown;
     int nodeslist_update_freq;  /* <= 0 to disable updates */
@@ -82,6 +88,7 @@ typedef struct Client_Config {
     int key_toggle_peerlist;
     int key_toggle_pastemode;
     int key_reload_config;
+    int key_history_search;
 
     bool mplex_away; /*  true for reaction to terminal attach/detach */
     char mplex_away_note [TOX_MAX_STATUS_MESSAGE_LENGTH];
@@ -127,64 +134,64 @@ typedef struct Windows Windows;
  */
 bool settings_load_config_file(Run_Options *run_opts, const Paths *paths, const char *data_path);
 
+/* The parsed contents of the toxic config file, read once and shared by the `settings_load` functions. */
+typedef struct Settings_Tree Settings_Tree;
+
 /*
- * Loads general toxic settings from the toxic config file pointed to by `patharg'.
+ * Reads and parses the toxic config file.
  *
- * Return 0 on success.
- * Return -1 if we fail to open the file path.
- * Return -2 if libconfig fails to read the config file.
+ * Returns the parsed tree on success, which must be freed with `settings_tree_free()`.
+ * Returns NULL on failure and sets `error` to:
+ *   -1 if the config file was not set by the client.
+ *   -2 if libconfig fails to read the config file.
+ *   -3 if memory allocation fails.
  */
-int settings_load_main(Client_Config *s, const Run_Options *run_opts);
+Settings_Tree *settings_tree_read(const Run_Options *run_opts, int *error);
+
+void settings_tree_free(Settings_Tree *tree);
 
 /*
- * Loads friend config settings from the toxic config file pointed to by `patharg`.
- * If `patharg` is null, the default config path is used.
- *
- * Return 0 on success (or if no config entry for friends exists).
- * Return -1 if we fail to open the file path.
- * Return -2 if libconfig fails to read the config file.
+ * Loads general toxic settings from `tree`. Settings missing from `tree`, or all of them if
+ * `tree` is NULL, are set to their defaults.
+ */
+void settings_load_main(Client_Config *s, const Settings_Tree *tree);
+
+/*
+ * Loads friend config settings from `tree`. Does nothing if `tree` is NULL.
  *
  * This function will have no effect on friends that are added in the future.
  */
-int settings_load_friends(FriendsList *friends, const Run_Options *run_opts);
+void settings_load_friends(FriendsList *friends, const Settings_Tree *tree);
 
 /*
- * Loads groupchat config settings from the toxic config file pointed to by `patharg`.
- * If `patharg` is null, the default config path is used.
- *
- * Return 0 on success (or if no config entry for groupchats exists).
- * Return -1 if we fail to open the file path.
- * Return -2 if libconfig fails to read the config file.
- *
- * This function will have no effect on groupchat instances that are created in the future.
+ * Loads the config settings in `tree` for the friend with `public_key`, for friends added after
+ * the config file was loaded. Does nothing if `tree` is NULL or has no entry for the friend.
  */
-int settings_load_groups(Windows *windows, const Run_Options *run_opts);
+void settings_load_friend(FriendsList *friends, const Settings_Tree *tree, const uint8_t *public_key);
 
 /*
- * Loads conference config settings from the toxic config file pointed to by `patharg`.
- * If `patharg` is null, the default config path is used.
- *
- * Return 0 on success (or if no config entry for conferences exists).
- * Return -1 if we fail to open the file path.
- * Return -2 if libconfig fails to read the config file.
- *
- * This function will have no effect on conference instances that are created in the future.
+ * Loads the config settings in `tree` for the groupchat with `chat_id`. Called whenever a
+ * groupchat window is created. Does nothing if `tree` is NULL or has no entry for the group.
+ */
+void settings_load_group(Windows *windows, const Settings_Tree *tree, const uint8_t *chat_id);
+
+/*
+ * Loads the config settings in `tree` for the conference with `conference_id`. Called whenever a
+ * conference window is created. Does nothing if `tree` is NULL or has no entry for the conference.
  */
-int settings_load_conferences(Windows *windows, const Run_Options *run_opts);
+void settings_load_conference(Windows *windows, const Settings_Tree *tree, const uint8_t *conference_id);
 
 /*
- * Loads the blocked words list from the toxic config file pointed to by `patharg`.
- * If `patharg` is null, the default config path is used.
+ * Loads the blocked words list from `tree`.
  *
- * Return 0 on success (or if no list exists in the config file).
- * Return -1 if we fail to open the file path.
- * Return -2 if libconfig fails to read the config file.
- * Return -3 if memory allocation fails.
+ * Return 0 on success (or if `tree` is NULL or has no list).
+ * Return -1 if memory allocation fails.
  */
-int settings_load_blocked_words(Client_Data *client_data, const Run_Options *run_opts);
+int settings_load_blocked_words(Client_Data *client_data, const Settings_Tree *tree);
 
 /*
- * Reloads config settings.
+ * Reloads config settings. Only the sections that changed since the config file was last
+ * loaded are re-applied; if the file can't be read the current settings are kept.
  */
 void settings_reload(Toxic *toxic);
 
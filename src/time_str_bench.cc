@@ -0,0 +1,65 @@
+/* Timestamp formatting benchmark.
+ *
+ * Times the two timestamps made for each incoming message, one for the chat window and one for the
+ * log, first with a localtime() and strftime() call for each as get_time_str() used to, then with
+ * get_time_str() and its per-second cache. Run with an optional message count.
+ */
+
+#include "misc_tools.h"
+#include "settings.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void uncached_time_str(char *buf, size_t bufsize, const char *format)
+{
+    const time_t t = time(nullptr);
+    strftime(buf, bufsize, format, localtime(&t));
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const size_t num_messages = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+
+    char timestr[TIME_STR_SIZE];
+    char log_timestr[MAX_STR_SIZE];
+    size_t checksum = 0;
+
+    auto start = Clock::now();
+
+    for (size_t i = 0; i < num_messages; ++i) {
+        uncached_time_str(timestr, sizeof(timestr), TIMESTAMP_DEFAULT);
+        uncached_time_str(log_timestr, sizeof(log_timestr), LOG_TIMESTAMP_DEFAULT);
+        checksum += strlen(timestr) + strlen(log_timestr);
+    }
+
+    const double uncached_ms = ms_since(start);
+    printf("localtime + strftime: %9.2f ms, %12.0f messages/s\n", uncached_ms, num_messages / (uncached_ms / 1e3));
+
+    start = Clock::now();
+
+    for (size_t i = 0; i < num_messages; ++i) {
+        get_time_str(timestr, sizeof(timestr), TIMESTAMP_DEFAULT);
+        get_time_str(log_timestr, sizeof(log_timestr), LOG_TIMESTAMP_DEFAULT);
+        checksum -= strlen(timestr) + strlen(log_timestr);
+    }
+
+    const double cached_ms = ms_since(start);
+    printf("get_time_str cached:  %9.2f ms, %12.0f messages/s\n", cached_ms, num_messages / (cached_ms / 1e3));
+
+    return checksum == 0 ? 0 : 1;
+}
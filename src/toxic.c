@@ -30,7 +30,6 @@
 #include <unistd.h>
 
 #include <curl/curl.h>
-#include <tox/toxencryptsave.h>
 #include <tox/tox.h>
 
 #include "audio_device.h"
@@ -50,6 +49,7 @@
 #include "netprof.h"
 #include "notify.h"
 #include "paths.h"
+#include "profile_save.h"
 #include "prompt.h"
 #include "run_options.h"
 #include "settings.h"
@@ -75,6 +75,14 @@
 
 struct Winthread Winthread;
 
+/* Asks the terminal to wrap pasted text in start and end markers so that it can be read as one event.
+   Terminals that don't support bracketed paste ignore this. */
+static void set_bracketed_paste(bool enable)
+{
+    fputs(enable ? "\033[?2004h" : "\033[?2004l", stdout);
+    fflush(stdout);
+}
+
 static void kill_toxic(Toxic *toxic)
 {
     if (toxic == NULL) {
@@ -83,9 +91,17 @@ static void kill_toxic(Toxic *toxic)
 
     Client_Data *client_data = &toxic->client_data;
 
+    // The save thread may still be writing the profile with the data path and the pass key
+    profile_save_shutdown();
+
     free(client_data->data_path);
     free(client_data->block_path);
-    free_ptr_array((void **) client_data->blocked_words);
+    free(client_data->group_ignore_path);
+    free(client_data->input_history_path);
+    input_history_free(&client_data->input_history);
+    tox_pass_key_free(client_data->pass_key);
+    word_filter_free(&client_data->blocked_words);
+    settings_tree_free(toxic->settings_tree);
     free(toxic->c_config);
     free(toxic->run_opts);
     free(toxic->windows);
@@ -127,6 +143,12 @@ void exit_toxic_success(Toxic *toxic)
 
     store_data(toxic);
 
+    const Client_Data *client_data = &toxic->client_data;
+
+    if (toxic->c_config->save_input_history && !client_data->is_encrypted) {
+        input_history_save(&client_data->input_history, client_data->input_history_path);
+    }
+
     terminate_notify();
 
     kill_all_file_transfers(toxic);
@@ -155,6 +177,7 @@ void exit_toxic_success(Toxic *toxic)
         run_opts->netprof_fp = NULL;
     }
 
+    set_bracketed_paste(false);
     endwin();
     curl_global_cleanup();
 
@@ -169,6 +192,7 @@ void exit_toxic_success(Toxic *toxic)
 
 void exit_toxic_err(int errcode, const char *errmsg, ...)
 {
+    set_bracketed_paste(false);
     endwin();
 
     freopen("/dev/tty", "w", stderr);
@@ -324,6 +348,7 @@ void init_term(const Client_Config *c_config, Init_Queue *init_q, bool use_defau
     noecho();
     nonl();
     set_window_refresh_rate(NCURSES_DEFAULT_REFRESH_RATE);
+    set_bracketed_paste(true);
 
     if (!has_colors()) {
         init_queue_add(init_q, "This terminal does not support colors.");
@@ -399,106 +424,14 @@ void init_term(const Client_Config *c_config, Init_Queue *init_q, bool use_defau
     refresh();
 }
 
-/* Store Tox profile data to path.
+/* Store Tox profile data to path, superseding any save that's still pending.
  *
  * Return 0 if stored successfully.
  * Return -1 on error.
  */
-#define TEMP_PROFILE_EXT ".tmp"
 int store_data(const Toxic *toxic)
 {
-    const Run_Options *run_opts = toxic->run_opts;
-
-    const char *path = toxic->client_data.data_path;
-
-    if (path == NULL) {
-        return -1;
-    }
-
-    const size_t temp_buf_size = strlen(path) + strlen(TEMP_PROFILE_EXT) + 1;
-    char *temp_path = malloc(temp_buf_size);
-
-    if (temp_path == NULL) {
-        return -1;
-    }
-
-    snprintf(temp_path, temp_buf_size, "%s%s", path, TEMP_PROFILE_EXT);
-
-    FILE *fp = fopen(temp_path, "wb");
-
-    if (fp == NULL) {
-        free(temp_path);
-        return -1;
-    }
-
-    const size_t data_len = tox_get_savedata_size(toxic->tox);
-    char *data = malloc(data_len * sizeof(char));
-
-    if (data == NULL) {
-        free(temp_path);
-        fclose(fp);
-        return -1;
-    }
-
-    tox_get_savedata(toxic->tox, (uint8_t *) data);
-
-    const Client_Data *client_data = &toxic->client_data;
-
-    if (client_data->is_encrypted && !run_opts->unencrypt_data) {
-        size_t enc_len = data_len + TOX_PASS_ENCRYPTION_EXTRA_LENGTH;
-        char *enc_data = malloc(enc_len * sizeof(char));
-
-        if (enc_data == NULL) {
-            fclose(fp);
-            free(temp_path);
-            free(data);
-            return -1;
-        }
-
-        Tox_Err_Encryption err;
-        tox_pass_encrypt((uint8_t *) data, data_len, (const uint8_t *) toxic->client_data.pass,
-                         toxic->client_data.pass_len, (uint8_t *) enc_data, &err);
-
-        if (err != TOX_ERR_ENCRYPTION_OK) {
-            fprintf(stderr, "tox_pass_encrypt() failed with error %d\n", err);
-            fclose(fp);
-            free(temp_path);
-            free(data);
-            free(enc_data);
-            return -1;
-        }
-
-        if (fwrite(enc_data, enc_len, 1, fp) != 1) {
-            fprintf(stderr, "Failed to write profile data.\n");
-            fclose(fp);
-            free(temp_path);
-            free(data);
-            free(enc_data);
-            return -1;
-        }
-
-        free(enc_data);
-    } else {  /* data will not be encrypted */
-        if (fwrite(data, data_len, 1, fp) != 1) {
-            fprintf(stderr, "Failed to write profile data.\n");
-            fclose(fp);
-            free(temp_path);
-            free(data);
-            return -1;
-        }
-    }
-
-    fclose(fp);
-    free(data);
-
-    if (rename(temp_path, path) != 0) {
-        free(temp_path);
-        return -1;
-    }
-
-    free(temp_path);
-
-    return 0;
+    return profile_save_now(toxic);
 }
 
 /* Set interface refresh flag. This should be called whenever the interface changes.
@@ -36,13 +36,16 @@
 #include <stdbool.h>
 
 #include <tox/tox.h>
+#include <tox/toxencryptsave.h>
 
 #ifdef TOX_EXPERIMENTAL
 #include <tox/tox_private.h>
 #endif
 
+#include "input_history.h"
 #include "settings.h"
 #include "toxic_constants.h"
+#include "word_filter.h"
 
 #ifdef X11
 #include "x11focus.h"
@@ -50,12 +53,15 @@
 
 typedef struct Client_Data {
     bool is_encrypted;
-    char pass[MAX_PASSWORD_LEN + 1];
+    char pass[MAX_PASSWORD_LEN + 1];    /* Wiped once pass_key has been derived from it */
     int  pass_len;
+    Tox_Pass_Key *pass_key;             /* Key for encrypted saves; NULL if it couldn't be derived */
     char *data_path;
     char *block_path;
-    char **blocked_words;
-    size_t num_blocked_words;
+    char *group_ignore_path;
+    char *input_history_path;
+    WordFilter blocked_words;
+    Input_History input_history;        /* Every line typed in any window, newest last */
     bool mplex_auto_away_initialized;
 } Client_Data;
 
@@ -110,6 +116,7 @@ typedef struct Toxic {
 
     FriendRequests frnd_requests;
     Paths         *paths;
+    Settings_Tree *settings_tree;    /* The config file as last loaded, diffed against on reload */
     time_t        last_bootstrap_time;
 } Toxic;
 
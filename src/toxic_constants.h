@@ -61,6 +61,7 @@
 #define T_KEY_NEXT       0x10     /* ctrl-p */
 #define T_KEY_PREV       0x0F     /* ctrl-o */
 #define T_KEY_C_E        0x05     /* ctrl-e */
+#define T_KEY_C_G        0x07     /* ctrl-g */
 #define T_KEY_C_A        0x01     /* ctrl-a */
 #define T_KEY_C_V        0x16     /* ctrl-v */
 #define T_KEY_C_F        0x06     /* ctrl-f */
@@ -76,6 +77,7 @@
 #define T_KEY_C_UP       0x236    /* ctrl-up arrow */
 #define T_KEY_C_DOWN     0x20D    /* ctrl-down arrow */
 #define T_KEY_TAB        0x09     /* TAB key */
+#define T_KEY_PASTE      0x110000 /* start of a bracketed paste (outside the range of chars and ncurses keys) */
 
 #define ONLINE_CHAR  "o"
 #define OFFLINE_CHAR "o"
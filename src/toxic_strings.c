@@ -20,6 +20,10 @@
  *
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE    /* needed for wcwidth() */
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
@@ -29,20 +33,178 @@
 #include "toxic_strings.h"
 #include "windows.h"
 
-/* Adds char to line at pos. Return 0 on success, -1 if line buffer is full */
-int add_char_to_buf(ChatContext *ctx, wint_t ch)
+/* Returns the index in line_text of the first char after the gap. */
+static int gap_end(const ChatContext *ctx)
+{
+    return MAX_STR_SIZE - (ctx->len - ctx->gap);
+}
+
+/* Returns the index in line_text of the char at position `i` in the line. */
+static int line_index(const ChatContext *ctx, int i)
+{
+    return i < ctx->gap ? i : i + MAX_STR_SIZE - ctx->len;
+}
+
+/* Moves the gap so that the first `to` chars of the line come before it. */
+static void move_gap(ChatContext *ctx, int to)
 {
-    if (ctx->len >= MAX_STR_SIZE - 1) {
+    const int end = gap_end(ctx);
+
+    if (to < ctx->gap) {
+        const int n = ctx->gap - to;
+
+        for (int i = to; i < ctx->gap; ++i) {
+            ctx->gap_width -= ctx->line_widths[i];
+        }
+
+        wmemmove(&ctx->line_text[end - n], &ctx->line_text[to], n);
+        memmove(&ctx->line_widths[end - n], &ctx->line_widths[to], n);
+    } else if (to > ctx->gap) {
+        const int n = to - ctx->gap;
+
+        for (int i = end; i < end + n; ++i) {
+            ctx->gap_width += ctx->line_widths[i];
+        }
+
+        wmemmove(&ctx->line_text[ctx->gap], &ctx->line_text[end], n);
+        memmove(&ctx->line_widths[ctx->gap], &ctx->line_widths[end], n);
+    }
+
+    ctx->gap = to;
+}
+
+/* Copies `n` chars of the line starting at position `from` to `dest`. */
+static void copy_from_buf(const ChatContext *ctx, int from, int n, wchar_t *dest)
+{
+    const int before_gap = MAX(0, MIN(n, ctx->gap - from));
+
+    wmemcpy(dest, &ctx->line_text[from], before_gap);
+    wmemcpy(dest + before_gap, &ctx->line_text[line_index(ctx, from + before_gap)], n - before_gap);
+}
+
+/* Removes the `n` chars starting at position `from` from the line. Doesn't move the cursor. */
+static void remove_from_buf(ChatContext *ctx, int from, int n)
+{
+    move_gap(ctx, from);
+
+    const int end = gap_end(ctx);
+
+    for (int i = 0; i < n; ++i) {
+        ctx->line_width -= ctx->line_widths[end + i];
+    }
+
+    ctx->len -= n;
+}
+
+/*
+ * Inserts `n` chars from `s` at pos and moves pos past them. If `strict` is true, nothing is
+ * inserted if any of the chars is unprintable; otherwise they're inserted with a width of zero.
+ *
+ * Return 0 on success, -1 if the chars don't fit or one of them is unprintable.
+ */
+static int insert_into_buf(ChatContext *ctx, const wchar_t *s, int n, bool strict)
+{
+    if (n < 0 || ctx->len + n >= MAX_STR_SIZE) {
         return -1;
     }
 
-    wmemmove(&ctx->line[ctx->pos + 1], &ctx->line[ctx->pos], ctx->len - ctx->pos);
-    ctx->line[ctx->pos++] = ch;
-    ctx->line[++ctx->len] = L'\0';
+    move_gap(ctx, ctx->pos);
+
+    // The gap has room for the chars, so they're only counted as part of the line once all are valid
+    int width = 0;
+
+    for (int i = 0; i < n; ++i) {
+        const int ch_width = wcwidth(s[i]);
+
+        if (ch_width < 0 && strict) {
+            return -1;
+        }
+
+        ctx->line_text[ctx->gap + i] = s[i];
+        ctx->line_widths[ctx->gap + i] = MAX(0, ch_width);
+        width += MAX(0, ch_width);
+    }
+
+    ctx->gap += n;
+    ctx->gap_width += width;
+    ctx->pos += n;
+    ctx->len += n;
+    ctx->line_width += width;
 
     return 0;
 }
 
+wchar_t *get_line_buf(ChatContext *ctx)
+{
+    move_gap(ctx, ctx->len);
+    ctx->line_text[ctx->len] = L'\0';
+
+    return ctx->line_text;
+}
+
+void copy_line_buf(const ChatContext *ctx, int from, wchar_t *buf)
+{
+    from = MAX(0, MIN(from, ctx->len));
+
+    copy_from_buf(ctx, from, ctx->len - from, buf);
+    buf[ctx->len - from] = L'\0';
+}
+
+int set_line_buf(ChatContext *ctx, const wchar_t *line, int len, int pos)
+{
+    if (len < 0 || len >= MAX_STR_SIZE) {
+        return -1;
+    }
+
+    reset_buf(ctx);
+    insert_into_buf(ctx, line, len, false);
+    ctx->pos = MAX(0, MIN(pos, len));
+
+    return 0;
+}
+
+wchar_t line_buf_char(const ChatContext *ctx, int i)
+{
+    if (i < 0 || i >= ctx->len) {
+        return L'\0';
+    }
+
+    return ctx->line_text[line_index(ctx, i)];
+}
+
+int line_buf_width(const ChatContext *ctx, int from, int to)
+{
+    int width = 0;
+
+    for (int i = from; i < to && i < ctx->gap; ++i) {
+        width += ctx->line_widths[i];
+    }
+
+    for (int i = MAX(from, ctx->gap); i < to; ++i) {
+        width += ctx->line_widths[line_index(ctx, i)];
+    }
+
+    return width;
+}
+
+int line_buf_cursor_width(ChatContext *ctx)
+{
+    move_gap(ctx, ctx->pos);
+    return ctx->gap_width;
+}
+
+/* Adds char to line at pos. Return 0 on success, -1 if line buffer is full or the char is unprintable */
+int add_char_to_buf(ChatContext *ctx, wint_t ch)
+{
+    const wchar_t wch = ch;
+    return insert_into_buf(ctx, &wch, 1, true);
+}
+
+int add_str_to_buf(ChatContext *ctx, const wchar_t *s, int n)
+{
+    return insert_into_buf(ctx, s, n, true);
+}
+
 /* Deletes the character before pos. Return 0 on success, -1 if nothing to delete */
 int del_char_buf_bck(ChatContext *ctx)
 {
@@ -50,9 +212,8 @@ int del_char_buf_bck(ChatContext *ctx)
         return -1;
     }
 
-    wmemmove(&ctx->line[ctx->pos - 1], &ctx->line[ctx->pos], ctx->len - ctx->pos);
+    remove_from_buf(ctx, ctx->pos - 1, 1);
     --ctx->pos;
-    ctx->line[--ctx->len] = L'\0';
 
     return 0;
 }
@@ -64,8 +225,7 @@ int del_char_buf_frnt(ChatContext *ctx)
         return -1;
     }
 
-    wmemmove(&ctx->line[ctx->pos], &ctx->line[ctx->pos + 1], ctx->len - ctx->pos - 1);
-    ctx->line[--ctx->len] = L'\0';
+    remove_from_buf(ctx, ctx->pos, 1);
 
     return 0;
 }
@@ -79,14 +239,12 @@ int discard_buf(ChatContext *ctx)
     }
 
     ctx->yank_len = ctx->pos;
-    wmemcpy(ctx->yank, ctx->line, ctx->yank_len);
+    copy_from_buf(ctx, 0, ctx->yank_len, ctx->yank);
     ctx->yank[ctx->yank_len] = L'\0';
 
-    wmemmove(ctx->line, &ctx->line[ctx->pos], ctx->len - ctx->pos);
-    ctx->len -= ctx->pos;
+    remove_from_buf(ctx, 0, ctx->pos);
     ctx->pos = 0;
     ctx->start = 0;
-    ctx->line[ctx->len] = L'\0';
 
     return 0;
 }
@@ -100,11 +258,10 @@ int kill_buf(ChatContext *ctx)
     }
 
     ctx->yank_len = ctx->len - ctx->pos;
-    wmemcpy(ctx->yank, &ctx->line[ctx->pos], ctx->yank_len);
+    copy_from_buf(ctx, ctx->pos, ctx->yank_len, ctx->yank);
     ctx->yank[ctx->yank_len] = L'\0';
 
-    ctx->line[ctx->pos] = L'\0';
-    ctx->len = ctx->pos;
+    remove_from_buf(ctx, ctx->pos, ctx->yank_len);
 
     return 0;
 }
@@ -117,18 +274,7 @@ int yank_buf(ChatContext *ctx)
         return -1;
     }
 
-    if (ctx->yank_len + ctx->len >= MAX_STR_SIZE) {
-        return -1;
-    }
-
-    wmemmove(&ctx->line[ctx->pos + ctx->yank_len], &ctx->line[ctx->pos], ctx->len - ctx->pos);
-    wmemcpy(&ctx->line[ctx->pos], ctx->yank, ctx->yank_len);
-
-    ctx->pos += ctx->yank_len;
-    ctx->len += ctx->yank_len;
-    ctx->line[ctx->len] = L'\0';
-
-    return 0;
+    return insert_into_buf(ctx, ctx->yank, ctx->yank_len, false);
 }
 
 /* Deletes all characters from line starting at pos and going backwards
@@ -143,23 +289,21 @@ int del_word_buf(ChatContext *ctx)
     int i = ctx->pos, count = 0;
 
     /* traverse past empty space */
-    while (i > 0 && ctx->line[i - 1] == L' ') {
+    while (i > 0 && line_buf_char(ctx, i - 1) == L' ') {
         ++count;
         --i;
     }
 
     /* traverse past last entered word */
-    while (i > 0 && ctx->line[i - 1] != L' ') {
+    while (i > 0 && line_buf_char(ctx, i - 1) != L' ') {
         ++count;
         --i;
     }
 
-    wmemmove(&ctx->line[i], &ctx->line[ctx->pos], ctx->len - ctx->pos);
+    remove_from_buf(ctx, i, count);
 
     ctx->start = MAX(0, ctx->start - count);   /* TODO: take into account widechar */
-    ctx->len -= count;
     ctx->pos -= count;
-    ctx->line[ctx->len] = L'\0';
 
     return 0;
 }
@@ -167,7 +311,10 @@ int del_word_buf(ChatContext *ctx)
 /* nulls line and sets pos, len and start to 0 */
 void reset_buf(ChatContext *ctx)
 {
-    ctx->line[0] = L'\0';
+    ctx->line_text[0] = L'\0';
+    ctx->gap = 0;
+    ctx->gap_width = 0;
+    ctx->line_width = 0;
     ctx->pos = 0;
     ctx->len = 0;
     ctx->start = 0;
@@ -180,100 +327,106 @@ void rm_trailing_spaces_buf(ChatContext *ctx)
         return;
     }
 
-    if (ctx->line[ctx->len - 1] != ' ' && ctx->line[ctx->len - 1] != L'¶') {
+    if (line_buf_char(ctx, ctx->len - 1) != ' ' && line_buf_char(ctx, ctx->len - 1) != L'¶') {
         return;
     }
 
     int i;
 
     for (i = ctx->len - 1; i >= 0; --i) {
-        if (ctx->line[i] != ' ' && ctx->line[i] != L'¶') {
+        if (line_buf_char(ctx, i) != ' ' && line_buf_char(ctx, i) != L'¶') {
             break;
         }
     }
 
-    ctx->len = i + 1;
+    remove_from_buf(ctx, i + 1, ctx->len - (i + 1));
     ctx->pos = MIN(ctx->pos, ctx->len);
-    ctx->line[ctx->len] = L'\0';
 }
 
-#define HIST_PURGE ((MAX_LINE_HIST) / 4)
-
-/* shifts hist items back and makes room for HIST_PURGE new entries */
-static void shift_hist_back(ChatContext *ctx)
+void init_line_hist(ChatContext *ctx, const Input_History *global, const uint8_t *id, size_t id_length)
 {
-    int n = MAX_LINE_HIST - HIST_PURGE;
+    ctx->hst_owner = input_history_owner(id, id_length);
 
-    for (int i = 0; i < n; ++i) {
-        wmemcpy(ctx->ln_history[i], ctx->ln_history[i + HIST_PURGE], MAX_STR_SIZE);
+    if (!input_history_init(&ctx->line_hist, MAX_LINE_HIST)
+            || !input_history_copy_owner(&ctx->line_hist, global, ctx->hst_owner)) {
+        exit_toxic_err(FATALERR_MEMORY, "failed in init_line_hist");
     }
 
-    ctx->hst_tot = n;
+    ctx->hst_pos = ctx->line_hist.count;
 }
 
-/* adds a line to the ln_history buffer at hst_pos and sets hst_pos to end of history. */
-void add_line_to_hist(ChatContext *ctx)
+void free_line_hist(ChatContext *ctx)
 {
-    if (ctx->len >= MAX_STR_SIZE) {
-        return;
-    }
+    input_history_free(&ctx->line_hist);
+}
 
-    if (ctx->hst_tot >= MAX_LINE_HIST) {
-        shift_hist_back(ctx);
-    }
+void add_line_to_hist(ChatContext *ctx, Input_History *global, const char *line)
+{
+    const size_t length = strlen(line);
 
-    ++ctx->hst_tot;
-    ctx->hst_pos = ctx->hst_tot;
+    input_history_add(&ctx->line_hist, line, length, ctx->hst_owner);
 
-    wmemcpy(ctx->ln_history[ctx->hst_tot - 1], ctx->line, ctx->len + 1);
-}
+    if (global != NULL) {
+        input_history_add(global, line, length, ctx->hst_owner);
+    }
 
-/* copies history item at hst_pos to line. Sets pos and len to the len of the history item.
-   hst_pos is decremented or incremented depending on key_dir.
+    ctx->hst_pos = ctx->line_hist.count;
+}
 
-   resets line if at end of history */
 void fetch_hist_item(const Client_Config *c_config, ChatContext *ctx, int key_dir)
 {
-    if (wcscmp(ctx->line, L"\0") != 0
-            && ctx->hst_pos == ctx->hst_tot) {
-        add_line_to_hist(ctx);
-        ctx->hst_pos--;
+    UNUSED_VAR(c_config);
+
+    if (ctx->len > 0 && ctx->hst_pos == ctx->line_hist.count) {
+        char line[MAX_STR_SIZE];
+
+        /* the unsent line is kept in this window's history so that it can be brought back */
+        if (wcs_to_mbs_buf(line, get_line_buf(ctx), sizeof(line)) != -1) {
+            add_line_to_hist(ctx, NULL, line);
+            --ctx->hst_pos;
+        }
     }
 
     if (key_dir == KEY_UP) {
-        if (--ctx->hst_pos < 0) {
-            ctx->hst_pos = 0;
+        if (ctx->hst_pos > 0) {
+            --ctx->hst_pos;
         }
     } else {
-        if (++ctx->hst_pos >= ctx->hst_tot) {
-            ctx->hst_pos = ctx->hst_tot;
+        if (++ctx->hst_pos >= ctx->line_hist.count) {
+            ctx->hst_pos = ctx->line_hist.count;
             reset_buf(ctx);
             return;
         }
     }
 
-    const wchar_t *hst_line = ctx->ln_history[ctx->hst_pos];
-    size_t h_len = wcslen(hst_line);
+    const Input_History_Entry *entry = input_history_get(&ctx->line_hist, ctx->hst_pos);
+    wchar_t hst_line[MAX_STR_SIZE];
+
+    if (entry == NULL || mbs_to_wcs_buf(hst_line, entry->line, MAX_STR_SIZE) == -1) {
+        return;
+    }
+
+    wstrsubst(hst_line, L'\n', L'¶');
+
+    const int h_len = wcslen(hst_line);
 
-    wmemcpy(ctx->line, hst_line, h_len + 1);
-    ctx->pos = h_len;
-    ctx->len = h_len;
+    set_line_buf(ctx, hst_line, h_len, h_len);
 }
 
-void strsubst(char *str, char old, char new)
+void strsubst(char *str, char old_ch, char new_ch)
 {
     for (int i = 0; str[i] != '\0'; ++i) {
-        if (str[i] == old) {
-            str[i] = new;
+        if (str[i] == old_ch) {
+            str[i] = new_ch;
         }
     }
 }
 
-void wstrsubst(wchar_t *str, wchar_t old, wchar_t new)
+void wstrsubst(wchar_t *str, wchar_t old_ch, wchar_t new_ch)
 {
     for (int i = 0; str[i] != L'\0'; ++i) {
-        if (str[i] == old) {
-            str[i] = new;
+        if (str[i] == old_ch) {
+            str[i] = new_ch;
         }
     }
 }
@@ -25,9 +25,39 @@
 
 #include "windows.h"
 
-/* Adds char to line at pos. Return 0 on success, -1 if line buffer is full */
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Returns the line as a null terminated string, moving the gap to the end of the line buffer.
+   The string may be modified in place as long as its length stays the same. */
+wchar_t *get_line_buf(ChatContext *ctx);
+
+/* Copies the line from position `from` on to `buf` as a null terminated string, without moving the gap.
+   `buf` must have room for MAX_STR_SIZE chars. */
+void copy_line_buf(const ChatContext *ctx, int from, wchar_t *buf);
+
+/* Replaces the line with the first `len` chars of `line` and puts the cursor at `pos`.
+   Return 0 on success, -1 if the line is too long */
+int set_line_buf(ChatContext *ctx, const wchar_t *line, int len, int pos);
+
+/* Returns the char at position `i` in the line, or a null char if `i` is out of range. */
+wchar_t line_buf_char(const ChatContext *ctx, int i);
+
+/* Returns the display width of the chars from position `from` up to `to` in the line. */
+int line_buf_width(const ChatContext *ctx, int from, int to);
+
+/* Returns the display width of the line up to the cursor. The gap is moved to the cursor, which
+   costs nothing unless the cursor has moved since the last edit. */
+int line_buf_cursor_width(ChatContext *ctx);
+
+/* Adds char to line at pos. Return 0 on success, -1 if line buffer is full or the char is unprintable */
 int add_char_to_buf(ChatContext *ctx, wint_t ch);
 
+/* Adds `n` chars from `s` to line at pos in one step.
+   Return 0 on success, -1 if line buffer is full or any of the chars is unprintable */
+int add_str_to_buf(ChatContext *ctx, const wchar_t *s, int n);
+
 /* Deletes the character before pos. Return 0 on success, -1 if nothing to delete */
 int del_char_buf_bck(ChatContext *ctx);
 
@@ -57,8 +87,15 @@ int del_word_buf(ChatContext *ctx);
 /* Removes trailing spaces from line. */
 void rm_trailing_spaces_buf(ChatContext *ctx);
 
-/* adds a line to the ln_history buffer at hst_pos and sets hst_pos to last history item. */
-void add_line_to_hist(ChatContext *ctx);
+/* Sets up the input history of ctx for the window identified by the first `id_length` bytes of `id`,
+   starting it off with the lines typed in that window that are still in the global history. */
+void init_line_hist(ChatContext *ctx, const Input_History *global, const uint8_t *id, size_t id_length);
+
+void free_line_hist(ChatContext *ctx);
+
+/* Adds `line` to the input history of ctx and, unless `global` is NULL, to the global input history.
+   Sets hst_pos past the last history item. */
+void add_line_to_hist(ChatContext *ctx, Input_History *global, const char *line);
 
 /* copies history item at hst_pos to line. Sets pos and len to the len of the history item.
    hst_pos is decremented or incremented depending on key_dir.
@@ -66,8 +103,12 @@ void add_line_to_hist(ChatContext *ctx);
    resets line if at end of history */
 void fetch_hist_item(const Client_Config *c_config, ChatContext *ctx, int key_dir);
 
-/* Substitutes all occurrences of old with new. */
-void strsubst(char *str, char old, char new);
-void wstrsubst(wchar_t *str, wchar_t old, wchar_t new);
+/* Substitutes all occurrences of old_ch with new_ch. */
+void strsubst(char *str, char old_ch, char new_ch);
+void wstrsubst(wchar_t *str, wchar_t old_ch, wchar_t new_ch);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
 
 #endif /* TOXIC_STRINGS_H */
@@ -0,0 +1,201 @@
+#include "toxic_strings.h"
+
+#include <gtest/gtest.h>
+
+#include <clocale>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace {
+
+class ToxicStringsTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        has_utf8_ = std::setlocale(LC_CTYPE, "C.UTF-8") != nullptr;
+        reset_buf(ctx_.get());
+    }
+
+    std::wstring line()
+    {
+        return get_line_buf(ctx_.get());
+    }
+
+    bool has_utf8_ = false;
+    std::unique_ptr<ChatContext> ctx_ = std::make_unique<ChatContext>();
+};
+
+TEST_F(ToxicStringsTest, EditsInTheMiddleOfTheLine)
+{
+    ChatContext *ctx = ctx_.get();
+
+    ASSERT_EQ(add_str_to_buf(ctx, L"hello world", 11), 0);
+    ctx->pos = 5;
+    ASSERT_EQ(add_char_to_buf(ctx, L','), 0);
+    EXPECT_EQ(ctx->pos, 6);
+    EXPECT_EQ(line_buf_char(ctx, 5), L',');
+    EXPECT_EQ(line_buf_char(ctx, 6), L' ');
+    EXPECT_EQ(line_buf_char(ctx, 12), L'\0');
+
+    ASSERT_EQ(del_char_buf_frnt(ctx), 0);
+    ASSERT_EQ(del_char_buf_bck(ctx), 0);
+    EXPECT_EQ(line(), L"helloworld");
+    EXPECT_EQ(ctx->pos, 5);
+    EXPECT_EQ(ctx->line_width, 10);
+
+    ASSERT_EQ(kill_buf(ctx), 0);
+    EXPECT_EQ(line(), L"hello");
+    ctx->pos = 0;
+    ASSERT_EQ(yank_buf(ctx), 0);
+    EXPECT_EQ(line(), L"worldhello");
+    EXPECT_EQ(ctx->pos, 5);
+}
+
+TEST_F(ToxicStringsTest, CachesDisplayWidths)
+{
+    if (!has_utf8_) {
+        GTEST_SKIP() << "no UTF-8 locale";
+    }
+
+    ChatContext *ctx = ctx_.get();
+
+    ASSERT_EQ(add_str_to_buf(ctx, L"a世b", 3), 0);
+    EXPECT_EQ(ctx->line_width, 4);
+    EXPECT_EQ(line_buf_width(ctx, 1, 2), 2);
+
+    ctx->pos = 1;
+    ASSERT_EQ(del_char_buf_bck(ctx), 0);
+    EXPECT_EQ(ctx->line_width, 3);
+    EXPECT_EQ(line_buf_width(ctx, 0, ctx->len), 3);
+}
+
+TEST_F(ToxicStringsTest, CopiesTheLineWithoutMovingTheGap)
+{
+    if (!has_utf8_) {
+        GTEST_SKIP() << "no UTF-8 locale";
+    }
+
+    ChatContext *ctx = ctx_.get();
+
+    ASSERT_EQ(add_str_to_buf(ctx, L"ab世cd", 5), 0);
+    ctx->pos = 3;
+    ASSERT_EQ(add_char_to_buf(ctx, L'x'), 0);
+
+    const int gap = ctx->gap;
+    wchar_t buf[MAX_STR_SIZE];
+
+    copy_line_buf(ctx, 0, buf);
+    EXPECT_STREQ(buf, L"ab世xcd");
+    copy_line_buf(ctx, 4, buf);
+    EXPECT_STREQ(buf, L"cd");
+    copy_line_buf(ctx, ctx->len, buf);
+    EXPECT_STREQ(buf, L"");
+    EXPECT_EQ(ctx->gap, gap);
+
+    EXPECT_EQ(line_buf_cursor_width(ctx), 5);
+    ctx->pos = 1;
+    EXPECT_EQ(line_buf_cursor_width(ctx), 1);
+    ctx->pos = ctx->len;
+    EXPECT_EQ(line_buf_cursor_width(ctx), line_buf_width(ctx, 0, ctx->len));
+}
+
+TEST_F(ToxicStringsTest, RejectsUnprintableAndOverlongInput)
+{
+    ChatContext *ctx = ctx_.get();
+
+    EXPECT_EQ(add_str_to_buf(ctx, L"ab\x01", 3), -1);
+    EXPECT_EQ(ctx->len, 0);
+
+    const std::wstring full(MAX_STR_SIZE - 1, L'x');
+    ASSERT_EQ(add_str_to_buf(ctx, full.data(), full.size()), 0);
+    EXPECT_EQ(add_char_to_buf(ctx, L'y'), -1);
+    EXPECT_EQ(line(), full);
+}
+
+TEST_F(ToxicStringsTest, MatchesReferenceUnderRandomEdits)
+{
+    ChatContext *ctx = ctx_.get();
+    std::wstring reference;
+    std::wstring yanked;
+    std::mt19937 rng(99);
+
+    for (int i = 0; i < 20000; ++i) {
+        const size_t pos = ctx->pos;
+
+        switch (rng() % 8) {
+            case 0:
+            case 1: {
+                const wchar_t ch = rng() % 4 == 0 ? L' ' : L'a' + rng() % 26;
+
+                if (add_char_to_buf(ctx, ch) == 0) {
+                    reference.insert(pos, 1, ch);
+                }
+
+                break;
+            }
+
+            case 2: {
+                const std::wstring s(rng() % 40, L'p');
+
+                if (add_str_to_buf(ctx, s.data(), s.size()) == 0) {
+                    reference.insert(pos, s);
+                }
+
+                break;
+            }
+
+            case 3: {
+                if (del_char_buf_bck(ctx) == 0) {
+                    reference.erase(pos - 1, 1);
+                }
+
+                break;
+            }
+
+            case 4: {
+                if (del_char_buf_frnt(ctx) == 0) {
+                    reference.erase(pos, 1);
+                }
+
+                break;
+            }
+
+            case 5: {
+                if (del_word_buf(ctx) == 0) {
+                    reference.erase(ctx->pos, pos - ctx->pos);
+                }
+
+                break;
+            }
+
+            case 6: {
+                if (kill_buf(ctx) == 0) {
+                    yanked = reference.substr(pos);
+                    reference.erase(pos);
+                } else if (yank_buf(ctx) == 0) {
+                    reference.insert(pos, yanked);
+                }
+
+                break;
+            }
+
+            default: {
+                ctx->pos = rng() % (ctx->len + 1);
+                break;
+            }
+        }
+
+        ASSERT_EQ(ctx->len, static_cast<int>(reference.size()));
+        ASSERT_EQ(ctx->line_width, ctx->len);
+        ASSERT_EQ(line_buf_cursor_width(ctx), ctx->pos);
+
+        if (i % 64 == 0) {
+            ASSERT_EQ(line(), reference);
+        }
+    }
+
+    EXPECT_EQ(line(), reference);
+}
+
+}  // namespace
@@ -525,13 +525,13 @@ void cmd_change_video_device(WINDOW *window, ToxWindow *self, Toxic *toxic, int
 
     const Client_Config *c_config = toxic->c_config;
 
-    if (argc != 2) {
+    if (argc != 2 && argc != 3) {
         if (argc < 1) {
             print_err(self, c_config, "Type must be specified!");
         } else if (argc < 2) {
             print_err(self, c_config, "Must have id!");
         } else {
-            print_err(self, c_config, "Only two arguments allowed!");
+            print_err(self, c_config, "Only three arguments allowed!");
         }
 
         return;
@@ -561,10 +561,22 @@ void cmd_change_video_device(WINDOW *window, ToxWindow *self, Toxic *toxic, int
         return;
     }
 
-    if (set_primary_video_device(type, selection) == vde_InvalidSelection) {
+    if (argc == 3 && set_video_device_file(type, argv[3]) != vde_None) {
+        print_err(self, c_config, "Failed to set device file");
+        return;
+    }
+
+    const VideoDeviceError err = set_primary_video_device(type, selection);
+
+    if (err == vde_InvalidSelection) {
         print_err(self, c_config, "Invalid selection!");
         return;
     }
+
+    if (err == vde_FileError) {
+        print_err(self, c_config, "Device file required. Usage: /svdev <type> <id> [file]");
+        return;
+    }
 }
 
 #endif /* VIDEO */
@@ -8,6 +8,7 @@
 
 #include "video_call.h"
 #include "video_device.h"
+#include "video_pseudo_device.h"
 
 #include <sys/ioctl.h>
 
@@ -68,6 +69,8 @@ typedef struct VideoDevice {
 
     vpx_image_t input;
 
+    PseudoVideoDevice *pseudo;              /* Set instead of fd and the X11 window for pseudo devices */
+
     Display *x_display;
     Window x_window;
     GC x_gc;
@@ -80,6 +83,24 @@ static int c_size[2];                               /* Size of above containers
 static VideoDevice *video_devices_running[2][MAX_DEVICES] = {{NULL}}; /* Running devices */
 static uint32_t primary_video_device[2];                              /* Primary device */
 
+/* Pseudo devices, listed after the real devices of each type */
+static const PseudoVideoKind pseudo_input_kinds[] = {pv_Pattern, pv_FileIn};
+static const PseudoVideoKind pseudo_output_kinds[] = {pv_Discard, pv_FileOut};
+static char *pseudo_video_files[2];
+
+static int num_pseudo_video_devices(VideoDeviceType type)
+{
+    return type == vdt_input ? sizeof(pseudo_input_kinds) / sizeof(pseudo_input_kinds[0])
+           : sizeof(pseudo_output_kinds) / sizeof(pseudo_output_kinds[0]);
+}
+
+static PseudoVideoKind pseudo_video_kind(VideoDeviceType type, int32_t selection)
+{
+    const int32_t idx = selection - c_size[type];
+
+    return type == vdt_input ? pseudo_input_kinds[idx] : pseudo_output_kinds[idx];
+}
+
 static ToxAV *av = NULL;
 
 /* q_mutex */
@@ -255,6 +276,9 @@ VideoDeviceError terminate_video_devices(void)
         free(video_devices_names[vdt_input][i]);
     }
 
+    free(pseudo_video_files[vdt_input]);
+    free(pseudo_video_files[vdt_output]);
+
     if (pthread_mutex_destroy(&video_mutex) != 0) {
         return (VideoDeviceError) vde_InternalError;
     }
@@ -277,8 +301,8 @@ VideoDeviceError register_video_device_callback(int32_t friend_number, uint32_t
 
 #else /* not __OSX__ || __APPLE__ */
 
-    if (c_size[vdt_input] <= device_idx || !video_devices_running[vdt_input][device_idx]
-            || !video_devices_running[vdt_input][device_idx]->fd) {
+    if (MAX_DEVICES <= device_idx || !video_devices_running[vdt_input][device_idx]
+            || (!video_devices_running[vdt_input][device_idx]->fd && !video_devices_running[vdt_input][device_idx]->pseudo)) {
         return vde_InvalidSelection;
     }
 
@@ -295,15 +319,74 @@ VideoDeviceError register_video_device_callback(int32_t friend_number, uint32_t
 
 VideoDeviceError set_primary_video_device(VideoDeviceType type, int32_t selection)
 {
-    if (c_size[type] <= selection || selection < 0) {
+    if (video_selection_valid(type, selection) != vde_None) {
         return vde_InvalidSelection;
     }
 
+    if (selection >= c_size[type] && pseudo_video_needs_file(pseudo_video_kind(type, selection))
+            && pseudo_video_files[type] == NULL) {
+        return vde_FileError;
+    }
+
     primary_video_device[type] = selection;
 
     return vde_None;
 }
 
+VideoDeviceError set_video_device_file(VideoDeviceType type, const char *path)
+{
+    char *file = strdup(path);
+
+    if (file == NULL) {
+        return vde_InternalError;
+    }
+
+    lock;
+    free(pseudo_video_files[type]);
+    pseudo_video_files[type] = file;
+    unlock;
+
+    return vde_None;
+}
+
+/* Opens a pseudo device in place of a camera or receive window. Must be called with the
+ * video mutex held.
+ */
+static VideoDeviceError open_pseudo_video_device(VideoDeviceType type, VideoDevice *device, uint32_t *width,
+        uint32_t *height)
+{
+    uint16_t video_width = width == NULL ? 0 : (uint16_t) * width;
+    uint16_t video_height = height == NULL ? 0 : (uint16_t) * height;
+
+    device->pseudo = pseudo_video_open(pseudo_video_kind(type, device->selection), pseudo_video_files[type],
+                                       &video_width, &video_height);
+
+    if (device->pseudo == NULL) {
+        return vde_FailedStart;
+    }
+
+    if (type == vdt_output) {
+        return vde_None;
+    }
+
+    device->video_width = video_width;
+    device->video_height = video_height;
+
+    vpx_img_alloc(&device->input, VPX_IMG_FMT_I420, device->video_width, device->video_height, 1);
+
+    if (width != NULL) {
+        *width = device->video_width;
+    }
+
+    if (height != NULL) {
+        *height = device->video_height;
+    }
+
+    video_thread_paused = false;
+
+    return vde_None;
+}
+
 VideoDeviceError open_primary_video_device(VideoDeviceType type, uint32_t *device_idx,
         uint32_t *width, uint32_t *height)
 {
@@ -318,7 +401,7 @@ void get_primary_video_device_name(VideoDeviceType type, char *buf, int size)
 VideoDeviceError open_video_device(VideoDeviceType type, int32_t selection, uint32_t *device_idx,
                                    uint32_t *width, uint32_t *height)
 {
-    if (c_size[type] <= selection || selection < 0) {
+    if (video_selection_valid(type, selection) != vde_None) {
         return vde_InvalidSelection;
     }
 
@@ -358,6 +441,27 @@ VideoDeviceError open_video_device(VideoDeviceType type, int32_t selection, uint
         return vde_InternalError;
     }
 
+    if (selection >= c_size[type]) {
+        if (type == vdt_input) {
+            video_thread_paused = true;
+        }
+
+        const VideoDeviceError err = open_pseudo_video_device(type, device, width, height);
+
+        if (err != vde_None) {
+            video_devices_running[type][temp_idx] = NULL;
+            pthread_mutex_destroy(device->mutex);
+            free(device);
+            unlock;
+            return err;
+        }
+
+        *device_idx = temp_idx;
+        unlock;
+
+        return vde_None;
+    }
+
     if (type == vdt_input) {
         video_thread_paused = true;
 
@@ -604,6 +708,14 @@ VideoDeviceError write_video_out(uint16_t width, uint16_t height,
         return vde_DeviceNotActive;
     }
 
+    if (device->pseudo != NULL) {
+        pthread_mutex_lock(device->mutex);
+        const bool written = pseudo_video_write(device->pseudo, width, height, y, u, v, ystride, ustride, vstride);
+        pthread_mutex_unlock(device->mutex);
+
+        return written ? vde_None : vde_FileError;
+    }
+
     if (!device->x_window) {
         return vde_DeviceNotActive;
     }
@@ -682,7 +794,7 @@ void *video_thread_poll(void *userdata)  // TODO: maybe use thread for every inp
         if (video_thread_paused) {
             sleep_thread(10000L);    /* Wait for unpause. */
         } else {
-            for (i = 0; i < c_size[vdt_input]; ++i) {
+            for (i = 0; i < MAX_DEVICES; ++i) {
                 lock;
 
                 if (video_devices_running[vdt_input][i] != NULL) {
@@ -694,6 +806,15 @@ void *video_thread_poll(void *userdata)  // TODO: maybe use thread for every inp
                     uint8_t *u = device->input.planes[1];
                     uint8_t *v = device->input.planes[2];
 
+                    if (device->pseudo != NULL) {
+                        if (device->cb && pseudo_video_read(device->pseudo, y, u, v)) {
+                            device->cb(toxic, device->friend_number, video_width, video_height, y, u, v, device->cb_data);
+                        }
+
+                        unlock;
+                        continue;
+                    }
+
 #if defined(__OSX__) || defined(__APPLE__)
 
                     if (osx_video_read_device(y, u, v, &video_width, &video_height) != 0) {
@@ -795,7 +916,12 @@ VideoDeviceError close_video_device(VideoDeviceType type, uint32_t device_idx)
 
     if (!device->ref_count) {
 
-        if (type == vdt_input) {
+        if (device->pseudo != NULL) {
+            pseudo_video_close(device->pseudo);
+            vpx_img_free(&device->input);
+            pthread_mutex_destroy(device->mutex);
+            free(device);
+        } else if (type == vdt_input) {
 #if defined(__OSX__) || defined(__APPLE__)
 
             osx_video_close_device(device_idx);
@@ -848,12 +974,21 @@ void print_video_devices(ToxWindow *self, const Client_Config *c_config, VideoDe
         line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "%d: %s", i, video_devices_names[type][i]);
     }
 
+    for (int i = c_size[type]; i < c_size[type] + num_pseudo_video_devices(type); ++i) {
+        const PseudoVideoKind kind = pseudo_video_kind(type, i);
+        const char *file = pseudo_video_needs_file(kind) && pseudo_video_files[type] != NULL
+                           ? pseudo_video_files[type] : "";
+
+        line_info_add(self, c_config, false, NULL, NULL, SYS_MSG, 0, 0, "%d: %s %s", i, pseudo_video_name(kind), file);
+    }
+
     return;
 }
 
 VideoDeviceError video_selection_valid(VideoDeviceType type, int32_t selection)
 {
-    return (c_size[type] <= selection || selection < 0) ? vde_InvalidSelection : vde_None;
+    return (c_size[type] + num_pseudo_video_devices(type) <= selection || selection < 0)
+           ? vde_InvalidSelection : vde_None;
 }
 
 #endif /* VIDEO */
@@ -32,6 +32,7 @@ typedef enum VideoDeviceError {
     vde_BufferError = -7,
     vde_UnsupportedMode = -8,
     vde_CaptureError = -9,
+    vde_FileError = -10,
 } VideoDeviceError;
 
 typedef void (*VideoDataHandleCallback)(Toxic *toxic, uint32_t friend_number, int16_t width, int16_t height,
@@ -46,7 +47,16 @@ VideoDeviceError register_video_device_callback(int32_t call_idx, uint32_t devic
         void *data);
 void *get_video_device_callback_data(uint32_t device_idx);
 
+/* Selections past the last camera (or the X11 receive window for outputs) pick a pseudo
+ * device instead (see video_pseudo_device.h). Returns vde_FileError if a file pseudo device
+ * is selected before its file is set.
+ */
 VideoDeviceError set_primary_video_device(VideoDeviceType type, int32_t selection);
+
+/* Sets the Y4M file read by the file input pseudo device or written by the file output
+ * pseudo device. Takes effect the next time the device is opened.
+ */
+VideoDeviceError set_video_device_file(VideoDeviceType type, const char *path);
 VideoDeviceError open_primary_video_device(VideoDeviceType type, uint32_t *device_idx,
         uint32_t *width, uint32_t *height);
 /* Start device */
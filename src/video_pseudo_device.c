@@ -0,0 +1,303 @@
+/*  video_pseudo_device.c
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+#include "video_pseudo_device.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define Y4M_MAGIC "YUV4MPEG2"
+#define Y4M_FRAME "FRAME"
+#define Y4M_MAX_HEADER 256
+
+/* Frame rate written to Y4M headers; matches the rate the capture thread polls at */
+#define Y4M_FRAME_RATE "24:1"
+
+/* Number of pixels the test pattern moves each frame */
+#define PATTERN_SPEED 4
+
+struct PseudoVideoDevice {
+    PseudoVideoKind kind;
+    FILE *fp;
+
+    uint16_t width;
+    uint16_t height;
+
+    long data_start;        /* Offset of the first frame of a Y4M input */
+    bool header_written;
+
+    uint64_t frames;
+};
+
+const char *pseudo_video_name(PseudoVideoKind kind)
+{
+    switch (kind) {
+        case pv_Pattern:
+            return "Test pattern (pseudo device)";
+
+        case pv_FileIn:
+            return "Y4M file input (pseudo device)";
+
+        case pv_Discard:
+            return "Discard (pseudo device)";
+
+        case pv_FileOut:
+            return "Y4M file output (pseudo device)";
+    }
+
+    return "Unknown (pseudo device)";
+}
+
+bool pseudo_video_needs_file(PseudoVideoKind kind)
+{
+    return kind == pv_FileIn || kind == pv_FileOut;
+}
+
+/* Reads a single newline terminated header line of at most `size` - 1 characters. */
+static bool read_line(FILE *fp, char *buf, size_t size)
+{
+    if (fgets(buf, (int) size, fp) == NULL) {
+        return false;
+    }
+
+    const size_t len = strlen(buf);
+
+    if (len == 0 || buf[len - 1] != '\n') {
+        return false;
+    }
+
+    buf[len - 1] = '\0';
+
+    return true;
+}
+
+/* Parses the stream header of a Y4M file. Only 4:2:0 chroma subsampling is accepted. */
+static bool y4m_read_header(PseudoVideoDevice *dev)
+{
+    char header[Y4M_MAX_HEADER];
+
+    if (!read_line(dev->fp, header, sizeof(header)) || strncmp(header, Y4M_MAGIC " ", strlen(Y4M_MAGIC) + 1) != 0) {
+        return false;
+    }
+
+    long width = 0;
+    long height = 0;
+    char *saveptr = NULL;
+
+    for (char *tok = strtok_r(header + strlen(Y4M_MAGIC), " ", &saveptr); tok != NULL;
+            tok = strtok_r(NULL, " ", &saveptr)) {
+        switch (tok[0]) {
+            case 'W':
+                width = strtol(tok + 1, NULL, 10);
+                break;
+
+            case 'H':
+                height = strtol(tok + 1, NULL, 10);
+                break;
+
+            case 'C':
+                if (strncmp(tok + 1, "420", 3) != 0) {
+                    return false;
+                }
+
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (width < 2 || height < 2 || width > UINT16_MAX || height > UINT16_MAX || width % 2 || height % 2) {
+        return false;
+    }
+
+    dev->width = (uint16_t) width;
+    dev->height = (uint16_t) height;
+    dev->data_start = ftell(dev->fp);
+
+    return dev->data_start >= 0;
+}
+
+PseudoVideoDevice *pseudo_video_open(PseudoVideoKind kind, const char *path, uint16_t *width, uint16_t *height)
+{
+    if (pseudo_video_needs_file(kind) && (path == NULL || path[0] == '\0')) {
+        return NULL;
+    }
+
+    PseudoVideoDevice *dev = calloc(1, sizeof(PseudoVideoDevice));
+
+    if (dev == NULL) {
+        return NULL;
+    }
+
+    dev->kind = kind;
+
+    if (kind == pv_FileIn) {
+        dev->fp = fopen(path, "rb");
+
+        if (dev->fp == NULL || !y4m_read_header(dev)) {
+            pseudo_video_close(dev);
+            return NULL;
+        }
+
+        *width = dev->width;
+        *height = dev->height;
+
+        return dev;
+    }
+
+    if (kind == pv_FileOut) {
+        dev->fp = fopen(path, "wb");
+
+        if (dev->fp == NULL) {
+            pseudo_video_close(dev);
+            return NULL;
+        }
+    }
+
+    if (kind == pv_Pattern) {
+        *width = *width >= 2 ? *width & ~1 : PSEUDO_VIDEO_DEFAULT_WIDTH;
+        *height = *height >= 2 ? *height & ~1 : PSEUDO_VIDEO_DEFAULT_HEIGHT;
+
+        dev->width = *width;
+        dev->height = *height;
+    }
+
+    return dev;
+}
+
+void pseudo_video_close(PseudoVideoDevice *dev)
+{
+    if (dev == NULL) {
+        return;
+    }
+
+    if (dev->fp != NULL) {
+        fclose(dev->fp);
+    }
+
+    free(dev);
+}
+
+/* Vertical luma ramp scrolling sideways over fixed chroma bars, so both motion and
+ * colour survive the encoder in a way that's easy to eyeball.
+ */
+static void draw_pattern(const PseudoVideoDevice *dev, uint8_t *y, uint8_t *u, uint8_t *v)
+{
+    const uint16_t width = dev->width;
+    const uint16_t height = dev->height;
+    const uint32_t shift = (uint32_t)(dev->frames * PATTERN_SPEED);
+
+    for (uint16_t row = 0; row < height; ++row) {
+        for (uint16_t col = 0; col < width; ++col) {
+            y[(size_t) row * width + col] = (uint8_t)(16 + ((col + shift) * 219 / width) % 220);
+        }
+    }
+
+    const uint16_t chroma_width = width / 2;
+    const uint16_t chroma_height = height / 2;
+
+    for (uint16_t row = 0; row < chroma_height; ++row) {
+        for (uint16_t col = 0; col < chroma_width; ++col) {
+            const uint32_t bar = (uint32_t) col * 8 / chroma_width;
+
+            u[(size_t) row * chroma_width + col] = (uint8_t)(bar & 1 ? 64 : 192);
+            v[(size_t) row * chroma_width + col] = (uint8_t)(bar & 2 ? 64 : 192);
+        }
+    }
+}
+
+static bool read_y4m_frame(PseudoVideoDevice *dev, uint8_t *y, uint8_t *u, uint8_t *v)
+{
+    char header[Y4M_MAX_HEADER];
+
+    if (!read_line(dev->fp, header, sizeof(header))) {
+        // loop back to the first frame
+        if (fseek(dev->fp, dev->data_start, SEEK_SET) != 0 || !read_line(dev->fp, header, sizeof(header))) {
+            return false;
+        }
+    }
+
+    if (strncmp(header, Y4M_FRAME, strlen(Y4M_FRAME)) != 0) {
+        return false;
+    }
+
+    const size_t luma_size = (size_t) dev->width * dev->height;
+    const size_t chroma_size = luma_size / 4;
+
+    return fread(y, luma_size, 1, dev->fp) == 1
+           && fread(u, chroma_size, 1, dev->fp) == 1
+           && fread(v, chroma_size, 1, dev->fp) == 1;
+}
+
+bool pseudo_video_read(PseudoVideoDevice *dev, uint8_t *y, uint8_t *u, uint8_t *v)
+{
+    if (dev->kind == pv_FileIn) {
+        if (!read_y4m_frame(dev, y, u, v)) {
+            return false;
+        }
+    } else {
+        draw_pattern(dev, y, u, v);
+    }
+
+    ++dev->frames;
+
+    return true;
+}
+
+static bool write_plane(FILE *fp, const uint8_t *plane, uint16_t width, uint16_t height, int32_t stride)
+{
+    stride = abs(stride);
+
+    for (uint16_t row = 0; row < height; ++row) {
+        if (fwrite(plane + (size_t) row * stride, width, 1, fp) != 1) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool pseudo_video_write(PseudoVideoDevice *dev, uint16_t width, uint16_t height, const uint8_t *y, const uint8_t *u,
+                        const uint8_t *v, int32_t ystride, int32_t ustride, int32_t vstride)
+{
+    if (dev->kind != pv_FileOut) {
+        ++dev->frames;
+        return true;
+    }
+
+    if (!dev->header_written) {
+        dev->width = width;
+        dev->height = height;
+
+        if (fprintf(dev->fp, Y4M_MAGIC " W%u H%u F" Y4M_FRAME_RATE " Ip A1:1 C420jpeg\n", width, height) < 0) {
+            return false;
+        }
+
+        dev->header_written = true;
+    }
+
+    if (width != dev->width || height != dev->height) {
+        return true;
+    }
+
+    const uint16_t chroma_width = (width + 1) / 2;
+    const uint16_t chroma_height = (height + 1) / 2;
+
+    if (fputs(Y4M_FRAME "\n", dev->fp) < 0
+            || !write_plane(dev->fp, y, width, height, ystride)
+            || !write_plane(dev->fp, u, chroma_width, chroma_height, ustride)
+            || !write_plane(dev->fp, v, chroma_width, chroma_height, vstride)) {
+        return false;
+    }
+
+    ++dev->frames;
+
+    return true;
+}
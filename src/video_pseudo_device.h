@@ -0,0 +1,79 @@
+/*  video_pseudo_device.h
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+/*
+ * Pseudo video devices stand in for cameras and the X11 receive window so video calls
+ * can run headless. Inputs generate a moving test pattern or loop a Y4M file; outputs
+ * discard what they receive or record it to a Y4M file.
+ */
+
+#ifndef VIDEO_PSEUDO_DEVICE_H
+#define VIDEO_PSEUDO_DEVICE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Size of the test pattern when the caller doesn't request one */
+#define PSEUDO_VIDEO_DEFAULT_WIDTH 640
+#define PSEUDO_VIDEO_DEFAULT_HEIGHT 480
+
+typedef enum PseudoVideoKind {
+    pv_Pattern,     /* Input: moving test pattern */
+    pv_FileIn,      /* Input: 4:2:0 Y4M file, looped */
+    pv_Discard,     /* Output: drops every frame */
+    pv_FileOut,     /* Output: records to a Y4M file */
+} PseudoVideoKind;
+
+typedef struct PseudoVideoDevice PseudoVideoDevice;
+
+/*
+ * Returns a human readable name for `kind`.
+ */
+const char *pseudo_video_name(PseudoVideoKind kind);
+
+/*
+ * Returns true if `kind` reads from or writes to a file and needs a path to open.
+ */
+bool pseudo_video_needs_file(PseudoVideoKind kind);
+
+/*
+ * Opens a pseudo device of `kind`. For a test pattern `width` and `height` give the
+ * requested frame size, and 0 picks the default. For a Y4M input they are set to the
+ * size of the file's frames. Sizes are rounded down to even numbers.
+ *
+ * Returns NULL on failure.
+ */
+PseudoVideoDevice *pseudo_video_open(PseudoVideoKind kind, const char *path, uint16_t *width, uint16_t *height);
+
+void pseudo_video_close(PseudoVideoDevice *dev);
+
+/*
+ * Fills the tightly packed I420 planes `y`, `u` and `v` with the next frame of an input.
+ *
+ * Returns false on a read error.
+ */
+bool pseudo_video_read(PseudoVideoDevice *dev, uint8_t *y, uint8_t *u, uint8_t *v);
+
+/*
+ * Passes a received I420 frame to an output. A Y4M output takes its frame size from the
+ * first frame and drops later frames of a different size.
+ *
+ * Returns false on a write error.
+ */
+bool pseudo_video_write(PseudoVideoDevice *dev, uint16_t width, uint16_t height, const uint8_t *y, const uint8_t *u,
+                        const uint8_t *v, int32_t ystride, int32_t ustride, int32_t vstride);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif /* __cplusplus */
+
+#endif /* VIDEO_PSEUDO_DEVICE_H */
@@ -17,9 +17,11 @@
 #include "file_transfers.h"
 #include "friendlist.h"
 #include "groupchats.h"
+#include "input.h"
 #include "line_info.h"
 #include "log.h"
 #include "misc_tools.h"
+#include "profile_save.h"
 #include "prompt.h"
 #include "settings.h"
 #include "toxic.h"
@@ -138,7 +140,7 @@ void on_friend_name(Tox *tox, uint32_t friendnumber, const uint8_t *string, size
 
     flag_interface_refresh();
 
-    store_data(toxic);
+    profile_save_request();
 }
 
 void on_friend_status_message(Tox *tox, uint32_t friendnumber, const uint8_t *string, size_t length, void *userdata)
@@ -192,7 +194,7 @@ void on_friend_added(Toxic *toxic, uint32_t friendnumber, bool sort)
         }
     }
 
-    store_data(toxic);
+    profile_save_request();
 }
 
 void on_conference_message(Tox *tox, uint32_t conferencenumber, uint32_t peernumber, Tox_Message_Type type,
@@ -1203,6 +1205,7 @@ static struct key_sequence_codes {
     { L"[1;5B", T_KEY_C_DOWN  },
     { L"[1;5C", T_KEY_C_RIGHT },
     { L"[1;5D", T_KEY_C_LEFT  },
+    { L"[200~", T_KEY_PASTE   },
     { NULL, 0 }
 };
 
@@ -1244,6 +1247,84 @@ static wint_t get_input_sequence_code(void)
     return -1;
 }
 
+/* The most pasted chars handed to a window at once; the rest of a longer paste is dropped */
+#define MAX_PASTE_LENGTH (MAX_STR_SIZE * 32)
+
+/* How long to wait for more of a paste before giving up on its end marker, in milliseconds */
+#define PASTE_READ_TIMEOUT 500
+
+/*
+ * Reads the rest of a bracketed paste from stdscr, up to and not including the end marker.
+ *
+ * Puts at most `size` chars in `buf` and drops the rest. Newlines, tabs and printable chars are
+ * kept; key codes that ncurses decoded from within the paste are not.
+ *
+ * Returns the number of chars put in `buf`.
+ */
+static size_t read_bracketed_paste(wchar_t *buf, size_t size)
+{
+    static const wchar_t end_marker[] = L"\033[201~";
+    const size_t end_marker_len = sizeof(end_marker) / sizeof(wchar_t) - 1;
+
+    size_t length = 0;
+    size_t matched = 0;
+
+    timeout(PASTE_READ_TIMEOUT);
+
+    while (matched < end_marker_len) {
+        wint_t ch = 0;
+        const int printable = get_current_char(&ch);
+
+        if (printable < 0) {
+            break;
+        }
+
+        if (printable == 0 && ch != L'\033' && ch != L'\r' && ch != L'\n' && ch != L'\t') {
+            continue;
+        }
+
+        if ((wchar_t) ch == end_marker[matched]) {
+            ++matched;
+            continue;
+        }
+
+        // The end marker starts with the only char in it that can't be pasted, so a partial match
+        // is never part of a longer one
+        for (size_t i = 0; i < matched && length < size; ++i) {
+            buf[length++] = end_marker[i];
+        }
+
+        matched = 0;
+
+        if (ch == end_marker[0]) {
+            matched = 1;
+        } else if (length < size) {
+            buf[length++] = (wchar_t) ch;
+        }
+    }
+
+    set_window_refresh_rate(NCURSES_DEFAULT_REFRESH_RATE);
+
+    return length;
+}
+
+/* Reads a bracketed paste and hands it to window `w` in one piece. */
+static void paste_to_window(ToxWindow *w, Toxic *toxic)
+{
+    wchar_t *buf = malloc(MAX_PASTE_LENGTH * sizeof(wchar_t));
+
+    // The paste has to be read off the input either way
+    const size_t length = read_bracketed_paste(buf, buf != NULL ? MAX_PASTE_LENGTH : 0);
+
+    if (length > 0 && w->chatwin != NULL) {
+        pthread_mutex_lock(&Winthread.lock);
+        input_paste(w, toxic, buf, length);
+        pthread_mutex_unlock(&Winthread.lock);
+    }
+
+    free(buf);
+}
+
 void draw_active_window(Toxic *toxic)
 {
     if (toxic == NULL) {
@@ -1321,6 +1402,19 @@ void draw_active_window(Toxic *toxic)
     flag_interface_refresh();
     pthread_mutex_unlock(&Winthread.lock);
 
+    // An escape may start a sequence. It's decoded before the window sees the escape, so that
+    // the start of a paste doesn't also act as an escape key press.
+    wint_t sequence_code = (wint_t) -1;
+
+    if (printable == 0 && ch == T_KEY_ESC) {
+        sequence_code = get_input_sequence_code();
+
+        if (sequence_code == T_KEY_PASTE) {
+            paste_to_window(a, toxic);
+            return;
+        }
+    }
+
     if (printable == 0 && (ch == c_config->key_next_tab || ch == c_config->key_prev_tab)) {
         set_next_window(windows, c_config, (int) ch);
         return;
@@ -1335,7 +1429,7 @@ void draw_active_window(Toxic *toxic)
 
         // if an unprintable key code is unrecognized by input handler we attempt to
         // manually decode char sequence
-        wint_t tmp = get_input_sequence_code();
+        wint_t tmp = ch == T_KEY_ESC ? sequence_code : get_input_sequence_code();
 
         if (tmp != (wint_t) -1) {
             ch = tmp;
@@ -143,6 +143,7 @@ typedef struct GameData GameData;
 
 struct ToxWindow {
     bool(*onKey)(ToxWindow *, Toxic *, wint_t, bool);
+    bool(*onPasteLine)(ToxWindow *, Toxic *, const char *);    /* Sends a pasted line as a message */
     void(*onDraw)(ToxWindow *, Toxic *);
     void(*onInit)(ToxWindow *, Toxic *);
     void(*onNickRefresh)(ToxWindow *, Toxic *);
@@ -279,14 +280,31 @@ struct infobox {
 
 /* chat and conference window/buffer holder */
 struct ChatContext {
-    wchar_t line[MAX_STR_SIZE];
+    /* The input line is a gap buffer: the chars before the gap are at the start of line_text and the
+     * chars after it at the end, so an edit at the cursor doesn't shift the rest of the line. Use
+     * get_line_buf() and the other functions in toxic_strings.h rather than line_text directly. */
+    wchar_t line_text[MAX_STR_SIZE];
+    uint8_t line_widths[MAX_STR_SIZE];    /* Display width of each char in line_text, laid out the same way */
+    int gap;           /* The number of chars before the gap */
+    int gap_width;     /* Display width of the chars before the gap */
+    int line_width;    /* Display width of the whole line */
     int pos;
     int len;
     int start;    /* the position to start printing line at */
 
-    wchar_t ln_history[MAX_LINE_HIST][MAX_STR_SIZE];  /* history for input lines/commands */
-    int hst_pos;
-    int hst_tot;
+    Input_History line_hist;    /* history for input lines/commands typed in this window */
+    uint32_t hst_owner;         /* identifies this window's lines in the global input history */
+    size_t hst_pos;             /* the history entry shown in the line, or line_hist.count for a new line */
+
+    /* An incremental search of the global input history replaces the line with the query and the
+     * newest line matching it until the search ends. */
+    bool hst_searching;
+    bool hst_search_failed;    /* nothing matches the query; the previous match is still shown */
+    wchar_t hst_query[MAX_STR_SIZE];
+    int hst_query_len;
+    size_t hst_match;          /* the global history entry that matched, or the history's count if none did */
+    wchar_t hst_saved_line[MAX_STR_SIZE];    /* the line as it was when the search started */
+    int hst_saved_len;
 
     wchar_t yank[MAX_STR_SIZE];    /* contains last killed/discarded line */
     int yank_len;
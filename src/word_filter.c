@@ -0,0 +1,298 @@
+/*  word_filter.c
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+#include "word_filter.h"
+
+#include <stdlib.h>
+#include <wctype.h>
+
+#define WORD_FILTER_NO_STATE UINT32_MAX
+
+/* Bytes that aren't part of a valid UTF-8 sequence decode to this plus the byte value */
+#define WORD_FILTER_INVALID_BASE 0x110000u
+
+/*
+ * Decodes the UTF-8 sequence at `*text`, advances `*text` past it and returns its case folded
+ * code point. An invalid byte is consumed on its own and decodes to a value outside of the
+ * Unicode range so that it can only match the same byte in a word.
+ */
+static uint32_t next_folded_code_point(const char **text)
+{
+    const uint8_t *s = (const uint8_t *) *text;
+
+    if (s[0] < 0x80) {
+        ++*text;
+        return s[0] >= 'A' && s[0] <= 'Z' ? s[0] + ('a' - 'A') : s[0];
+    }
+
+    uint32_t code_point;
+    size_t length;
+
+    if ((s[0] & 0xE0) == 0xC0) {
+        code_point = s[0] & 0x1F;
+        length = 2;
+    } else if ((s[0] & 0xF0) == 0xE0) {
+        code_point = s[0] & 0x0F;
+        length = 3;
+    } else if ((s[0] & 0xF8) == 0xF0) {
+        code_point = s[0] & 0x07;
+        length = 4;
+    } else {
+        ++*text;
+        return WORD_FILTER_INVALID_BASE + s[0];
+    }
+
+    // A NUL terminator fails this check, so we never read past the end of the string
+    for (size_t i = 1; i < length; ++i) {
+        if ((s[i] & 0xC0) != 0x80) {
+            ++*text;
+            return WORD_FILTER_INVALID_BASE + s[0];
+        }
+
+        code_point = (code_point << 6) | (s[i] & 0x3F);
+    }
+
+    *text += length;
+
+    if (code_point >= WORD_FILTER_INVALID_BASE) {
+        return code_point;
+    }
+
+    // Going through upper case first folds variants such as the final sigma onto one lower case letter
+    return (uint32_t) towlower(towupper((wint_t) code_point));
+}
+
+static uint32_t edge_hash(uint32_t state, uint32_t code_point)
+{
+    return hash_index_u32(state * 0x9E3779B1u ^ code_point);
+}
+
+/* Returns the state reached from `state` on `code_point`, or WORD_FILTER_NO_STATE if there's no such edge. */
+static uint32_t word_filter_goto(const WordFilter *filter, uint32_t state, uint32_t code_point)
+{
+    const uint32_t hash = edge_hash(state, code_point);
+    size_t cursor = hash;
+    uint32_t slot;
+
+    while (hash_index_next(&filter->edge_index, hash, &cursor, &slot)) {
+        const WordFilterEdge *edge = &filter->edges[slot];
+
+        if (edge->state == state && edge->code_point == code_point) {
+            return edge->next;
+        }
+    }
+
+    return WORD_FILTER_NO_STATE;
+}
+
+/* Adds `word` to the trie. The edge and state arrays are sized for every word up front. */
+static bool word_filter_add_word(WordFilter *filter, const char *word, uint32_t *depth)
+{
+    uint32_t state = 0;
+
+    while (*word != '\0') {
+        const uint32_t code_point = next_folded_code_point(&word);
+        const uint32_t next = word_filter_goto(filter, state, code_point);
+
+        if (next != WORD_FILTER_NO_STATE) {
+            state = next;
+            continue;
+        }
+
+        const uint32_t slot = filter->num_edges;
+
+        if (!hash_index_add(&filter->edge_index, edge_hash(state, code_point), slot)) {
+            return false;
+        }
+
+        const uint32_t new_state = filter->num_states;
+
+        filter->edges[slot] = (WordFilterEdge) {
+            state, code_point, new_state
+        };
+
+        ++filter->num_edges;
+        ++filter->num_states;
+
+        depth[new_state] = depth[state] + 1;
+        state = new_state;
+    }
+
+    if (state != 0) {
+        filter->accepting[state] = true;
+        ++filter->num_words;
+    }
+
+    return true;
+}
+
+/*
+ * Sets the fail link of every state. The links of shallower states are needed first, so the edges
+ * are visited in order of depth by counting sort.
+ */
+static bool word_filter_link(WordFilter *filter, const uint32_t *depth, uint32_t max_depth)
+{
+    uint32_t *count = calloc((size_t) max_depth + 2, sizeof(uint32_t));
+    uint32_t *order = malloc(((size_t) filter->num_edges + 1) * sizeof(uint32_t));
+
+    if (count == NULL || order == NULL) {
+        free(count);
+        free(order);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < filter->num_edges; ++i) {
+        ++count[depth[filter->edges[i].next]];
+    }
+
+    for (uint32_t d = 1; d <= max_depth + 1; ++d) {
+        count[d] += count[d - 1];
+    }
+
+    for (uint32_t i = filter->num_edges; i > 0; --i) {
+        order[--count[depth[filter->edges[i - 1].next]]] = i - 1;
+    }
+
+    for (uint32_t i = 0; i < filter->num_edges; ++i) {
+        const WordFilterEdge *edge = &filter->edges[order[i]];
+        uint32_t fail = 0;
+
+        if (edge->state != 0) {
+            uint32_t state = filter->fail[edge->state];
+
+            while (true) {
+                const uint32_t next = word_filter_goto(filter, state, edge->code_point);
+
+                if (next != WORD_FILTER_NO_STATE) {
+                    fail = next;
+                    break;
+                }
+
+                if (state == 0) {
+                    break;
+                }
+
+                state = filter->fail[state];
+            }
+        }
+
+        filter->fail[edge->next] = fail;
+        filter->accepting[edge->next] |= filter->accepting[fail];
+    }
+
+    free(count);
+    free(order);
+
+    return true;
+}
+
+bool word_filter_init(WordFilter *filter, const char *const *words, size_t num_words)
+{
+    *filter = (WordFilter) {
+        0
+    };
+
+    size_t max_states = 1;
+
+    for (size_t i = 0; i < num_words; ++i) {
+        for (const char *p = words[i]; *p != '\0';) {
+            next_folded_code_point(&p);
+            ++max_states;
+        }
+    }
+
+    if (max_states >= WORD_FILTER_NO_STATE) {
+        return false;
+    }
+
+    filter->edges = malloc(max_states * sizeof(WordFilterEdge));
+    filter->fail = calloc(max_states, sizeof(uint32_t));
+    filter->accepting = calloc(max_states, sizeof(bool));
+    uint32_t *depth = calloc(max_states, sizeof(uint32_t));
+
+    if (filter->edges == NULL || filter->fail == NULL || filter->accepting == NULL || depth == NULL) {
+        free(depth);
+        word_filter_free(filter);
+        return false;
+    }
+
+    filter->num_states = 1;
+
+    for (size_t i = 0; i < num_words; ++i) {
+        if (!word_filter_add_word(filter, words[i], depth)) {
+            free(depth);
+            word_filter_free(filter);
+            return false;
+        }
+    }
+
+    uint32_t max_depth = 0;
+
+    for (uint32_t i = 0; i < filter->num_states; ++i) {
+        if (depth[i] > max_depth) {
+            max_depth = depth[i];
+        }
+    }
+
+    const bool linked = word_filter_link(filter, depth, max_depth);
+
+    free(depth);
+
+    if (!linked) {
+        word_filter_free(filter);
+        return false;
+    }
+
+    return true;
+}
+
+bool word_filter_match(const WordFilter *filter, const char *text)
+{
+    if (filter->num_words == 0) {
+        return false;
+    }
+
+    uint32_t state = 0;
+
+    while (*text != '\0') {
+        const uint32_t code_point = next_folded_code_point(&text);
+
+        while (true) {
+            const uint32_t next = word_filter_goto(filter, state, code_point);
+
+            if (next != WORD_FILTER_NO_STATE) {
+                state = next;
+                break;
+            }
+
+            if (state == 0) {
+                break;
+            }
+
+            state = filter->fail[state];
+        }
+
+        if (filter->accepting[state]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void word_filter_free(WordFilter *filter)
+{
+    free(filter->edges);
+    free(filter->fail);
+    free(filter->accepting);
+    hash_index_free(&filter->edge_index);
+
+    *filter = (WordFilter) {
+        0
+    };
+}
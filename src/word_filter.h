@@ -0,0 +1,62 @@
+/*  word_filter.h
+ *
+ *  Copyright (C) 2026 Toxic All Rights Reserved.
+ *
+ *  This file is part of Toxic. Toxic is free software licensed
+ *  under the GNU General Public License 3.0.
+ */
+
+/*
+ * Matches text against a list of words in a single pass, however long the list is. The words are
+ * compiled into an Aho-Corasick automaton over case folded code points, so a match ignores case
+ * for non-ASCII letters too and can start anywhere in the text.
+ */
+
+#ifndef WORD_FILTER_H
+#define WORD_FILTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hash_index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct WordFilterEdge {
+    uint32_t state;
+    uint32_t code_point;
+    uint32_t next;
+} WordFilterEdge;
+
+typedef struct WordFilter {
+    WordFilterEdge *edges;     /* The trie's transitions; the root is state 0 */
+    uint32_t num_edges;
+    HashIndex edge_index;      /* Maps a (state, code point) pair to its slot in edges */
+
+    uint32_t *fail;            /* Per state: the state for the longest proper suffix that's also in the trie */
+    bool *accepting;           /* Per state: a word ends here or somewhere along the state's fail links */
+    uint32_t num_states;
+
+    size_t num_words;
+} WordFilter;
+
+/*
+ * Compiles `num_words` UTF-8 encoded words into `filter`. Empty words are ignored.
+ *
+ * Returns false on allocation failure, in which case `filter` is left empty.
+ */
+bool word_filter_init(WordFilter *filter, const char *const *words, size_t num_words);
+
+/* Returns true if `text` contains any of the words in `filter`, ignoring case. */
+bool word_filter_match(const WordFilter *filter, const char *text);
+
+void word_filter_free(WordFilter *filter);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* WORD_FILTER_H */
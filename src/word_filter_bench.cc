@@ -0,0 +1,122 @@
+/* Blocked word matching benchmark.
+ *
+ * Builds a list of random words and times matching a batch of chat lines against it, first with
+ * one strcasestr() per word as string_contains_blocked_word() used to, then with the compiled
+ * word filter. Run with optional word and line counts.
+ */
+
+#include "word_filter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::string random_word(std::mt19937 &rng, size_t min_length, size_t max_length)
+{
+    std::uniform_int_distribution<size_t> length(min_length, max_length);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::string word;
+
+    for (size_t i = length(rng); i > 0; --i) {
+        word += static_cast<char>(letter(rng));
+    }
+
+    return word;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const size_t num_words = argc > 1 ? strtoul(argv[1], nullptr, 10) : 5000;
+    const size_t num_lines = argc > 2 ? strtoul(argv[2], nullptr, 10) : 2000;
+
+    std::mt19937 rng(1234);
+
+    std::vector<std::string> words;
+
+    for (size_t i = 0; i < num_words; ++i) {
+        words.push_back(random_word(rng, 6, 12));
+    }
+
+    std::vector<const char *> word_ptrs;
+
+    for (const std::string &word : words) {
+        word_ptrs.push_back(word.c_str());
+    }
+
+    // Chat lines of short words, one in a hundred containing a blocked word
+    std::vector<std::string> lines;
+    size_t total_bytes = 0;
+
+    for (size_t i = 0; i < num_lines; ++i) {
+        std::string line;
+
+        while (line.size() < 120) {
+            line += random_word(rng, 2, 7) + ' ';
+        }
+
+        if (i % 100 == 0 && !words.empty()) {
+            line += words[rng() % words.size()];
+        }
+
+        total_bytes += line.size();
+        lines.push_back(line);
+    }
+
+    printf("%zu words, %zu lines, %zu bytes\n", num_words, num_lines, total_bytes);
+
+    auto start = Clock::now();
+    size_t naive_matches = 0;
+
+    for (const std::string &line : lines) {
+        for (const std::string &word : words) {
+            if (strcasestr(line.c_str(), word.c_str()) != nullptr) {
+                ++naive_matches;
+                break;
+            }
+        }
+    }
+
+    const double naive_ms = ms_since(start);
+    printf("strcasestr per word: %9.2f ms, %8.2f MB/s, %zu matches\n", naive_ms,
+           total_bytes / 1e3 / naive_ms, naive_matches);
+
+    start = Clock::now();
+    WordFilter filter;
+
+    if (!word_filter_init(&filter, word_ptrs.data(), word_ptrs.size())) {
+        fprintf(stderr, "Failed to compile word filter\n");
+        return 1;
+    }
+
+    printf("compile:             %9.2f ms, %u states\n", ms_since(start), filter.num_states);
+
+    start = Clock::now();
+    size_t filter_matches = 0;
+
+    for (const std::string &line : lines) {
+        filter_matches += word_filter_match(&filter, line.c_str());
+    }
+
+    const double filter_ms = ms_since(start);
+    printf("word filter:         %9.2f ms, %8.2f MB/s, %zu matches\n", filter_ms,
+           total_bytes / 1e3 / filter_ms, filter_matches);
+
+    word_filter_free(&filter);
+
+    return naive_matches == filter_matches ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+#include "word_filter.h"
+
+#include <gtest/gtest.h>
+
+#include <clocale>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+class WordFilterTest : public ::testing::Test {
+protected:
+    void TearDown() override
+    {
+        word_filter_free(&filter_);
+    }
+
+    void init(const std::vector<const char *> &words)
+    {
+        ASSERT_TRUE(word_filter_init(&filter_, words.data(), words.size()));
+    }
+
+    bool match(const char *text) const
+    {
+        return word_filter_match(&filter_, text);
+    }
+
+    WordFilter filter_{};
+};
+
+TEST_F(WordFilterTest, EmptyFilterMatchesNothing)
+{
+    init({"", ""});
+    EXPECT_EQ(filter_.num_words, 0);
+    EXPECT_FALSE(match("anything"));
+    EXPECT_FALSE(match(""));
+}
+
+TEST_F(WordFilterTest, MatchesAnywhereIgnoringAsciiCase)
+{
+    init({"hunter2", "Certainly!"});
+    EXPECT_TRUE(match("my password is HUNTER2"));
+    EXPECT_TRUE(match("certainly! here you go"));
+    EXPECT_TRUE(match("xxhunter2xx"));
+    EXPECT_FALSE(match("hunter"));
+    EXPECT_FALSE(match("certainly"));
+}
+
+TEST_F(WordFilterTest, FollowsFailLinksAcrossOverlappingWords)
+{
+    init({"he", "she", "hers", "abcd", "bce"});
+    EXPECT_TRUE(match("ushers"));
+    EXPECT_TRUE(match("xabce"));  // abcd fails on e and falls back to bc
+    EXPECT_FALSE(match("abcx"));
+    EXPECT_FALSE(match("h e"));
+}
+
+TEST_F(WordFilterTest, ShorterWordInsideLongerWordMatches)
+{
+    init({"abcdef", "cd"});
+    EXPECT_TRUE(match("abcdx"));
+}
+
+TEST_F(WordFilterTest, FoldsNonAsciiCase)
+{
+    if (std::setlocale(LC_CTYPE, "C.UTF-8") == nullptr) {
+        GTEST_SKIP() << "no UTF-8 locale";
+    }
+
+    init({"straße", "ΟΔΥΣΣΕΥΣ", "привет"});
+    EXPECT_TRUE(match("STRAßE"));
+    EXPECT_TRUE(match("ὁ οδυσσευς"));
+    EXPECT_TRUE(match("οδυσσευς"));
+    EXPECT_TRUE(match("Οδυσσευς"));
+    EXPECT_TRUE(match("ПРИВЕТ мир"));
+    EXPECT_FALSE(match("пока"));
+
+    std::setlocale(LC_CTYPE, "C");
+}
+
+TEST_F(WordFilterTest, InvalidUtf8OnlyMatchesItself)
+{
+    init({"a\xff" "b"});
+    EXPECT_TRUE(match("xa\xff" "b"));
+    EXPECT_FALSE(match("a\xfe" "b"));
+    EXPECT_FALSE(match("a\xc3"));  // truncated sequence at the end of the string
+}
+
+TEST_F(WordFilterTest, MatchesReferenceOnRandomText)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> letter('a', 'd');
+
+    auto random_string = [&](size_t length) {
+        std::string s;
+
+        for (size_t i = 0; i < length; ++i) {
+            s += static_cast<char>(letter(rng));
+        }
+
+        return s;
+    };
+
+    std::vector<std::string> words;
+
+    for (int i = 0; i < 30; ++i) {
+        words.push_back(random_string(2 + rng() % 4));
+    }
+
+    std::vector<const char *> word_ptrs;
+
+    for (const std::string &word : words) {
+        word_ptrs.push_back(word.c_str());
+    }
+
+    init(word_ptrs);
+
+    for (int i = 0; i < 2000; ++i) {
+        const std::string text = random_string(rng() % 12);
+        bool expected = false;
+
+        for (const std::string &word : words) {
+            expected |= text.find(word) != std::string::npos;
+        }
+
+        EXPECT_EQ(match(text.c_str()), expected) << text;
+    }
+}
+
+}  // namespace